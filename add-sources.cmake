@@ -16,6 +16,7 @@ set(AGG_FILES
     ${LOMSE_SRC_DIR}/agg/src/agg_gsv_text.cpp
     ${LOMSE_SRC_DIR}/agg/src/agg_line_aa_basics.cpp
     ${LOMSE_SRC_DIR}/agg/src/agg_rounded_rect.cpp
+    ${LOMSE_SRC_DIR}/agg/src/agg_span_blend_simd.cpp
     ${LOMSE_SRC_DIR}/agg/src/agg_trans_affine.cpp
     ${LOMSE_SRC_DIR}/agg/src/agg_vcgen_contour.cpp
     ${LOMSE_SRC_DIR}/agg/src/agg_vcgen_markers_term.cpp
@@ -23,6 +24,7 @@ set(AGG_FILES
 )
 
 set(DOCUMENT_FILES
+    ${LOMSE_SRC_DIR}/document/lomse_binary_delta.cpp
     ${LOMSE_SRC_DIR}/document/lomse_command.cpp
     ${LOMSE_SRC_DIR}/document/lomse_document.cpp
     ${LOMSE_SRC_DIR}/document/lomse_document_cursor.cpp
@@ -39,6 +41,7 @@ set(EXPORTERS_FILES
 set(FILE_SYSTEM_FILES
     ${LOMSE_SRC_DIR}/file_system/lomse_file_system.cpp
     ${LOMSE_SRC_DIR}/file_system/lomse_image_reader.cpp
+    ${LOMSE_SRC_DIR}/file_system/lomse_image_writer.cpp
     ${LOMSE_SRC_DIR}/file_system/lomse_zip_stream.cpp
 )
 
@@ -138,6 +141,7 @@ set(INTERNAL_MODEL_FILES
     ${LOMSE_SRC_DIR}/internal_model/lomse_im_factory.cpp
     ${LOMSE_SRC_DIR}/internal_model/lomse_im_figured_bass.cpp
     ${LOMSE_SRC_DIR}/internal_model/lomse_im_note.cpp
+    ${LOMSE_SRC_DIR}/internal_model/lomse_im_snapshot.cpp
     ${LOMSE_SRC_DIR}/internal_model/lomse_internal_model.cpp
     ${LOMSE_SRC_DIR}/internal_model/lomse_im_measures_table.cpp
     ${LOMSE_SRC_DIR}/internal_model/lomse_model_builder.cpp
@@ -150,6 +154,7 @@ set(MODULE_FILES
     ${LOMSE_SRC_DIR}/module/lomse_doorway.cpp
     ${LOMSE_SRC_DIR}/module/lomse_events.cpp
     ${LOMSE_SRC_DIR}/module/lomse_events_dispatcher.cpp
+    ${LOMSE_SRC_DIR}/module/lomse_forensic_log.cpp
     ${LOMSE_SRC_DIR}/module/lomse_image.cpp
     ${LOMSE_SRC_DIR}/module/lomse_injectors.cpp
     ${LOMSE_SRC_DIR}/module/lomse_interval.cpp
@@ -159,6 +164,8 @@ set(MODULE_FILES
 )
 
 set(MVC_FILES
+    ${LOMSE_SRC_DIR}/mvc/lomse_batch_renderer.cpp
+    ${LOMSE_SRC_DIR}/mvc/lomse_document_loader.cpp
     ${LOMSE_SRC_DIR}/mvc/lomse_graphic_view.cpp
     ${LOMSE_SRC_DIR}/mvc/lomse_interactor.cpp
     ${LOMSE_SRC_DIR}/mvc/lomse_presenter.cpp 
@@ -194,6 +201,7 @@ set(PARSER_FILES
 
 set(RENDER_FILES
     ${LOMSE_SRC_DIR}/render/lomse_calligrapher.cpp
+    ${LOMSE_SRC_DIR}/render/lomse_display_list_drawer.cpp
     ${LOMSE_SRC_DIR}/render/lomse_font_freetype.cpp
     ${LOMSE_SRC_DIR}/render/lomse_font_storage.cpp
     ${LOMSE_SRC_DIR}/render/lomse_renderer.cpp
@@ -205,6 +213,7 @@ set(SCORE_FILES
 )
 
 set(SOUND_FILES
+    ${LOMSE_SRC_DIR}/sound/lomse_midi_file.cpp
     ${LOMSE_SRC_DIR}/sound/lomse_midi_table.cpp
     ${LOMSE_SRC_DIR}/sound/lomse_score_player.cpp
 )
@@ -42,6 +42,12 @@ option(LOMSE_RUN_TESTS "Run tests after building"
 #Build the example-1 program that uses the library
 option(LOMSE_BUILD_EXAMPLE "Build the example-1 program" OFF)
 
+#Build the lomse_render command line program for rendering pages as PNG images
+option(LOMSE_BUILD_RENDER_TOOL "Build the lomse_render program" OFF)
+
+#Build the lomse_benchmarks program, for measuring performance
+option(LOMSE_BUILD_BENCHMARKS "Build the lomse_benchmarks program" OFF)
+
 #optional dependencies
 option(LOMSE_ENABLE_COMPRESSION "Enable compressed formats (requires zlib)" ON)
 option(LOMSE_ENABLE_PNG "Enable png format (requires pnglib and zlib)" ON)
@@ -75,6 +81,8 @@ message(STATUS "Build the static library = ${LOMSE_BUILD_STATIC_LIB}")
 message(STATUS "Build the shared library = ${LOMSE_BUILD_SHARED_LIB}")
 message(STATUS "Build testlib program = ${LOMSE_BUILD_TESTS}")
 message(STATUS "Run tests after building = ${LOMSE_RUN_TESTS}")
+message(STATUS "Build lomse_render program = ${LOMSE_BUILD_RENDER_TOOL}")
+message(STATUS "Build lomse_benchmarks program = ${LOMSE_BUILD_BENCHMARKS}")
 message(STATUS "Create Debug build = ${LOMSE_DEBUG}")
 message(STATUS "Enable debug logs = ${LOMSE_ENABLE_DEBUG_LOGS}")
 message(STATUS "Compatibility for LDP v1.5 = ${LOMSE_COMPATIBILITY_LDP_1_5}")
@@ -0,0 +1,210 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#ifndef __LOMSE_BATCH_RENDERER_H__
+#define __LOMSE_BATCH_RENDERER_H__
+
+#include "lomse_basic.h"
+#include "lomse_agg_types.h"
+#include "lomse_pixel_formats.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+///@cond INTERNALS
+namespace lomse
+{
+///@endcond
+
+//forward declarations
+class LibraryScope;
+class Presenter;
+
+
+//---------------------------------------------------------------------------------------
+/** %BatchRenderer is a facade for rendering document pages on bitmaps without a
+    window, i.e. for generating thumbnails or previews in a server. It hides the
+    Presenter, Interactor and View objects and the printing API (see
+    @ref page-printing) used for rendering the pages.
+
+    A document is laid out only once, when the first page is rendered or when
+    information about the pages is requested, and then any page can be rendered at
+    any resolution. Pages can be rendered on a bitmap provided by your application or
+    on an internal bitmap that is reused for all pages and documents, so that no
+    memory allocations are needed once the biggest page has been rendered.
+
+    Bitmaps are always in the pixel format specified in LomseDoorway::init_library().
+    Fonts and glyph caches are owned by the library and, therefore, they are reused
+    for all documents rendered by all %BatchRenderer objects created by the same
+    LomseDoorway.
+
+    Example:
+
+    @code
+    LomseDoorway lomse;
+    lomse.init_library(k_pix_format_rgba32, 96, false);
+
+    BatchRenderer* pRenderer = lomse.create_batch_renderer();
+    for (const string& filename : filenames)
+    {
+        if (pRenderer->open_document(filename))
+            pRenderer->render_pages_to_png(filename, 150.0);
+    }
+    delete pRenderer;
+    @endcode
+
+    @see LomseDoorway::create_batch_renderer()
+*/
+class BatchRenderer
+{
+protected:
+    LibraryScope& m_libScope;
+    Presenter* m_pPresenter;
+    EPixelFormat m_format;
+    int m_compressionLevel;
+    std::vector<unsigned char> m_pool;     //memory for the internal bitmap
+    RenderingBuffer m_rbuf;                 //the internal bitmap
+
+public:
+    /** Constructor. Your application should not directly create %BatchRenderer
+        objects but use LomseDoorway::create_batch_renderer().   */
+    BatchRenderer(LibraryScope& libraryScope);
+    virtual ~BatchRenderer();
+
+    //documents
+    /// @name Documents
+    //@{
+
+    /** Load the document to render. Its content is read from a file. The document
+        format is determined by the file extension. Any previously loaded document is
+        closed.
+        @return @true if the document has been loaded.
+    */
+    bool open_document(const string& filename, ostream& reporter=cout);
+
+    /** Load the document to render. Its content is provided in a string. Any
+        previously loaded document is closed.
+        @param source A string with the content for the document.
+        @param format A value from enum Document::EFileFormat.
+        @param reporter The ostream to be used for reporting any errors.
+        @return @true if the document has been loaded.
+    */
+    bool new_document(const string& source, int format, ostream& reporter=cout);
+
+    /** Delete current document and all related objects. The internal bitmap is not
+        deleted, so that it can be reused for next document.   */
+    void close_document();
+
+    /** Returns the Presenter for current document or @nullptr if no document is
+        loaded. Ownership is not transferred.   */
+    inline Presenter* get_presenter() { return m_pPresenter; }
+
+    //@}    //Documents
+
+
+    //information about pages
+    /// @name Information about pages
+    //@{
+
+    /** Returns the number of pages in current document. If the document is not yet
+        laid out, this method will force the layout.   */
+    int get_num_pages();
+
+    /** Returns the size of page @c iPage (0..n-1), in logical units (cents of a
+        millimeter).   */
+    USize get_page_size(int iPage);
+
+    /** Returns the size (pixels) of the bitmap required for rendering page @c iPage
+        (0..n-1) at a resolution of @c dpi dots per inch.   */
+    VSize get_page_size_in_pixels(int iPage, double dpi);
+
+    //@}    //Information about pages
+
+
+    //rendering
+    /// @name Rendering
+    //@{
+
+    /** Render page @c iPage (0..n-1) on the bitmap provided by your application,
+        at a resolution of @c dpi dots per inch. The bitmap pixel format must be the
+        format specified in LomseDoorway::init_library(). If the bitmap is smaller
+        than the page size, only the top-left part of the page will be rendered.
+        @return @false if no document is loaded or the page does not exist.
+    */
+    bool render_page(int iPage, double dpi, RenderingBuffer* pBitmap);
+
+    /** Render page @c iPage (0..n-1) on the internal bitmap, at a resolution of
+        @c dpi dots per inch. The bitmap is sized to fit the page.
+        @return A pointer to the internal bitmap or @nullptr if no document is loaded,
+            the page does not exist or its size at @c dpi is zero pixels. The bitmap is owned by the %BatchRenderer and
+            its content will be overwritten when rendering another page.
+    */
+    RenderingBuffer* render_page(int iPage, double dpi);
+
+    /** Render page @c iPage (0..n-1) at a resolution of @c dpi dots per inch and
+        save it in a file, in PNG format.
+        @return @false if the page could not be rendered or the file could not be
+            saved, e.g. Lomse built without PNG support or pixel format not supported
+            by the PNG encoder. The file is not created when the page does not exist.
+    */
+    bool render_page_to_png(int iPage, double dpi, const string& filename);
+
+    /** Render page @c iPage (0..n-1) at a resolution of @c dpi dots per inch and
+        write it in PNG format on stream @c out.  */
+    bool render_page_to_png(int iPage, double dpi, ostream& out);
+
+    /** Render pages @c firstPage to @c lastPage (0..n-1) at a resolution of
+        @c dpi dots per inch and save them in PNG files. Files are named by appending
+        the page number (1..n) and the extension ".png" to the passed base name, i.e.
+        "score-1.png", "score-2.png", etc. When @c lastPage is -1 all pages from
+        @c firstPage to the end of the document will be rendered.
+        @return The number of pages saved.
+    */
+    int render_pages_to_png(const string& basename, double dpi, int firstPage=0,
+                            int lastPage=-1);
+
+    /** Set the zlib compression level for PNG files: 0 (none) to 9 (best). By default,
+        value -1, the zlib default level is used.   */
+    inline void set_png_compression_level(int level) { m_compressionLevel = level; }
+
+    //@}    //Rendering
+
+
+protected:
+    int bytes_per_pixel();
+    bool is_valid_page(int iPage);
+
+};
+
+
+}   //namespace lomse
+
+#endif      //__LOMSE_BATCH_RENDERER_H__
@@ -0,0 +1,58 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2016. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#ifndef __LOMSE_BINARY_DELTA_H__
+#define __LOMSE_BINARY_DELTA_H__
+
+#include <string>
+using namespace std;
+
+namespace lomse
+{
+
+//---------------------------------------------------------------------------------------
+// BinaryDelta: encodes a byte string as the differences with another, similar, string.
+// The delta is a sequence of 'copy' operations, for blocks found in the source string,
+// and 'insert' operations, for new bytes. It is used for storing undo checkpoints,
+// as consecutive checkpoints of a document are nearly identical.
+class BinaryDelta
+{
+public:
+    //returns the delta for obtaining 'target' from 'source'
+    static string create(const string& source, const string& target);
+
+    //returns the target string, from the delta and the source used for creating it.
+    //Throws a runtime_error exception if the delta is not valid
+    static string apply(const string& source, const string& delta);
+};
+
+
+}   //namespace lomse
+
+#endif      //__LOMSE_BINARY_DELTA_H__
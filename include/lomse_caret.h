@@ -78,6 +78,7 @@ public:
     //mandatory overrides from VisualEffect
     void on_draw(ScreenDrawer* pDrawer);
     URect get_bounds() { return m_bounds; }
+    URect get_view_bounds() { return m_viewBounds; }
 
     //caret shapes
     enum { k_top_level=0, k_box, k_line, k_block, };
@@ -50,6 +50,7 @@ namespace lomse
 class Document;
 class SelectionSet;
 class DocCommandExecuter;
+class DocCmdTransaction;
 class OverlappedNoteRest;
 
 //---------------------------------------------------------------------------------------
@@ -84,6 +85,7 @@ protected:
     string m_name;          //displayable name for undo/redo actions display
     string m_checkpoint;    //checkpoint data
     ImoId m_idChk;          //id for target object in case of partial checkpoint
+    list<ImoId> m_idsChk;   //affected objects in case of selection checkpoint
     ImoId m_idRefresh;      //id for cursor object, for k_refresh policy
     string m_error;
     uint_least16_t m_flags;
@@ -93,6 +95,8 @@ protected:
         k_recordable                    = 0x0002,
         k_target_set_in_constructor     = 0x0004,
         k_included_in_composite_cmd     = 0x0008,
+        k_checkpoint_is_delta           = 0x0010,
+        k_checkpoint_is_selection       = 0x0020,
     };
 
     DocCommand(const string& name)
@@ -125,6 +129,9 @@ public:
         k_undo_policy_full_checkpoint=0,    ///< Undo is based on a full checkpoint
         k_undo_policy_partial_checkpoint,   ///< Undo is based on a partial checkpoint
         k_undo_policy_specific,             ///< Undo is implemented by the command
+        k_undo_policy_selection_checkpoint, ///< Undo is based on a checkpoint of only the
+                                            ///< staff objects affected by the command and
+                                            ///< of their relations
     };
 
     /** Returns a value from #ECmdUndoPolicy that indicates the undo policy
@@ -176,6 +183,9 @@ public:
     /// Returns @true if the command is composite.
     virtual bool is_composite() = 0;
 
+    /// Returns @true if the command is a transaction. See DocCmdTransaction.
+    virtual bool is_transaction() { return false; }
+
 
 //excluded from public API. Only for internal use.
 ///@cond INTERNALS
@@ -198,14 +208,31 @@ public:
     virtual int set_target(Document* pDoc, DocCursor* pCursor, SelectionSet* pSelection)=0;
     virtual int perform_action(Document* pDoc, DocCursor* pCursor)=0;
     virtual void undo_action(Document* pDoc, DocCursor* pCursor);
+
+    //undo data, managed by DocCommandExecuter
+    inline bool has_checkpoint() { return !m_checkpoint.empty(); }
+    inline bool is_checkpoint_delta() { return (m_flags & k_checkpoint_is_delta) != 0; }
+    inline bool has_selection_checkpoint() {
+        return (m_flags & k_checkpoint_is_selection) != 0;
+    }
+    virtual size_t get_undo_data_size() { return m_checkpoint.size(); }
+    void store_checkpoint_as_delta(DocCommand* pNewer);
+    void restore_checkpoint_from_delta(DocCommand* pNewer);
 ///@endcond
 
 protected:
     void create_checkpoint(Document* pDoc);
+    void create_selection_checkpoint(Document* pDoc);
+    inline bool is_partial_checkpoint() {
+        //selection checkpoints fall back to a checkpoint of the score when needed
+        return get_undo_policy() == k_undo_policy_partial_checkpoint
+               || (get_undo_policy() == k_undo_policy_selection_checkpoint
+                   && m_idChk != k_no_imoid);
+    }
     void log_forensic_data(Document* pDoc, DocCursor* pCursor);
     void set_command_name(const string& name, ImoObj* pImo);
     int validate_source(const string& source);
-    virtual void log_command(ofstream &logger);
+    virtual void log_command(ostream& logger);
 
 };
 
@@ -264,6 +291,7 @@ public:
     int set_target(Document* pDoc, DocCursor* pCursor, SelectionSet* pSelection) override;
     int perform_action(Document* pDoc, DocCursor* pCursor) override;
     void undo_action(Document* pDoc, DocCursor* pCursor) override;
+    size_t get_undo_data_size() override;
 
     //operations delegated by DocCommandExecuter
     void update_cursor(DocCursor* pCursor, DocCommandExecuter* pExecuter);
@@ -279,7 +307,7 @@ protected:
 
 //---------------------------------------------------------------------------------------
 /** Class %UndoElement holds the necessary information to perform an undo/redo
-    operation.
+    operation. It owns the command.
 */
 class UndoElement
 {
@@ -294,33 +322,105 @@ public:
         : pCmd(cmd), cursorState(state), selState(sel)
     {
     }
+
+    /// Destructor. Deletes the command
+    ~UndoElement() { delete pCmd; }
+
+    //the command is owned. Copies would delete it twice
+    UndoElement(const UndoElement&) = delete;
+    UndoElement& operator=(const UndoElement&) = delete;
 };
 
 
 
+//---------------------------------------------------------------------------------------
+/** Class %DocCmdTransaction groups a sequence of commands executed by the user
+    application between DocCommandExecuter::begin_transaction() and
+    DocCommandExecuter::commit_transaction(), so that all of them are undone and redone
+    as a single command.
+
+    Contrary to DocCmdComposite, children commands are executed one after the other and
+    each one sets its target after the previous one has been executed. Only one full
+    checkpoint is saved, before executing the first command. Transactions are created
+    and managed by DocCommandExecuter.
+*/
+class DocCmdTransaction : public DocCommand
+{
+protected:
+    list<UndoElement*> m_commands;      //children and cursor/selection before them
+    DocCursorState m_finalCursor;       //cursor state after last command
+    list<ImoId> m_finalSelection;       //selection after last command
+
+public:
+    /// Constructor
+    DocCmdTransaction(const string& name);
+    /// Destructor. Deletes the children commands
+    virtual ~DocCmdTransaction();
+
+    /// Returns the number of commands included in the transaction
+    inline size_t num_commands() { return m_commands.size(); }
+
+    //overrides
+    int get_cursor_update_policy() override { return k_do_nothing; }
+    int get_undo_policy() override { return k_undo_policy_full_checkpoint; }
+    int get_selection_update_policy() override { return k_sel_do_nothing; }
+    bool is_composite() override { return false; }
+    bool is_transaction() override { return true; }
+
+    ///@cond INTERNALS
+    //mandatory interface implementation
+    int set_target(Document* pDoc, DocCursor* pCursor, SelectionSet* pSelection) override;
+    int perform_action(Document* pDoc, DocCursor* pCursor) override;
+    size_t get_undo_data_size() override;
+
+    //operations delegated by DocCommandExecuter
+    void start(Document* pDoc);
+    void add_command(UndoElement* pUE);
+    void save_final_state(DocCursor* pCursor, SelectionSet* pSelection);
+    void update_cursor(DocCursor* pCursor);
+    void update_selection(SelectionSet* pSelection);
+    ///@endcond
+
+};
+
+
 //---------------------------------------------------------------------------------------
 // Helper, to manage the undo/redo stack
 typedef UndoableStack< UndoElement* >   UndoStack;
 
 
 //---------------------------------------------------------------------------------------
-/// Keeps the stack of executed commands and performs undo/redo
+/** Keeps the stack of executed commands and performs undo/redo.
+
+    Only the checkpoint of the most recent command is stored in full. Older checkpoints
+    are stored as the differences with the next one, as consecutive checkpoints of a
+    document are nearly identical. Optionally, the memory used by checkpoints can be
+    limited, by removing the oldest commands. See set_undo_memory_limit().
+*/
 class DocCommandExecuter
 {
 private:
     Document*   m_pDoc;
     UndoStack   m_stack;
     string      m_error;
+    size_t      m_maxUndoBytes;
+    UndoElement* m_pTransactionUE;      //open transaction, or nullptr
+    int         m_transactionLevel;     //for nested begin_transaction()
 
 public:
     /// Constructor
     DocCommandExecuter(Document* target);
-    virtual ~DocCommandExecuter() {}
+    virtual ~DocCommandExecuter();
 
     /** Executes a command and saves the necessary information for undo/redo operation.
-        Returns value 0 if the command successfully executed. Otherwise returns value 1
-        and a relevant error message can be retrieved by invoking
-        method get_error().    */
+        Returns value k_success if the command successfully executed. Otherwise returns
+        value k_failure and a relevant error message can be retrieved by invoking
+        method get_error().
+
+        When a reversible command is successfully executed, it is saved for undo and
+        the %DocCommandExecuter takes its ownership. Otherwise, the command is not
+        saved and the caller keeps its ownership and must delete it.
+    */
     virtual int execute(DocCursor* pCursor, DocCommand* pCmd,
                         SelectionSet* pSelection);
 
@@ -341,10 +441,57 @@ public:
     /// Returns the number of undo/redo elements in the undo/redo stack.
     virtual size_t undo_stack_size() { return m_stack.size(); }
 
+    //memory
+    /** Sets the maximum memory, in bytes, to be used for storing the data for undo/redo
+        operations. When this limit is exceeded, the oldest commands in the undo stack
+        are removed, and it will not be possible to undo them. The most recent command
+        is never removed. Value 0 (the default) means that there is no limit.    */
+    void set_undo_memory_limit(size_t maxBytes);
+    /// Returns the maximum memory for undo/redo data. Value 0 means no limit.
+    inline size_t get_undo_memory_limit() { return m_maxUndoBytes; }
+    /// Returns the memory, in bytes, currently used by the data for undo/redo.
+    size_t get_undo_memory_used();
+
+    //transactions
+    /** Starts a transaction. All reversible commands executed until invoking
+        commit_transaction() are grouped in a single undo/redo element, and only one
+        checkpoint is saved for all of them. Calls can be nested; the transaction is
+        only closed by the commit_transaction() matching the outermost
+        begin_transaction().
+        @param pCursor, pSelection Current cursor and selection. Their state is saved
+            for restoring them when the transaction is undone.
+        @param name The displayable name for the transaction in undo/redo actions.
+
+        @remarks Invoking undo() or redo() while a transaction is open commits it.
+    */
+    void begin_transaction(DocCursor* pCursor, SelectionSet* pSelection,
+                           const string& name="Transaction");
+
+    /** Closes the transaction opened by the matching begin_transaction(). When closing
+        the outermost transaction, the executed commands are pushed in the undo stack
+        as a single element. Nothing is pushed if no command was executed.  */
+    void commit_transaction(DocCursor* pCursor, SelectionSet* pSelection);
+
+    /** Undoes all commands executed since the outermost begin_transaction() and
+        closes the transaction. Cursor and selection are restored to their state
+        when the transaction started.  */
+    void rollback_transaction(DocCursor* pCursor, SelectionSet* pSelection);
+
+    /// Returns @true if there is an open transaction.
+    inline bool is_transaction_open() { return m_pTransactionUE != nullptr; }
+
 protected:
     friend class DocCmdComposite;
     void update_cursor(DocCursor* pCursor, DocCommand* pCmd);
     void update_selection(SelectionSet* pSelection, DocCommand* pCmd);
+    DocCommand* last_command_with_checkpoint();
+    void enforce_memory_limit();
+    int execute_in_transaction(DocCursor* pCursor, DocCommand* pCmd,
+                               SelectionSet* pSelection);
+    void close_open_transaction(DocCursor* pCursor, SelectionSet* pSelection);
+    inline DocCmdTransaction* get_transaction() {
+        return static_cast<DocCmdTransaction*>(m_pTransactionUE->pCmd);
+    }
 
 };
 
@@ -424,7 +571,7 @@ public:
 
 protected:
     void update_selection(SelectionSet* pSelection);
-    void log_command(ofstream &logger);
+    void log_command(ostream& logger);
 
 };
 
@@ -535,7 +682,7 @@ protected:
 
     //overrides and mandatory virtual methods
     void set_command_name();
-    void log_command(ofstream &logger);
+    void log_command(ostream& logger);
 
 };
 
@@ -593,7 +740,7 @@ public:
     ///@endcond
 
 protected:
-    void log_command(ofstream &logger);
+    void log_command(ostream& logger);
 };
 
 //---------------------------------------------------------------------------------------
@@ -661,7 +808,7 @@ public:
     ///@endcond
 
 protected:
-    void log_command(ofstream &logger);
+    void log_command(ostream& logger);
 };
 
 //---------------------------------------------------------------------------------------
@@ -709,7 +856,7 @@ public:
     virtual ~CmdBreakBeam() {};
 
     int get_cursor_update_policy() { return k_do_nothing; }
-    int get_undo_policy() { return k_undo_policy_partial_checkpoint; }
+    int get_undo_policy() { return k_undo_policy_selection_checkpoint; }
     int get_selection_update_policy() { return k_sel_do_nothing; }
 
     ///@cond INTERNALS
@@ -718,7 +865,7 @@ public:
     ///@endcond
 
 protected:
-    void log_command(ofstream &logger);
+    void log_command(ostream& logger);
 };
 
 //---------------------------------------------------------------------------------------
@@ -776,7 +923,7 @@ public:
     ///@endcond
 
 protected:
-    void log_command(ofstream &logger);
+    void log_command(ostream& logger);
 };
 
 //---------------------------------------------------------------------------------------
@@ -1416,7 +1563,7 @@ public:
     virtual ~CmdDeleteRelation() {};
 
     int get_cursor_update_policy() { return k_do_nothing; }
-    int get_undo_policy() { return k_undo_policy_partial_checkpoint; }
+    int get_undo_policy() { return k_undo_policy_selection_checkpoint; }
     int get_selection_update_policy() { return k_sel_do_nothing; }
 
     ///@cond INTERNALS
@@ -1425,7 +1572,7 @@ public:
     ///@endcond
 
 private:
-    int set_score_id(Document* pDoc);
+    int set_checkpoint_ids(Document* pDoc);
 
 };
 
@@ -1826,7 +1973,7 @@ public:
     virtual ~CmdJoinBeam() {};
 
     int get_cursor_update_policy() { return k_do_nothing; }
-    int get_undo_policy() { return k_undo_policy_full_checkpoint; }
+    int get_undo_policy() { return k_undo_policy_selection_checkpoint; }
     int get_selection_update_policy() { return k_sel_do_nothing; }
 
     ///@cond INTERNALS
@@ -1835,7 +1982,7 @@ public:
     ///@endcond
 
 protected:
-    void log_command(ofstream &logger);
+    void log_command(ostream& logger);
 };
 
 //---------------------------------------------------------------------------------------
@@ -47,6 +47,20 @@ class ImoDocument;
 class Document;
 
 
+//---------------------------------------------------------------------------------------
+// CompilerMonitor: interface for objects that need to follow the compilation progress,
+// i.e. the DocumentLoader. The compiler informs when a new stage (a value from enum
+// EventLoad::EStage) starts, and the compilation is aborted if the monitor returns
+// false.
+class CompilerMonitor
+{
+public:
+    virtual ~CompilerMonitor() {}
+
+    virtual bool on_compiler_stage(int stage) = 0;
+};
+
+
 //---------------------------------------------------------------------------------------
 // Compiler: base class for all compilers
 class Compiler
@@ -57,12 +71,14 @@ protected:
     ModelBuilder*   m_pModelBuilder;
     Document*       m_pDoc;
     string         m_fileLocator;
+    CompilerMonitor* m_pMonitor;
 
     Compiler()
         : m_pParser(nullptr)
         , m_pAnalyser(nullptr)
         , m_pModelBuilder(nullptr)
         , m_pDoc(nullptr)
+        , m_pMonitor(nullptr)
     {
     }
     Compiler(Parser* p, Analyser* a, ModelBuilder* mb, Document* pDoc);
@@ -78,6 +94,12 @@ public:
     int get_num_errors();
     string get_file_locator() { return m_fileLocator; }
 
+    //progress
+    inline void set_monitor(CompilerMonitor* pMonitor) { m_pMonitor = pMonitor; }
+
+protected:
+    bool continue_with(int stage);
+
 };
 
 
@@ -0,0 +1,294 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#ifndef __LOMSE_DISPLAY_LIST_DRAWER_H__        //to avoid nested includes
+#define __LOMSE_DISPLAY_LIST_DRAWER_H__
+
+#include "lomse_drawer.h"
+
+#include <string>
+#include <vector>
+using namespace std;
+
+///@cond INTERNALS
+namespace lomse
+{
+///@endcond
+
+//forward declarations
+class GraphicModel;
+
+
+//---------------------------------------------------------------------------------------
+// DisplayList: the drawing commands for one page, recorded by a DisplayListDrawer,
+// stored in a compact and flat format so that they can be replayed on any Drawer.
+//
+// Commands are stored as a sequence of opcodes. Their numeric arguments are stored, in
+// order, in a separate vector of doubles; strings and bitmaps are stored in tables
+// and referenced by index. Coordinates are recorded in page coordinates (LUnits), so
+// that the list can be replayed with any viewport and transform.
+//
+// Bitmaps are not copied: the list keeps references to the bitmaps owned by the
+// document images. Therefore, a display list is only valid while the document from
+// which it was recorded exists and the graphic model has not been rebuilt.
+//
+class DisplayList
+{
+public:
+    //opcodes
+    enum EOpcode
+    {
+        k_op_begin_path = 0,
+        k_op_end_path,
+        k_op_close_subpath,
+        k_op_move_to,
+        k_op_move_to_rel,
+        k_op_line_to,
+        k_op_line_to_rel,
+        k_op_hline_to,
+        k_op_hline_to_rel,
+        k_op_vline_to,
+        k_op_vline_to_rel,
+        k_op_cubic_bezier,
+        k_op_cubic_bezier_rel,
+        k_op_cubic_bezier_short,
+        k_op_cubic_bezier_short_rel,
+        k_op_quadratic_bezier,
+        k_op_quadratic_bezier_rel,
+        k_op_quadratic_bezier_short,
+        k_op_quadratic_bezier_short_rel,
+        k_op_rect,
+        k_op_circle,
+        k_op_line,
+        k_op_polygon,
+        k_op_add_path,
+        k_op_select_font,
+        k_op_select_raster_font,
+        k_op_select_vector_font,
+        k_op_set_text_color,
+        k_op_draw_text,
+        k_op_draw_wtext,
+        k_op_draw_glyph,
+        k_op_copy_bitmap,
+        k_op_copy_bitmap_area,
+        k_op_draw_bitmap,
+        k_op_line_with_markers,
+        k_op_fill,
+        k_op_stroke,
+        k_op_even_odd,
+        k_op_stroke_width,
+        k_op_fill_none,
+        k_op_stroke_none,
+        k_op_fill_opacity,
+        k_op_stroke_opacity,
+        k_op_line_join,
+        k_op_line_cap,
+        k_op_miter_limit,
+        k_op_fill_linear_gradient,
+        k_op_gradient_color2,
+        k_op_gradient_color,
+        k_op_set_shift,
+        k_op_remove_shift,
+        k_op_render,
+    };
+
+protected:
+    std::vector<unsigned char> m_ops;
+    std::vector<double> m_args;
+    std::vector<std::string> m_strings;
+    std::vector<std::wstring> m_wstrings;
+    std::vector<RenderingBuffer> m_bitmaps;
+
+    friend class DisplayListDrawer;
+
+public:
+    DisplayList() {}
+    ~DisplayList() {}
+
+    /** Re-issue all recorded commands on Drawer @c pDrawer. The page is drawn with its
+        top-left corner at @c origin (LUnits), as GraphicModel::draw_page() does.
+        Viewport and transform are not changed: the caller is responsible for
+        setting them in the drawer before invoking this method.  */
+    void replay(Drawer* pDrawer, UPoint origin=UPoint(0.0f, 0.0f));
+
+    void clear();
+    inline bool is_empty() const { return m_ops.empty(); }
+    inline size_t get_num_commands() const { return m_ops.size(); }
+
+    /** Approximate memory used by the recorded commands, in bytes.  */
+    size_t get_memory_size() const;
+
+protected:
+    //recording helpers
+    inline void add_op(EOpcode op) { m_ops.push_back(static_cast<unsigned char>(op)); }
+    inline void add_arg(double value) { m_args.push_back(value); }
+    void add_color(Color color);
+    size_t add_string(const std::string& str);
+    size_t add_wstring(const std::wstring& str);
+    size_t add_bitmap(RenderingBuffer& bmap);
+
+};
+
+
+//---------------------------------------------------------------------------------------
+// DisplayListDrawer: a Drawer that does not render anything but records all drawing
+// commands in a DisplayList.
+//
+// Recording a page traverses the graphic model once. Then, the page can be drawn again,
+// with any viewport, scale or other transform, by replaying the list on a ScreenDrawer,
+// i.e. for zooming or scrolling, without having to traverse again the graphic model.
+// The list can also be replayed on other drawers, i.e. for exporting the page.
+//
+class DisplayListDrawer : public Drawer
+{
+protected:
+    DisplayList* m_pList;
+
+public:
+    DisplayListDrawer(LibraryScope& libraryScope);
+    virtual ~DisplayListDrawer() {}
+
+    //recording control
+    /** Start recording commands on display list @c pList. Ownership is not
+        transferred. Commands are appended to any existing content in the list. */
+    inline void start_recording(DisplayList* pList) { m_pList = pList; }
+    inline void stop_recording() { m_pList = nullptr; }
+    inline bool is_recording() const { return m_pList != nullptr; }
+
+    /** Create a new DisplayList with the commands for drawing page @c iPage
+        (0..n-1) of the graphic model. Ownership of the returned list is transferred
+        to the caller.  */
+    DisplayList* record_page(GraphicModel* pGModel, int iPage, RenderOptions& opt);
+
+    // SVG path commands
+    void begin_path() override;
+    void end_path() override;
+    void close_subpath() override;
+    void move_to(double x, double y) override;
+    void move_to_rel(double x, double y) override;
+    void line_to(double x,  double y) override;
+    void line_to_rel(double x,  double y) override;
+    void hline_to(double x) override;
+    void hline_to_rel(double x) override;
+    void vline_to(double y) override;
+    void vline_to_rel(double y) override;
+    void cubic_bezier(double x1, double y1, double x, double y) override;
+    void cubic_bezier_rel(double x1, double y1, double x, double y) override;
+    void cubic_bezier(double x, double y) override;
+    void cubic_bezier_rel(double x, double y) override;
+    void quadratic_bezier(double x1, double y1, double x2, double y2,
+                          double x, double y) override;
+    void quadratic_bezier_rel(double x1, double y1, double x2, double y2,
+                              double x, double y) override;
+    void quadratic_bezier(double x2, double y2, double x, double y) override;
+    void quadratic_bezier_rel(double x2, double y2, double x, double y) override;
+
+    // SVG basic shapes commands
+    void rect(UPoint pos, USize size, LUnits radius) override;
+    void circle(LUnits xCenter, LUnits yCenter, LUnits radius) override;
+    void line(LUnits x1, LUnits y1, LUnits x2, LUnits y2,
+              LUnits width, ELineEdge nEdge=k_edge_normal) override;
+    void polygon(int n, UPoint points[]) override;
+
+    // not the same but similar to SVG path command
+    void add_path(VertexSource& vs, unsigned path_id = 0, bool solid_path = true) override;
+
+    // current font
+    bool select_font(const std::string& language,
+                     const std::string& fontFile,
+                     const std::string& fontName, double height,
+                     bool fBold=false, bool fItalic=false) override;
+    bool select_raster_font(const std::string& language,
+                            const std::string& fontFile,
+                            const std::string& fontName, double height,
+                            bool fBold=false, bool fItalic=false) override;
+    bool select_vector_font(const std::string& language,
+                            const std::string& fontFile,
+                            const std::string& fontName, double height,
+                            bool fBold=false, bool fItalic=false) override;
+
+    // text
+    void set_text_color(Color color) override;
+    int draw_text(double x, double y, const std::string& str) override;
+    int draw_text(double x, double y, const wstring& str) override;
+    void draw_glyph(double x, double y, unsigned int ch) override;
+
+    //bitmaps
+    void copy_bitmap(RenderingBuffer& img, UPoint pos) override;
+    void copy_bitmap(RenderingBuffer& bmap,
+                     Pixels srcX1, Pixels srcY1, Pixels srcX2, Pixels srcY2,
+                     UPoint dest) override;
+    void draw_bitmap(RenderingBuffer& bmap, bool hasAlpha,
+                     Pixels srcX1, Pixels srcY1, Pixels srcX2, Pixels srcY2,
+                     LUnits dstX1, LUnits dstY1, LUnits dstX2, LUnits dstY2,
+                     EResamplingQuality resamplingMode,
+                     double alpha=1.0) override;
+
+    //SVG line with start/end markers
+    void line_with_markers(UPoint start, UPoint end, LUnits width,
+                           ELineCap startCap, ELineCap endCap) override;
+
+    // Attribute setting functions.
+    void fill(Color color) override;
+    void stroke(Color color) override;
+    void even_odd(bool flag) override;
+    void stroke_width(double w) override;
+    void fill_none() override;
+    void stroke_none() override;
+    void fill_opacity(unsigned op) override;
+    void stroke_opacity(unsigned op) override;
+    void line_join(line_join_e join) override;
+    void line_cap(line_cap_e cap) override;
+    void miter_limit(double ml) override;
+    void fill_linear_gradient(LUnits x1, LUnits y1, LUnits x2, LUnits y2) override;
+    void gradient_color(Color c1, Color c2, double start, double stop) override;
+    void gradient_color(Color c1, double start, double stop) override;
+
+    // settings
+    void set_shift(LUnits x, LUnits y) override;
+    void remove_shift() override;
+    void render() override;
+
+protected:
+    void record(DisplayList::EOpcode op);
+    void record(DisplayList::EOpcode op, double a1);
+    void record(DisplayList::EOpcode op, double a1, double a2);
+    void record(DisplayList::EOpcode op, double a1, double a2, double a3, double a4);
+    void record(DisplayList::EOpcode op, double a1, double a2, double a3, double a4,
+                double a5, double a6);
+    void record_font(DisplayList::EOpcode op, const std::string& language,
+                     const std::string& fontFile, const std::string& fontName,
+                     double height, bool fBold, bool fItalic);
+
+};
+
+
+}   //namespace lomse
+
+#endif    // __LOMSE_DISPLAY_LIST_DRAWER_H__
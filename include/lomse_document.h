@@ -39,6 +39,10 @@
 #include "lomse_reader.h"
 
 #include <sstream>
+#include <climits>
+#include <map>
+#include <set>
+#include <vector>
 using namespace std;
 
 ///@cond INTERNALS
@@ -50,6 +54,7 @@ namespace lomse
 class DocCommand;
 class DocCommandExecuter;
 class Compiler;
+class CompilerMonitor;
 class IdAssigner;
 class Interactor;
 class ImoDocument;
@@ -108,6 +113,112 @@ enum EBeatDuration
 };
 
 
+//---------------------------------------------------------------------------------------
+/** %DocChangeSet describes the parts of a Document modified since the Document was
+    last notified as modified, so that views, the player and other caches can update
+    only what has changed. It is carried by the EventDoc events of type
+    <tt>k_doc_modified_event</tt> (see EventDoc::get_change_set()).
+
+    Changes are recorded at several levels: the top-level items (the scores,
+    paragraphs, etc. in the document content) containing modified objects, and, for
+    modified scores, the instruments and the range of measures containing the
+    modified staff objects.
+
+    Information is always conservative. When items are added to or removed from the
+    document content, or when the modified objects are not inside a top-level item,
+    the whole document is considered changed (is_all_changed() returns @true). And,
+    when the modified measures can not be determined, i.e. when instruments are added
+    to a score, all the measures are considered changed.
+
+    Measures are numbered 0..n-1, as in the staffobjs table.
+*/
+class DocChangeSet
+{
+public:
+    /// Value for last measure meaning that all measures after the first one changed
+    enum { k_end_of_score = INT_MAX };
+
+protected:
+    //a modified staff object, pending to determine its measure
+    struct StaffObjChange
+    {
+        ImoId id;           //the modified staff object
+        ImoId prevId;       //previous staff object. Used when the object is deleted
+        bool fBarline;      //measures after it could be renumbered
+    };
+
+    struct ScoreChanges
+    {
+        bool fWholeScore;
+        set<int> instruments;
+        int firstMeasure;
+        int lastMeasure;
+        map<int, vector<StaffObjChange> > pending;    //key: instrument
+
+        ScoreChanges() : fWholeScore(false), firstMeasure(INT_MAX), lastMeasure(-1) {}
+    };
+
+    bool m_fAll;
+    set<ImoId> m_items;
+    map<ImoId, ScoreChanges> m_scores;
+
+public:
+    DocChangeSet() : m_fAll(false) {}
+    ~DocChangeSet() {}
+
+    /** Returns @true if the whole document must be considered changed.    */
+    inline bool is_all_changed() const { return m_fAll; }
+
+    /** Returns @true if there are no changes.    */
+    inline bool is_empty() const { return !m_fAll && m_items.empty(); }
+
+    /** Returns the ids of the modified top-level items. If is_all_changed() returns
+        @true this information is not valid, as all items could have changed.    */
+    inline const set<ImoId>& get_changed_items() const { return m_items; }
+
+    /** Returns @true if the top-level item with the given id has been modified.    */
+    bool is_item_changed(ImoId id) const;
+
+    /** Returns the ids of the modified scores. If is_all_changed() returns @true this
+        information is not valid, as all scores could have changed.    */
+    list<ImoId> get_changed_scores() const;
+
+    /** Returns @true if the score with the given id has been modified.    */
+    bool is_score_changed(ImoId scoreId) const;
+
+    /** Returns @true if the instrument iInstr (0..n-1) of the score with the given id
+        has been modified.    */
+    bool is_instrument_changed(ImoId scoreId, int iInstr) const;
+
+    /** Gets the range of modified measures in the score with the given id. Returns
+        @false if the score has not been modified. The last measure is
+        DocChangeSet::k_end_of_score when all measures after the first one could
+        have changed.    */
+    bool get_changed_measures(ImoId scoreId, int* pFirst, int* pLast) const;
+
+///@cond INTERNALS
+//excluded from public API. Only for internal use.
+
+    void add_change(ImoObj* pImo);
+    inline void set_all_changed() { m_fAll = true; m_items.clear(); m_scores.clear(); }
+    inline void clear() { m_fAll = false; m_items.clear(); m_scores.clear(); }
+    void resolve_measures(Document* pDoc);
+
+protected:
+    void resolve_instrument(ScoreChanges& changes, ImoInstrument* pInstr,
+                            vector<StaffObjChange>& objects);
+    void add_measures(ScoreChanges& changes, int first, int last);
+
+///@endcond
+};
+
+/** A shared pointer for a DocChangeSet.
+    @ingroup typedefs
+    @#include <lomse_document.h>
+*/
+typedef std::shared_ptr<DocChangeSet>  SpDocChangeSet;
+
+
 //------------------------------------------------------------------------------------
 /** The %Document class is a facade object that contains, basically, the @IM, a model
     similar to the DOM in HTML. By accessing and modifying this internal model you
@@ -155,6 +266,10 @@ protected:
     int             m_modified;
     int             m_beatType;
     TimeUnits       m_beatDuration;
+    unsigned int    m_changes;          //changes counter, never decremented
+    unsigned int    m_snapshotChanges;  //value of m_changes when last snapshot taken
+    std::weak_ptr<Document> m_wpSnapshot;   //last shared snapshot, while in use
+    DocChangeSet    m_changeSet;        //changes since last clear_dirty()
 
 public:
     /// Constructor
@@ -164,6 +279,7 @@ public:
     ///Values for flags
     enum EDocumentFlags {
         k_dirty             = 0x0001,   ///< dirty: modified since last "clear_dirty()" ==> need to rebuild GModel
+        k_snapshot          = 0x0002,   ///< read-only snapshot of other document. See get_snapshot()
     };
 
     ///Supported file formats
@@ -194,8 +310,11 @@ public:
             document with a valid empty internal model.
         - Errors detected while parsing the file are reported to the reporter object
             defined in %Document constructor. By default, to `cout` stream.
+        - Parameter `pMonitor` is for internal use. It is used by the DocumentLoader
+            to follow the loading progress and to cancel it.
     */
-    int from_file(const string& filename, int format=k_format_ldp);
+    int from_file(const string& filename, int format=k_format_ldp,
+                  CompilerMonitor* pMonitor=nullptr);
 
     /** Add content to an uninitialized %Document (a %Document created by just invoking
         the %Document constructor) by parsing the passed string.
@@ -582,8 +701,8 @@ public:
 
         <b>Remarks</b>
         - This method is intended to add support, in future, for <i>write protected</i>
-        documents. But for now all documents are editable and this method always
-        returns @true.
+        documents. For now, all documents are editable except snapshots created by
+        get_snapshot().
     */
     bool is_editable();
 
@@ -628,12 +747,54 @@ public:
         method after finishing the modifications.
 
         Edition commands and low level edition API methods do not invoke it.
+
+        The event carries a DocChangeSet with the changes done since the previous
+        notification, so that observers can update only what has changed.
     */
     void notify_if_document_modified();
 
     //@}    //Miscellaneous methods
 
 
+    /// @name Snapshots for concurrent readers
+    //@{
+
+    /** Returns an immutable copy of this %Document, for processing it in other
+        threads (i.e. rendering thumbnails, exporting, or computing the sound events
+        table) while the user continues editing this %Document. The snapshot does not
+        share any object with this %Document, so it is not affected by further
+        changes, and it is deleted when the last shared pointer to it is released.
+
+        The snapshot is a cached full copy, not a structural sharing one: while this
+        %Document is not modified, all invocations return the same snapshot, as long
+        as it is still in use, but after any change the whole %Document is copied
+        again. The copy is done through a checkpoint and its cost is proportional to
+        the %Document size (about 35 ms per 1000 measures of a piano score), so avoid
+        requesting a new snapshot after each edition.
+
+        @param fShared  When @false, a new private copy is always created. Use it when
+            several threads will do, at the same time, operations that build computed
+            data on the snapshot, such as layout or the sound events table.
+
+        <b>Remarks</b>
+        - This method must be invoked in the thread that modifies the %Document.
+        - Snapshots are not editable (is_editable() returns @false) and must not be
+            modified.
+    */
+    std::shared_ptr<Document> get_snapshot(bool fShared=true);
+
+    /** Returns @true if this %Document is a snapshot created by get_snapshot().    */
+    inline bool is_snapshot() { return (m_flags & k_snapshot) != 0; }
+
+    /** Returns a counter that is incremented each time the %Document is modified.
+        It is never decremented, not even when a modification is undone, so it can
+        be used for knowing if the %Document has changed since a previous moment.
+    */
+    inline unsigned int get_changes_counter() { return m_changes; }
+
+    //@}    //Snapshots for concurrent readers
+
+
 
 
 ///@cond INTERNALS
@@ -654,9 +815,14 @@ public:
 
     //TODO: public to be used by exercises (reconfigure buttons), To be changed to
     //protected as soon as buttons changed to controls
-    inline void set_dirty() { m_flags |= k_dirty; }
+    inline void set_dirty() { m_flags |= k_dirty; ++m_changes; m_changeSet.set_all_changed(); }
+    void set_dirty(ImoObj* pModified);
+
+    void clear_dirty();
 
-    inline void clear_dirty() { m_flags &= ~k_dirty; }
+    /** Returns the changes done since the document was last notified as modified.
+        See notify_if_document_modified().    */
+    inline const DocChangeSet& get_change_set() { return m_changeSet; }
 
         //events
     /** Mandatory override from Observable. Returns the EventNotifier associated to
@@ -676,12 +842,15 @@ public:
     int replace_object_from_checkpoint_data(ImoId id, const string& data);
     string get_checkpoint_data();
     string get_checkpoint_data_for(ImoId id);
+    string get_checkpoint_source_for(ImoId id);
+    string get_checkpoint_data_for_objects(const list<ImoId>& ids);
+    int replace_objects_from_checkpoint_data(const string& data);
 
     //modified since last 'save to file' operation
     inline void clear_modified() { m_modified = 0; }
     inline bool is_modified() { return m_modified > 0; }
-    inline void set_modified() { ++m_modified; }
-    inline void reset_modified() { if (m_modified > 0) --m_modified; }
+    inline void set_modified() { ++m_modified; ++m_changes; }
+    inline void reset_modified() { if (m_modified > 0) --m_modified; ++m_changes; }
 
     //debug
     string dump_ids() const;
@@ -699,6 +868,7 @@ protected:
     void initialize();
     Compiler* get_compiler_for_format(int format);
     void fix_malformed_musicxml();
+    void update_midi_tables();
 
     friend class ImFactory;
     void assign_id(ImoObj* pImo);
@@ -0,0 +1,173 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2016. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#ifndef __LOMSE_DOCUMENT_LOADER_H__
+#define __LOMSE_DOCUMENT_LOADER_H__
+
+#include "lomse_events.h"
+#include "lomse_compiler.h"
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+using namespace std;
+
+///@cond INTERNALS
+namespace lomse
+{
+///@endcond
+
+//forward declarations
+class LibraryScope;
+class Document;
+class Presenter;
+
+
+//---------------------------------------------------------------------------------------
+/** %DocumentLoader opens a document in a background thread, so that opening big files
+    does not freeze the user interface. The file is parsed, analysed and the internal
+    model is built in the loader thread, and an EventLoad event is generated when each
+    stage starts and when the loading finishes. Events are delivered through the
+    library events dispatcher, the same as any other event generated by an Observable
+    object.
+
+    When the loading finishes with success, invoke get_presenter() for obtaining the
+    Presenter for the document. The Presenter, the View and the Interactor are created
+    in the thread invoking get_presenter(), normally the application main thread, and
+    the document layout will be done there, as usual, when the View is rendered.
+
+    Example:
+
+    @code
+    DocumentLoader* pLoader = lomse.create_document_loader(k_view_vertical_book,
+                                                           filename);
+    pLoader->add_event_handler(k_load_progress_event, this, wrapper_on_load_event);
+    pLoader->add_event_handler(k_load_end_event, this, wrapper_on_load_event);
+    pLoader->start();
+    ...
+
+    void MyFrame::on_load_end(SpEventLoad pEv)     //in the main thread
+    {
+        DocumentLoader* pLoader = pEv->get_loader();
+        if (pEv->is_ready())
+            m_pPresenter = pLoader->get_presenter();
+        delete pLoader;
+    }
+    @endcode
+
+    @attention Event handlers must be registered before invoking start(). They are
+        invoked from the loader thread. Therefore, do not retain control: generate an
+        application event, place it on the application events loop, and return
+        control to Lomse.
+*/
+class DocumentLoader : public EventNotifier
+                     , public Observable
+                     , public CompilerMonitor
+{
+protected:
+    LibraryScope&   m_libScope;
+    int             m_viewType;
+    string          m_filename;
+    ostream&        m_reporter;
+
+    std::thread*    m_pThread;
+    std::mutex      m_mutex;
+    std::atomic<bool> m_fCancel;
+    std::atomic<int> m_stage;
+    Document*       m_pDoc;         //loaded document, until get_presenter() is invoked
+    int             m_numErrors;
+
+public:
+    /** Destructor. If the loading is in progress it is cancelled and the destructor
+        waits for the loader thread to finish. */
+    virtual ~DocumentLoader();
+
+    /** Starts loading the document in a new thread. This method returns immediately.
+        Invoking it more than once has no effect.    */
+    void start();
+
+    /** Requests to cancel the loading. The loading is aborted as soon as the current
+        stage finishes and then a <tt>k_load_end_event</tt> is generated, with stage
+        <tt>EventLoad::k_stage_cancelled</tt>. This method does nothing if the
+        document is already loaded.    */
+    void cancel();
+
+    /** Blocks the calling thread until the loading finishes. Do not invoke it from an
+        event handler.    */
+    void wait();
+
+    /** Returns the Presenter for the loaded document, or @nullptr if the document is
+        not yet loaded, if loading was cancelled or failed, or if this method was
+        already invoked. The Presenter is created in the calling thread.
+
+        @attention As Presenter ownership is transferred to user application, you have
+            to take care of deleting the Presenter when no longer needed.
+    */
+    Presenter* get_presenter();
+
+    /// Returns the current stage, a value from enum EventLoad::EStage
+    inline int get_stage() { return m_stage; }
+
+    /// Returns @true if the loading has finished, successfully or not.
+    inline bool is_finished() { return m_stage >= EventLoad::k_stage_ready; }
+
+    /** Returns the number of errors found while parsing the document. Only
+        meaningful after loading finished.    */
+    inline int get_num_errors() { return m_numErrors; }
+
+    /// Returns the name of the file being loaded
+    inline const string& get_filename() { return m_filename; }
+
+    //mandatory overrides from Observable
+    EventNotifier* get_event_notifier() { return this; }
+
+///@cond INTERNALS
+//excluded from public API. Only for internal use.
+
+    DocumentLoader(LibraryScope& libraryScope, int viewType, const string& filename,
+                   ostream& reporter=cout);
+
+    //mandatory override from CompilerMonitor. Invoked in the loader thread
+    bool on_compiler_stage(int stage);
+
+protected:
+    void thread_main();
+    void terminate_thread();
+    bool is_loader_thread();
+    void notify_stage(EEventType type, int stage, int numErrors=0);
+
+///@endcond
+};
+
+
+}   //namespace lomse
+
+#endif      //__LOMSE_DOCUMENT_LOADER_H__
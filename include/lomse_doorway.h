@@ -60,6 +60,9 @@ class ScorePlayer;
 class MidiServerBase;
 class Metronome;
 class MusicXmlOptions;
+class BatchRenderer;
+class MidiFileRenderer;
+class DocumentLoader;
 
 
 
@@ -251,6 +254,22 @@ public:
 	*/
     void set_default_fonts_path(const string& fontsPath);
 
+	/** Method enable_events_thread() selects how Lomse delivers events to your
+        application. By default, events are delivered synchronously, in the thread
+        that generates them. When the events thread is enabled, events are enqueued
+        and delivered by a Lomse thread and, while they are waiting, pending
+        @c k_update_window_event events for the same View are merged into a single
+        event. Your event handlers will then be invoked from the Lomse events
+        thread and must not delete the LomseDoorway object.
+
+        This method should be invoked after init_library() and before creating
+        any document.
+
+        @param fValue   @true for delivering events from the Lomse events thread, or
+            @false for direct delivery.
+	*/
+    void enable_events_thread(bool fValue=true);
+
     //playback related
 	/** This method is used for informing Lomse about the metronome control to use to
         determine tempo in playback.
@@ -366,6 +385,55 @@ public:
     Presenter* open_document(int viewType, LdpReader& reader,
                              ostream& reporter = cout);
 
+	/** Creates a DocumentLoader, for opening a document in a background thread so that
+        your application user interface is not blocked while big files are being
+        loaded. Loading starts when DocumentLoader::start() is invoked, and progress is
+        informed by EventLoad events. When the document is loaded, the Presenter is
+        obtained by invoking DocumentLoader::get_presenter().
+
+        @param viewType   A value from enum EViewType, for the View to create for the
+            document.
+        @param filename   The full path of the file to open.
+        @param reporter   An output stream for reporting parsing errors. By default,
+            all errors will be send to cout.
+
+        @return A pointer to the created DocumentLoader.
+
+        @attention As DocumentLoader ownership is transferred to user application, you
+            have to take care of deleting it when no longer needed. Deleting it does
+            not delete the Presenter obtained from it.
+	*/
+    DocumentLoader* create_document_loader(int viewType, const std::string& filename,
+                                           ostream& reporter = cout);
+
+    //headless rendering
+	/** Creates a BatchRenderer, for rendering document pages on bitmaps or PNG files
+        without having to create a View or a window. It is oriented to generate
+        thumbnails and previews, i.e. in a server.
+
+        All BatchRenderer objects share the fonts and caches owned by the library.
+        Therefore, for rendering many documents it is better to reuse the same
+        BatchRenderer object or to create all of them from the same LomseDoorway.
+
+        @return A pointer to the created BatchRenderer.
+
+        @attention As BatchRenderer ownership is transferred to user application, you
+            have to take care of deleting it when no longer needed.
+
+        @see @ref page-printing
+	*/
+    BatchRenderer* create_batch_renderer();
+
+	/** Creates a MidiFileRenderer, for converting scores into Standard MIDI Files
+        without real time playback.
+
+        @return A pointer to the created MidiFileRenderer.
+
+        @attention As MidiFileRenderer ownership is transferred to user application, you
+            have to take care of deleting it when no longer needed.
+	*/
+    MidiFileRenderer* create_midi_file_renderer();
+
     //access to global objects
 
 	/** Get the pointer to an object of class LibraryScope. This object gives access to
@@ -60,6 +60,11 @@ typedef std::weak_ptr<Interactor>     WpInteractor;
 class Document;
 typedef std::weak_ptr<Document>       WpDocument;
 
+class DocumentLoader;
+
+class DocChangeSet;
+typedef std::shared_ptr<DocChangeSet> SpDocChangeSet;
+
 
 //observer pattern
 class EventNotifier;
@@ -112,6 +117,9 @@ enum EEventType
         //EventEndOfPlayback
         k_end_of_playback_event,        ///< Playback ended.
 
+    //EventLoad
+        k_load_progress_event,          ///< Background loading entered a new stage
+        k_load_end_event,               ///< Background loading finished or cancelled
 
 };
 
@@ -157,6 +165,8 @@ public:
     inline bool is_tracking_event() { return m_type == k_tracking_event; }
     inline bool is_update_viewport_event() { return m_type == k_update_viewport_event; }
     inline bool is_end_of_playback_event() { return m_type == k_end_of_playback_event; }
+    inline bool is_load_progress_event() { return m_type == k_load_progress_event; }
+    inline bool is_load_end_event() { return m_type == k_load_end_event; }
     //@}
 
 protected:
@@ -188,18 +198,24 @@ typedef std::shared_ptr<EventInfo>  SpEventInfo;
     You can always check if a Document has been modified by invoking method
     Document::is_dirty().
 
+    The event carries a DocChangeSet describing the modified parts of the Document,
+    so that your application can update only what has changed.
+
     See @ref handling-events
 */
 class EventDoc : public EventInfo
 {
 protected:
    Document* m_pDoc;
+   SpDocChangeSet m_spChanges;
 
 public:
     /// Constructor
-    EventDoc(EEventType type, Document* pDoc)
+    EventDoc(EEventType type, Document* pDoc,
+             SpDocChangeSet spChanges=SpDocChangeSet())
         : EventInfo(type)
         , m_pDoc(pDoc)
+        , m_spChanges(spChanges)
     {
     }
     /// Destructor
@@ -207,6 +223,10 @@ public:
 
     ///Returns a ptr. to the Document object in which the event is generated.
     inline Document* get_document() { return m_pDoc; }
+
+    /** Returns the description of the changes done in the Document, or an empty
+        shared pointer if not available.    */
+    inline SpDocChangeSet get_change_set() { return m_spChanges; }
 };
 
 /** A shared pointer for an EventDoc.
@@ -290,20 +310,25 @@ class EventPaint : public EventInfo
 protected:
     WpInteractor m_wpInteractor;
     VRect m_damagedRectangle;
+    bool m_fWholeWindow;
 
-    EventPaint(EEventType type, WpInteractor wpInteractor, VRect damagedRectangle)
+    EventPaint(EEventType type, WpInteractor wpInteractor, VRect damagedRectangle,
+               bool fWholeWindow=false)
         : EventInfo(type)
         , m_wpInteractor(wpInteractor)
         , m_damagedRectangle(damagedRectangle)
+        , m_fWholeWindow(fWholeWindow)
     {
     }
 
 public:
     /// Constructor
-    EventPaint(WpInteractor wpInteractor, VRect damagedRectangle)
+    EventPaint(WpInteractor wpInteractor, VRect damagedRectangle,
+               bool fWholeWindow=false)
         : EventInfo(k_update_window_event)
         , m_wpInteractor(wpInteractor)
         , m_damagedRectangle(damagedRectangle)
+        , m_fWholeWindow(fWholeWindow)
     {
     }
     /// Destructor
@@ -313,8 +338,29 @@ public:
         View in which the event is generated. */
     inline WpInteractor get_interactor() { return m_wpInteractor; }
 
-    /** Returns the damaged rectangle, that is, the rectangle that needs repaint. */
+    /** Returns the damaged rectangle, that is, the rectangle that needs repaint.
+        When the whole window must be repainted it is an empty rectangle. */
     inline VRect get_damaged_rectangle() { return m_damagedRectangle; }
+
+    /** Returns @true when the whole window must be repainted. */
+    inline bool is_whole_window() { return m_fWholeWindow; }
+
+///@cond INTERNAL
+    //used when merging pending paint events
+    inline void merge(EventPaint* pEvent)
+    {
+        if (m_fWholeWindow)
+            return;
+
+        if (pEvent->is_whole_window())
+        {
+            m_fWholeWindow = true;
+            m_damagedRectangle = VRect(0, 0, 0, 0);
+        }
+        else
+            m_damagedRectangle.Union( pEvent->get_damaged_rectangle() );
+    }
+///@endcond
 };
 
 /** A shared pointer for an EventPaint.
@@ -1295,6 +1341,72 @@ public:
 typedef std::shared_ptr<EventControlPointMoved>  SpEventControlPointMoved;
 
 
+//---------------------------------------------------------------------------------------
+// EventLoad
+/** An event generated by a DocumentLoader object to inform about the progress of a
+    background document loading. There are two types of %EventLoad events:
+
+    - <tt>k_load_progress_event</tt> is generated each time the loader enters a new
+        stage: parsing the file, analysing the parsed tree and building the internal
+        model.
+    - <tt>k_load_end_event</tt> is generated once, when the loading finishes. Method
+        get_stage() informs about the result: <tt>EventLoad::k_stage_ready</tt>, when
+        the document is ready and the Presenter can be obtained by invoking
+        DocumentLoader::get_presenter(); <tt>EventLoad::k_stage_cancelled</tt>, when
+        the loading was cancelled by invoking DocumentLoader::cancel(), or
+        <tt>EventLoad::k_stage_failed</tt> when an unrecoverable error was found.
+
+	@warning These events are sent to your application from the loader thread.
+			 For processing them, do not retain control: generate an application
+			 event, place it on the application events loop, and return control to Lomse.
+*/
+class EventLoad : public EventInfo
+{
+public:
+    /// Stages of the loading process. They are reported in this order.
+    enum EStage
+    {
+        k_stage_parsing = 0,        ///< Reading and parsing the file
+        k_stage_analysing,          ///< Analysing the parsed tree
+        k_stage_building_model,     ///< Building the internal model
+        k_stage_ready,              ///< Document loaded. The Presenter can be obtained
+        k_stage_cancelled,          ///< Loading cancelled. There is no document
+        k_stage_failed,             ///< Loading failed. There is no document
+    };
+
+protected:
+    DocumentLoader* m_pLoader;
+    int m_stage;
+    int m_numErrors;
+
+public:
+    /// Constructor
+    EventLoad(EEventType evType, DocumentLoader* pLoader, int stage, int numErrors=0)
+        : EventInfo(evType)
+        , m_pLoader(pLoader)
+        , m_stage(stage)
+        , m_numErrors(numErrors)
+    {
+    }
+
+    // accessors
+    /// Returns a ptr. to the DocumentLoader object that generated the event
+    inline DocumentLoader* get_loader() const { return m_pLoader; }
+    /// Returns the stage, a value from enum EventLoad::EStage
+    inline int get_stage() const { return m_stage; }
+    /// Returns the number of errors found while parsing. Only meaningful when ready
+    inline int get_num_errors() const { return m_numErrors; }
+    /// Returns @true if the document is loaded and the Presenter can be obtained
+    inline bool is_ready() const { return m_stage == k_stage_ready; }
+};
+
+/** A shared pointer for an EventLoad.
+    @ingroup typedefs
+    @#include <lomse_events.h>
+*/
+typedef std::shared_ptr<EventLoad>  SpEventLoad;
+
+
 //=======================================================================================
 // Requests
 //=======================================================================================
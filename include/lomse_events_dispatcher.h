@@ -36,7 +36,8 @@
 
 #include <thread>
 #include <mutex>
-#include <queue>
+#include <condition_variable>
+#include <deque>
 using namespace std;
 
 namespace lomse
@@ -49,6 +50,9 @@ namespace lomse
 typedef std::thread EventsThread;
 typedef std::mutex QueueMutex;
 typedef std::unique_lock<std::mutex> QueueLock;
+typedef std::condition_variable QueueCondition;
+typedef pair<SpEventInfo, Observer*> QueuedEvent;
+typedef deque<QueuedEvent> EventsQueue;
 
 
 
@@ -56,16 +60,35 @@ typedef std::unique_lock<std::mutex> QueueLock;
 // EventsDispatcher
 //  Class to manage the event-dispatch loop.
 //  This class is a singleton maintained in Lomse LibraryScope object
+//
+//  Events can be delivered directly, in the thread posting the event, or enqueued and
+//  delivered by the events thread. The events thread sleeps on a condition variable
+//  until new events are posted and, when woken up, takes all pending events in a
+//  single lock acquisition and dispatches them.
 class EventsDispatcher
 {
+public:
+    //policies for merging redundant events enqueued before being dispatched
+    enum ECoalescingPolicy
+    {
+        k_coalesce_none = 0,        //all events are dispatched
+        k_coalesce_update_window,   //pending update window events for the same
+                                    //observer are merged into one event
+    };
+
 protected:
     EventsThread* m_pThread;        //execution thread
     QueueMutex m_mutex;             //to control queue access
+    QueueCondition m_condition;     //signals new events or stop request
     bool m_fStopLoop;
-    queue< pair<SpEventInfo, Observer*> > m_events;
+    bool m_fDirectInvocation;
+    int m_coalescing;
+    EventsQueue m_events;
 
 public:
-    EventsDispatcher();
+    //fDirectInvocation: deliver events in the posting thread instead of enqueuing
+    //them for the events thread
+    EventsDispatcher(bool fDirectInvocation = true);
     ~EventsDispatcher();
 
     void start_events_loop();
@@ -73,12 +96,21 @@ public:
 
     void post_event(Observer* pObserver, SpEventInfo pEvent);
 
+    //settings
+    void set_direct_invocation(bool fValue);
+    inline void set_coalescing_policy(int policy) { m_coalescing = policy; }
+    inline int get_coalescing_policy() { return m_coalescing; }
+    inline bool is_direct_invocation() { return m_fDirectInvocation; }
+
+    //info
+    size_t num_pending_events();
+
 protected:
-    inline bool stop_event_received() { return m_fStopLoop; }
+    bool is_events_thread();
     void run_events_loop();
     void thread_main();
-    inline bool pending_events() { return !m_events.empty(); }
-    void dispatch_next_event();
+    void dispatch_events(EventsQueue& events);
+    bool coalesce_event(Observer* pObserver, SpEventInfo pEvent);
 
 };
 
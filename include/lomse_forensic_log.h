@@ -0,0 +1,135 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2016. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#ifndef __LOMSE_FORENSIC_LOG_H__
+#define __LOMSE_FORENSIC_LOG_H__
+
+#include "lomse_build_options.h"
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+using namespace std;
+
+namespace lomse
+{
+
+//---------------------------------------------------------------------------------------
+typedef std::thread ForensicLogThread;
+typedef std::mutex ForensicLogMutex;
+typedef std::unique_lock<std::mutex> ForensicLogLock;
+typedef std::condition_variable ForensicLogCondition;
+typedef deque<string> ForensicRecords;
+
+
+//=======================================================================================
+// ForensicLog
+//  Sink for the data saved by edition commands (command, cursor, checkpoint) for
+//  analysing crashes. This class is a singleton maintained in Lomse LibraryScope object.
+//
+//  In synchronous mode each record is appended to the log file when it is written.
+//  In asynchronous mode records are kept in a bounded in-memory ring and are written
+//  to the file by a background thread, so that the thread executing the commands does
+//  not wait for disk operations. Pending records are also written when the log is
+//  flushed or destroyed. When the ring is full the oldest pending records are
+//  discarded.
+//
+//  Lomse does not install signal handlers. For not losing the pending records when
+//  the program crashes, the application can invoke flush_all_on_crash() from its own
+//  crash handler. It writes the pending records of all logs in asynchronous mode on
+//  a best effort basis: busy logs are skipped instead of waiting for their locks.
+//  It uses the C library for writing, so it is not async-signal-safe and must be
+//  invoked as the last action before terminating the program.
+class ForensicLog
+{
+public:
+    enum EForensicLogMode
+    {
+        k_disabled = 0,     //nothing is logged
+        k_synchronous,      //records are written to the file immediately
+        k_asynchronous,     //records are written by a background thread
+    };
+
+protected:
+    string m_path;
+    int m_mode;
+    size_t m_capacity;              //max. bytes in pending records
+    ForensicLogThread* m_pThread;   //writer thread, for asynchronous mode
+    ForensicLogMutex m_mutex;       //to control access to pending records
+    ForensicLogMutex m_fileMutex;   //to preserve records order when writing
+    ForensicLogCondition m_condition;
+    ForensicRecords m_records;      //pending records
+    size_t m_pendingBytes;
+    size_t m_numLost;               //records discarded because the ring was full
+    size_t m_numLostReported;       //discarded records already noted in the file
+    bool m_fStop;
+
+public:
+    ForensicLog(const string& path = "forensic_log.txt", int mode = k_synchronous);
+    ~ForensicLog();
+
+    //settings
+    void set_mode(int mode);
+    inline int get_mode() { return m_mode; }
+    inline bool is_enabled() { return m_mode != k_disabled; }
+    void set_capacity(size_t maxBytes);
+    inline size_t get_capacity() { return m_capacity; }
+    inline const string& get_path() { return m_path; }
+
+    //operations
+    void write(const string& record);
+    void flush();
+    void clear();
+
+    //info
+    size_t num_pending_records();
+    size_t num_lost_records();
+
+    //crash handling. To be invoked by the application crash handler
+    static void flush_all_on_crash();
+
+protected:
+    void start_thread();
+    void stop_thread();
+    void thread_main();
+    void write_pending_records();
+    void write_records(ForensicRecords& records, size_t numLost);
+    void discard_oldest_records();
+    void flush_on_crash();
+    static void register_log(ForensicLog* pLog);
+    static void unregister_log(ForensicLog* pLog);
+
+};
+
+
+}   //namespace lomse
+
+#endif      //__LOMSE_FORENSIC_LOG_H__
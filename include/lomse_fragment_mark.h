@@ -355,6 +355,7 @@ public:
     //mandatory overrides from VisualEffect
     void on_draw(ScreenDrawer* pDrawer);
     URect get_bounds();
+    URect get_view_bounds() { return m_viewBounds; }
 
     //initial data for position and context
     void initialize(LUnits xPos, GmoBoxSystem* pBoxSystem, bool fBarline=false);
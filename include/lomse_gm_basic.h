@@ -522,7 +522,8 @@ class GmoBoxDocPage : public GmoBox
 {
 protected:
     int m_numPage;      //1..n
-    std::list<GmoShape*> m_allShapes;		//contained shapes, ordered by layer and creation order
+    std::vector< std::vector<GmoShape*> > m_layers;   //contained shapes, a bucket per
+                                                      //layer, in creation order
 
 public:
     GmoBoxDocPage(ImoObj* pCreatorImo);
@@ -537,7 +538,8 @@ public:
 
     //shapes
     void add_to_tables(GmoShape* pShape);
-    GmoShape* get_first_shape_for_layer(int order);
+    GmoShape* get_first_shape_for_layer(int layer);
+    int get_num_shapes();
     GmoShape* find_shape_for_object(ImoStaffObj* pSO);
     void store_in_map_imo_shape(GmoShape* pShape);
 
@@ -80,6 +80,8 @@ protected:
     int         m_timeModifierBottom;
     TimeUnits   m_duration;
 
+    friend class ImSnapshot;
+
 public:
     ImoNoteRest(int objtype);
     virtual ~ImoNoteRest() {}
@@ -133,6 +135,7 @@ protected:
     bool m_fFullMeasureRest;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoRest() : ImoNoteRest(k_imo_rest), m_fGoFwd(false), m_fFullMeasureRest(false) {}
 
     friend class GoBackFwdAnalyser;
@@ -179,6 +182,7 @@ protected:
     ImoTie* m_pTiePrev;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoNote();
     ImoNote(int step, int octave, int noteType, EAccidentals accidentals=k_no_accidentals,
             int dots=0, int staff=0, int voice=0, int stem=k_stem_default);
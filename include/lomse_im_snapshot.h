@@ -0,0 +1,187 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2016. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#ifndef __LOMSE_IM_SNAPSHOT_H__
+#define __LOMSE_IM_SNAPSHOT_H__
+
+#include "lomse_basic.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+using namespace std;
+
+namespace lomse
+{
+
+//forward declarations
+class Document;
+class IdAssigner;
+class ImoObj;
+class ImoAttr;
+class ImoContentObj;
+class ImoScoreObj;
+class ImoStaffObj;
+class ImoNoteRest;
+class ImoRelObj;
+class ImoRelDataObj;
+class ImoRelations;
+class ImoStyle;
+class ImoTextInfo;
+class ImoScoreText;
+class ImoLineStyle;
+class ImoTextBlockInfo;
+class ImoPageInfo;
+class ImoSystemInfo;
+class ImoBezierInfo;
+
+//---------------------------------------------------------------------------------------
+// ImSnapshot: compact binary image of an internal model subtree.
+//
+// It is used for undo checkpoints as a faster alternative to exporting the subtree
+// to LMD and compiling it again. The snapshot keeps the ImoObj ids, and restoring it
+// re-creates the objects directly through ImFactory, with the same ids and tree
+// structure. Relations, styles and other cross references are saved as references
+// to objects in the snapshot and are re-linked after all objects have been created.
+//
+// Computed data (staffobjs table, measures tables, MIDI table) is not saved and must
+// be rebuilt by ModelBuilder after restoring.
+//
+// Not all objects are supported (i.e. images, controls, figured bass, dynamic
+// content). When the subtree contains unsupported objects save() returns an empty
+// string and the caller must use the LMD format.
+class ImSnapshot
+{
+protected:
+    Document* m_pDoc;
+    bool m_fSaving;
+    bool m_fSupported;
+    int m_lastIndex;        //node index and id are saved as differences with
+    ImoId m_lastId;         //the previous node, as usually they are consecutive
+
+    //saving
+    string m_data;
+    map<ImoObj*, int> m_indexes;
+    vector<ImoObj*> m_referenced;
+    vector<bool> m_fSaved;
+
+    //restoring
+    const unsigned char* m_pCur;
+    const unsigned char* m_pEnd;
+    IdAssigner* m_pExternalIds;
+    vector<ImoObj*> m_restored;
+    vector< std::function<void()> > m_pending;
+
+public:
+    ImSnapshot(Document* pDoc);
+    ~ImSnapshot() {}
+
+    //Returns the snapshot data for the subtree rooted at pImo, or an empty string
+    //if the subtree contains objects not supported in snapshots.
+    string save(ImoObj* pImo);
+
+    //Returns the snapshot data for several subtrees, or an empty string if they
+    //contain objects not supported in snapshots or references to objects not
+    //included in the snapshot.
+    string save(const vector<ImoObj*>& objects);
+
+    //Re-creates the subtree saved in data. Styles not included in the snapshot are
+    //looked up by id in pExternalIds, or in the Document when nullptr.
+    ImoObj* restore(const string& data, IdAssigner* pExternalIds=nullptr);
+
+    //Re-creates the subtrees saved in data, in the same order than when saved.
+    vector<ImoObj*> restore_objects(const string& data,
+                                    IdAssigner* pExternalIds=nullptr);
+
+    //Returns true if data is a snapshot created by save().
+    static bool is_snapshot(const string& data);
+
+protected:
+    //nodes
+    void save_node(ImoObj* pImo);
+    ImoObj* restore_node();
+    ImoObj* create_object(int type, ImoId id);
+    void transfer_attributes(ImoObj* pImo);
+    void transfer_fields(ImoObj* pImo);
+
+    //fields of base classes and embedded objects
+    void transfer_embedded(ImoObj* pImo);
+    void transfer_contentobj(ImoContentObj* pImo);
+    void transfer_scoreobj(ImoScoreObj* pImo);
+    void transfer_staffobj(ImoStaffObj* pImo);
+    void transfer_noterest(ImoNoteRest* pImo);
+    void transfer_relobj(ImoRelObj* pImo);
+    void transfer_relations(ImoRelations* pImo);
+    void transfer_style(ImoStyle* pImo);
+    void transfer_text_info(ImoTextInfo* pImo);
+    void transfer_score_text(ImoScoreText* pImo);
+    void transfer_line_style(ImoLineStyle* pImo);
+    void transfer_textblock_info(ImoTextBlockInfo* pImo);
+    void transfer_page_info(ImoPageInfo* pImo);
+    void transfer_system_info(ImoSystemInfo* pImo);
+    void transfer_bezier(ImoBezierInfo*& pBezier);
+
+    //references
+    template <class T> void transfer_ref(T*& pImo);
+    template <class T> void transfer_enum(T& value);
+    int index_of(ImoObj* pImo);
+    void write_ref(ImoObj* pImo);
+    int read_ref();
+    ImoObj* object_at(int i);
+    bool save_external_refs();
+    void restore_external_refs();
+
+    //values
+    void transfer(int& value);
+    void transfer(long& value);
+    void transfer(bool& value);
+    void transfer(float& value);
+    void transfer(double& value);
+    void transfer(string& value);
+    void transfer(Color& value);
+    void transfer(Point<float>& value);
+    void transfer(Size<float>& value);
+
+    //encoding
+    void write_int(long long value);
+    void write_uint(unsigned long long value);
+    void write_bytes(const void* pData, size_t size);
+    bool write_integral(double value);
+    long long read_int();
+    unsigned long long read_uint();
+    void read_bytes(void* pData, size_t size);
+    bool read_integral(long long* pValue);
+    void check_available(size_t size);
+};
+
+
+} //namespace lomse
+
+#endif    //__LOMSE_IM_SNAPSHOT_H__
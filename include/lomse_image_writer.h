@@ -0,0 +1,102 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#ifndef __LOMSE_IMAGE_WRITER_H__
+#define __LOMSE_IMAGE_WRITER_H__
+
+#include "lomse_build_options.h"
+#include "lomse_agg_types.h"
+#include "lomse_pixel_formats.h"
+
+#include <iostream>
+#include <string>
+using namespace std;
+
+
+namespace lomse
+{
+
+//---------------------------------------------------------------------------------------
+// ImageWriter: knows how to save a bitmap in a file. Delegates in an ImageEncoder
+class ImageWriter
+{
+public:
+    ImageWriter() {}
+    ~ImageWriter() {}
+
+    static bool save_as_png(RenderingBuffer& rbuf, EPixelFormat format,
+                            const string& filename);
+};
+
+//---------------------------------------------------------------------------------------
+// ImageEncoder: abstract base for any image encoder
+class ImageEncoder
+{
+public:
+    ImageEncoder() {}
+    virtual ~ImageEncoder() {}
+
+    virtual bool can_encode(EPixelFormat format) = 0;
+    virtual bool encode(RenderingBuffer& rbuf, EPixelFormat format, ostream& out) = 0;
+};
+
+#if (LOMSE_ENABLE_PNG == 1)
+//---------------------------------------------------------------------------------------
+// PngImageEncoder: knows how to write a bitmap as a PNG image.
+// Supported pixel formats are rgb24, bgr24, rgba32, bgra32, argb32 and abgr32. The
+// bitmap is encoded without conversions other than the order of color components.
+class PngImageEncoder : public ImageEncoder
+{
+protected:
+    int m_compressionLevel;
+
+public:
+    PngImageEncoder(int compressionLevel=-1)
+        : ImageEncoder()
+        , m_compressionLevel(compressionLevel)
+    {
+    }
+    virtual ~PngImageEncoder() {}
+
+    //mandatory overrides
+    bool can_encode(EPixelFormat format);
+    bool encode(RenderingBuffer& rbuf, EPixelFormat format, ostream& out);
+
+    //settings
+    /** Set the zlib compression level: 0 (none) to 9 (best). -1 uses the zlib default.
+        For thumbnails generated in batch, low levels (1 or 2) are much faster and
+        produce files only slightly bigger.  */
+    inline void set_compression_level(int level) { m_compressionLevel = level; }
+
+};
+#endif // LOMSE_ENABLE_PNG
+
+}   //namespace lomse
+
+#endif      //__LOMSE_IMAGE_WRITER_H__
@@ -60,6 +60,7 @@ class LdpFactory;
 class FontStorage;
 class FontSelector;
 class MusicGlyphs;
+class ForensicLog;
 class View;
 class SimpleView;
 class VerticalBookView;
@@ -103,6 +104,7 @@ protected:
     FontSelector* m_pFontSelector;
     Metronome* m_pGlobalMetronome;
     EventsDispatcher* m_pDispatcher;
+    ForensicLog* m_pForensicLog;
     string m_sMusicFontFile;
     string m_sMusicFontName;
     string m_sMusicFontPath;
@@ -111,6 +113,7 @@ protected:
 
     //options
     bool m_fReplaceLocalMetronome;
+    bool m_fEventsThread;
     MusicXmlOptions m_importOptions;
 
     //debug options
@@ -142,6 +145,10 @@ public:
     EventsDispatcher* get_events_dispatcher();
     FontSelector* get_font_selector();
 
+    //forensic log for edition commands
+    ForensicLog* get_forensic_log();
+    void set_forensic_log_mode(int mode);
+
     //callbacks
     void post_event(SpEventInfo pEvent);
     void post_request(Request* pRequest);
@@ -178,6 +185,8 @@ public:
     inline Metronome* get_global_metronome() { return m_pGlobalMetronome; }
     inline bool global_metronome_replaces_local() { return m_fReplaceLocalMetronome; }
     inline MusicXmlOptions* get_musicxml_options() { return &m_importOptions; }
+    void enable_events_thread(bool fValue);
+    inline bool is_events_thread_enabled() { return m_fEventsThread; }
 
     //spacing and lines breaker algorithm parameters
     inline bool use_debug_values() { return m_fUseDbgValues; }
@@ -59,6 +59,7 @@ class Handler;
 class ImoScore;
 class ImoStaffObj;
 class PlayerGui;
+class ScorePlayer;
 class Task;
 class VisualEffect;
 class FragmentMark;
@@ -1015,6 +1016,16 @@ public:
         @todo Document Interactor::on_visual_tracking    */
     virtual void on_visual_tracking(SpEventVisualTracking pEvent);
 
+    /** When the ScorePlayer has been requested to not generate visual tracking
+        events (see ScorePlayer::use_tracking_ring()), your application must invoke
+        this method periodically, at display refresh rate, while the score is being
+        played back. All visual tracking information accumulated since previous
+        invocation is merged and the display is updated only once.
+        @param pPlayer The ScorePlayer that is playing back the score.
+        @return @TRUE if there was visual tracking information to process.
+    */
+    virtual bool update_visual_tracking(ScorePlayer* pPlayer);
+
     //@}    //Visual effects during playback
 
 
@@ -1273,7 +1284,7 @@ public:
 
     /** Execute an edition command for modifying the document content, the current set
         of selected objects or the cursor position.
-        @param pCmd The command to execute.
+        @param pCmd The command to execute. The %Interactor takes its ownership.
 
         @remarks This method has no effect when document edition is disabled.
         See @ref set_operating_mode().
@@ -1339,6 +1350,52 @@ public:
     */
     void exec_redo();
 
+
+    /** Start a group of edition commands that will be undone and redone as a single
+        command. While the group is open, commands executed via exec_command() modify
+        the document but the views are not updated. The graphic model is rebuilt and
+        the views updated only once, when the group is closed by invoking
+        commit_commands_group(). This is useful for applications and scripts issuing
+        many small commands (e.g. changing an attribute on every selected note).
+        @param name The displayable name for the group in undo/redo actions.
+
+        @remarks Groups can be nested. Only the commit_commands_group() matching the
+        outermost begin_commands_group() closes the group.
+
+        Example:
+
+        @code
+        void CommandGenerator::change_color(list<ImoObj*>& objects, Color color)
+        {
+            if (SpInteractor spInteractor = m_pPresenter->get_interactor(0).lock())
+            {
+                spInteractor->begin_commands_group("Change color");
+                for (ImoObj* pImo : objects)
+                {
+                    spInteractor->exec_command(
+                        new CmdChangeAttribute(pImo, k_attr_color, color) );
+                }
+                spInteractor->commit_commands_group();
+            }
+        }
+        @endcode
+
+        @see commit_commands_group(), rollback_commands_group()
+    */
+    void begin_commands_group(const string& name);
+
+    /** Close the group of edition commands opened by begin_commands_group(), and
+        update the views.
+        @see begin_commands_group(), rollback_commands_group()
+    */
+    void commit_commands_group();
+
+    /** Undo all edition commands executed since the outermost begin_commands_group()
+        was invoked, close the group and update the views.
+        @see begin_commands_group(), commit_commands_group()
+    */
+    void rollback_commands_group();
+
     //edition related info
     /** Returns @true if there are commands in the undo queue.
 
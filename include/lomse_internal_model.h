@@ -929,6 +929,8 @@ private:
     enum AttribType { vt_empty, vt_int, vt_string, vt_bool, vt_float, vt_double, vt_color };
     AttribType m_type = vt_empty;
 
+    friend class ImSnapshot;
+
 public:
     AttribValue() {}
     ~AttribValue() { Cleanup(); }
@@ -1039,6 +1041,8 @@ protected:
     AttribValue m_value;
     ImoAttr* m_next;
 
+    friend class ImSnapshot;
+
 public:
     ImoAttr(int idx) : m_attrbIdx(idx), m_next(nullptr) {}
     ImoAttr(int idx, const string& value);
@@ -1205,6 +1209,7 @@ protected:
     ImoObj(int objtype, ImoId id=k_no_imoid);
 
     friend class ImFactory;
+    friend class ImSnapshot;
     inline void set_owner_document(Document* pDoc)
     {
         m_pDoc = pDoc;
@@ -1223,6 +1228,7 @@ public:
         k_editable          = 0x0008,   //in edition, this node can be edited
         k_deletable         = 0x0010,   //if editable, this node can be also deleted
         k_expandable        = 0x0020,   //if editable, more children can be added/inserted
+        k_being_deleted     = 0x0040,   //destructor is deleting the children
     };
 
     //dirty
@@ -1236,6 +1242,10 @@ public:
         return (m_flags & k_children_dirty) != 0;
     }
     void set_children_dirty(bool value);
+    inline bool is_being_deleted()
+    {
+        return (m_flags & k_being_deleted) != 0;
+    }
 
     //edition flags
     inline bool is_edit_terminal()
@@ -1508,7 +1518,7 @@ public:
 
 protected:
     void visit_children(BaseVisitor& v);
-    void propagate_dirty();
+    void propagate_dirty(ImoObj* pModified);
     void remove_id();
     void delete_attributes();
 
@@ -1661,6 +1671,7 @@ protected:
     std::map<int, Color> m_colorProps;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoStyle() : ImoSimpleObj(k_imo_style), m_name(), m_pParent(nullptr) {}
 
 public:
@@ -2291,6 +2302,8 @@ protected:
     ImoContentObj(int objtype);
     ImoContentObj(ImoId id, int objtype);
 
+    friend class ImSnapshot;
+
 public:
     virtual ~ImoContentObj();
 
@@ -2424,6 +2437,7 @@ protected:
     std::list<ImoRelObj*> m_relations;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     friend class ImoContentObj;
     ImoRelations() : ImoSimpleObj(k_imo_relations) {}
 
@@ -2614,6 +2628,8 @@ protected:
         set_inline_level_creator_api_parent(this);
     }
 
+    friend class ImSnapshot;
+
 public:
     virtual ~ImoBoxInline() {}
 
@@ -2684,6 +2700,7 @@ private:
     string m_language;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoLink() : ImoBoxInline(k_imo_link) {}
 
 public:
@@ -2716,6 +2733,8 @@ protected:
     ImoScoreObj(ImoId id, int objtype) : ImoContentObj(id, objtype), m_color(0,0,0) {}
     ImoScoreObj(int objtype) : ImoContentObj(objtype), m_color(0,0,0) {}
 
+    friend class ImSnapshot;
+
 public:
     virtual ~ImoScoreObj() {}
 
@@ -2755,6 +2774,8 @@ protected:
     ImoStaffObj(ImoId id, int objtype)
         : ImoScoreObj(id, objtype), m_staff(0), m_measure(0), m_time(0.0f) {}
 
+    friend class ImSnapshot;
+
 public:
     virtual ~ImoStaffObj();
 
@@ -2852,6 +2873,8 @@ protected:
     {
     }
 
+    friend class ImSnapshot;
+
 
 public:
     virtual ~ImoAuxRelObj();
@@ -2893,6 +2916,8 @@ class ImoRelObj : public ImoScoreObj
 protected:
     std::list< pair<ImoStaffObj*, ImoRelDataObj*> > m_relatedObjects;
 
+    friend class ImSnapshot;
+
 public:
     virtual ~ImoRelObj();
 
@@ -2975,6 +3000,8 @@ protected:
     bool m_repeat[6];
 
     friend class ImFactory;
+    friend class ImSnapshot;
+    ImoBeamData();
     ImoBeamData(ImoBeamDto* pDto);
 
 public:
@@ -3081,6 +3108,7 @@ protected:
     TPoint m_tPoints[4];   //start, end, ctrol1, ctrol2
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoBezierInfo() : ImoSimpleObj(k_imo_bezier_info) {}
 
 public:
@@ -3225,6 +3253,7 @@ protected:
     TPoint      m_endPoint;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     friend class ImoTextBox;
     friend class ImoLine;
     friend class ImoScoreLine;
@@ -3368,6 +3397,7 @@ protected:
     //-90 = directly below.
 
     friend class ImFactory;
+    friend class ImSnapshot;
     friend class ImoInstrument;
     ImoMidiInfo()
         : ImoSimpleObj(k_imo_midi_info)
@@ -3500,6 +3530,8 @@ protected:
     Tenths        m_borderWidth;
     ELineStyle    m_borderStyle;
 
+    friend class ImSnapshot;
+
 public:
     ImoTextBlockInfo()
         : ImoSimpleObj(k_imo_textblock_info)
@@ -3597,6 +3629,7 @@ protected:
 
 
     friend class ImFactory;
+    friend class ImSnapshot;
     friend class ImoInstrument;
     ImoSoundInfo();
     void initialize_object(Document* pDoc) override;
@@ -3691,6 +3724,7 @@ protected:
     ImoStyle* m_pStyle;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     friend class ImoTextBox;
     friend class ImoButton;
     friend class ImoScoreText;
@@ -3749,6 +3783,7 @@ protected:
     bool    m_fPortrait;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     friend class ImoDocument;
     friend class ImoScore;
     ImoPageInfo();
@@ -3878,6 +3913,7 @@ protected:
 
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoBarline()
         : ImoStaffObj(k_imo_barline)
         , m_barlineType(k_barline_simple)
@@ -3943,6 +3979,8 @@ protected:
     ImoBlock(int objtype) : ImoAuxObj(objtype) {}
     ImoBlock(int objtype, ImoTextBlockInfo& box) : ImoAuxObj(objtype), m_box(box) {}
 
+    friend class ImSnapshot;
+
 public:
     virtual ~ImoBlock() {}
 
@@ -3958,6 +3996,7 @@ protected:
     //TPoint m_anchorJoinPoint;     //point on the box rectangle
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoTextBox() : ImoBlock(k_imo_text_box), m_fHasAnchorLine(false) {}
     ImoTextBox(ImoTextBlockInfo& box) : ImoBlock(k_imo_text_box, box)
         , m_fHasAnchorLine(false) {}
@@ -4115,6 +4154,7 @@ protected:
     int m_symbolSize;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoClef()
         : ImoStaffObj(k_imo_clef)
         , m_clefType(k_clef_G2)
@@ -4229,6 +4269,7 @@ protected:
 
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoDirection()
         : ImoStaffObj(k_imo_direction)
         , m_space(0.0f)
@@ -4286,6 +4327,7 @@ protected:
     int m_symbol;       //a value from enum ESymbolRepetitionMark
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoSymbolRepetitionMark()
         : ImoAuxObj(k_imo_symbol_repetition_mark)
         , m_symbol(ImoSymbolRepetitionMark::k_undefined)
@@ -4389,6 +4431,7 @@ protected:
     std::list<ImoStyle*> m_privateStyles;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoDocument(const std::string& version="");
 
 public:
@@ -4441,6 +4484,7 @@ protected:
     int m_symbol;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoFermata()
         : ImoAuxObj(k_imo_fermata)
         , m_placement(k_placement_default)
@@ -4491,6 +4535,8 @@ protected:
     {
     }
 
+    friend class ImSnapshot;
+
 public:
     virtual ~ImoArticulation() {}
 
@@ -4524,6 +4570,7 @@ protected:
     int m_symbol;   //symbol to use when alternatives. For now only for breath_mark
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoArticulationSymbol()
         : ImoArticulation(k_imo_articulation_symbol)
         , m_fUp(true)
@@ -4595,6 +4642,7 @@ protected:
     Tenths m_dashSpace;     //only for dashed lines
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoArticulationLine()
         : ImoArticulation(k_imo_articulation_line)
         , m_lineShape(k_line_shape_straight)
@@ -4656,6 +4704,7 @@ protected:
 //    %enclosure;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoDynamicsMark()
         : ImoAuxObj(k_imo_dynamics_mark)
         , m_markType("")
@@ -4699,6 +4748,7 @@ protected:
 //    %enclosure;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoOrnament()
         : ImoAuxObj(k_imo_ornament)
         , m_ornamentType(k_ornament_unknown)
@@ -4739,6 +4789,7 @@ protected:
     int m_placement;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoTechnical()
         : ImoAuxObj(k_imo_technical)
         , m_technicalType(k_technical_unknown)
@@ -4781,6 +4832,7 @@ protected:
     const TimeUnits SHIFT_START_END;     //any too big value
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoGoBackFwd()
         : ImoStaffObj(k_imo_go_back_fwd), m_fFwd(true), m_rTimeShift(0.0)
         , SHIFT_START_END(100000000.0)
@@ -4831,6 +4883,7 @@ protected:
     ImoTextInfo m_text;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     friend class ImoInstrument;
     friend class ImoInstrGroup;
     ImoScoreText() : ImoAuxObj(k_imo_score_text), m_text() {}
@@ -4871,6 +4924,7 @@ protected:
     int m_hAlign;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoScoreTitle() : ImoScoreText(k_imo_score_title), m_hAlign(k_halign_center) {}
 
 public:
@@ -4914,6 +4968,7 @@ protected:
     int m_repeatType;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoTextRepetitionMark()
         : ImoScoreText(k_imo_text_repetition_mark)
         , m_repeatType(0)
@@ -5035,6 +5090,7 @@ protected:
     std::list<ImoInstrument*> m_instruments;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoInstrGroup();
 
     friend class ImoScore;
@@ -5146,12 +5202,17 @@ protected:
                                             //has no metric. Otherwise it will be nullptr.
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoInstrument();
 
     friend class ImoScore;
     friend class ImoInstrGroup;
     inline void set_owner_score(ImoScore* pScore) { m_pScore = pScore; }
 
+    //staffobjs edition: the instrument is dirty but the modification is reported
+    //by the modified staffobjs, for recording the changed measures
+    inline void set_dirty_flag() { m_flags |= k_dirty; }
+
 public:
     virtual ~ImoInstrument();
 
@@ -5309,6 +5370,7 @@ protected:
     int m_keyMode;      ///< A value from EKeyModes
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoKeySignature()
         : ImoStaffObj(k_imo_key_signature)
         , m_fifths(0)
@@ -5348,6 +5410,7 @@ class ImoLine : public ImoAuxObj
     ImoLineStyle* m_pStyle;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoLine() : ImoAuxObj(k_imo_line), m_pStyle(nullptr) {}
 
 public:
@@ -5387,6 +5450,7 @@ protected:
     int m_listType;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoList(Document* pDoc);
 
 public:
@@ -5430,6 +5494,7 @@ protected:
     bool    m_fParenthesis;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoMetronomeMark()
         : ImoAuxObj(k_imo_metronome_mark), m_markType(k_value)
         , m_ticksPerMinute(60), m_leftNoteType(0), m_leftDots(0)
@@ -5509,6 +5574,7 @@ protected:
     std::vector<float> m_widths;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoMultiColumn(Document* pDoc);
 
 public:
@@ -5558,6 +5624,7 @@ protected:
     float       m_rValue;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoOptionInfo()
         : ImoSimpleObj(k_imo_option), m_type(k_boolean), m_name("")
         , m_fValue(false), m_nValue(0L), m_rValue(0.0f)  {}
@@ -5676,6 +5743,7 @@ protected:
     string m_value;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoParamInfo() : ImoSimpleObj(k_imo_param_info), m_name(), m_value() {}
 
 public:
@@ -5711,6 +5779,7 @@ protected:
     int m_level;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoHeading()
         : ImoInlinesContainer(k_imo_heading)
         , m_level(1)
@@ -5771,6 +5840,7 @@ protected:
     ImoLineStyle m_style;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoScoreLine()
         : ImoAuxObj(k_imo_score_line)
         , m_startPoint(0.0f, 0.0f)
@@ -5985,6 +6055,7 @@ protected:
     LUnits   m_topSystemDistance;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     friend class ImoScore;
     ImoSystemInfo();
     ImoSystemInfo(ImoSystemInfo& dto);
@@ -6043,7 +6114,10 @@ class ImoScore : public ImoBlockLevelObj      //ImoBlocksContainer
 protected:
     int             m_version;
     ColStaffObjs*   m_pColStaffObjs;
-    SoundEventsTable* m_pMidiTable;
+    std::shared_ptr<SoundEventsTable> m_spMidiTable;
+    bool            m_fMidiTableOutdated;
+    int             m_midiFirstMeasure;     //range of modified measures pending to
+    int             m_midiLastMeasure;      //  update in the sound events table
     ImoSystemInfo   m_systemInfoFirst;
     ImoSystemInfo   m_systemInfoOther;
     ImoPageInfo     m_pageInfo;
@@ -6051,6 +6125,7 @@ protected:
     map<string, ImoStyle*> m_nameToStyle;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoScore(Document* pDoc);
     void initialize();
 
@@ -6082,6 +6157,9 @@ public:
     }
     void set_staffobjs_table(ColStaffObjs* pColStaffObjs);
     SoundEventsTable* get_midi_table();
+    //A ScorePlayer keeps the table in use while playing. The score never modifies a
+    //table shared with other owners: a new table is created instead
+    std::shared_ptr<SoundEventsTable> get_shared_midi_table();
 
     //required by Visitable parent class
     void accept_visitor(BaseVisitor& v);
@@ -6145,6 +6223,19 @@ public:
         that will invoke this method on all scores. */
     void end_of_changes();
 
+    /** Informs the score that the content of some measures has been modified, so
+        that the table of sound events used for playback is updated by regenerating
+        only the events for the modified measures, when the table is needed again.
+        The %Document invokes this method for the changes informed by
+        ImoObj::set_dirty(), when they are cleared (i.e. when the %Document is
+        notified as modified). If you modify the content of a score by other means
+        and invoke end_of_changes(), you can invoke this method for avoiding the
+        creation of the whole table the next time the score is played back.
+        @param firstMeasure, lastMeasure  The range of modified measures (1..n).
+            Value INT_MAX for lastMeasure means all measures after the first one.
+    */
+    void update_midi_table(int firstMeasure, int lastMeasure);
+
 
 protected:
     void add_option(ImoOptionInfo* pOpt);
@@ -6171,6 +6262,7 @@ protected:
     Color   m_color;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoSlur()
         : ImoRelObj(k_imo_slur), m_slurNum(0), m_orientation(k_orientation_default)
     {}
@@ -6226,6 +6318,8 @@ protected:
     ImoBezierInfo* m_pBezier;
 
     friend class ImFactory;
+    friend class ImSnapshot;
+    ImoSlurData();
     ImoSlurData(ImoSlurDto* pDto);
 
 public:
@@ -6367,6 +6461,7 @@ protected:
     LUnits m_uMarging;      //distance from the bottom line of the previous staff
 
     friend class ImFactory;
+    friend class ImSnapshot;
     friend class ImoInstrument;
     //Default values for staff. Line spacing: 1.8 mm (staff height = 7.2 mm),
     //line thickness: 0.15 millimeters, top margin: 10 millimeters
@@ -6472,6 +6567,7 @@ protected:
     std::map<std::string, ImoStyle*> m_nameToStyle;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoStyles(Document* pDoc);
 
 public:
@@ -6519,6 +6615,7 @@ protected:
     }
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoTable() : ImoBlocksContainer(k_imo_table) {}
 
 public:
@@ -6550,6 +6647,7 @@ protected:
 
     friend class Document;
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoTableCell(Document* pDoc);
 
 public:
@@ -6664,6 +6762,7 @@ private:
 
 protected:
     friend class ImFactory;
+    friend class ImSnapshot;
     friend class TextItemAnalyser;
     friend class TextItemLmdAnalyser;
 
@@ -6701,6 +6800,8 @@ protected:
     ImoBezierInfo* m_pBezier;
 
     friend class ImFactory;
+    friend class ImSnapshot;
+    ImoTieData();
     ImoTieData(ImoTieDto* pDto);
 
 public:
@@ -6737,6 +6838,7 @@ protected:
     Color   m_color;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoTie()
         : ImoRelObj(k_imo_tie), m_tieNum(0), m_orientation(k_orientation_default)
     {}
@@ -6924,6 +7026,7 @@ protected:
     int     m_type;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoTimeSignature()
         : ImoStaffObj(k_imo_time_signature)
         , m_top(2)
@@ -7138,6 +7241,7 @@ protected:
     int m_nPlacement;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoTuplet()
         : ImoRelObj(k_imo_tuplet)
         , m_nActualNum(0)
@@ -7200,6 +7304,7 @@ protected:
     // ImoLyricsTextInfo[]
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoLyric()
         : ImoAuxRelObj(k_imo_lyric)
         , m_number(0)
@@ -7333,6 +7438,7 @@ protected:
 //    Color m_elisionColor;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoLyricsTextInfo()
         : ImoSimpleObj(k_imo_lyrics_text_info)
         , m_syllableType(k_single)
@@ -7403,6 +7509,7 @@ protected:
     int     m_octaveShiftNum;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoOctaveShift(int num=0)
         : ImoRelObj(k_imo_octave_shift)
         , m_steps(0)
@@ -7496,6 +7603,7 @@ protected:
     int m_numVoltas;                //number of voltas in the set
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoVoltaBracket()
         : ImoRelObj(k_imo_volta_bracket)
         , m_fStopJog(true)
@@ -7697,6 +7805,7 @@ protected:
 //    Color   m_color;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoWedge(int num=0)
         : ImoRelObj(k_imo_wedge)
         , m_startSpread(0.0f)
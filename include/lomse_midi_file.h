@@ -0,0 +1,216 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#ifndef __LOMSE_MIDI_FILE_H__
+#define __LOMSE_MIDI_FILE_H__
+
+#include "lomse_basic.h"
+#include "lomse_score_player.h"
+#include "lomse_player_gui.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+///@cond INTERNALS
+namespace lomse
+{
+///@endcond
+
+//forward declarations
+class LibraryScope;
+class ImoScore;
+
+
+//---------------------------------------------------------------------------------------
+/** %MidiMessage is a MIDI channel message with the time at which it was requested,
+    as recorded by MidiRecorder.
+*/
+struct MidiMessage
+{
+    long time;          ///< Milliseconds from the start of the playback
+    int status;         ///< MIDI status byte, including the channel (i.e. 0x90 | ch)
+    int data1;          ///< First data byte (i.e. pitch, program)
+    int data2;          ///< Second data byte (i.e. velocity) or 0 if not used
+
+    MidiMessage(long t, int st, int d1, int d2)
+        : time(t), status(st), data1(d1), data2(d2)
+    {
+    }
+
+    /// Returns the MIDI channel (0..15)
+    inline int channel() const { return status & 0x0F; }
+    /// Returns the message type (the status byte without the channel)
+    inline int type() const { return status & 0xF0; }
+
+    ///Values for message type
+    enum EMidiMessageType
+    {
+        k_note_off = 0x80,
+        k_note_on = 0x90,
+        k_control_change = 0xB0,
+        k_program_change = 0xC0,
+    };
+};
+
+//---------------------------------------------------------------------------------------
+/** %MidiRecorder is a MidiServerBase that does not generate sound but records, with
+    its timestamp, all the requests received from a ScorePlayer as MIDI messages.
+    The recorded messages can then be saved as a Standard MIDI File.
+
+    Timestamps are obtained from the ScorePlayer (see ScorePlayer::get_playback_time()),
+    so it must be informed of the player that will use it, by invoking set_player().
+    When used with ScorePlayer::play_offline() the recorded messages and their times
+    are deterministic, so %MidiRecorder is also useful for testing.
+
+    The 'All Sound Off' request is recorded as a 'Control Change 120' message for
+    each channel used in previous messages.
+
+    @see MidiFileRenderer
+*/
+class MidiRecorder : public MidiServerBase
+{
+protected:
+    ScorePlayer* m_pPlayer;             //source for timestamps
+    std::vector<MidiMessage> m_messages;
+    unsigned m_usedChannels;            //bit i set if channel i has been used
+
+public:
+    MidiRecorder();
+    virtual ~MidiRecorder() {}
+
+    /** Set the ScorePlayer that will send requests to this recorder. It is used
+        for timestamping the messages. If not set, all timestamps will be 0.   */
+    inline void set_player(ScorePlayer* pPlayer) { m_pPlayer = pPlayer; }
+
+    /// Returns the recorded messages, in the order they were received.
+    inline std::vector<MidiMessage>& get_messages() { return m_messages; }
+
+    /// Removes all recorded messages.
+    void clear();
+
+    /** Write the recorded messages as a Type 1 Standard MIDI File: a first track with
+        the tempo and one track for each used MIDI channel. The time resolution is one
+        millisecond.
+        @return @FALSE if any error writing the file.
+    */
+    bool save_as_midi_file(std::ostream& file);
+
+    //overrides for MidiServerBase
+    void program_change(int channel, int instr);
+    void voice_change(int channel, int instr);
+    void note_on(int channel, int pitch, int volume);
+    void note_off(int channel, int pitch, int volume);
+    void all_sounds_off();
+
+protected:
+    void add_message(int type, int channel, int data1, int data2);
+    void write_track(std::ostream& file, const std::string& track);
+};
+
+//---------------------------------------------------------------------------------------
+/** %MidiFileRenderer is a facade for converting scores into Standard MIDI Files
+    without real time playback. It uses a ScorePlayer for playing back the score
+    offline (see ScorePlayer::play_offline()) on a MidiRecorder, so that the generated
+    file contains exactly the same MIDI messages that a real time playback would
+    generate with the same options, including jumps and repetitions, count-off,
+    metronome clicks and tempo changes. It runs as fast as the CPU allows.
+
+    Example:
+
+    @code
+    LomseDoorway lomse;
+    lomse.init_library(k_pix_format_rgba32, 96, false);
+
+    MidiFileRenderer* pRenderer = lomse.create_midi_file_renderer();
+    pRenderer->set_metronome_mm(90);
+    pRenderer->render(pScore, "score.mid");
+    delete pRenderer;
+    @endcode
+
+    @see LomseDoorway::create_midi_file_renderer()
+*/
+class MidiFileRenderer
+{
+protected:
+    LibraryScope& m_libScope;
+    MidiRecorder m_recorder;
+    ScorePlayer* m_pPlayer;
+    PlayerNoGui m_options;
+
+public:
+    /** Constructor. Your application should not directly create %MidiFileRenderer
+        objects but use LomseDoorway::create_midi_file_renderer().   */
+    MidiFileRenderer(LibraryScope& libraryScope);
+    virtual ~MidiFileRenderer();
+
+    /// @name Playback options
+    //@{
+
+    /// Tempo, in beats per minute. Default value is 60.
+    inline void set_metronome_mm(int value) { m_options.set_metronome_mm(value); }
+    /// Generate count-off metronome clicks before the music. Default value is @FALSE.
+    inline void set_countoff(bool value) { m_options.countoff_status(value); }
+    /// Generate metronome clicks. Default value is @FALSE.
+    inline void set_metronome(bool value) { m_options.metronome_status(value); }
+    /// Play mode (k_play_normal_instrument, k_play_rhythm_instrument, etc.).
+    /// Default value is k_play_normal_instrument.
+    inline void set_play_mode(int value) { m_options.set_play_mode(value); }
+
+    //@}
+
+    /// @name Rendering
+    //@{
+
+    /** Play back the score offline and write the MIDI messages as a Standard MIDI File.
+        @return @FALSE if any error writing the file.
+    */
+    bool render(ImoScore* pScore, std::ostream& file);
+
+    /** Play back the score offline and save the MIDI messages in a Standard MIDI File
+        with the given name.
+        @return @FALSE if the file can not be created or any error writing it.
+    */
+    bool render(ImoScore* pScore, const std::string& filename);
+
+    /** Returns the MidiRecorder used for rendering. Its messages are those of the
+        last rendered score. Ownership is not transferred.   */
+    inline MidiRecorder* get_recorder() { return &m_recorder; }
+
+    //@}
+
+protected:
+    void play(ImoScore* pScore);
+};
+
+
+}   //namespace lomse
+
+#endif      //__LOMSE_MIDI_FILE_H__
@@ -87,6 +87,10 @@ public:
     inline void set_times_before(int times) { m_timesBefore = times; }
     inline void increment_visited() { ++m_visited; }
     inline void set_label(const string& label) { m_label = label; }
+    inline void set_counters(int visited, int executed) {
+        m_visited = visited;
+        m_executed = executed;
+    }
 
 
     //debug
@@ -110,6 +114,7 @@ public:
         , Volume(nVolume)
         , pSO(pStaffObj)
         , Measure(nMeasure)
+        , Score(0)
     {
     }
     SoundEvent(TimeUnits rTime, int nEventType, JumpEntry* pJumpEntry, int nMeasure)
@@ -121,6 +126,7 @@ public:
         , Volume(0)
         , pJump(pJumpEntry)
         , Measure(nMeasure)
+        , Score(0)
     {
     }
     ~SoundEvent() {}
@@ -160,7 +166,53 @@ public:
         JumpEntry*      pJump;      //jump entry, for playback jumps
     };
     int             Measure;    //measure number containing this staffobj
+    int             Score;      //score index in mixed tables. 0 = main score
+
+};
+
+//---------------------------------------------------------------------------------------
+//MetronomeState: metronome settings for the time signature in effect. The click
+//interval for a new time signature is computed from the interval for the previous one,
+//so the state depends on all previous time signatures, not only on the last ones.
+class MetronomeState
+{
+public:
+    long curMtrIntval;          //current TS: metronome click interval, in milliseconds
+    long prevMtrIntval;         //previous TS: metronome click interval, in milliseconds
+    long curMeasureDuration;    //current TS: measure duration, in TU
+    long prevMeasureDuration;   //previous TS: measure duration, in TU
+    long curNumPulses;          //current TS: number of metronome pulses per measure
+    long prevNumPulses;         //previous TS: number of metronome pulses per measure
+    long mtrPulseDuration;      //a beat duration, in TU
+
+    MetronomeState();
+
+    //state before the first time signature: 4/4 is assumed
+    void initialize(long mtrIntval, long pulseDuration);
+
+    //apply a k_rhythm_change event. beatType is the Document beat type (enum EBeatDuration)
+    void apply_rhythm_change(const SoundEvent& event, int beatType);
 
+    bool operator ==(const MetronomeState& state) const;
+};
+
+//---------------------------------------------------------------------------------------
+//PlaybackSnapshot: playback state when a measure is reached for the first time in
+//normal playback, so that playback can start in any measure without having to process
+//all previous events.
+class PlaybackSnapshot
+{
+public:
+    int rhythmChange;               //index of last k_rhythm_change event before the
+                                    //measure, or -1 if none
+    MetronomeState metronome;       //metronome state when the measure starts. See
+                                    //SoundEventsTable::compute_metronome_states()
+    vector< pair<int, int> > jumps; //visited and executed counters for each jump.
+                                    //Empty if all counters are zero
+    vector<int> tiedNotes;          //index of the k_note_on events for the notes
+                                    //still sounding when the measure starts
+
+    PlaybackSnapshot() : rhythmChange(-1) {}
 };
 
 //---------------------------------------------------------------------------------------
@@ -170,8 +222,16 @@ class SoundEventsTable
 protected:
     ImoScore* m_pScore;
     int m_numMeasures;
-    vector<SoundEvent*> m_events;
+    vector<SoundEvent> m_events;
     vector<int> m_measures;
+    vector<TimeUnits> m_measureStart;               //start time of each measure
+    vector<PlaybackSnapshot> m_snapshots;           //playback state for each measure
+    vector<int> m_rhythmChanges;                    //index of k_rhythm_change events
+    MetronomeState m_mtrInitial;                    //settings used for computing the
+    int m_mtrBeatType;                              //  metronome state in snapshots
+    bool m_fMtrComputed;                            //metronome state is computed
+    vector<long> m_times;                           //event times, in milliseconds
+    float m_timesFactor;                            //conversion factor used for m_times
     vector<int> m_channels;
     vector<JumpEntry*> m_jumps;
     vector< pair<int, string> > m_targets;          //pair measure, label
@@ -183,21 +243,66 @@ public:
     SoundEventsTable(ImoScore* pScore);
     virtual ~SoundEventsTable();
 
+    //the table owns the jump entries
+    SoundEventsTable(const SoundEventsTable&) = delete;
+    SoundEventsTable& operator=(const SoundEventsTable&) = delete;
+
     void create_table();
 
+    //Regenerate only the events for measures firstMeasure to lastMeasure (1..n),
+    //after these measures have been edited. Events for other measures are kept, and
+    //jumps, labels, instrument programs and the measures table are rebuilt. If the
+    //duration of the edited measures or the time signature in effect after them has
+    //changed, all following measures are also regenerated. If the number of
+    //measures or instruments or the MIDI channel of an instrument has changed, the
+    //whole table is created again.
+    //AWARE: only the events for the regenerated measures are created and sorted, but
+    //finding them and rebuilding the jumps still requires a pass over the staffobjs
+    //table, as its rebuild in ImoScore::end_of_changes().
+    void update_table(int firstMeasure, int lastMeasure);
+
+    //As previous method, but taking the events for measures not modified from
+    //another table for the same score. That table is not modified, so it can be
+    //in use by the playback thread.
+    void update_table(const SoundEventsTable& table, int firstMeasure, int lastMeasure);
+
+    //Mixed playback: merge the events of the table for another score, so that both
+    //scores are played as a single stream. The MIDI channels of the other score are
+    //remapped to channels not used in this table, except channel 9 (percussion).
+    //Jumps and time signatures of the other score are ignored, as this score
+    //controls repetitions and metronome. Merged events are tagged with scoreIndex.
+    //Returns false, and the table is not modified, if there are not enough
+    //free MIDI channels.
+    bool mix_table(SoundEventsTable* pTable, int scoreIndex);
+
     inline int num_events() { return int(m_events.size()); }
-    vector<SoundEvent*>& get_events() { return m_events; }
+    vector<SoundEvent>& get_events() { return m_events; }
     vector<int>& get_channels() { return m_channels; }
     inline int get_first_event_for_measure(int nMeasure) { return m_measures[nMeasure]; }
     inline int get_last_event() { return int(m_events.size()) - 1; }
     inline int get_num_measures() { return m_numMeasures; }
     inline TimeUnits get_anacrusis_missing_time() { return m_rAnacrusisMissingTime; }
 
+    //timeline: absolute time (milliseconds) for each event. It is only recomputed
+    //when the conversion factor (millisecs per time unit) changes
+    vector<long>& get_timeline(float conversionFactor);
+
     //jumps table
     inline int num_jumps() { return int(m_jumps.size()); }
     JumpEntry* get_jump(int i);
     void reset_jumps();
 
+    //playback state at the start of each measure (0..n+1). It is computed when the
+    //table is created. restore_jumps() sets the jump counters as they are when the
+    //measure is reached for the first time in normal playback.
+    PlaybackSnapshot* get_snapshot(int nMeasure);
+    void restore_jumps(int nMeasure);
+
+    //metronome state at the start of each measure, for the metronome state before the
+    //first time signature and the beat type in use. It is saved in the snapshots and
+    //only recomputed when these settings change.
+    void compute_metronome_states(const MetronomeState& initial, int beatType);
+
     //debug
     string dump_midi_events();
 
@@ -207,7 +312,20 @@ protected:
                      int volume, int step, ImoStaffObj* pSO, int measure);
     void store_jump_event(TimeUnits rTime, JumpEntry* pJump, int measure);
     void program_sounds_for_instruments();
-    void create_events();
+    void create_events(int firstMeasure, int lastMeasure);
+    void update_events(const vector<SoundEvent>& oldEvents,
+                       const vector<TimeUnits>& oldStart, const vector<int>& oldChannels,
+                       int firstMeasure, int lastMeasure);
+    void merge_updated_events(const vector<SoundEvent>& oldEvents, int firstMeasure,
+                              int lastMeasure);
+    bool is_rhythm_changed(const vector<SoundEvent>& oldEvents, int firstMeasure,
+                           int lastMeasure);
+    const SoundEvent* find_last_rhythm_change(const vector<SoundEvent>& events,
+                                              int maxMeasure);
+    void clear_table();
+    void delete_jumps();
+    void create_snapshots();
+    void add_jumps_to_snapshots();
     void close_table();
     void sort_by_time();
     void create_measures_table();
@@ -36,6 +36,7 @@
 
 //other
 #include <iostream>
+#include <map>
 using namespace std;
 
 
@@ -52,7 +53,11 @@ class GmoObj;
 //---------------------------------------------------------------------------------------
 // OverlaysGenerator:
 //  responsible for generating all visual sprites and overlaying them onto the
-//  rendering buffer
+//  rendering buffer.
+//  For each visual effect it keeps the area covered the last time it was drawn. When
+//  effects have to be updated, only those areas are restored from the clean copy of
+//  the rendering buffer, and the reported damaged rectangle only includes the areas
+//  that have changed.
 class OverlaysGenerator
 {
 protected:
@@ -64,9 +69,10 @@ protected:
     bool m_fBackgroundDirty;            //overlays already applied to rendering buffer
     bool m_fFullRectangle;              //damaged rectangle is all screen
     int8u* m_pSaveBytes;                //the real buffer for the clean copy
-    URect m_damagedRect;
-    URect m_prevDamagedRect;
+    URect m_damagedRect;                //accumulated damage not yet reported
+    URect m_prevDamagedRect;            //last reported damaged rectangle
     GmoObj* m_pHandlersOwner;           //object owning current defined handlers
+    map<VisualEffect*, URect> m_drawnAreas;     //area covered by each drawn effect
 
 public:
     OverlaysGenerator(GraphicView* view, LibraryScope& libraryScope);
@@ -86,8 +92,13 @@ public:
     inline GmoObj* get_handlers_owner() { return m_pHandlersOwner; }
 
 protected:
+    void redraw_visual_effects(ScreenDrawer* pDrawer, VisualEffect* pUpdated);
     void save_rendering_buffer();
-    void expand_damaged_rectangle();
+    void restore_rendering_buffer(ScreenDrawer* pDrawer);
+    void restore_area(const VRect& area, int bytesPerPixel);
+    VRect area_to_pixels(const URect& area, ScreenDrawer* pDrawer);
+    int bytes_per_pixel();
+    URect expand_damaged_rectangle(const URect& rect);
 
 
 };
@@ -89,6 +89,9 @@ public:
     Presenter* open_document(int viewType, LdpReader& reader,
                              ostream& reporter = cout);
 
+    //helpers
+    static int determine_format(const std::string& filename);
+
 };
 ///@endcond
 
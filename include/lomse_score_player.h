@@ -35,7 +35,12 @@
 
 #include <vector>
 #include <thread>
+#include <mutex>
+#include <chrono>
+#include <atomic>
 #include <condition_variable>
+#include <deque>
+#include <memory>
 
 ///@cond INTERNALS
 namespace lomse
@@ -47,10 +52,12 @@ class ImoScore;
 class ImoStaffObj;
 class SoundEventsTable;
 class SoundEvent;
+class MetronomeState;
 class Interactor;
 class LibraryScope;
 class PlayerGui;
 class Metronome;
+class EventVisualTracking;
 
 //some constants for greater code legibility
 #define k_no_visual_tracking    false
@@ -136,6 +143,181 @@ public:
 };
 
 
+//---------------------------------------------------------------------------------------
+/** %PlaybackTimingStats contains the timing statistics measured by ScorePlayer during
+    playback: how late, with respect to the scheduled time, the playback thread
+    was able to process the sound events. All times are in microseconds.
+*/
+struct PlaybackTimingStats
+{
+    long numEvents;         ///< Number of scheduled time points processed
+    double meanLatency;     ///< Mean delay with respect to the scheduled time
+    double maxLatency;      ///< Maximum delay with respect to the scheduled time
+    double jitter;          ///< Standard deviation of the delay
+
+    PlaybackTimingStats()
+        : numEvents(0L), meanLatency(0.0), maxLatency(0.0), jitter(0.0)
+    {
+    }
+};
+
+//---------------------------------------------------------------------------------------
+/** %VisualTrackingRecord is the information for a visual tracking sub-event, as
+    stored in the VisualTrackingRing. It contains the same information than the
+    sub-events in an EventVisualTracking event.
+*/
+struct VisualTrackingRecord
+{
+    int type;               ///< Sub-event type, from enum EventVisualTracking::ETrackingEvent
+    ImoId scoreId;          ///< ID of the score being played back
+    ImoId id;               ///< ID of the note/rest, for highlight sub-events
+    TimeUnits timepos;      ///< Time position, for move tempo line sub-events
+};
+
+//---------------------------------------------------------------------------------------
+/** %VisualTrackingRing is a fixed capacity, lock-free queue for transferring
+    visual tracking records from the playback thread (the only producer) to the
+    thread that updates the display (the only consumer). It is used by ScorePlayer
+    when it is requested to not generate EventVisualTracking events (see
+    ScorePlayer::use_tracking_ring()).
+
+    If the ring is full, new records are discarded and counted as dropped.
+*/
+class VisualTrackingRing
+{
+protected:
+    std::vector<VisualTrackingRecord> m_records;
+    size_t m_mask;
+    std::atomic<size_t> m_head;     //next record to read. Only modified by the consumer
+    std::atomic<size_t> m_tail;     //next slot to write. Only modified by the producer
+    std::atomic<long> m_dropped;    //records discarded because the ring was full
+
+public:
+    /** Constructor.
+        @param capacity Maximum number of records in the ring. It is rounded up to
+            a power of two.
+    */
+    VisualTrackingRing(size_t capacity = 4096);
+
+    /** Producer side. Adds a record to the ring. Returns @FALSE if the ring is full
+        and the record has been discarded.
+    */
+    bool push(int type, ImoId scoreId, ImoId id, TimeUnits timepos);
+
+    /** Consumer side. Removes the oldest record from the ring and copies it
+        into @c record. Returns @FALSE if the ring is empty.
+    */
+    bool pop(VisualTrackingRecord& record);
+
+    /// Returns @TRUE if there are no records in the ring.
+    inline bool is_empty() { return m_head.load() == m_tail.load(); }
+
+    /// Returns the maximum number of records that the ring can contain.
+    inline size_t capacity() { return m_records.size(); }
+
+    /// Returns the number of records discarded because the ring was full.
+    inline long num_dropped() { return m_dropped.load(); }
+};
+
+
+///@cond INTERNALS
+//---------------------------------------------------------------------------------------
+// PlaybackScheduler: helper for ScorePlayer. It paces playback by waiting for
+// absolute deadlines on a monotonic clock, so that the time spent processing events
+// is not accumulated as timing errors. Times are expressed in milliseconds from the
+// start of the playback timeline. It also collects the timing statistics.
+class PlaybackScheduler
+{
+protected:
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point m_origin;             //time point for timeline time 0
+    Clock::time_point m_start;              //time point for playback start
+    Clock::time_point m_lastDeadline;       //last deadline waited for
+    Clock::time_point m_pauseStart;
+    std::chrono::microseconds m_spinTime;   //busy-wait before each deadline
+    bool m_fOffline;                        //do not wait. Time is simulated
+    std::mutex m_statsMutex;
+    long m_numEvents;
+    double m_sumLatency;
+    double m_sumSqLatency;
+    double m_maxLatency;
+
+public:
+    PlaybackScheduler();
+
+    //timeline
+    void start(long time);
+    void set_current_time(long time);
+    void wait_until(long time);
+    void pause();
+    void resume();
+    long get_elapsed_time();
+
+    //settings
+    void set_spin_time(long microseconds);
+    inline long get_spin_time() { return long(m_spinTime.count()); }
+    inline void set_offline(bool value) { m_fOffline = value; }
+    inline bool is_offline() { return m_fOffline; }
+
+    //statistics
+    PlaybackTimingStats get_stats();
+    void reset_stats();
+
+protected:
+    void add_latency(double latency);
+};
+
+//---------------------------------------------------------------------------------------
+// PlaybackCommand: a request for the playback thread. The application thread
+// enqueues commands and the playback thread processes them when idle or, while
+// playing, between events.
+struct PlaybackCommand
+{
+    enum ECommand
+    {
+        k_play = 0,     //play events nEvStart..nEvEnd. Current playback is stopped
+        k_pause,        //pause/resume current playback
+        k_stop,         //finish current playback
+        k_seek,         //continue current playback from event nEvStart
+        k_tempo,        //change tempo to nMM
+        k_terminate,    //finish the playback thread
+    };
+
+    int type;
+    int nEvStart;
+    int nEvEnd;
+    bool fVisualTracking;
+    long nMM;
+    Interactor* pInteractor;
+
+    PlaybackCommand(int cmd=k_stop, int start=0, int end=0, bool fTracking=false,
+                    long mm=0L, Interactor* pIntor=nullptr)
+        : type(cmd), nEvStart(start), nEvEnd(end), fVisualTracking(fTracking)
+        , nMM(mm), pInteractor(pIntor)
+    {
+    }
+};
+
+typedef std::deque<PlaybackCommand> PlaybackCommands;
+
+//---------------------------------------------------------------------------------------
+// PlaybackTrack: helper for ScorePlayer. A score being played back and the Interactor
+// for its visual tracking. In mixed playback there is a track for each score.
+struct PlaybackTrack
+{
+    ImoScore* pScore;
+    Interactor* pInteractor;                        //nullptr for no visual tracking
+    std::weak_ptr<Interactor> wpInteractor;
+    std::shared_ptr<EventVisualTracking> pEvent;    //pending visual tracking items
+
+    PlaybackTrack(ImoScore* score=nullptr, Interactor* pIntor=nullptr)
+        : pScore(score), pInteractor(pIntor)
+    {
+    }
+};
+///@endcond
+
 //---------------------------------------------------------------------------------------
 /** %ScorePlayer class is responsible for managing score playback.
     It provides the necessary methods for controlling all playback (start, stop, pause,
@@ -168,19 +350,29 @@ class ScorePlayer
 {
 protected:
     LibraryScope&       m_libScope;
-    SoundThread*        m_pThread;      //execution thread
-    std::mutex          m_startMutex;   //mutex so synchronize thread start
+    SoundThread*        m_pThread;      //playback thread. Lives until player deletion
+    std::mutex          m_commandsMutex;    //to control commands queue access
+    SoundFlag           m_newCommand;   //signals new commands for the thread
+    SoundFlag           m_idle;         //signals that the thread has finished playback
+    PlaybackCommands    m_commands;     //pending requests for the playback thread
+    PlaybackCommand     m_current;      //current playback parameters
     MidiServerBase*     m_pMidi;        //MIDI server to receive MIDI events
-    bool                m_fPaused;      //execution is paused
-    bool                m_fRunning;     //method do_play has not finished.
-    bool                m_fShouldStop;  //request to stop playback
-    bool                m_fPlaying;     //playing (control in do_play loop)
+    std::atomic<bool>   m_fPaused;      //execution is paused
+    std::atomic<bool>   m_fRunning;     //method do_play has not finished.
+    std::atomic<bool>   m_fShouldStop;  //request to stop playback
+    std::atomic<bool>   m_fPlaying;     //playing (control in do_play loop)
     bool                m_fPostEvents;  //post events to application events loop
     bool                m_fQuit;        //the request to stop is for application quit
     bool                m_fFinalEventSent;      //to avoid duplicating final event
     ImoScore*           m_pScore;       //score to play
-    SoundEventsTable*   m_pTable;
-    SoundFlag           m_canPlay;      //playback is not paused
+    SoundEventsTable*   m_pTable;       //table in use: score table or mixed table
+    std::shared_ptr<SoundEventsTable> m_spScoreTable;   //kept while in use, as the
+                                        //score creates a new one when edited
+    SoundEventsTable*   m_pMixedTable;  //owned table, for mixed playback
+    std::vector<PlaybackTrack> m_tracks;    //main score (index 0) and mixed scores
+    long                m_nRequestedMM; //pending tempo change. 0 = none
+    bool                m_fRestart;     //a new playback follows current one
+    bool                m_fRealTime;    //use real-time priority for playback thread
 
     //metronome: MIDI parameters
     int m_MtrChannel;
@@ -194,6 +386,10 @@ protected:
     Interactor*     m_pInteractor;
     PlayerGui*      m_pPlayerGui;
     Metronome*      m_pMtr;
+    PlaybackScheduler   m_scheduler;    //to pace events in do_play()
+    VisualTrackingRing  m_trackingRing; //visual tracking records for the display thread
+    bool                m_fUseTrackingRing;
+    bool                m_fOffline;     //play without waiting, in the calling thread
 
     friend class Injector;
     ScorePlayer(LibraryScope& libScope, MidiServerBase* pMidi);
@@ -221,6 +417,43 @@ public:
                     int metronomeChannel=9, int metronomeInstr=0,
                     int tone1=60, int tone2=77);
 
+    /** @name Mixed playback   */
+    //@{
+
+    /** Add a score to be played together with the score loaded by load_score(), for
+        instance an accompaniment for a student part. All scores are merged into a
+        single stream of events, time-ordered, that is played by the playback thread
+        and sent to the MidiServerBase object. Therefore, all scores share the timing
+        and there is no drift between them.
+
+        The score loaded by load_score() controls tempo, metronome, repetitions
+        and measure numbers. The time signatures and repetition marks in the added
+        score are ignored. The MIDI channels used in the added score are remapped to
+        channels not used by other scores, except channel 9 (percussion), that is
+        shared.
+
+        This method must be invoked after load_score(), as load_score() removes all
+        added scores. If any score is modified, all scores must be loaded again.
+
+        @param pScore A pointer to the score to add.
+        @param pInteractor Pointer to the Interactor associated to the View in which
+            the added score is displayed, for visual tracking. @nullptr (default) in
+            case the score is not displayed. Visual tracking events for the added
+            score are always sent as EventVisualTracking events, even when
+            use_tracking_ring() is enabled.
+        @return @FALSE if the score can not be added because there are not enough free
+            MIDI channels.
+    */
+    bool mix_score(ImoScore* pScore, Interactor* pInteractor = nullptr);
+
+    /** Remove all scores added by mix_score(). */
+    void remove_mixed_scores();
+
+    /** Returns the number of scores added by mix_score(). */
+    inline int num_mixed_scores() { return max(0, int(m_tracks.size()) - 1); }
+
+    //@}
+
     // methods to start playback
     /** @name Methods to start playback   */
     //@{
@@ -302,7 +535,8 @@ public:
     //@}    //Methods to start playback
 
     /** Finish current playback. To start a new playback you must invoke
-        any of the play methods.
+        any of the play methods. This method returns when the playback has finished.
+        Pending requests (play, pause, seek, etc.) are discarded.
     */
     void stop();
 
@@ -324,6 +558,109 @@ public:
     */
     inline bool is_playing() { return m_fPlaying; }
 
+    /** Continue current playback from the start of the indicated measure. The end
+        of the playback and all other playback options are not changed. If the
+        player is not playing, or the measure is after the end of current playback,
+        this method does nothing.
+        @param nMeasure Number of measure to continue playback (1..n).
+    */
+    void seek(int nMeasure);
+
+    /** Change the tempo of current playback. The new tempo will be used until the
+        end of current playback, and overrides the tempo specified in the play
+        method and the tempo in the metronome control (in PlayerGui object).
+        @param nMM New tempo speed, in BPM (beats per minute).
+    */
+    void set_tempo(long nMM);
+
+    /** @name Playback timing   */
+    //@{
+
+    /** Returns the timing statistics for the current playback or, if not playing,
+        for the last playback. Statistics are reset when a new playback starts.
+    */
+    inline PlaybackTimingStats get_timing_stats() { return m_scheduler.get_stats(); }
+
+    /** The playback thread sleeps until the time for next event arrives. As the
+        operating system can wake up the thread later than requested, the sleep can
+        be shortened by the amount of time specified here, and the remaining time
+        is spent in a busy-wait loop. This improves timing accuracy at the cost
+        of CPU usage.
+        @param microseconds Busy-wait time, in microseconds (0..1000). Default
+            value is 0, that is, no busy-wait.
+    */
+    inline void set_spin_wait(long microseconds) {
+        m_scheduler.set_spin_time(microseconds);
+    }
+
+    /** Request to run the playback thread with real-time scheduling (SCHED_FIFO
+        policy). This reduces the delays caused by other threads and processes but
+        requires privileges (e.g., CAP_SYS_NICE or an appropriate RLIMIT_RTPRIO
+        value). It is only available on Linux and other Unix platforms.
+        Returns @TRUE if the requested scheduling is in use or @FALSE if it is not
+        supported or not permitted. In this case, the normal scheduling is kept.
+        @param value @TRUE for real-time scheduling, @FALSE for normal scheduling.
+    */
+    bool set_realtime_priority(bool value);
+
+    /** Returns @TRUE if the playback thread is using real-time scheduling.
+        See set_realtime_priority().
+    */
+    inline bool is_realtime_priority() { return m_fRealTime; }
+
+    //@}
+
+    /** @name Offline playback   */
+    //@{
+
+    /** Play back the score in the calling thread, without waiting for the time of
+        each event, that is, as fast as possible. The MidiServerBase object receives
+        the same invocations, and in the same order, than in a normal playback with
+        the same options, including count-off, metronome clicks, jumps and repetitions,
+        but they are not issued in real time. Instead, the MIDI server can invoke
+        get_playback_time() for knowing the time at which each invocation should have
+        taken place. No visual tracking events are generated.
+
+        This method is used by MidiRecorder and MidiFileRenderer for converting a
+        score into a MIDI file.
+
+        @param startMeasure Number of measure to start playback (1..n).
+        @param numMeasures Number of measures to play. Value 0 (default) means:
+            play until the end of the score.
+        @param nMM Tempo speed for playback, as in play(). Value 0 (default) means that
+            tempo will be taken from the PlayerGui object specified in load_score().
+    */
+    void play_offline(int startMeasure=1, int numMeasures=0, long nMM=0);
+
+    /** Returns the time, in milliseconds, elapsed since the start of current
+        playback, including count-off. During a normal playback it is the time of the
+        last scheduled event, and during an offline playback it is the simulated
+        time. It is intended to be invoked from the MidiServerBase methods, for
+        timestamping the requests.
+    */
+    inline long get_playback_time() { return m_scheduler.get_elapsed_time(); }
+
+    //@}
+
+    /** @name Visual tracking   */
+    //@{
+
+    /** Select how visual tracking information is transferred to the View.
+        By default, the playback thread creates EventVisualTracking events and
+        posts them to your application (or sends them directly to the Interactor),
+        so the time spent for updating the display delays the playback thread.
+
+        When @c value is @TRUE, the playback thread does not generate events. It
+        just stores the visual tracking information in a lock-free ring buffer, and
+        your application is responsible for invoking, at display refresh rate (i.e.
+        from a timer in the GUI thread), Interactor::update_visual_tracking()
+        passing this player. That method will process all the pending information
+        and will update the display.
+    */
+    inline void use_tracking_ring(bool value) { m_fUseTrackingRing = value; }
+
+    //@}
+
 
 ///@cond INTERNALS
 //excluded from public API. Only for internal use.
@@ -331,7 +668,10 @@ public:
     //For selecting method to send events to user application
     inline void post_tracking_events(bool value) { m_fPostEvents = value; }
 
-    //only to be used by SoundThread
+    //access to the ring, when visual tracking is not done by events
+    inline VisualTrackingRing* get_tracking_ring() { return &m_trackingRing; }
+
+    //only to be used by the playback thread
     void do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
                  long nMM, Interactor* pInteractor );
 
@@ -339,10 +679,27 @@ public:
 
 protected:
     virtual void play_segment(int nEvStart, int nEvEnd);
-    void thread_main(int nEvStart, int nEvEnd, bool fVisualTracking, long nMM,
-                     Interactor* pInteractor);
+    void thread_main();
+    void play_command(const PlaybackCommand& cmd, PlaybackCommand& next);
+    void start_thread();
+    void terminate_thread();
+    void post_command(const PlaybackCommand& cmd);
+    void refresh_score_table();
+    void process_commands();
+    void wait_while_paused();
+    bool is_playback_thread();
+    bool apply_thread_priority(bool fRealTime);
     void end_of_playback_housekeeping(bool fVisualTracking, Interactor* pInteractor);
-    void set_new_beat_information(SoundEvent* pEvent);
+    void set_new_beat_information(const SoundEvent& event);
+    MetronomeState get_metronome_state();
+    void set_metronome_state(const MetronomeState& state);
+    void program_instrument(const SoundEvent& event, int playMode);
+    void start_tracking();
+    void flush_tracking_events();
+    void end_tracking();
+    void enable_forced_view_updates(bool value);
+    void add_tracking_item(int score, int type, ImoId id);
+    void add_tempo_line_item(TimeUnits timepos);
 
     //helper, for do_play()
     //-----------------------------------------------------------------------------------
@@ -146,6 +146,22 @@ public:
         return (it != m_list.end() ? *it : nullptr);
     }
 
+    //removes and deletes the oldest element in the stack
+    void remove_oldest() {
+        if (m_list.size() > 0)
+        {
+            delete m_list.front();
+            m_list.pop_front();
+        }
+    }
+
+    //iterators, from oldest to newest element, for the stack and for the history
+    typedef typename std::list<T>::iterator iterator;
+    iterator begin() { return m_list.begin(); }
+    iterator end() { return m_list.end(); }
+    iterator history_begin() { return m_history.begin(); }
+    iterator history_end() { return m_history.end(); }
+
 protected:
     void remove_history() {
         typename std::list<T>::iterator it;
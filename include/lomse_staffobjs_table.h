@@ -33,6 +33,7 @@
 #include <vector>
 #include <ostream>
 #include <map>
+#include <unordered_map>
 #include "lomse_document.h"
 #include "lomse_time.h"
 
@@ -53,6 +54,7 @@ class ImoScore;
 class ImoTimeSignature;
 class ImoGoBackFwd;
 class ImoMusicData;
+class ColStaffObjsIndex;
 
 
 //---------------------------------------------------------------------------------------
@@ -65,6 +67,7 @@ protected:
     int                 m_instr;
     int                 m_line;
     int                 m_staff;
+    int                 m_index;    //position in the collection. Set by ColStaffObjsIndex
     ImoStaffObj*        m_pImo;
 
     ColStaffObjsEntry*  m_pNext;    //next entry in the collection
@@ -76,6 +79,7 @@ public:
         , m_instr(instr)
         , m_line(line)
         , m_staff(staff)
+        , m_index(-1)
         , m_pImo(pImo)
         , m_pNext(nullptr)
         , m_pPrev(nullptr)
@@ -111,6 +115,10 @@ protected:
     inline void set_next(ColStaffObjsEntry* pEntry) { m_pNext = pEntry; }
     inline void set_prev(ColStaffObjsEntry* pEntry) { m_pPrev = pEntry; }
 
+    friend class ColStaffObjsIndex;
+    inline int index() const { return m_index; }
+    inline void set_index(int index) { m_index = index; }
+
 
 };
 
@@ -131,6 +139,7 @@ protected:
 
     ColStaffObjsEntry* m_pFirst;
     ColStaffObjsEntry* m_pLast;
+    ColStaffObjsIndex* m_pIndex;
 
 public:
     ColStaffObjs();
@@ -225,10 +234,15 @@ public:
     inline ColStaffObjsEntry* front() { return m_pFirst; }
     inline iterator find(ImoStaffObj* pSO) { return iterator(find_entry_for(pSO)); }
 
+    //index for direct positioning. Created on demand and discarded when the table
+    //is modified
+    ColStaffObjsIndex* get_index();
+
     //debug
     string dump(bool fWithIds=true);
 
 protected:
+    void invalidate_index();
 
     friend class ColStaffObjsBuilder;
     friend class ColStaffObjsBuilderEngine;
@@ -249,6 +263,55 @@ protected:
 typedef  ColStaffObjs::iterator      ColStaffObjsIterator;
 
 
+//---------------------------------------------------------------------------------------
+// ColStaffObjsIndex: index for locating entries in a ColStaffObjs table without
+// traversing it: by object id, by instrument/staff and timepos, and by instrument and
+// measure. It is used by ScoreCursor for direct positioning.
+//---------------------------------------------------------------------------------------
+class ColStaffObjsIndex
+{
+protected:
+    typedef vector<ColStaffObjsEntry*> Entries;
+
+    std::unordered_map<ImoId, ColStaffObjsEntry*> m_ids;
+    vector<Entries> m_instruments;              //entries for each instrument
+    vector< vector<Entries> > m_staves;         //[instr][staff]: entries and barlines
+    vector<Entries> m_barlines;                 //barlines for each instrument
+    vector<Entries> m_timeSignatures;           //time signatures for each instrument
+    vector< map<int, ColStaffObjsEntry*> > m_measures;  //first barline in each measure
+
+public:
+    ColStaffObjsIndex(ColStaffObjs* pColStaffObjs);
+    ~ColStaffObjsIndex() {}
+
+    //Returns the entry for the staffobj with the given id, or nullptr
+    ColStaffObjsEntry* find_entry(ImoId id);
+
+    //Returns the first barline in instrument instr with the given measure number
+    ColStaffObjsEntry* find_barline(int instr, int measure);
+
+    //Returns the first entry in instrument instr that is not before pStart and whose
+    //timepos is not lower than time. If staff >= 0 only entries in that staff and
+    //barlines are considered. pStart == nullptr means from start of table.
+    ColStaffObjsEntry* find_entry_not_before(int instr, int staff, TimeUnits time,
+                                             ColStaffObjsEntry* pStart);
+
+    //Return the last barline/time signature in instrument instr placed before pEntry
+    ColStaffObjsEntry* find_barline_before(int instr, ColStaffObjsEntry* pEntry);
+    ColStaffObjsEntry* find_time_signature_before(int instr, ColStaffObjsEntry* pEntry);
+
+    //Returns the last entry for instrument instr
+    ColStaffObjsEntry* last_entry(int instr);
+
+protected:
+    void build(ColStaffObjs* pColStaffObjs);
+    ColStaffObjsEntry* find_last_before(Entries& entries, ColStaffObjsEntry* pEntry);
+    inline bool is_valid_instrument(int instr) {
+        return instr >= 0 && instr < int(m_instruments.size());
+    }
+};
+
+
 //---------------------------------------------------------------------------------------
 // StaffVoiceLineTable: algorithm assign line number to voices/staves
 //---------------------------------------------------------------------------------------
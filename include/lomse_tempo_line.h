@@ -96,6 +96,7 @@ public:
     //mandatory overrides from VisualEffect
     void on_draw(ScreenDrawer* pDrawer);
     URect get_bounds() { return m_bounds; }
+    URect get_view_bounds() { return m_viewBounds; }
 
 protected:
 
@@ -64,6 +64,7 @@ public:
     //operations
     void on_draw(ScreenDrawer* pDrawer);
     URect get_bounds() { return m_bounds; }
+    URect get_view_bounds() { return m_viewBounds; }
 
     //getters
     inline Color get_color() const { return m_color; }
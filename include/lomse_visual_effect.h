@@ -65,6 +65,7 @@ protected:
     GraphicView* m_pView;       //the view to which this visual effect is associated
     bool m_fVisible;
     bool m_fEnabled;
+    URect m_viewBounds;         //area covered by last on_draw(), in view coordinates
 
     VisualEffect(GraphicView* view, LibraryScope& libraryScope);
 
@@ -87,6 +88,13 @@ public:
     //size when rendered
     virtual URect get_bounds() = 0;
 
+    /** Returns the area covered by this effect when it was last rendered, in view
+        coordinates. By default it is assumed that get_bounds() is expressed in view
+        coordinates. Effects that are drawn relative to a page origin must override
+        this method.
+    */
+    virtual URect get_view_bounds() { return get_bounds(); }
+
 
 protected:
     friend class OverlaysGenerator;
@@ -95,6 +103,9 @@ protected:
     //Returns the GraphicView to which this visual effect is associated
     inline GraphicView* get_view() { return m_pView; }
 
+    //helper for effects drawn relative to a page origin
+    void add_view_bounds(const URect& bounds, const UPoint& org);
+
 
 ///@endcond
 };
@@ -194,6 +205,7 @@ public:
     //mandatory overrides from VisualEffect
     void on_draw(ScreenDrawer* pDrawer);
     URect get_bounds();
+    URect get_view_bounds() { return m_viewBounds; }
 
 ///@endcond
 };
@@ -217,6 +229,7 @@ public:
     //mandatory overrides from VisualEffect
     void on_draw(ScreenDrawer* pDrawer);
     URect get_bounds();
+    URect get_view_bounds() { return m_viewBounds; }
 
     //other
     bool are_handlers_needed();
@@ -28,6 +28,7 @@
 #include <math.h>
 #include "agg_pixfmt_base.h"
 #include "agg_rendering_buffer.h"
+#include "agg_span_blend_simd.h"     //Lomse: SIMD span blending
 
 namespace agg
 {
@@ -201,6 +202,18 @@ namespace agg
     };
 
 
+    //=====================================================blender_rgba8_simd
+    //Lomse: pixel formats using blender_rgba with 8 bits per component have
+    //SIMD implementations for the span blending loops (agg_span_blend_simd.h)
+    template<class Blender> struct blender_rgba8_simd { enum { value = 0 }; };
+#if !defined(AGG_NO_SIMD)
+    template<class Order> struct blender_rgba8_simd< blender_rgba<rgba8, Order> >
+    {
+        enum { value = 1 };
+    };
+#endif
+
+
     //========================================================blender_rgba_pre
     // Blends premultiplied colors into a premultiplied buffer.
     template<class ColorT, class Order> 
@@ -1581,6 +1594,13 @@ namespace agg
             m_blender.blend_pix(p->c, c.r, c.g, c.b, c.a, cover);
         }
 
+        //--------------------------------------------------------------------
+        //Lomse: components order, for the SIMD implementation
+        static AGG_INLINE simd::order_e simd_order()
+        {
+            return simd::order_e(simd::order32<order_type>::value);
+        }
+
         //--------------------------------------------------------------------
         AGG_INLINE void blend_pix(pixel_type* p, const color_type& c)
         {
@@ -1733,6 +1753,14 @@ namespace agg
                                    unsigned len, 
                                    const color_type& c)
         {
+            //Lomse: SIMD implementation
+            if (blender_rgba8_simd<blender_type>::value)
+            {
+                simd::copy_hline_rgba8((int8u*)pix_value_ptr(x, y, len), len,
+                                       (const int8u*)&c, simd_order());
+                return;
+            }
+
             pixel_type v;
             v.set(c);
             pixel_type* p = pix_value_ptr(x, y, len);
@@ -1768,6 +1796,15 @@ namespace agg
             if (!c.is_transparent())
             {
                 pixel_type* p = pix_value_ptr(x, y, len);
+
+                //Lomse: SIMD implementation
+                if (blender_rgba8_simd<blender_type>::value)
+                {
+                    simd::blend_hline_rgba8((int8u*)p, len, (const int8u*)&c, cover,
+                                            simd_order());
+                    return;
+                }
+
                 if (c.is_opaque() && cover == cover_mask)
                 {
                     pixel_type v;
@@ -1854,6 +1891,15 @@ namespace agg
             if (!c.is_transparent())
             {
                 pixel_type* p = pix_value_ptr(x, y, len);
+
+                //Lomse: SIMD implementation
+                if (blender_rgba8_simd<blender_type>::value)
+                {
+                    simd::blend_solid_hspan_rgba8((int8u*)p, len, (const int8u*)&c,
+                                                  covers, simd_order());
+                    return;
+                }
+
                 do 
                 {
                     if (c.is_opaque() && *covers == cover_mask)
@@ -1932,6 +1978,15 @@ namespace agg
                                int8u cover)
         {
             pixel_type* p = pix_value_ptr(x, y, len);
+
+            //Lomse: SIMD implementation
+            if (blender_rgba8_simd<blender_type>::value)
+            {
+                simd::blend_color_hspan_rgba8((int8u*)p, len, (const int8u*)colors,
+                                              covers, cover, simd_order());
+                return;
+            }
+
             if (covers)
             {
                 do 
@@ -0,0 +1,125 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+//
+// Lomse: SIMD implementation of the span blending loops used by the 32 bits
+// (8 bits per channel) pixel formats defined in agg_pixfmt_rgba.h.
+//
+//---------------------------------------------------------------------------------------
+
+#ifndef AGG_SPAN_BLEND_SIMD_INCLUDED
+#define AGG_SPAN_BLEND_SIMD_INCLUDED
+
+#include "agg_basics.h"
+#include "agg_color_rgba.h"
+
+// Define AGG_NO_SIMD for building only the scalar implementation
+#if !defined(AGG_NO_SIMD)
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define AGG_SIMD_SSE2   1
+        #if defined(__GNUC__) || defined(_MSC_VER)
+            #define AGG_SIMD_AVX2   1
+        #endif
+    #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        #define AGG_SIMD_NEON   1
+    #endif
+#endif
+
+
+namespace agg
+{
+namespace simd
+{
+    //--------------------------------------------------------------------
+    // Instruction sets for which an implementation exists. The best one
+    // supported by the CPU is selected at run time, the first time a span
+    // is blended.
+    enum isa_e
+    {
+        isa_scalar = 0,
+        isa_sse2,
+        isa_avx2,
+        isa_neon,
+    };
+
+    // Instruction set in use
+    isa_e get_isa();
+
+    // Best instruction set supported by the CPU
+    isa_e detect_isa();
+
+    // Force the use of instruction set isa, i.e. for tests or benchmarks.
+    // Returns false, and nothing is changed, if it is not supported by the CPU.
+    bool set_isa(isa_e isa);
+
+    // Name of the instruction set
+    const char* isa_name(isa_e isa);
+
+    //--------------------------------------------------------------------
+    // Position of each component in the pixels of a 32 bits format. Same
+    // values than in order_rgba, order_argb, order_abgr and order_bgra.
+    enum order_e
+    {
+        order_rgba32 = 0,
+        order_argb32,
+        order_abgr32,
+        order_bgra32,
+    };
+
+    template<class Order> struct order32;
+    template<> struct order32<order_rgba> { enum { value = order_rgba32 }; };
+    template<> struct order32<order_argb> { enum { value = order_argb32 }; };
+    template<> struct order32<order_abgr> { enum { value = order_abgr32 }; };
+    template<> struct order32<order_bgra> { enum { value = order_bgra32 }; };
+
+    //--------------------------------------------------------------------
+    // All blending functions follow blender_rgba<rgba8, Order> semantics:
+    // plain (non-premultiplied) colors are blended into a premultiplied
+    // buffer. Results are identical to the ones of the scalar AGG code.
+
+    // Blend a solid color, with a cover value for each pixel.
+    // color: r, g, b, a values.
+    void blend_solid_hspan_rgba8(int8u* p, unsigned len, const int8u* color,
+                                 const int8u* covers, order_e order);
+
+    // Blend a solid color, with the same cover value for all pixels.
+    void blend_hline_rgba8(int8u* p, unsigned len, const int8u* color,
+                           unsigned cover, order_e order);
+
+    // Blend an array of rgba8 colors. If covers is null, the same cover
+    // value is used for all pixels.
+    void blend_color_hspan_rgba8(int8u* p, unsigned len, const int8u* colors,
+                                 const int8u* covers, unsigned cover, order_e order);
+
+    // Copy a solid color.
+    void copy_hline_rgba8(int8u* p, unsigned len, const int8u* color, order_e order);
+
+}
+}
+
+#endif
@@ -0,0 +1,751 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+//
+// Lomse: SIMD implementation of the span blending loops used by the 32 bits
+// (8 bits per channel) pixel formats defined in agg_pixfmt_rgba.h.
+//
+// Blending a plain color (r, g, b, a) with cover c into a premultiplied pixel p is,
+// for the scalar AGG code:
+//      alpha = multiply(a, c)
+//      p[R] = lerp(p[R], r, alpha)     (same for G and B)
+//      p[A] = prelerp(p[A], alpha, alpha)
+//
+// and, for 8 bits values, lerp(p, q, alpha) == div255(p * (255 - alpha) + q * alpha)
+// and prelerp(p, alpha, alpha) == lerp(p, 255, alpha) for all possible values. Thus,
+// the four components can be processed in the same way, by using 255 as the color
+// alpha value, and all intermediate values fit in 16 bits unsigned integers.
+//
+//---------------------------------------------------------------------------------------
+
+#include "agg_span_blend_simd.h"
+
+#include <string.h>
+
+#if defined(AGG_SIMD_SSE2)
+    #include <emmintrin.h>
+    #if defined(AGG_SIMD_AVX2)
+        #include <immintrin.h>
+        #if defined(_MSC_VER)
+            #include <intrin.h>
+            #define AGG_TARGET_AVX2
+        #else
+            #define AGG_TARGET_AVX2     __attribute__((target("avx2")))
+        #endif
+    #endif
+#elif defined(AGG_SIMD_NEON)
+    #include <arm_neon.h>
+#endif
+
+
+namespace agg
+{
+namespace simd
+{
+
+//---------------------------------------------------------------------------------------
+// component positions, in pixel, for each order_e value
+struct order_table
+{
+    unsigned R, G, B, A;
+};
+
+static const order_table s_orders[4] =
+{
+    { order_rgba::R, order_rgba::G, order_rgba::B, order_rgba::A },
+    { order_argb::R, order_argb::G, order_argb::B, order_argb::A },
+    { order_abgr::R, order_abgr::G, order_abgr::B, order_abgr::A },
+    { order_bgra::R, order_bgra::G, order_bgra::B, order_bgra::A },
+};
+
+//---------------------------------------------------------------------------------------
+// color components in pixel order, with alpha = 255 (q) and with real alpha (pix)
+struct solid_color
+{
+    int8u q[4];
+    int8u pix[4];
+    unsigned alpha;
+
+    solid_color(const int8u* color, order_e order)
+    {
+        const order_table& o = s_orders[order];
+        pix[o.R] = q[o.R] = color[0];
+        pix[o.G] = q[o.G] = color[1];
+        pix[o.B] = q[o.B] = color[2];
+        pix[o.A] = color[3];
+        q[o.A] = 255;
+        alpha = color[3];
+    }
+};
+
+//---------------------------------------------------------------------------------------
+static inline unsigned div255(unsigned v)
+{
+    v += 128;
+    return ((v >> 8) + v) >> 8;
+}
+
+//---------------------------------------------------------------------------------------
+static inline int8u lerp(unsigned p, unsigned q, unsigned a)
+{
+    return int8u( div255(p * (255 - a) + q * a) );
+}
+
+//---------------------------------------------------------------------------------------
+static inline void blend_pix(int8u* p, const int8u* q, unsigned a)
+{
+    p[0] = lerp(p[0], q[0], a);
+    p[1] = lerp(p[1], q[1], a);
+    p[2] = lerp(p[2], q[2], a);
+    p[3] = lerp(p[3], q[3], a);
+}
+
+
+//=======================================================================================
+// Scalar implementation. Also used for the last pixels of a span.
+//=======================================================================================
+static void blend_solid_hspan_scalar(int8u* p, unsigned len, const solid_color& c,
+                                     const int8u* covers)
+{
+    for (; len > 0; --len, p += 4, ++covers)
+    {
+        if (c.alpha == 255 && *covers == 255)
+            memcpy(p, c.pix, 4);
+        else
+            blend_pix(p, c.q, div255(c.alpha * *covers));
+    }
+}
+
+//---------------------------------------------------------------------------------------
+static void blend_hline_scalar(int8u* p, unsigned len, const solid_color& c,
+                               unsigned alpha)
+{
+    for (; len > 0; --len, p += 4)
+        blend_pix(p, c.q, alpha);
+}
+
+//---------------------------------------------------------------------------------------
+static void blend_color_hspan_scalar(int8u* p, unsigned len, const int8u* colors,
+                                     const int8u* covers, unsigned cover, order_e order)
+{
+    const order_table& o = s_orders[order];
+    int8u q[4];
+    q[o.A] = 255;
+    for (; len > 0; --len, p += 4, colors += 4)
+    {
+        unsigned c = (covers ? *covers++ : cover);
+        unsigned alpha = div255(colors[3] * c);
+        if (alpha != 0)
+        {
+            q[o.R] = colors[0];
+            q[o.G] = colors[1];
+            q[o.B] = colors[2];
+            blend_pix(p, q, alpha);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------
+static void copy_hline_scalar(int8u* p, unsigned len, const solid_color& c)
+{
+    for (; len > 0; --len, p += 4)
+        memcpy(p, c.pix, 4);
+}
+
+
+#if defined(AGG_SIMD_SSE2)
+//=======================================================================================
+// SSE2 implementation: four pixels per iteration
+//=======================================================================================
+static inline __m128i div255_sse2(__m128i v)
+{
+    v = _mm_add_epi16(v, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+}
+
+//---------------------------------------------------------------------------------------
+static inline __m128i lerp_sse2(__m128i p, __m128i q, __m128i a)
+{
+    __m128i ia = _mm_sub_epi16(_mm_set1_epi16(255), a);
+    return div255_sse2( _mm_add_epi16(_mm_mullo_epi16(p, ia), _mm_mullo_epi16(q, a)) );
+}
+
+//---------------------------------------------------------------------------------------
+// blends four pixels. alpha: 16 bits alpha values for the four pixels, in the
+// lower half of the register
+static inline void blend_4pix_sse2(int8u* p, __m128i q, __m128i alpha)
+{
+    __m128i zero = _mm_setzero_si128();
+    alpha = _mm_unpacklo_epi16(alpha, alpha);
+    __m128i a01 = _mm_unpacklo_epi32(alpha, alpha);
+    __m128i a23 = _mm_unpackhi_epi32(alpha, alpha);
+
+    __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i d01 = lerp_sse2(_mm_unpacklo_epi8(d, zero), q, a01);
+    __m128i d23 = lerp_sse2(_mm_unpackhi_epi8(d, zero), q, a23);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_packus_epi16(d01, d23));
+}
+
+//---------------------------------------------------------------------------------------
+static inline __m128i load_q_sse2(const solid_color& c)
+{
+    return _mm_set_epi16(c.q[3], c.q[2], c.q[1], c.q[0], c.q[3], c.q[2], c.q[1], c.q[0]);
+}
+
+//---------------------------------------------------------------------------------------
+static inline int32u load_4covers(const int8u* covers)
+{
+    int32u value;
+    memcpy(&value, covers, 4);
+    return value;
+}
+
+//---------------------------------------------------------------------------------------
+static void blend_solid_hspan_sse2(int8u* p, unsigned len, const solid_color& c,
+                                   const int8u* covers)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i q = load_q_sse2(c);
+    __m128i ca = _mm_set1_epi16(short(c.alpha));
+    int32u pix;
+    memcpy(&pix, c.pix, 4);
+    __m128i opaque = _mm_set1_epi32(int(pix));
+
+    for (; len >= 4; len -= 4, p += 4*4, covers += 4)
+    {
+        int32u cover4 = load_4covers(covers);
+        if (cover4 == 0)
+            continue;
+
+        if (cover4 == 0xFFFFFFFF && c.alpha == 255)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p), opaque);
+            continue;
+        }
+
+        __m128i cov = _mm_unpacklo_epi8(_mm_cvtsi32_si128(int(cover4)), zero);
+        blend_4pix_sse2(p, q, div255_sse2(_mm_mullo_epi16(cov, ca)));
+    }
+    blend_solid_hspan_scalar(p, len, c, covers);
+}
+
+//---------------------------------------------------------------------------------------
+static void blend_hline_sse2(int8u* p, unsigned len, const solid_color& c,
+                             unsigned alpha)
+{
+    __m128i q = load_q_sse2(c);
+    __m128i a = _mm_set1_epi16(short(alpha));
+    for (; len >= 4; len -= 4, p += 4*4)
+        blend_4pix_sse2(p, q, a);
+    blend_hline_scalar(p, len, c, alpha);
+}
+
+//---------------------------------------------------------------------------------------
+// S0..S3: color component (0=r, 1=g, 2=b, 3=a) for each pixel position
+template<int S0, int S1, int S2, int S3>
+static void blend_color_hspan_sse2_t(int8u* p, unsigned len, const int8u* colors,
+                                     const int8u* covers, unsigned cover, order_e order)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i amask = _mm_set_epi16(S3 == 3 ? 255 : 0, S2 == 3 ? 255 : 0,
+                                  S1 == 3 ? 255 : 0, S0 == 3 ? 255 : 0,
+                                  S3 == 3 ? 255 : 0, S2 == 3 ? 255 : 0,
+                                  S1 == 3 ? 255 : 0, S0 == 3 ? 255 : 0);
+    __m128i const_cover = _mm_set1_epi16(short(cover));
+
+    for (; len >= 4; len -= 4, p += 4*4, colors += 4*4)
+    {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(colors));
+        __m128i c01 = _mm_unpacklo_epi8(c, zero);
+        __m128i c23 = _mm_unpackhi_epi8(c, zero);
+
+        //color alpha values, replicated
+        __m128i a01 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c01, 0xFF), 0xFF);
+        __m128i a23 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c23, 0xFF), 0xFF);
+
+        //cover values, replicated
+        __m128i cov01, cov23;
+        if (covers)
+        {
+            __m128i cov = _mm_unpacklo_epi8(_mm_cvtsi32_si128(int(load_4covers(covers))),
+                                            zero);
+            covers += 4;
+            cov = _mm_unpacklo_epi16(cov, cov);
+            cov01 = _mm_unpacklo_epi32(cov, cov);
+            cov23 = _mm_unpackhi_epi32(cov, cov);
+        }
+        else
+        {
+            cov01 = cov23 = const_cover;
+        }
+        a01 = div255_sse2(_mm_mullo_epi16(a01, cov01));
+        a23 = div255_sse2(_mm_mullo_epi16(a23, cov23));
+
+        //colors in pixel order, with alpha = 255
+        const int imm = _MM_SHUFFLE(S3, S2, S1, S0);
+        __m128i q01 = _mm_or_si128(
+                        _mm_shufflehi_epi16(_mm_shufflelo_epi16(c01, imm), imm), amask);
+        __m128i q23 = _mm_or_si128(
+                        _mm_shufflehi_epi16(_mm_shufflelo_epi16(c23, imm), imm), amask);
+
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i d01 = lerp_sse2(_mm_unpacklo_epi8(d, zero), q01, a01);
+        __m128i d23 = lerp_sse2(_mm_unpackhi_epi8(d, zero), q23, a23);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_packus_epi16(d01, d23));
+    }
+    blend_color_hspan_scalar(p, len, colors, covers, cover, order);
+}
+
+//---------------------------------------------------------------------------------------
+static void blend_color_hspan_sse2(int8u* p, unsigned len, const int8u* colors,
+                                   const int8u* covers, unsigned cover, order_e order)
+{
+    switch (order)
+    {
+        case order_rgba32:
+            blend_color_hspan_sse2_t<0,1,2,3>(p, len, colors, covers, cover, order);
+            break;
+        case order_argb32:
+            blend_color_hspan_sse2_t<3,0,1,2>(p, len, colors, covers, cover, order);
+            break;
+        case order_abgr32:
+            blend_color_hspan_sse2_t<3,2,1,0>(p, len, colors, covers, cover, order);
+            break;
+        case order_bgra32:
+            blend_color_hspan_sse2_t<2,1,0,3>(p, len, colors, covers, cover, order);
+            break;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+static void copy_hline_sse2(int8u* p, unsigned len, const solid_color& c)
+{
+    int32u pix;
+    memcpy(&pix, c.pix, 4);
+    __m128i v = _mm_set1_epi32(int(pix));
+    for (; len >= 4; len -= 4, p += 4*4)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+    copy_hline_scalar(p, len, c);
+}
+
+#endif  //AGG_SIMD_SSE2
+
+
+#if defined(AGG_SIMD_AVX2)
+//=======================================================================================
+// AVX2 implementation: eight pixels per iteration
+//=======================================================================================
+AGG_TARGET_AVX2
+static inline __m256i div255_avx2(__m256i v)
+{
+    v = _mm256_add_epi16(v, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(v, _mm256_srli_epi16(v, 8)), 8);
+}
+
+//---------------------------------------------------------------------------------------
+AGG_TARGET_AVX2
+static inline __m256i lerp_avx2(__m256i p, __m256i q, __m256i a)
+{
+    __m256i ia = _mm256_sub_epi16(_mm256_set1_epi16(255), a);
+    return div255_avx2( _mm256_add_epi16(_mm256_mullo_epi16(p, ia),
+                                         _mm256_mullo_epi16(q, a)) );
+}
+
+//---------------------------------------------------------------------------------------
+// blends eight pixels. alpha: 16 bits alpha values for the eight pixels
+AGG_TARGET_AVX2
+static inline void blend_8pix_avx2(int8u* p, __m256i q, __m128i alpha)
+{
+    //replicate each alpha value four times
+    __m256i a0123 = _mm256_cvtepu16_epi64(alpha);
+    __m256i a4567 = _mm256_cvtepu16_epi64(_mm_srli_si128(alpha, 8));
+    a0123 = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(a0123, 0), 0);
+    a4567 = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(a4567, 0), 0);
+
+    __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i d0123 = lerp_avx2(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(d)), q, a0123);
+    __m256i d4567 = lerp_avx2(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(d, 1)),
+                              q, a4567);
+    d = _mm256_permute4x64_epi64(_mm256_packus_epi16(d0123, d4567),
+                                 _MM_SHUFFLE(3, 1, 2, 0));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), d);
+}
+
+//---------------------------------------------------------------------------------------
+AGG_TARGET_AVX2
+static inline __m256i load_q_avx2(const solid_color& c)
+{
+    int32u q;
+    memcpy(&q, c.q, 4);
+    return _mm256_cvtepu8_epi16(_mm_set1_epi32(int(q)));
+}
+
+//---------------------------------------------------------------------------------------
+AGG_TARGET_AVX2
+static void blend_solid_hspan_avx2(int8u* p, unsigned len, const solid_color& c,
+                                   const int8u* covers)
+{
+    __m256i q = load_q_avx2(c);
+    __m128i ca = _mm_set1_epi16(short(c.alpha));
+    int32u pix;
+    memcpy(&pix, c.pix, 4);
+    __m256i opaque = _mm256_set1_epi32(int(pix));
+
+    for (; len >= 8; len -= 8, p += 8*4, covers += 8)
+    {
+        __m128i cov8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(covers));
+        int zeros = _mm_movemask_epi8(_mm_cmpeq_epi8(cov8, _mm_setzero_si128())) & 0xFF;
+        if (zeros == 0xFF)
+            continue;
+
+        int full = _mm_movemask_epi8(_mm_cmpeq_epi8(cov8, _mm_set1_epi8(-1))) & 0xFF;
+        if (full == 0xFF && c.alpha == 255)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), opaque);
+            continue;
+        }
+
+        __m128i cov = _mm_cvtepu8_epi16(cov8);
+        __m128i alpha = _mm_add_epi16(_mm_mullo_epi16(cov, ca), _mm_set1_epi16(128));
+        alpha = _mm_srli_epi16(_mm_add_epi16(alpha, _mm_srli_epi16(alpha, 8)), 8);
+        blend_8pix_avx2(p, q, alpha);
+    }
+
+    //avoid AVX-SSE transition penalties in the remaining code
+    _mm256_zeroupper();
+    blend_solid_hspan_sse2(p, len, c, covers);
+}
+
+//---------------------------------------------------------------------------------------
+AGG_TARGET_AVX2
+static void blend_hline_avx2(int8u* p, unsigned len, const solid_color& c,
+                             unsigned alpha)
+{
+    __m256i q = load_q_avx2(c);
+    __m128i a = _mm_set1_epi16(short(alpha));
+    for (; len >= 8; len -= 8, p += 8*4)
+        blend_8pix_avx2(p, q, a);
+
+    //avoid AVX-SSE transition penalties in the remaining code
+    _mm256_zeroupper();
+    blend_hline_sse2(p, len, c, alpha);
+}
+
+//---------------------------------------------------------------------------------------
+AGG_TARGET_AVX2
+static void copy_hline_avx2(int8u* p, unsigned len, const solid_color& c)
+{
+    int32u pix;
+    memcpy(&pix, c.pix, 4);
+    __m256i v = _mm256_set1_epi32(int(pix));
+    for (; len >= 8; len -= 8, p += 8*4)
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+
+    //avoid AVX-SSE transition penalties in the remaining code
+    _mm256_zeroupper();
+    copy_hline_scalar(p, len, c);
+}
+
+//---------------------------------------------------------------------------------------
+static bool cpu_has_avx2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    bool fOsxsave = (info[2] & (1 << 27)) != 0;
+    bool fAvx = (info[2] & (1 << 28)) != 0;
+    if (!fOsxsave || !fAvx || (_xgetbv(0) & 0x6) != 0x6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif  //AGG_SIMD_AVX2
+
+
+#if defined(AGG_SIMD_NEON)
+//=======================================================================================
+// NEON implementation: eight pixels per iteration, de-interleaved by components
+//=======================================================================================
+static inline uint8x8_t div255_neon(uint16x8_t v)
+{
+    v = vaddq_u16(v, vdupq_n_u16(128));
+    return vshrn_n_u16(vsraq_n_u16(v, v, 8), 8);
+}
+
+//---------------------------------------------------------------------------------------
+static inline uint8x8_t lerp_neon(uint8x8_t p, uint8x8_t q, uint8x8_t a)
+{
+    return div255_neon( vmlal_u8(vmull_u8(p, vmvn_u8(a)), q, a) );
+}
+
+//---------------------------------------------------------------------------------------
+static inline void blend_8pix_neon(int8u* p, const int8u* q, uint8x8_t a)
+{
+    uint8x8x4_t d = vld4_u8(p);
+    d.val[0] = lerp_neon(d.val[0], vdup_n_u8(q[0]), a);
+    d.val[1] = lerp_neon(d.val[1], vdup_n_u8(q[1]), a);
+    d.val[2] = lerp_neon(d.val[2], vdup_n_u8(q[2]), a);
+    d.val[3] = lerp_neon(d.val[3], vdup_n_u8(q[3]), a);
+    vst4_u8(p, d);
+}
+
+//---------------------------------------------------------------------------------------
+static void blend_solid_hspan_neon(int8u* p, unsigned len, const solid_color& c,
+                                   const int8u* covers)
+{
+    uint8x8_t ca = vdup_n_u8(int8u(c.alpha));
+    for (; len >= 8; len -= 8, p += 8*4, covers += 8)
+    {
+        uint8x8_t cov = vld1_u8(covers);
+        uint64_t cover8 = vget_lane_u64(vreinterpret_u64_u8(cov), 0);
+        if (cover8 == 0)
+            continue;
+
+        if (cover8 == ~uint64_t(0) && c.alpha == 255)
+        {
+            copy_hline_scalar(p, 8, c);
+            continue;
+        }
+        blend_8pix_neon(p, c.q, div255_neon(vmull_u8(cov, ca)));
+    }
+    blend_solid_hspan_scalar(p, len, c, covers);
+}
+
+//---------------------------------------------------------------------------------------
+static void blend_hline_neon(int8u* p, unsigned len, const solid_color& c,
+                             unsigned alpha)
+{
+    uint8x8_t a = vdup_n_u8(int8u(alpha));
+    for (; len >= 8; len -= 8, p += 8*4)
+        blend_8pix_neon(p, c.q, a);
+    blend_hline_scalar(p, len, c, alpha);
+}
+
+//---------------------------------------------------------------------------------------
+static void blend_color_hspan_neon(int8u* p, unsigned len, const int8u* colors,
+                                   const int8u* covers, unsigned cover, order_e order)
+{
+    const order_table& o = s_orders[order];
+    uint8x8_t const_cover = vdup_n_u8(int8u(cover));
+    for (; len >= 8; len -= 8, p += 8*4, colors += 8*4)
+    {
+        uint8x8x4_t c = vld4_u8(colors);
+        uint8x8_t cov = const_cover;
+        if (covers)
+        {
+            cov = vld1_u8(covers);
+            covers += 8;
+        }
+        uint8x8_t a = div255_neon(vmull_u8(c.val[3], cov));
+
+        uint8x8x4_t d = vld4_u8(p);
+        d.val[o.R] = lerp_neon(d.val[o.R], c.val[0], a);
+        d.val[o.G] = lerp_neon(d.val[o.G], c.val[1], a);
+        d.val[o.B] = lerp_neon(d.val[o.B], c.val[2], a);
+        d.val[o.A] = lerp_neon(d.val[o.A], vdup_n_u8(255), a);
+        vst4_u8(p, d);
+    }
+    blend_color_hspan_scalar(p, len, colors, covers, cover, order);
+}
+
+//---------------------------------------------------------------------------------------
+static void copy_hline_neon(int8u* p, unsigned len, const solid_color& c)
+{
+    int32u pix;
+    memcpy(&pix, c.pix, 4);
+    uint32x4_t v = vdupq_n_u32(pix);
+    for (; len >= 4; len -= 4, p += 4*4)
+        vst1q_u8(p, vreinterpretq_u8_u32(v));
+    copy_hline_scalar(p, len, c);
+}
+
+#endif  //AGG_SIMD_NEON
+
+
+//=======================================================================================
+// Run time dispatch
+//=======================================================================================
+struct kernels
+{
+    isa_e isa;
+    void (*blend_solid_hspan)(int8u* p, unsigned len, const solid_color& c,
+                              const int8u* covers);
+    void (*blend_hline)(int8u* p, unsigned len, const solid_color& c, unsigned alpha);
+    void (*blend_color_hspan)(int8u* p, unsigned len, const int8u* colors,
+                              const int8u* covers, unsigned cover, order_e order);
+    void (*copy_hline)(int8u* p, unsigned len, const solid_color& c);
+};
+
+static const kernels s_scalar_kernels =
+{
+    isa_scalar, blend_solid_hspan_scalar, blend_hline_scalar,
+    blend_color_hspan_scalar, copy_hline_scalar
+};
+
+#if defined(AGG_SIMD_SSE2)
+static const kernels s_sse2_kernels =
+{
+    isa_sse2, blend_solid_hspan_sse2, blend_hline_sse2,
+    blend_color_hspan_sse2, copy_hline_sse2
+};
+#endif
+
+#if defined(AGG_SIMD_AVX2)
+//blending of color spans is not faster than SSE2 code
+static const kernels s_avx2_kernels =
+{
+    isa_avx2, blend_solid_hspan_avx2, blend_hline_avx2,
+    blend_color_hspan_sse2, copy_hline_avx2
+};
+#endif
+
+#if defined(AGG_SIMD_NEON)
+static const kernels s_neon_kernels =
+{
+    isa_neon, blend_solid_hspan_neon, blend_hline_neon,
+    blend_color_hspan_neon, copy_hline_neon
+};
+#endif
+
+//---------------------------------------------------------------------------------------
+static const kernels* get_kernels(isa_e isa)
+{
+    switch (isa)
+    {
+#if defined(AGG_SIMD_SSE2)
+        case isa_sse2:      return &s_sse2_kernels;
+#endif
+#if defined(AGG_SIMD_AVX2)
+        case isa_avx2:      return (cpu_has_avx2() ? &s_avx2_kernels : nullptr);
+#endif
+#if defined(AGG_SIMD_NEON)
+        case isa_neon:      return &s_neon_kernels;
+#endif
+        case isa_scalar:    return &s_scalar_kernels;
+        default:            return nullptr;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+isa_e detect_isa()
+{
+#if defined(AGG_SIMD_AVX2)
+    if (cpu_has_avx2())
+        return isa_avx2;
+#endif
+#if defined(AGG_SIMD_SSE2)
+    return isa_sse2;
+#elif defined(AGG_SIMD_NEON)
+    return isa_neon;
+#else
+    return isa_scalar;
+#endif
+}
+
+//---------------------------------------------------------------------------------------
+static const kernels*& active_kernels()
+{
+    static const kernels* pKernels = get_kernels( detect_isa() );
+    return pKernels;
+}
+
+//---------------------------------------------------------------------------------------
+isa_e get_isa()
+{
+    return active_kernels()->isa;
+}
+
+//---------------------------------------------------------------------------------------
+bool set_isa(isa_e isa)
+{
+    const kernels* pKernels = get_kernels(isa);
+    if (!pKernels)
+        return false;
+    active_kernels() = pKernels;
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+const char* isa_name(isa_e isa)
+{
+    switch (isa)
+    {
+        case isa_scalar:    return "scalar";
+        case isa_sse2:      return "SSE2";
+        case isa_avx2:      return "AVX2";
+        case isa_neon:      return "NEON";
+        default:            return "unknown";
+    }
+}
+
+
+//=======================================================================================
+// Public interface
+//=======================================================================================
+void blend_solid_hspan_rgba8(int8u* p, unsigned len, const int8u* color,
+                             const int8u* covers, order_e order)
+{
+    solid_color c(color, order);
+    active_kernels()->blend_solid_hspan(p, len, c, covers);
+}
+
+//---------------------------------------------------------------------------------------
+void blend_hline_rgba8(int8u* p, unsigned len, const int8u* color, unsigned cover,
+                       order_e order)
+{
+    solid_color c(color, order);
+    if (c.alpha == 255 && cover == 255)
+        active_kernels()->copy_hline(p, len, c);
+    else
+        active_kernels()->blend_hline(p, len, c, div255(c.alpha * cover));
+}
+
+//---------------------------------------------------------------------------------------
+void blend_color_hspan_rgba8(int8u* p, unsigned len, const int8u* colors,
+                             const int8u* covers, unsigned cover, order_e order)
+{
+    active_kernels()->blend_color_hspan(p, len, colors, covers, cover, order);
+}
+
+//---------------------------------------------------------------------------------------
+void copy_hline_rgba8(int8u* p, unsigned len, const int8u* color, order_e order)
+{
+    solid_color c(color, order);
+    active_kernels()->copy_hline(p, len, c);
+}
+
+}
+}
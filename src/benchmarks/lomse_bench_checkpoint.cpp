@@ -0,0 +1,179 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2016. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include "lomse_benchmark.h"
+
+#include "lomse_injectors.h"
+#include "lomse_document.h"
+#include "lomse_internal_model.h"
+#include "lomse_im_snapshot.h"
+#include "lomse_lmd_exporter.h"
+#include "lomse_staffobjs_table.h"
+
+#include <sstream>
+
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+// Returns the LDP source for a score with the given number of instruments and
+// measures. Each measure has two beamed groups of four eighth notes, the first one
+// under a slur, and a tie to the next measure.
+static string generate_score(int numInstruments, int numMeasures)
+{
+    const char* notes[] = { "c4", "d4", "e4", "f4", "g4", "a4", "b4", "c5" };
+
+    stringstream src;
+    src << "(score (vers 2.0)";
+    for (int iInstr=0; iInstr < numInstruments; ++iInstr)
+    {
+        src << "(instrument (musicData (clef G)(key C)(time 4 4)";
+        for (int m=0; m < numMeasures; ++m)
+        {
+            src << "(n " << notes[m % 8] << " e g+ (slur 1 start))"
+                << "(n " << notes[(m + 1) % 8] << " e)"
+                << "(n " << notes[(m + 2) % 8] << " e)"
+                << "(n " << notes[(m + 3) % 8] << " e g- (slur 1 stop))"
+                << "(n " << notes[(m + 4) % 8] << " e g+)"
+                << "(n " << notes[(m + 5) % 8] << " e)"
+                << "(n " << notes[(m + 6) % 8] << " e)"
+                << "(n " << notes[(m + 1) % 8] << " e g- l)(barline)";
+        }
+        src << "(n " << notes[numMeasures % 8] << " w)(barline)))";
+    }
+    src << ")";
+    return src.str();
+}
+
+//---------------------------------------------------------------------------------------
+// Undo checkpoints for a score: creation of the checkpoint data and restoration of the
+// score from it, using the LMD text export and using the binary snapshot
+//---------------------------------------------------------------------------------------
+static void checkpoint_score(BenchmarkContext& ctx, int numInstruments, int numMeasures)
+{
+    LibraryScope libraryScope(cerr);
+    libraryScope.set_default_fonts_path(ctx.fonts_path());
+    stringstream errors;
+    Document doc(libraryScope, errors);
+    doc.from_string(generate_score(numInstruments, numMeasures));
+    ImoId id = doc.get_im_root()->get_content_item(0)->get_id();
+
+    stringstream label;
+    label << numInstruments << " instr. x " << numMeasures << " measures";
+
+    //save
+    int n = ctx.iterations(10);
+    string lmd;
+    BenchmarkTimer timer;
+    for (int i=0; i < n; ++i)
+    {
+        LmdExporter exporter(libraryScope);
+        exporter.set_add_id(true);
+        exporter.set_score_format(LmdExporter::k_format_ldp);
+        lmd = exporter.get_source( doc.get_pointer_to_imo(id) );
+    }
+    double msecs = timer.elapsed_msecs();
+    ctx.report(label.str() + ", save LMD", msecs, n, double(lmd.size()) * n, "byte");
+
+    string snapshot;
+    timer.restart();
+    for (int i=0; i < n; ++i)
+    {
+        ImSnapshot saver(&doc);
+        snapshot = saver.save( doc.get_pointer_to_imo(id) );
+    }
+    msecs = timer.elapsed_msecs();
+    ctx.report(label.str() + ", save snapshot", msecs, n,
+               double(snapshot.size()) * n, "byte");
+
+    //restore
+    timer.restart();
+    for (int i=0; i < n; ++i)
+        doc.replace_object_from_checkpoint_data(id, lmd);
+    msecs = timer.elapsed_msecs();
+    ctx.report(label.str() + ", restore LMD", msecs, n);
+
+    timer.restart();
+    for (int i=0; i < n; ++i)
+        doc.replace_object_from_checkpoint_data(id, snapshot);
+    msecs = timer.elapsed_msecs();
+    ctx.report(label.str() + ", restore snapshot", msecs, n);
+
+    //checkpoint of only the objects affected by a command: the first note in a
+    //measure of the middle of the score, and the objects related to it
+    ImoScore* pScore = static_cast<ImoScore*>( doc.get_pointer_to_imo(id) );
+    ColStaffObjsIndex* pIndex = pScore->get_staffobjs_table()->get_index();
+    ColStaffObjsEntry* pEntry = pIndex->find_barline(0, numMeasures / 2 - 1);
+    while (pEntry->num_instrument() != 0 || !pEntry->imo_object()->is_note())
+        pEntry = pEntry->get_next();
+    list<ImoId> ids;
+    ids.push_back( pEntry->element_id() );
+
+    string selection;
+    timer.restart();
+    for (int i=0; i < n; ++i)
+        selection = doc.get_checkpoint_data_for_objects(ids);
+    msecs = timer.elapsed_msecs();
+    ctx.report(label.str() + ", save selection", msecs, n,
+               double(selection.size()) * n, "byte");
+
+    timer.restart();
+    for (int i=0; i < n; ++i)
+        doc.replace_objects_from_checkpoint_data(selection);
+    msecs = timer.elapsed_msecs();
+    ctx.report(label.str() + ", restore selection", msecs, n);
+
+    //snapshots for concurrent readers: a new copy and the shared unchanged copy
+    SpDocument spSnapshot;
+    timer.restart();
+    for (int i=0; i < n; ++i)
+        spSnapshot = doc.get_snapshot(false);
+    msecs = timer.elapsed_msecs();
+    ctx.report(label.str() + ", document snapshot", msecs, n);
+
+    spSnapshot = doc.get_snapshot();
+    timer.restart();
+    for (int i=0; i < n; ++i)
+        spSnapshot = doc.get_snapshot();
+    msecs = timer.elapsed_msecs();
+    ctx.report(label.str() + ", shared snapshot", msecs, n);
+
+    stringstream sizes;
+    sizes << label.str() << ": LMD " << lmd.size() << " bytes, snapshot "
+          << snapshot.size() << " bytes, selection " << selection.size() << " bytes";
+    ctx.note(sizes.str());
+}
+
+//---------------------------------------------------------------------------------------
+LOMSE_BENCHMARK(checkpoints, "Undo checkpoints for scores: LMD text vs. binary snapshot")
+{
+    checkpoint_score(ctx, 1, 50);
+    checkpoint_score(ctx, 1, 1000);
+    checkpoint_score(ctx, 4, 250);
+}
@@ -0,0 +1,297 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include "lomse_benchmark.h"
+
+#include "lomse_doorway.h"
+#include "lomse_presenter.h"
+#include "lomse_interactor.h"
+#include "lomse_graphic_view.h"
+#include "lomse_command.h"
+#include "lomse_document_cursor.h"
+#include "lomse_agg_types.h"
+#include "lomse_events.h"
+
+#include <map>
+#include <sstream>
+
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+// Recorded editing session, replayed through the Interactor. One command per line:
+//
+//      enter | next | prev             move the cursor
+//      measure <m> <instr> <staff>     move the cursor to a measure (0..n-1)
+//      note <ldp>                      add a note or rest, in replace mode
+//      select | select+                set/add the pointed object to the selection
+//      tie                             tie the selected notes
+//      tuplet <ldp>                    add a tuplet to the selected notes
+//      undo | redo                     undo/redo the last command
+//
+// The session must leave the score as it was at start, so that it can be replayed
+// many times. Text after "//" is ignored.
+//---------------------------------------------------------------------------------------
+static const char* k_session =
+    "enter\n"
+    "measure 1 0 0\n"
+    "note (n g4 q v1 p1)\n"
+    "note (n g4 q v1 p1)\n"
+    "prev\n"
+    "prev\n"
+    "select\n"
+    "next\n"
+    "select+\n"
+    "tie\n"
+    "undo               //tie\n"
+    "redo\n"
+    "measure 4 0 0\n"
+    "note (n e4 e v1 p1)\n"
+    "note (n f4 e v1 p1)\n"
+    "note (n g4 e v1 p1)\n"
+    "prev\n"
+    "prev\n"
+    "prev\n"
+    "select\n"
+    "next\n"
+    "select+\n"
+    "next\n"
+    "select+\n"
+    "tuplet (t + 2 3)\n"
+    "undo               //tuplet\n"
+    "redo\n";
+
+//---------------------------------------------------------------------------------------
+// Per command latencies, split using the Interactor timers:
+//  - layout: time for building the graphic model (k_timing_gmodel_build_time)
+//  - render: rest of the renderization time (k_timing_total_render_time)
+//  - model: rest of the time, mainly for executing the command on the document
+struct CommandLatencies
+{
+    vector<double> model;
+    vector<double> layout;
+    vector<double> render;
+};
+
+//---------------------------------------------------------------------------------------
+class SessionReplayer
+{
+protected:
+    SpInteractor m_spInteractor;
+    double m_times[Interactor::k_timing_max_value];
+    vector<string> m_names;                         //commands, in order of appearance
+    map<string, CommandLatencies> m_latencies;
+
+public:
+    SessionReplayer(SpInteractor spInteractor)
+        : m_spInteractor(spInteractor)
+    {
+        m_spInteractor->add_event_handler(k_update_window_event, this,
+                                          wrapper_update_window);
+    }
+
+    //returns false if the session has an invalid command
+    bool replay(const string& session);
+    void rewind();
+    void report(BenchmarkContext& ctx);
+
+protected:
+    static void wrapper_update_window(void* pThis, SpEventInfo pEvent);
+    void on_update_window();
+    bool execute(const string& name, const string& arg);
+};
+
+//---------------------------------------------------------------------------------------
+void SessionReplayer::wrapper_update_window(void* pThis, SpEventInfo UNUSED(pEvent))
+{
+    static_cast<SessionReplayer*>(pThis)->on_update_window();
+}
+
+//---------------------------------------------------------------------------------------
+void SessionReplayer::on_update_window()
+{
+    //AWARE: a command can cause several repaints (i.e. document and then caret) and
+    //timers are restarted for each one. Keep the times of the longest renderization
+    double* pTimes = m_spInteractor->get_elapsed_times();
+    if (pTimes[Interactor::k_timing_total_render_time]
+            >= m_times[Interactor::k_timing_total_render_time])
+    {
+        for (int i=0; i < Interactor::k_timing_max_value; ++i)
+            m_times[i] = pTimes[i];
+    }
+}
+
+//---------------------------------------------------------------------------------------
+bool SessionReplayer::replay(const string& session)
+{
+    stringstream ss(session);
+    string line;
+    while (getline(ss, line))
+    {
+        size_t comment = line.find("//");
+        if (comment != string::npos)
+            line.erase(comment);
+
+        stringstream words(line);
+        string name;
+        if (!(words >> name))
+            continue;
+        string arg;
+        getline(words, arg);
+        size_t start = arg.find_first_not_of(" ");
+        size_t end = arg.find_last_not_of(" ");
+        arg = (start == string::npos ? "" : arg.substr(start, end - start + 1));
+
+        for (int i=0; i < Interactor::k_timing_max_value; ++i)
+            m_times[i] = 0.0;
+        m_spInteractor->timing_start_measurements();
+
+        BenchmarkTimer timer;
+        if (!execute(name, arg))
+            return false;
+        double msecs = timer.elapsed_msecs();
+
+        if (m_latencies.find(name) == m_latencies.end())
+            m_names.push_back(name);
+        CommandLatencies& latencies = m_latencies[name];
+        double layout = m_times[Interactor::k_timing_gmodel_build_time];
+        double render = m_times[Interactor::k_timing_total_render_time];
+        latencies.model.push_back(max(0.0, msecs - render));
+        latencies.layout.push_back(layout);
+        latencies.render.push_back(max(0.0, render - layout));
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+bool SessionReplayer::execute(const string& name, const string& arg)
+{
+    if (name == "enter")
+        m_spInteractor->exec_command( LOMSE_NEW CmdCursor(CmdCursor::k_enter) );
+    else if (name == "next")
+        m_spInteractor->exec_command( LOMSE_NEW CmdCursor(CmdCursor::k_move_next) );
+    else if (name == "prev")
+        m_spInteractor->exec_command( LOMSE_NEW CmdCursor(CmdCursor::k_move_prev) );
+    else if (name == "measure")
+    {
+        int measure = 0, instr = -1, staff = -1;
+        stringstream(arg) >> measure >> instr >> staff;
+        m_spInteractor->exec_command( LOMSE_NEW CmdCursor(measure, instr, staff) );
+    }
+    else if (name == "note")
+    {
+        m_spInteractor->exec_command(
+            LOMSE_NEW CmdAddNoteRest(arg, k_edit_mode_replace) );
+    }
+    else if (name == "select" || name == "select+")
+    {
+        ImoId id = m_spInteractor->get_cursor()->get_pointee_id();
+        int action = (name == "select" ? CmdSelection::k_set : CmdSelection::k_add);
+        m_spInteractor->exec_command( LOMSE_NEW CmdSelection(action, id) );
+    }
+    else if (name == "tie")
+        m_spInteractor->exec_command( LOMSE_NEW CmdAddTie() );
+    else if (name == "tuplet")
+        m_spInteractor->exec_command( LOMSE_NEW CmdAddTuplet(arg) );
+    else if (name == "undo")
+        m_spInteractor->exec_undo();
+    else if (name == "redo")
+        m_spInteractor->exec_redo();
+    else
+        return false;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+void SessionReplayer::rewind()
+{
+    //undo all the session commands, to restore the initial document
+    while (m_spInteractor->should_enable_edit_undo())
+        m_spInteractor->exec_undo();
+}
+
+//---------------------------------------------------------------------------------------
+void SessionReplayer::report(BenchmarkContext& ctx)
+{
+    for (const string& name : m_names)
+    {
+        CommandLatencies& latencies = m_latencies[name];
+        ctx.report_percentiles(name + ", model", latencies.model);
+        ctx.report_percentiles(name + ", layout", latencies.layout);
+        ctx.report_percentiles(name + ", render", latencies.render);
+    }
+}
+
+
+//---------------------------------------------------------------------------------------
+// Replay of an editing session on a score, measuring the latency of each command,
+// from execution to the view updated.
+//---------------------------------------------------------------------------------------
+LOMSE_BENCHMARK(replay_commands, "Replay of edition commands through the Interactor")
+{
+    LomseDoorway lomse;
+    lomse.init_library(k_pix_format_rgba32, 96, false, cerr);
+    lomse.set_default_fonts_path(ctx.fonts_path());
+
+    stringstream errors;
+    string score = "00227-group-mensurstrich-layout.lms";
+    Presenter* pPresenter = lomse.open_document(k_view_vertical_book,
+                                                ctx.scores_path() + score, errors);
+    SpInteractor spInteractor = pPresenter->get_interactor(0).lock();
+
+    const int width = 1024;
+    const int height = 768;
+    vector<unsigned char> buffer(width * height * 4);
+    RenderingBuffer rbuf(&buffer[0], width, height, width * 4);
+    spInteractor->set_rendering_buffer(&rbuf);
+    spInteractor->force_redraw();
+
+    SessionReplayer replayer(spInteractor);
+    string source = pPresenter->get_document_raw_ptr()->to_string();
+    int n = ctx.iterations(20);
+    for (int i=0; i < n; ++i)
+    {
+        if (!replayer.replay(k_session))
+        {
+            ctx.note("Error: invalid command in session");
+            break;
+        }
+        replayer.rewind();
+    }
+
+    if (pPresenter->get_document_raw_ptr()->to_string() != source)
+        ctx.note("Error: session does not restore the score");
+
+    ctx.note(score);
+    replayer.report(ctx);
+
+    spInteractor.reset();
+    delete pPresenter;
+}
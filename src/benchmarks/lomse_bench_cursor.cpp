@@ -0,0 +1,160 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2016. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include "lomse_benchmark.h"
+
+#include "lomse_injectors.h"
+#include "lomse_document.h"
+#include "lomse_document_cursor.h"
+#include "lomse_internal_model.h"
+#include "lomse_staffobjs_table.h"
+
+#include <sstream>
+
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+// Returns the LDP source for a score with the given number of instruments and
+// measures, with four quarter notes per measure.
+static string generate_score(int numInstruments, int numMeasures)
+{
+    const char* notes[] = { "c4", "d4", "e4", "f4", "g4", "a4", "b4", "c5" };
+
+    stringstream src;
+    src << "(score (vers 2.0)";
+    for (int iInstr=0; iInstr < numInstruments; ++iInstr)
+    {
+        src << "(instrument (musicData (clef G)(key C)(time 4 4)";
+        for (int m=0; m < numMeasures; ++m)
+        {
+            src << "(n " << notes[m % 8] << " q)"
+                << "(n " << notes[(m + 1) % 8] << " q)"
+                << "(n " << notes[(m + 2) % 8] << " q)"
+                << "(n " << notes[(m + 3) % 8] << " q)(barline)";
+        }
+        src << "))";
+    }
+    src << ")";
+    return src.str();
+}
+
+//---------------------------------------------------------------------------------------
+// Simple deterministic generator, so that all runs visit the same positions
+static int next_random(unsigned& seed, int range)
+{
+    seed = seed * 1103515245 + 12345;
+    return int((seed >> 16) % unsigned(range));
+}
+
+//---------------------------------------------------------------------------------------
+// Cursor positioning in a long score: jumps to random measures, to random objects and
+// to random saved positions, as done when undoing/redoing commands
+//---------------------------------------------------------------------------------------
+static void position_cursor(BenchmarkContext& ctx, int numInstruments, int numMeasures)
+{
+    LibraryScope libraryScope(cerr);
+    libraryScope.set_default_fonts_path(ctx.fonts_path());
+    stringstream errors;
+    Document doc(libraryScope, errors);
+    doc.from_string(generate_score(numInstruments, numMeasures));
+    ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+
+    stringstream label;
+    label << numInstruments << " instr. x " << numMeasures << " measures";
+
+    //collect ids and positions
+    ScoreCursor cursor(&doc, pScore);
+    vector<ImoId> ids;
+    vector<SpElementCursorState> states;
+    while (!cursor.is_at_end_of_score())
+    {
+        ids.push_back( cursor.staffobj_id_internal() );
+        states.push_back( cursor.get_state() );
+        cursor.move_next();
+    }
+    cursor.point_to( ids.front() );
+
+    int n = ctx.iterations(2000);
+
+    //to measure
+    unsigned seed = 1;
+    BenchmarkTimer timer;
+    for (int i=0; i < n; ++i)
+    {
+        int instr = next_random(seed, numInstruments);
+        cursor.to_measure(next_random(seed, numMeasures), instr, 0);
+    }
+    double msecs = timer.elapsed_msecs();
+    ctx.report(label.str() + ", to_measure()", msecs, n, n, "jump");
+
+    //point to object
+    timer.restart();
+    for (int i=0; i < n; ++i)
+        cursor.point_to( ids[next_random(seed, int(ids.size()))] );
+    msecs = timer.elapsed_msecs();
+    ctx.report(label.str() + ", point_to()", msecs, n, n, "jump");
+
+    //to time
+    timer.restart();
+    for (int i=0; i < n; ++i)
+    {
+        int instr = next_random(seed, numInstruments);
+        TimeUnits time = TimeUnits(next_random(seed, numMeasures * 4)) * k_duration_quarter;
+        cursor.to_time(instr, 0, time);
+    }
+    msecs = timer.elapsed_msecs();
+    ctx.report(label.str() + ", to_time()", msecs, n, n, "jump");
+
+    //restore saved state
+    timer.restart();
+    for (int i=0; i < n; ++i)
+        cursor.restore_state( states[next_random(seed, int(states.size()))] );
+    msecs = timer.elapsed_msecs();
+    ctx.report(label.str() + ", restore_state()", msecs, n, n, "jump");
+
+    //step by step traversal
+    cursor.point_to( ids.front() );
+    int steps = 0;
+    timer.restart();
+    while (!cursor.is_at_end_of_score())
+    {
+        cursor.move_next();
+        ++steps;
+    }
+    msecs = timer.elapsed_msecs();
+    ctx.report(label.str() + ", move_next() full score", msecs, 1, steps, "step");
+}
+
+//---------------------------------------------------------------------------------------
+LOMSE_BENCHMARK(cursor, "Score cursor positioning by measure, time and object")
+{
+    position_cursor(ctx, 1, 2000);
+    position_cursor(ctx, 4, 250);
+}
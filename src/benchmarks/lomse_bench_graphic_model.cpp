@@ -0,0 +1,105 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include "lomse_benchmark.h"
+
+#include "lomse_gm_basic.h"
+#include "lomse_shapes.h"
+
+#include <sstream>
+
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+class BenchShape : public GmoShapeInvisible
+{
+public:
+    BenchShape(int idx)
+        : GmoShapeInvisible(nullptr, idx, UPoint(0.0f, 0.0f), USize(100.0f, 100.0f))
+    {
+    }
+};
+
+//---------------------------------------------------------------------------------------
+// Populating a page with shapes. Layers are assigned as in a typical score: for each
+// staff shape there are many notes, barlines and auxiliary objects
+//---------------------------------------------------------------------------------------
+static void populate_page(BenchmarkContext& ctx, int numShapes)
+{
+    const int layers[] = { GmoShape::k_layer_staff, GmoShape::k_layer_notes,
+                           GmoShape::k_layer_notes, GmoShape::k_layer_aux_objs,
+                           GmoShape::k_layer_notes, GmoShape::k_layer_barlines,
+                           GmoShape::k_layer_notes, GmoShape::k_layer_aux_objs,
+                           GmoShape::k_layer_top, GmoShape::k_layer_notes };
+    const int numLayers = sizeof(layers) / sizeof(int);
+
+    std::vector<GmoShape*> shapes;
+    shapes.reserve(numShapes);
+    for (int i=0; i < numShapes; ++i)
+    {
+        GmoShape* pShape = LOMSE_NEW BenchShape(i);
+        pShape->set_layer(layers[i % numLayers]);
+        shapes.push_back(pShape);
+    }
+
+    int n = ctx.iterations(10);
+    double msecs = 0.0;
+    int found = 0;
+    for (int k=0; k < n; ++k)
+    {
+        GmoBoxDocPage page(nullptr);
+        BenchmarkTimer timer;
+        for (int i=0; i < numShapes; ++i)
+        {
+            page.add_to_tables(shapes[i]);
+            if (page.get_first_shape_for_layer(GmoShape::k_layer_staff))
+                ++found;
+        }
+        msecs += timer.elapsed_msecs();
+    }
+
+    if (found == 0)
+        ctx.note("Error: no shapes added");
+
+    stringstream label;
+    label << numShapes << " shapes";
+    ctx.report(label.str(), msecs, n, double(numShapes) * n, "shape");
+
+    for (int i=0; i < numShapes; ++i)
+        delete shapes[i];
+}
+
+//---------------------------------------------------------------------------------------
+LOMSE_BENCHMARK(page_shapes, "Adding shapes to a page, ordered by layer")
+{
+    populate_page(ctx, 1000);
+    populate_page(ctx, 10000);
+    populate_page(ctx, 50000);
+}
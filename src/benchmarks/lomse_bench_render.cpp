@@ -0,0 +1,95 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include "lomse_benchmark.h"
+
+#include "lomse_doorway.h"
+#include "lomse_batch_renderer.h"
+#include "agg_span_blend_simd.h"
+
+#include <sstream>
+
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+// Full page rendering throughput, for the 32 bits pixel formats, using the available
+// implementations of the span blending loops
+//---------------------------------------------------------------------------------------
+static void render_score(BenchmarkContext& ctx, const string& score, int format,
+                         const string& formatName)
+{
+    LomseDoorway lomse;
+    lomse.init_library(format, 96, false, cerr);
+    lomse.set_default_fonts_path(ctx.fonts_path());
+
+    BatchRenderer* pRenderer = lomse.create_batch_renderer();
+    if (!pRenderer->open_document(ctx.scores_path() + score))
+    {
+        ctx.note("Error: cannot open score " + score);
+        delete pRenderer;
+        return;
+    }
+
+    const double dpi = 150.0;
+    VSize size = pRenderer->get_page_size_in_pixels(0, dpi);
+    double megapixels = double(size.width) * double(size.height) / 1.0e6;
+
+    agg::simd::isa_e savedIsa = agg::simd::get_isa();
+    const agg::simd::isa_e isas[] = { agg::simd::isa_scalar, agg::simd::isa_sse2,
+                                      agg::simd::isa_avx2, agg::simd::isa_neon };
+    for (agg::simd::isa_e isa : isas)
+    {
+        if (!agg::simd::set_isa(isa))
+            continue;
+
+        pRenderer->render_page(0, dpi);     //warm up
+        int n = ctx.iterations(20);
+        BenchmarkTimer timer;
+        for (int i=0; i < n; ++i)
+            pRenderer->render_page(0, dpi);
+        double msecs = timer.elapsed_msecs();
+
+        stringstream label;
+        label << formatName << ", " << agg::simd::isa_name(isa) << ", "
+              << size.width << "x" << size.height;
+        ctx.report(label.str(), msecs, n, megapixels * n, "Mpixel");
+    }
+    agg::simd::set_isa(savedIsa);
+
+    delete pRenderer;
+}
+
+//---------------------------------------------------------------------------------------
+LOMSE_BENCHMARK(render_page, "Full page rendering at 150 dpi, for each SIMD implementation")
+{
+    render_score(ctx, "00623-clef-change-lyrics.xml", k_pix_format_rgba32, "rgba32");
+    render_score(ctx, "00623-clef-change-lyrics.xml", k_pix_format_bgra32, "bgra32");
+    render_score(ctx, "50011-ornaments.xml", k_pix_format_rgba32, "rgba32");
+}
@@ -0,0 +1,212 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include "lomse_benchmark.h"
+
+#include "lomse_injectors.h"
+#include "lomse_document.h"
+#include "lomse_internal_model.h"
+#include "lomse_im_note.h"
+#include "lomse_midi_table.h"
+#include "lomse_midi_file.h"
+
+#include <sstream>
+
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+// Returns the LDP source for a score with the given number of instruments and
+// measures. In even instruments each measure has eight eighth notes, with a tie in the
+// last one. Odd instruments have a whole note per measure.
+static string generate_score(int numInstruments, int numMeasures)
+{
+    const char* notes[] = { "c4", "d4", "e4", "f4", "g4", "a4", "b4", "c5" };
+
+    stringstream src;
+    src << "(score (vers 2.0)";
+    for (int iInstr=0; iInstr < numInstruments; ++iInstr)
+    {
+        src << "(instrument (musicData (clef G)(key C)(time 4 4)";
+        for (int m=0; m < numMeasures; ++m)
+        {
+            if (iInstr % 2 == 1)
+                src << "(n " << notes[m % 8] << " w)(barline)";
+            else
+            {
+                for (int i=0; i < 7; ++i)
+                    src << "(n " << notes[(i + m + iInstr) % 8] << " e)";
+                src << "(n c5 e l)(barline)";
+            }
+        }
+        src << "))";
+    }
+    src << ")";
+    return src.str();
+}
+
+//---------------------------------------------------------------------------------------
+// Creation of the sound events table, as done by ScorePlayer when a score is loaded
+//---------------------------------------------------------------------------------------
+static void create_events_table(BenchmarkContext& ctx, int numInstruments,
+                                int numMeasures)
+{
+    LibraryScope libraryScope(cerr);
+    libraryScope.set_default_fonts_path(ctx.fonts_path());
+    stringstream errors;
+    Document doc(libraryScope, errors);
+    doc.from_string(generate_score(numInstruments, numMeasures));
+    ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+
+    int n = ctx.iterations(5);
+    int numEvents = 0;
+    BenchmarkTimer timer;
+    for (int i=0; i < n; ++i)
+    {
+        SoundEventsTable table(pScore);
+        table.create_table();
+        numEvents = table.num_events();
+    }
+    double msecs = timer.elapsed_msecs();
+
+    stringstream label;
+    label << numInstruments << " instr. x " << numMeasures << " measures, "
+          << numEvents << " events";
+    ctx.report(label.str(), msecs, n, double(numEvents) * n, "event");
+}
+
+//---------------------------------------------------------------------------------------
+LOMSE_BENCHMARK(events_table, "Creation of the sound events table for large scores")
+{
+    create_events_table(ctx, 1, 100);
+    create_events_table(ctx, 4, 500);
+    create_events_table(ctx, 10, 600);
+}
+
+//---------------------------------------------------------------------------------------
+// Update of the sound events table after changing a note pitch, compared with the
+// creation of the whole table
+//---------------------------------------------------------------------------------------
+static void update_events_table(BenchmarkContext& ctx, int numInstruments,
+                                int numMeasures)
+{
+    LibraryScope libraryScope(cerr);
+    libraryScope.set_default_fonts_path(ctx.fonts_path());
+    stringstream errors;
+    Document doc(libraryScope, errors);
+    doc.from_string(generate_score(numInstruments, numMeasures));
+    ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+    SoundEventsTable* pTable = pScore->get_midi_table();
+
+    int measure = numMeasures / 2;
+    ImoNote* pNote = static_cast<ImoNote*>(
+                pTable->get_events()[pTable->get_first_event_for_measure(measure)].pSO );
+
+    int n = ctx.iterations(20);
+    double updateMsecs = 0.0;
+    double createMsecs = 0.0;
+    for (int i=0; i < n; ++i)
+    {
+        pNote->set_notated_pitch((i % 2 == 0 ? k_step_D : k_step_C), 4, k_no_accidentals);
+        pScore->end_of_changes();       //not measured
+
+        BenchmarkTimer timer;
+        pScore->update_midi_table(measure, measure);
+        pScore->get_midi_table();       //the table is updated when needed
+        updateMsecs += timer.elapsed_msecs();
+
+        timer.restart();
+        pTable->create_table();
+        createMsecs += timer.elapsed_msecs();
+    }
+
+    stringstream label;
+    label << numInstruments << " instr. x " << numMeasures << " measures, "
+          << pTable->num_events() << " events";
+    ctx.report(label.str() + ", update 1 measure", updateMsecs, n);
+    ctx.report(label.str() + ", create table", createMsecs, n);
+}
+
+//---------------------------------------------------------------------------------------
+LOMSE_BENCHMARK(events_table_update, "Update of the sound events table after an edit")
+{
+    update_events_table(ctx, 1, 100);
+    update_events_table(ctx, 4, 500);
+    update_events_table(ctx, 10, 600);
+}
+
+//---------------------------------------------------------------------------------------
+// Offline playback of a score into a Standard MIDI File, in memory
+//---------------------------------------------------------------------------------------
+static void render_midi_file(BenchmarkContext& ctx, int numInstruments, int numMeasures)
+{
+    LibraryScope libraryScope(cerr);
+    libraryScope.set_default_fonts_path(ctx.fonts_path());
+    stringstream errors;
+    Document doc(libraryScope, errors);
+    doc.from_string(generate_score(numInstruments, numMeasures));
+    ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+    pScore->get_midi_table();       //exclude table creation from measurements
+
+    MidiFileRenderer renderer(libraryScope);
+    renderer.set_metronome(true);
+
+    int n = ctx.iterations(5);
+    size_t numMessages = 0;
+    size_t fileSize = 0;
+    BenchmarkTimer timer;
+    for (int i=0; i < n; ++i)
+    {
+        stringstream file;
+        renderer.render(pScore, file);
+        numMessages = renderer.get_recorder()->get_messages().size();
+        fileSize = file.str().size();
+    }
+    double msecs = timer.elapsed_msecs();
+
+    long playbackTime = renderer.get_recorder()->get_messages().back().time;
+    stringstream label;
+    label << numInstruments << " instr. x " << numMeasures << " measures, "
+          << numMessages << " messages, " << fileSize / 1024 << " KB";
+    ctx.report(label.str(), msecs, n, double(numMessages) * n, "message");
+
+    stringstream note;
+    note << "playback time " << playbackTime / 1000L << " s, rendered "
+         << long(double(playbackTime) * n / max(msecs, 0.001)) << " times faster "
+         << "than real time";
+    ctx.note(note.str());
+}
+
+//---------------------------------------------------------------------------------------
+LOMSE_BENCHMARK(midi_render, "Offline rendering of scores to Standard MIDI Files")
+{
+    render_midi_file(ctx, 1, 100);
+    render_midi_file(ctx, 4, 500);
+    render_midi_file(ctx, 10, 600);
+}
@@ -0,0 +1,153 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#ifndef __LOMSE_BENCHMARK_H__        //to avoid nested includes
+#define __LOMSE_BENCHMARK_H__
+
+#include "lomse_build_options.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace lomse
+{
+
+//---------------------------------------------------------------------------------------
+// Infrastructure for the micro-benchmarks in program lomse_benchmarks.
+//
+// Each benchmark is a function defined with macro LOMSE_BENCHMARK. It receives a
+// BenchmarkContext, that provides the paths to test scores and fonts, the scale
+// factor for the number of iterations, and methods for measuring and reporting
+// elapsed times:
+//
+//      LOMSE_BENCHMARK(sort_events, "Sorting the events table")
+//      {
+//          ...
+//          BenchmarkTimer timer;
+//          for (int i=0; i < ctx.iterations(100); ++i)
+//              ...
+//          ctx.report("1000 events", timer.elapsed_msecs(), ctx.iterations(100));
+//      }
+//
+//---------------------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------------------
+// BenchmarkTimer: measures elapsed time since its creation or last restart
+class BenchmarkTimer
+{
+protected:
+    chrono::steady_clock::time_point m_start;
+
+public:
+    BenchmarkTimer() : m_start(chrono::steady_clock::now()) {}
+
+    inline void restart() { m_start = chrono::steady_clock::now(); }
+    inline double elapsed_msecs() const
+    {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - m_start).count();
+    }
+};
+
+//---------------------------------------------------------------------------------------
+class BenchmarkContext
+{
+protected:
+    ostream& m_out;
+    string m_benchmark;
+    string m_scoresPath;
+    string m_fontsPath;
+    double m_scale;
+
+public:
+    BenchmarkContext(ostream& out, double scale);
+
+    inline void set_benchmark(const string& name) { m_benchmark = name; }
+
+    //resources
+    inline const string& scores_path() const { return m_scoresPath; }
+    inline const string& fonts_path() const { return m_fontsPath; }
+
+    //number of iterations, adjusted with the scale factor (option -s)
+    int iterations(int nominal) const;
+
+    /** Reports the result of a measurement. @c msecs is the total time for @c count
+        repetitions of the measured operation. If @c items is not zero, throughput is
+        also reported, as @c items per second, labelled with @c unit.  */
+    void report(const string& label, double msecs, long count,
+                double items=0.0, const string& unit="");
+
+    /** Reports the distribution of a set of measurements: the 50th, 90th and 99th
+        percentiles and the maximum of the times in @c samples, in milliseconds. */
+    void report_percentiles(const string& label, const vector<double>& samples);
+
+    //informative messages
+    void note(const string& msg);
+};
+
+//---------------------------------------------------------------------------------------
+typedef void (*BenchmarkFunction)(BenchmarkContext& ctx);
+
+struct BenchmarkInfo
+{
+    const char* name;
+    const char* description;
+    BenchmarkFunction function;
+};
+
+//---------------------------------------------------------------------------------------
+class BenchmarkRegistry
+{
+public:
+    static vector<BenchmarkInfo>& benchmarks();
+    static void add(const char* name, const char* description, BenchmarkFunction pFunc);
+};
+
+//---------------------------------------------------------------------------------------
+struct BenchmarkRegistrar
+{
+    BenchmarkRegistrar(const char* name, const char* description, BenchmarkFunction pFunc)
+    {
+        BenchmarkRegistry::add(name, description, pFunc);
+    }
+};
+
+#define LOMSE_BENCHMARK(name, description)                                      \
+    static void lomse_benchmark_##name(lomse::BenchmarkContext& ctx);           \
+    static lomse::BenchmarkRegistrar lomse_benchmark_registrar_##name(          \
+                    #name, description, lomse_benchmark_##name);                \
+    static void lomse_benchmark_##name(lomse::BenchmarkContext& ctx)
+
+
+}   //namespace lomse
+
+#endif    // __LOMSE_BENCHMARK_H__
@@ -0,0 +1,192 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------------------
+// lomse_benchmarks: program for running the micro-benchmarks of the library.
+//
+// Usage:  lomse_benchmarks [options] [name ...]
+//
+// When names are specified, only the benchmarks whose name contains any of them are
+// run. Options:
+//      -l, --list          List the available benchmarks and exit
+//      -s, --scale <x>     Multiply the number of iterations by <x> (default 1.0)
+//
+//---------------------------------------------------------------------------------------
+
+#include "lomse_benchmark.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+
+using namespace lomse;
+
+
+namespace lomse
+{
+
+//=======================================================================================
+// BenchmarkContext implementation
+//=======================================================================================
+BenchmarkContext::BenchmarkContext(ostream& out, double scale)
+    : m_out(out)
+    , m_scoresPath(TESTLIB_SCORES_PATH)
+    , m_fontsPath(TESTLIB_FONTS_PATH)
+    , m_scale(scale)
+{
+}
+
+//---------------------------------------------------------------------------------------
+int BenchmarkContext::iterations(int nominal) const
+{
+    int n = int(nominal * m_scale + 0.5);
+    return n < 1 ? 1 : n;
+}
+
+//---------------------------------------------------------------------------------------
+void BenchmarkContext::report(const string& label, double msecs, long count,
+                              double items, const string& unit)
+{
+    double perOp = (count > 0 ? msecs / double(count) : msecs);
+
+    m_out << left << setw(22) << m_benchmark << setw(40) << label
+          << right << fixed << setprecision(4) << setw(14) << perOp << " ms";
+    if (items > 0.0 && msecs > 0.0)
+    {
+        m_out << setprecision(2) << setw(14) << (items * 1000.0 / msecs)
+              << " " << unit << "/s";
+    }
+    m_out << endl;
+}
+
+//---------------------------------------------------------------------------------------
+void BenchmarkContext::report_percentiles(const string& label,
+                                          const vector<double>& samples)
+{
+    if (samples.empty())
+        return;
+
+    vector<double> sorted(samples);
+    sort(sorted.begin(), sorted.end());
+    size_t last = sorted.size() - 1;
+    double p50 = sorted[ (last * 50) / 100 ];
+    double p90 = sorted[ (last * 90) / 100 ];
+    double p99 = sorted[ (last * 99) / 100 ];
+
+    m_out << left << setw(22) << m_benchmark << setw(40) << label
+          << right << fixed << setprecision(4)
+          << "  p50 " << setw(10) << p50 << "  p90 " << setw(10) << p90
+          << "  p99 " << setw(10) << p99 << "  max " << setw(10) << sorted[last]
+          << " ms  (" << sorted.size() << ")" << endl;
+}
+
+//---------------------------------------------------------------------------------------
+void BenchmarkContext::note(const string& msg)
+{
+    m_out << left << setw(22) << m_benchmark << msg << endl;
+}
+
+
+//=======================================================================================
+// BenchmarkRegistry implementation
+//=======================================================================================
+vector<BenchmarkInfo>& BenchmarkRegistry::benchmarks()
+{
+    static vector<BenchmarkInfo> benchmarks;
+    return benchmarks;
+}
+
+//---------------------------------------------------------------------------------------
+void BenchmarkRegistry::add(const char* name, const char* description,
+                            BenchmarkFunction pFunc)
+{
+    BenchmarkInfo info = { name, description, pFunc };
+    benchmarks().push_back(info);
+}
+
+}   //namespace lomse
+
+
+//---------------------------------------------------------------------------------------
+static bool is_selected(const char* name, const vector<string>& filters)
+{
+    if (filters.empty())
+        return true;
+
+    for (const string& filter : filters)
+    {
+        if (strstr(name, filter.c_str()) != nullptr)
+            return true;
+    }
+    return false;
+}
+
+//---------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    double scale = 1.0;
+    bool fList = false;
+    vector<string> filters;
+
+    for (int i=1; i < argc; ++i)
+    {
+        string arg(argv[i]);
+        if (arg == "-l" || arg == "--list")
+            fList = true;
+        else if ((arg == "-s" || arg == "--scale") && i + 1 < argc)
+            scale = atof(argv[++i]);
+        else if (arg == "-h" || arg == "--help")
+        {
+            cout << "Usage: lomse_benchmarks [-l] [-s scale] [name ...]" << endl;
+            return 0;
+        }
+        else
+            filters.push_back(arg);
+    }
+
+    vector<BenchmarkInfo>& benchmarks = BenchmarkRegistry::benchmarks();
+    if (fList)
+    {
+        for (const BenchmarkInfo& info : benchmarks)
+            cout << left << setw(22) << info.name << info.description << endl;
+        return 0;
+    }
+
+    BenchmarkContext ctx(cout, scale > 0.0 ? scale : 1.0);
+    for (const BenchmarkInfo& info : benchmarks)
+    {
+        if (is_selected(info.name, filters))
+        {
+            ctx.set_benchmark(info.name);
+            info.function(ctx);
+        }
+    }
+    return 0;
+}
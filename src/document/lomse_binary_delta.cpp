@@ -0,0 +1,262 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2016. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include "lomse_binary_delta.h"
+
+#include "lomse_logger.h"
+
+#include <algorithm>        //min
+#include <cstring>          //memcmp
+#include <stdexcept>
+#include <stdint.h>
+#include <unordered_map>
+
+namespace lomse
+{
+
+//size of the source blocks searched in the target string
+static const size_t k_block_size = 16;
+
+//multiplier for the rolling hash
+static const uint64_t k_hash_base = 0x100000001B3ULL;
+
+//---------------------------------------------------------------------------------------
+// Delta format: target size followed by a sequence of operations. Each operation
+// starts with a varint, (length << 1) | kind. Kind 1 is 'insert' and is followed by
+// the bytes to insert. Kind 0 is 'copy' and is followed by the source offset, saved as
+// the (zigzag) difference with the end of previous copy.
+//---------------------------------------------------------------------------------------
+static void write_uint(string& data, unsigned long long value)
+{
+    while (value >= 0x80)
+    {
+        data.push_back( char((value & 0x7F) | 0x80) );
+        value >>= 7;
+    }
+    data.push_back( char(value) );
+}
+
+//---------------------------------------------------------------------------------------
+static void write_int(string& data, long long value)
+{
+    write_uint(data, (static_cast<unsigned long long>(value) << 1)
+                     ^ (value < 0 ? ~0ULL : 0ULL) );
+}
+
+//---------------------------------------------------------------------------------------
+static void invalid_delta()
+{
+    LOMSE_LOG_ERROR("Invalid delta data.");
+    throw runtime_error("[BinaryDelta::apply] Invalid delta data.");
+}
+
+//---------------------------------------------------------------------------------------
+static unsigned long long read_uint(const string& data, size_t& pos)
+{
+    unsigned long long value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (pos >= data.size())
+            break;
+        unsigned char byte = static_cast<unsigned char>(data[pos++]);
+        value |= static_cast<unsigned long long>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return value;
+    }
+    invalid_delta();
+    return 0;
+}
+
+//---------------------------------------------------------------------------------------
+static long long read_int(const string& data, size_t& pos)
+{
+    unsigned long long value = read_uint(data, pos);
+    return static_cast<long long>(value >> 1) ^ -static_cast<long long>(value & 1);
+}
+
+//---------------------------------------------------------------------------------------
+static uint64_t block_hash(const char* pData)
+{
+    uint64_t hash = 0;
+    for (size_t i=0; i < k_block_size; ++i)
+        hash = hash * k_hash_base + static_cast<unsigned char>(pData[i]);
+    return hash;
+}
+
+//---------------------------------------------------------------------------------------
+static void add_insert(string& delta, const string& target, size_t start, size_t end)
+{
+    if (end > start)
+    {
+        write_uint(delta, ((end - start) << 1) | 1);
+        delta.append(target, start, end - start);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+static void add_copy(string& delta, size_t offset, size_t length, size_t& expected)
+{
+    write_uint(delta, length << 1);
+    write_int(delta, static_cast<long long>(offset) - static_cast<long long>(expected));
+    expected = offset + length;
+}
+
+
+//=======================================================================================
+// BinaryDelta implementation
+//=======================================================================================
+string BinaryDelta::create(const string& source, const string& target)
+{
+    string delta;
+    write_uint(delta, target.size());
+
+    //common prefix and suffix
+    size_t maxCommon = min(source.size(), target.size());
+    size_t prefix = 0;
+    while (prefix < maxCommon && source[prefix] == target[prefix])
+        ++prefix;
+    size_t suffix = 0;
+    while (suffix < maxCommon - prefix
+           && source[source.size() - 1 - suffix] == target[target.size() - 1 - suffix])
+    {
+        ++suffix;
+    }
+
+    size_t expected = 0;
+    if (prefix > 0)
+        add_copy(delta, 0, prefix, expected);
+
+    //changed part: blocks of the source are located in the target by using a
+    //rolling hash, and matches are extended in both directions
+    size_t srcEnd = source.size() - suffix;
+    size_t tgtEnd = target.size() - suffix;
+    size_t pos = prefix;        //current position in target
+    size_t literal = prefix;    //start of pending bytes to insert
+    if (tgtEnd - prefix >= k_block_size && srcEnd - prefix >= k_block_size)
+    {
+        std::unordered_map<uint64_t, size_t> blocks;
+        blocks.reserve((srcEnd - prefix) / k_block_size);
+        for (size_t i = prefix; i + k_block_size <= srcEnd; i += k_block_size)
+            blocks.insert( make_pair(block_hash(&source[i]), i) );
+
+        uint64_t power = 1;     //k_hash_base ^ (k_block_size - 1)
+        for (size_t i=1; i < k_block_size; ++i)
+            power *= k_hash_base;
+
+        uint64_t hash = block_hash(&target[pos]);
+        while (pos + k_block_size <= tgtEnd)
+        {
+            std::unordered_map<uint64_t, size_t>::const_iterator it = blocks.find(hash);
+            if (it != blocks.end()
+                && memcmp(&source[it->second], &target[pos], k_block_size) == 0)
+            {
+                size_t src = it->second;
+                size_t length = k_block_size;
+                while (pos + length < tgtEnd && src + length < source.size()
+                       && source[src + length] == target[pos + length])
+                {
+                    ++length;
+                }
+                while (pos > literal && src > 0 && source[src - 1] == target[pos - 1])
+                {
+                    --src;
+                    --pos;
+                    ++length;
+                }
+
+                add_insert(delta, target, literal, pos);
+                add_copy(delta, src, length, expected);
+                pos += length;
+                literal = pos;
+                if (pos + k_block_size <= tgtEnd)
+                    hash = block_hash(&target[pos]);
+            }
+            else
+            {
+                if (pos + k_block_size < tgtEnd)
+                {
+                    hash -= static_cast<unsigned char>(target[pos]) * power;
+                    hash = hash * k_hash_base
+                           + static_cast<unsigned char>(target[pos + k_block_size]);
+                }
+                ++pos;
+            }
+        }
+    }
+    add_insert(delta, target, literal, tgtEnd);
+
+    if (suffix > 0)
+        add_copy(delta, source.size() - suffix, suffix, expected);
+
+    return delta;
+}
+
+//---------------------------------------------------------------------------------------
+string BinaryDelta::apply(const string& source, const string& delta)
+{
+    size_t pos = 0;
+    size_t size = size_t( read_uint(delta, pos) );
+    string target;
+    target.reserve(size);
+
+    size_t expected = 0;
+    while (pos < delta.size())
+    {
+        unsigned long long op = read_uint(delta, pos);
+        size_t length = size_t(op >> 1);
+        if (op & 1)
+        {
+            if (length > delta.size() - pos)
+                invalid_delta();
+            target.append(delta, pos, length);
+            pos += length;
+        }
+        else
+        {
+            long long offset = static_cast<long long>(expected) + read_int(delta, pos);
+            if (offset < 0 || size_t(offset) > source.size()
+                || length > source.size() - size_t(offset))
+            {
+                invalid_delta();
+            }
+            target.append(source, size_t(offset), length);
+            expected = size_t(offset) + length;
+        }
+        if (target.size() > size)
+            invalid_delta();
+    }
+
+    if (target.size() != size)
+        invalid_delta();
+
+    return target;
+}
+
+
+}   //namespace lomse
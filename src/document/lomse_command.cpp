@@ -34,6 +34,10 @@
 #include "lomse_document.h"
 #include "lomse_document_cursor.h"
 #include "lomse_im_factory.h"
+#include "lomse_im_snapshot.h"
+#include "lomse_binary_delta.h"
+#include "lomse_forensic_log.h"
+#include "lomse_injectors.h"
 #include "lomse_logger.h"
 #include "lomse_ldp_analyser.h"         //ldp_pitch_to_components
 #include "lomse_autobeamer.h"
@@ -62,7 +66,9 @@ void DocCommand::create_checkpoint(Document* pDoc)
     {
         if (m_checkpoint.empty())
         {
-            if (get_undo_policy() == k_undo_policy_partial_checkpoint)
+            if (get_undo_policy() == k_undo_policy_selection_checkpoint)
+                create_selection_checkpoint(pDoc);
+            else if (get_undo_policy() == k_undo_policy_partial_checkpoint)
                 m_checkpoint = pDoc->get_checkpoint_data_for(m_idChk);
             else
                 m_checkpoint = pDoc->get_checkpoint_data();
@@ -70,44 +76,102 @@ void DocCommand::create_checkpoint(Document* pDoc)
     }
 }
 
+//---------------------------------------------------------------------------------------
+void DocCommand::create_selection_checkpoint(Document* pDoc)
+{
+    //only the affected staff objects are saved. When this is not possible, the
+    //checkpoint is for the whole score and m_idChk is the score id
+    m_checkpoint = pDoc->get_checkpoint_data_for_objects(m_idsChk);
+    if (!m_checkpoint.empty())
+    {
+        m_flags |= k_checkpoint_is_selection;
+        return;
+    }
+
+    ImoObj* pImo = (m_idsChk.empty() ? nullptr
+                                     : pDoc->get_pointer_to_imo(m_idsChk.front()) );
+    ImoObj* pScore = (pImo ? pImo->find_block_level_parent() : nullptr);
+    if (pScore && pScore->is_score())
+    {
+        m_idChk = pScore->get_id();
+        m_checkpoint = pDoc->get_checkpoint_data_for(m_idChk);
+    }
+    else
+        m_checkpoint = pDoc->get_checkpoint_data();
+}
+
 //---------------------------------------------------------------------------------------
 void DocCommand::undo_action(Document* pDoc, DocCursor* UNUSED(pCursor))
 {
     //default implementation based on restoring from saved checkpoint data
 
     //log command for forensic analysis
-    ofstream logger;
-    logger.open("forensic_log.txt", std::ofstream::out | std::ofstream::app);
-
-    logger << "---------------------------------------------"
-           << "---------------------------------------------" << endl;
-    logger << "Before Undo, time="
-           << to_simple_string(chrono::system_clock::now()) << endl;
-    if (get_undo_policy() == k_undo_policy_partial_checkpoint)
-        logger << "Undo policy: Partial checkpoint. Obj: " << m_idChk << endl;
-    else
-        logger << "Undo policy: Full checkpoint" << endl;
+    ForensicLog* pLog = pDoc->get_library_scope().get_forensic_log();
+    stringstream logger;
+    if (pLog->is_enabled())
+    {
+        logger << "---------------------------------------------"
+               << "---------------------------------------------" << endl;
+        logger << "Before Undo, time="
+               << to_simple_string(chrono::system_clock::now()) << endl;
+        if (has_selection_checkpoint())
+            logger << "Undo policy: Selection checkpoint. Objs: " << m_idsChk.size() << endl;
+        else if (is_partial_checkpoint())
+            logger << "Undo policy: Partial checkpoint. Obj: " << m_idChk << endl;
+        else
+            logger << "Undo policy: Full checkpoint" << endl;
 
-    logger << "IdAssigner. Before: " << pDoc->dump_ids() << endl;
+        logger << "IdAssigner. Before: " << pDoc->dump_ids() << endl;
+    }
 
     //execute undo
-    if (get_undo_policy() == k_undo_policy_partial_checkpoint)
+    if (has_selection_checkpoint())
+        pDoc->replace_objects_from_checkpoint_data(m_checkpoint);
+    else if (is_partial_checkpoint())
         pDoc->replace_object_from_checkpoint_data(m_idChk, m_checkpoint);
     else
         pDoc->from_checkpoint(m_checkpoint);
 
-    logger << "IdAssigner. After: " << pDoc->dump_ids() << endl;
-    logger.close();
+    if (pLog->is_enabled())
+    {
+        logger << "IdAssigner. After: " << pDoc->dump_ids() << endl;
+        pLog->write(logger.str());
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void DocCommand::store_checkpoint_as_delta(DocCommand* pNewer)
+{
+    //replace checkpoint data by the differences with the checkpoint of next command.
+    //Selection checkpoints only contain some objects and are always stored in full
+    if (has_checkpoint() && !is_checkpoint_delta() && !has_selection_checkpoint()
+        && !pNewer->has_selection_checkpoint())
+    {
+        m_checkpoint = BinaryDelta::create(pNewer->m_checkpoint, m_checkpoint);
+        m_flags |= k_checkpoint_is_delta;
+    }
 }
 
 //---------------------------------------------------------------------------------------
-void DocCommand::log_forensic_data(Document* UNUSED(pDoc), DocCursor* pCursor)
+void DocCommand::restore_checkpoint_from_delta(DocCommand* pNewer)
+{
+    if (is_checkpoint_delta() && !pNewer->has_selection_checkpoint())
+    {
+        m_checkpoint = BinaryDelta::apply(pNewer->m_checkpoint, m_checkpoint);
+        m_flags &= ~k_checkpoint_is_delta;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void DocCommand::log_forensic_data(Document* pDoc, DocCursor* pCursor)
 {
     //save data for forensic analysis if a crash
 
-    ofstream logger;
-    logger.open("forensic_log.txt", std::ofstream::out | std::ofstream::app);
+    ForensicLog* pLog = pDoc->get_library_scope().get_forensic_log();
+    if (!pLog->is_enabled())
+        return;
 
+    stringstream logger;
     logger << "---------------------------------------------"
            << "---------------------------------------------" << endl;
     logger << "Before executing command, time="
@@ -115,12 +179,22 @@ void DocCommand::log_forensic_data(Document* UNUSED(pDoc), DocCursor* pCursor)
     log_command(logger);
     logger << "Cursor: " << pCursor->dump_cursor();
     logger << "Checkpoint data (last id " << m_idChk << "):" << endl;
-    logger << m_checkpoint << endl;
-    logger.close();
+    if (ImSnapshot::is_snapshot(m_checkpoint))
+    {
+        //binary snapshots are not readable. The source of the checkpointed object
+        //(the whole document for full and selection checkpoints) is logged instead,
+        //so that the document can be rebuilt
+        ImoId id = (is_partial_checkpoint() ? m_idChk
+                                            : pDoc->get_im_root()->get_id());
+        logger << pDoc->get_checkpoint_source_for(id) << endl;
+    }
+    else
+        logger << m_checkpoint << endl;
+    pLog->write(logger.str());
 }
 
 //---------------------------------------------------------------------------------------
-void DocCommand::log_command(ofstream &logger)
+void DocCommand::log_command(ostream& logger)
 {
     //default implementation. Should be overriden in specific commands
     logger << "Command. Name: " << this->get_name() << endl;
@@ -213,8 +287,13 @@ void DocCmdComposite::add_child_command(DocCommand* pCmd)
 {
     m_commands.push_back(pCmd);
     pCmd->mark_as_included_in_composite_cmd();
-    if (pCmd->get_undo_policy() == k_undo_policy_full_checkpoint)
+
+    //children do not save checkpoints. The composite command does it
+    if (pCmd->get_undo_policy() == k_undo_policy_full_checkpoint
+        || pCmd->get_undo_policy() == k_undo_policy_selection_checkpoint)
+    {
         m_undoPolicy = k_undo_policy_full_checkpoint;
+    }
 }
 
 //---------------------------------------------------------------------------------------
@@ -273,6 +352,16 @@ void DocCmdComposite::undo_action(Document* pDoc, DocCursor* pCursor)
     }
 }
 
+//---------------------------------------------------------------------------------------
+size_t DocCmdComposite::get_undo_data_size()
+{
+    size_t size = DocCommand::get_undo_data_size();
+    list<DocCommand*>::iterator it;
+    for (it=m_commands.begin(); it != m_commands.end(); ++it)
+        size += (*it)->get_undo_data_size();
+    return size;
+}
+
 //---------------------------------------------------------------------------------------
 void DocCmdComposite::update_cursor(DocCursor* pCursor, DocCommandExecuter* pExecuter)
 {
@@ -295,18 +384,115 @@ void DocCmdComposite::update_selection(SelectionSet* pSelection,
 }
 
 
+//=======================================================================================
+// DocCmdTransaction
+//=======================================================================================
+DocCmdTransaction::DocCmdTransaction(const string& name)
+    : DocCommand(name)
+{
+    m_flags = k_recordable | k_reversible | k_target_set_in_constructor;
+}
+
+//---------------------------------------------------------------------------------------
+DocCmdTransaction::~DocCmdTransaction()
+{
+    list<UndoElement*>::iterator it;
+    for (it=m_commands.begin(); it != m_commands.end(); ++it)
+        delete *it;
+}
+
+//---------------------------------------------------------------------------------------
+int DocCmdTransaction::set_target(Document* UNUSED(pDoc), DocCursor* UNUSED(pCursor),
+                                  SelectionSet* UNUSED(pSelection))
+{
+    //children commands set their target when executed
+    return k_success;
+}
+
+//---------------------------------------------------------------------------------------
+void DocCmdTransaction::start(Document* pDoc)
+{
+    //save the checkpoint for all commands in the transaction
+    create_checkpoint(pDoc);
+}
+
+//---------------------------------------------------------------------------------------
+void DocCmdTransaction::add_command(UndoElement* pUE)
+{
+    m_commands.push_back(pUE);
+}
+
+//---------------------------------------------------------------------------------------
+int DocCmdTransaction::perform_action(Document* pDoc, DocCursor* pCursor)
+{
+    //redo: replay children commands, each one with the cursor it found when executed
+
+    int result = k_success;
+    list<UndoElement*>::iterator it;
+    for (it=m_commands.begin(); it != m_commands.end(); ++it)
+    {
+        pCursor->restore_state( (*it)->cursorState );
+        result &= (*it)->pCmd->perform_action(pDoc, pCursor);
+    }
+    return result;
+}
+
+//---------------------------------------------------------------------------------------
+size_t DocCmdTransaction::get_undo_data_size()
+{
+    size_t size = DocCommand::get_undo_data_size();
+    list<UndoElement*>::iterator it;
+    for (it=m_commands.begin(); it != m_commands.end(); ++it)
+        size += (*it)->pCmd->get_undo_data_size();
+    return size;
+}
+
+//---------------------------------------------------------------------------------------
+void DocCmdTransaction::save_final_state(DocCursor* pCursor, SelectionSet* pSelection)
+{
+    m_finalCursor = pCursor->get_state();
+    if (pSelection)
+        m_finalSelection = pSelection->get_state().m_ids;
+}
+
+//---------------------------------------------------------------------------------------
+void DocCmdTransaction::update_cursor(DocCursor* pCursor)
+{
+    pCursor->restore_state(m_finalCursor);
+}
+
+//---------------------------------------------------------------------------------------
+void DocCmdTransaction::update_selection(SelectionSet* pSelection)
+{
+    if (pSelection)
+        pSelection->restore_state( SelectionState(m_finalSelection) );
+}
+
+
 //=======================================================================================
 // DocCommandExecuter
 //=======================================================================================
 DocCommandExecuter::DocCommandExecuter(Document* target)
     : m_pDoc(target)
+    , m_maxUndoBytes(0)
+    , m_pTransactionUE(nullptr)
+    , m_transactionLevel(0)
 {
 }
 
+//---------------------------------------------------------------------------------------
+DocCommandExecuter::~DocCommandExecuter()
+{
+    delete m_pTransactionUE;
+}
+
 //---------------------------------------------------------------------------------------
 int DocCommandExecuter::execute(DocCursor* pCursor, DocCommand* pCmd,
                                 SelectionSet* pSelection)
 {
+    if (m_pTransactionUE && pCmd->is_reversible())
+        return execute_in_transaction(pCursor, pCmd, pSelection);
+
     int result = k_success;
     if (!pCmd->is_target_set_in_constructor())
         result = pCmd->set_target(m_pDoc, pCursor, pSelection);
@@ -327,13 +513,22 @@ int DocCommandExecuter::execute(DocCursor* pCursor, DocCommand* pCmd,
         m_error = pCmd->get_error();
         if ( result == k_success && pCmd->is_reversible())
         {
+            //previous checkpoint is now stored as differences with the new one
+            DocCommand* pPrev = last_command_with_checkpoint();
+            if (pPrev && pCmd->has_checkpoint())
+                pPrev->store_checkpoint_as_delta(pCmd);
+
             m_stack.push( pUE );
+            enforce_memory_limit();
             update_cursor(pCursor, pCmd);
             update_selection(pSelection, pCmd);
             m_pDoc->set_modified();
         }
-        else
+        else if (pUE)
+        {
+            pUE->pCmd = nullptr;    //the command is not owned
             delete pUE;
+        }
     }
     else
     {
@@ -347,6 +542,112 @@ int DocCommandExecuter::execute(DocCursor* pCursor, DocCommand* pCmd,
     return result;
 }
 
+//---------------------------------------------------------------------------------------
+int DocCommandExecuter::execute_in_transaction(DocCursor* pCursor, DocCommand* pCmd,
+                                               SelectionSet* pSelection)
+{
+    //the command is executed now but its undo data is the transaction checkpoint
+
+    DocCmdTransaction* pTransaction = get_transaction();
+    int result = k_success;
+    if (!pCmd->is_target_set_in_constructor())
+        result = pCmd->set_target(m_pDoc, pCursor, pSelection);
+
+    if (result != k_success)
+    {
+        string error = pCmd->get_error();
+        m_error = (error.empty() ? "Command ignored. Can not set target" : error);
+        return result;
+    }
+
+    if (!pTransaction->has_checkpoint())
+        pTransaction->start(m_pDoc);
+
+    pCmd->mark_as_included_in_composite_cmd();
+    UndoElement* pUE = LOMSE_NEW UndoElement(pCmd,
+                                             pCursor->get_state(),
+                                             pSelection->get_state()
+                                            );
+
+    if (pCmd->get_cursor_update_policy() == DocCommand::k_refresh)
+        pCmd->set_final_cursor_pos( pCursor->get_pointee_id() );
+
+    result = pCmd->perform_action(m_pDoc, pCursor);
+    m_error = pCmd->get_error();
+    if (result == k_success)
+    {
+        pTransaction->add_command(pUE);
+        update_cursor(pCursor, pCmd);
+        update_selection(pSelection, pCmd);
+    }
+    else
+    {
+        pUE->pCmd = nullptr;    //the command is not owned
+        delete pUE;
+    }
+
+    return result;
+}
+
+//---------------------------------------------------------------------------------------
+void DocCommandExecuter::begin_transaction(DocCursor* pCursor, SelectionSet* pSelection,
+                                           const string& name)
+{
+    ++m_transactionLevel;
+    if (m_pTransactionUE)
+        return;
+
+    m_pTransactionUE = LOMSE_NEW UndoElement(LOMSE_NEW DocCmdTransaction(name),
+                                             pCursor->get_state(),
+                                             pSelection->get_state()
+                                            );
+}
+
+//---------------------------------------------------------------------------------------
+void DocCommandExecuter::commit_transaction(DocCursor* pCursor, SelectionSet* pSelection)
+{
+    if (!m_pTransactionUE || --m_transactionLevel > 0)
+        return;
+
+    UndoElement* pUE = m_pTransactionUE;
+    m_pTransactionUE = nullptr;
+    DocCmdTransaction* pTransaction = static_cast<DocCmdTransaction*>(pUE->pCmd);
+    if (pTransaction->num_commands() == 0)
+    {
+        delete pUE;
+        return;
+    }
+
+    pTransaction->save_final_state(pCursor, pSelection);
+
+    DocCommand* pPrev = last_command_with_checkpoint();
+    if (pPrev)
+        pPrev->store_checkpoint_as_delta(pTransaction);
+
+    m_stack.push( pUE );
+    enforce_memory_limit();
+    m_pDoc->set_modified();
+}
+
+//---------------------------------------------------------------------------------------
+void DocCommandExecuter::rollback_transaction(DocCursor* pCursor, SelectionSet* pSelection)
+{
+    if (!m_pTransactionUE)
+        return;
+
+    UndoElement* pUE = m_pTransactionUE;
+    m_pTransactionUE = nullptr;
+    m_transactionLevel = 0;
+
+    DocCmdTransaction* pTransaction = static_cast<DocCmdTransaction*>(pUE->pCmd);
+    if (pTransaction->num_commands() > 0)
+        pTransaction->undo_action(m_pDoc, pCursor);
+
+    pCursor->restore_state( pUE->cursorState );
+    pSelection->restore_state( pUE->selState );
+    delete pUE;
+}
+
 //---------------------------------------------------------------------------------------
 void DocCommandExecuter::update_cursor(DocCursor* pCursor, DocCommand* pCmd)
 {
@@ -354,6 +655,10 @@ void DocCommandExecuter::update_cursor(DocCursor* pCursor, DocCommand* pCmd)
     {
         (static_cast<DocCmdComposite*>(pCmd))->update_cursor(pCursor, this);
     }
+    else if (pCmd->is_transaction())
+    {
+        (static_cast<DocCmdTransaction*>(pCmd))->update_cursor(pCursor);
+    }
     else
     {
         int policy = pCmd->get_cursor_update_policy();
@@ -396,6 +701,10 @@ void DocCommandExecuter::update_selection(SelectionSet* pSelection, DocCommand*
     {
         (static_cast<DocCmdComposite*>(pCmd))->update_selection(pSelection, this);
     }
+    else if (pCmd->is_transaction())
+    {
+        (static_cast<DocCmdTransaction*>(pCmd))->update_selection(pSelection);
+    }
     else
     {
         int policy = pCmd->get_selection_update_policy();
@@ -432,6 +741,8 @@ void DocCommandExecuter::update_selection(SelectionSet* pSelection, DocCommand*
 //---------------------------------------------------------------------------------------
 void DocCommandExecuter::undo(DocCursor* pCursor, SelectionSet* pSelection)
 {
+    close_open_transaction(pCursor, pSelection);
+
     UndoElement* pUE = m_stack.pop();
     if (pUE)
     {
@@ -443,15 +754,26 @@ void DocCommandExecuter::undo(DocCursor* pCursor, SelectionSet* pSelection)
 
         if (cmd->is_reversible())
             m_pDoc->reset_modified();
+
+        //previous checkpoint is now the most recent one and must be fully restored
+        DocCommand* pPrev = last_command_with_checkpoint();
+        if (pPrev && cmd->has_checkpoint())
+            pPrev->restore_checkpoint_from_delta(cmd);
     }
 }
 
 //---------------------------------------------------------------------------------------
 void DocCommandExecuter::redo(DocCursor* pCursor, SelectionSet* pSelection)
 {
+    close_open_transaction(pCursor, pSelection);
+
+    DocCommand* pPrev = last_command_with_checkpoint();
     UndoElement* pUE = m_stack.undo_pop();
     if (pUE)
     {
+        if (pPrev && pUE->pCmd->has_checkpoint())
+            pPrev->store_checkpoint_as_delta(pUE->pCmd);
+
         pCursor->restore_state( pUE->cursorState );
         pSelection->restore_state( pUE->selState );
         DocCommand* cmd = pUE->pCmd;
@@ -465,6 +787,67 @@ void DocCommandExecuter::redo(DocCursor* pCursor, SelectionSet* pSelection)
     }
 }
 
+//---------------------------------------------------------------------------------------
+void DocCommandExecuter::close_open_transaction(DocCursor* pCursor,
+                                                SelectionSet* pSelection)
+{
+    //undo/redo are not possible inside a transaction. Commit it
+    if (m_pTransactionUE)
+    {
+        m_transactionLevel = 1;
+        commit_transaction(pCursor, pSelection);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+DocCommand* DocCommandExecuter::last_command_with_checkpoint()
+{
+    UndoStack::iterator it = m_stack.end();
+    while (it != m_stack.begin())
+    {
+        --it;
+        if ((*it)->pCmd->has_checkpoint() && !(*it)->pCmd->has_selection_checkpoint())
+            return (*it)->pCmd;
+    }
+    return nullptr;
+}
+
+//---------------------------------------------------------------------------------------
+void DocCommandExecuter::set_undo_memory_limit(size_t maxBytes)
+{
+    m_maxUndoBytes = maxBytes;
+    enforce_memory_limit();
+}
+
+//---------------------------------------------------------------------------------------
+size_t DocCommandExecuter::get_undo_memory_used()
+{
+    size_t used = 0;
+    UndoStack::iterator it;
+    for (it = m_stack.begin(); it != m_stack.end(); ++it)
+        used += (*it)->pCmd->get_undo_data_size();
+    for (it = m_stack.history_begin(); it != m_stack.history_end(); ++it)
+        used += (*it)->pCmd->get_undo_data_size();
+    return used;
+}
+
+//---------------------------------------------------------------------------------------
+void DocCommandExecuter::enforce_memory_limit()
+{
+    //Oldest checkpoints are stored as differences with newer ones. Therefore, the
+    //oldest commands can be removed without affecting the others
+
+    if (m_maxUndoBytes == 0)
+        return;
+
+    size_t used = get_undo_memory_used();
+    while (used > m_maxUndoBytes && m_stack.size() > 1)
+    {
+        used -= (*m_stack.begin())->pCmd->get_undo_data_size();
+        m_stack.remove_oldest();
+    }
+}
+
 ////---------------------------------------------------------------------------------------
 //void DocCommandExecuter::replay(DocCursor* pCursor)
 //{
@@ -499,7 +882,7 @@ CmdAddChordNote::CmdAddChordNote(const string& pitch, const string& name)
 }
 
 //---------------------------------------------------------------------------------------
-void CmdAddChordNote::log_command(ofstream &logger)
+void CmdAddChordNote::log_command(ostream& logger)
 {
     logger << "Command CmdAddChordNote. Name: '" << this->get_name()
         << ", pitch: " << m_pitch << endl;
@@ -609,7 +992,7 @@ CmdAddNoteRest::CmdAddNoteRest(const string& source, int UNUSED(editMode),
 }
 
 //---------------------------------------------------------------------------------------
-void CmdAddNoteRest::log_command(ofstream &logger)
+void CmdAddNoteRest::log_command(ostream& logger)
 {
     logger << "Command CmdAddNoteRest. Name: '" << this->get_name()
         << ", source: " << m_source << endl;
@@ -937,7 +1320,7 @@ int CmdAddTie::set_target(Document* UNUSED(pDoc), DocCursor* UNUSED(pCursor),
 }
 
 //---------------------------------------------------------------------------------------
-void CmdAddTie::log_command(ofstream &logger)
+void CmdAddTie::log_command(ostream& logger)
 {
     logger << "Command CmdAddTie. Name: '" << this->get_name()
         << ", start & end notes: " << m_startId << ", " << m_endId << endl;
@@ -1011,7 +1394,7 @@ int CmdAddTuplet::set_target(Document* UNUSED(pDoc), DocCursor* UNUSED(pCursor),
 }
 
 //---------------------------------------------------------------------------------------
-void CmdAddTuplet::log_command(ofstream &logger)
+void CmdAddTuplet::log_command(ostream& logger)
 {
     logger << "Command CmdAddTuplet. Name: '" << this->get_name()
         << ", start & end notes: " << m_startId << ", " << m_endId
@@ -1067,14 +1450,13 @@ CmdBreakBeam::CmdBreakBeam(const string& name)
 int CmdBreakBeam::set_target(Document* UNUSED(pDoc), DocCursor* pCursor,
                              SelectionSet* UNUSED(pSelection))
 {
-    ImoObj* pParent = pCursor->get_parent_object();
     if (pCursor->get_parent_object()->is_score())
     {
-        m_idChk = pParent->get_id();
         ImoNoteRest* pBeforeNR = dynamic_cast<ImoNoteRest*>( pCursor->get_pointee() );
         if (pBeforeNR)
         {
             m_beforeId = pBeforeNR->get_id();
+            m_idsChk.push_back(m_beforeId);
             return k_success;
         }
     }
@@ -1082,7 +1464,7 @@ int CmdBreakBeam::set_target(Document* UNUSED(pDoc), DocCursor* pCursor,
 }
 
 //---------------------------------------------------------------------------------------
-void CmdBreakBeam::log_command(ofstream &logger)
+void CmdBreakBeam::log_command(ostream& logger)
 {
     logger << "Command CmdBreakBeam. Name: '" << this->get_name()
         << ", before note: " << m_beforeId << endl;
@@ -1091,8 +1473,7 @@ void CmdBreakBeam::log_command(ofstream &logger)
 //---------------------------------------------------------------------------------------
 int CmdBreakBeam::perform_action(Document* pDoc, DocCursor* pCursor)
 {
-    //Undo strategy: Checkpoint.
-    //TODO: Posible optimization: minimal checkpoint: save only source code for beam
+    //Undo strategy: selection checkpoint. It includes all notes in the beam
     create_checkpoint(pDoc);
     log_forensic_data(pDoc, pCursor);
 
@@ -1222,7 +1603,7 @@ int CmdChangeAccidentals::set_target(Document* UNUSED(pDoc), DocCursor* UNUSED(p
 }
 
 //---------------------------------------------------------------------------------------
-void CmdChangeAccidentals::log_command(ofstream &logger)
+void CmdChangeAccidentals::log_command(ostream& logger)
 {
     logger << "Command CmdChangeAccidentals. Name: '" << this->get_name() << endl;
 }
@@ -1845,7 +2226,7 @@ int CmdDeleteRelation::set_target(Document* pDoc, DocCursor* UNUSED(pCursor),
                 m_relobjs.push_back( pRO->get_id() );
                 if (m_name == "")
                     m_name = "Delete " + pRO->get_name();
-                return set_score_id(pDoc);
+                return set_checkpoint_ids(pDoc);
             }
         }
         else
@@ -1856,7 +2237,7 @@ int CmdDeleteRelation::set_target(Document* pDoc, DocCursor* UNUSED(pCursor),
             {
                 if (m_name == "")
                     m_name = "Delete " + ImoObj::get_name(m_type);
-                return set_score_id(pDoc);
+                return set_checkpoint_ids(pDoc);
             }
         }
     }
@@ -1866,10 +2247,9 @@ int CmdDeleteRelation::set_target(Document* pDoc, DocCursor* UNUSED(pCursor),
 //---------------------------------------------------------------------------------------
 int CmdDeleteRelation::perform_action(Document* pDoc, DocCursor* pCursor)
 {
-    //Undo strategy: checkpoint, because the relation could have some attributes
-    //modified (color, user positioned, ...).
-    //TODO: OPTIMIZATION direct undo via partial checkpoint, that is, only relation
-    //      source code
+    //Undo strategy: selection checkpoint, because the relation could have some
+    //attributes modified (color, user positioned, ...). It includes all the objects
+    //in the relation
     create_checkpoint(pDoc);
     log_forensic_data(pDoc, pCursor);
 
@@ -1883,14 +2263,14 @@ int CmdDeleteRelation::perform_action(Document* pDoc, DocCursor* pCursor)
 }
 
 //---------------------------------------------------------------------------------------
-int CmdDeleteRelation::set_score_id(Document* pDoc)
+int CmdDeleteRelation::set_checkpoint_ids(Document* pDoc)
 {
     ImoId id = m_relobjs.front();
     ImoRelObj* pRO = static_cast<ImoRelObj*>( pDoc->get_pointer_to_imo(id) );
     ImoObj* pParent = pRO->find_block_level_parent();
     if (pParent && pParent->is_score())
     {
-        m_idChk = pParent->get_id();
+        m_idsChk = m_relobjs;
         return k_success;
     }
     return k_failure;
@@ -2518,13 +2898,14 @@ int CmdJoinBeam::set_target(Document* UNUSED(pDoc), DocCursor* UNUSED(pCursor),
     if (pSelection && !pSelection->empty())
     {
         m_noteRests = pSelection->filter_notes_rests();
+        m_idsChk = m_noteRests;
         return k_success;
     }
     return k_failure;
 }
 
 //---------------------------------------------------------------------------------------
-void CmdJoinBeam::log_command(ofstream &logger)
+void CmdJoinBeam::log_command(ostream& logger)
 {
     logger << "Command CmdJoinBeam. Name: '" << this->get_name()
         << ", notes:";
@@ -2537,8 +2918,8 @@ void CmdJoinBeam::log_command(ofstream &logger)
 //---------------------------------------------------------------------------------------
 int CmdJoinBeam::perform_action(Document* pDoc, DocCursor* pCursor)
 {
-    //Undo strategy: Note/rests to be beamed could have beams. For now, it is
-    //simpler to use a checkpoint
+    //Undo strategy: Note/rests to be beamed could have beams. Selection checkpoint
+    //of the note/rests and the notes in their beams
     create_checkpoint(pDoc);
     log_forensic_data(pDoc, pCursor);
 
@@ -45,6 +45,7 @@
 #include "lomse_lmd_exporter.h"
 #include "lomse_model_builder.h"
 #include "lomse_im_factory.h"
+#include "lomse_im_snapshot.h"
 #include "lomse_events.h"
 #include "lomse_ldp_elements.h"
 #include "lomse_control.h"
@@ -53,6 +54,7 @@
 #include "lomse_autoclef.h"
 
 #include <sstream>
+#include <set>
 using namespace std;
 
 namespace lomse
@@ -136,6 +138,252 @@ protected:
 };
 
 
+//=======================================================================================
+// DocChangeSet implementation
+//=======================================================================================
+bool DocChangeSet::is_item_changed(ImoId id) const
+{
+    return m_fAll || m_items.find(id) != m_items.end();
+}
+
+//---------------------------------------------------------------------------------------
+list<ImoId> DocChangeSet::get_changed_scores() const
+{
+    list<ImoId> scores;
+    map<ImoId, ScoreChanges>::const_iterator it;
+    for (it = m_scores.begin(); it != m_scores.end(); ++it)
+        scores.push_back(it->first);
+    return scores;
+}
+
+//---------------------------------------------------------------------------------------
+bool DocChangeSet::is_score_changed(ImoId scoreId) const
+{
+    return m_fAll || m_scores.find(scoreId) != m_scores.end();
+}
+
+//---------------------------------------------------------------------------------------
+bool DocChangeSet::is_instrument_changed(ImoId scoreId, int iInstr) const
+{
+    if (m_fAll)
+        return true;
+
+    map<ImoId, ScoreChanges>::const_iterator it = m_scores.find(scoreId);
+    if (it == m_scores.end())
+        return false;
+
+    const ScoreChanges& changes = it->second;
+    return changes.fWholeScore
+           || changes.instruments.find(iInstr) != changes.instruments.end();
+}
+
+//---------------------------------------------------------------------------------------
+bool DocChangeSet::get_changed_measures(ImoId scoreId, int* pFirst, int* pLast) const
+{
+    if (m_fAll)
+    {
+        *pFirst = 0;
+        *pLast = k_end_of_score;
+        return true;
+    }
+
+    map<ImoId, ScoreChanges>::const_iterator it = m_scores.find(scoreId);
+    if (it == m_scores.end())
+        return false;
+
+    const ScoreChanges& changes = it->second;
+    if (changes.fWholeScore || !changes.pending.empty()
+        || changes.firstMeasure > changes.lastMeasure)
+    {
+        *pFirst = 0;
+        *pLast = k_end_of_score;
+    }
+    else
+    {
+        *pFirst = changes.firstMeasure;
+        *pLast = changes.lastMeasure;
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+void DocChangeSet::add_change(ImoObj* pImo)
+{
+    if (m_fAll)
+        return;
+
+    //find the top-level item, the score, the instrument and the staff object
+    //containing the modified object
+    ImoStaffObj* pSO = nullptr;
+    ImoInstrument* pInstr = nullptr;
+    ImoScore* pScore = nullptr;
+    ImoObj* pItem = nullptr;
+    ImoObj* pChild = pImo;
+    ImoObj* pParent = pImo->get_parent_imo();
+    while (pParent)
+    {
+        //deleting a subtree: siblings and collections can not be accessed
+        if (pParent->is_being_deleted())
+        {
+            set_all_changed();
+            return;
+        }
+
+        if (!pSO && pChild->is_staffobj() && pParent->is_music_data())
+            pSO = static_cast<ImoStaffObj*>(pChild);
+        else if (!pInstr && pChild->is_instrument())
+            pInstr = static_cast<ImoInstrument*>(pChild);
+        else if (!pScore && pChild->is_score())
+            pScore = static_cast<ImoScore*>(pChild);
+
+        if (pParent->is_content() && pParent->get_parent_imo()
+            && pParent->get_parent_imo()->is_document())
+        {
+            pItem = pChild;
+            break;
+        }
+
+        pChild = pParent;
+        pParent = pParent->get_parent_imo();
+    }
+
+    //content added or removed, or changes outside the content
+    if (!pItem)
+    {
+        set_all_changed();
+        return;
+    }
+
+    m_items.insert( pItem->get_id() );
+    if (!pScore)
+        return;
+
+    ScoreChanges& changes = m_scores[ pScore->get_id() ];
+    if (changes.fWholeScore)
+        return;
+
+    if (!pInstr)
+    {
+        changes.fWholeScore = true;
+        changes.instruments.clear();
+        changes.pending.clear();
+        return;
+    }
+
+    int iInstr = pScore->get_instr_number_for(pInstr);
+    changes.instruments.insert(iInstr);
+
+    if (!pSO)
+    {
+        add_measures(changes, 0, k_end_of_score);
+        return;
+    }
+
+    //AWARE: the staff object could be deleted before measures are resolved.
+    //Save the previous object to locate its position.
+    vector<StaffObjChange>& objects = changes.pending[iInstr];
+    if (objects.size() >= 256)
+    {
+        add_measures(changes, 0, k_end_of_score);
+        return;
+    }
+
+    StaffObjChange change;
+    change.id = pSO->get_id();
+    ImoObj* pPrev = pSO->get_prev_sibling();
+    change.prevId = (pPrev ? pPrev->get_id() : k_no_imoid);
+    change.fBarline = pSO->is_barline();
+    objects.push_back(change);
+}
+
+//---------------------------------------------------------------------------------------
+void DocChangeSet::add_measures(ScoreChanges& changes, int first, int last)
+{
+    changes.firstMeasure = min(changes.firstMeasure, first);
+    changes.lastMeasure = max(changes.lastMeasure, last);
+}
+
+//---------------------------------------------------------------------------------------
+void DocChangeSet::resolve_measures(Document* pDoc)
+{
+    map<ImoId, ScoreChanges>::iterator it;
+    for (it = m_scores.begin(); it != m_scores.end(); ++it)
+    {
+        ScoreChanges& changes = it->second;
+        if (changes.pending.empty())
+            continue;
+
+        ImoScore* pScore = dynamic_cast<ImoScore*>( pDoc->get_pointer_to_imo(it->first) );
+        if (!pScore)
+        {
+            changes.fWholeScore = true;
+            changes.pending.clear();
+            continue;
+        }
+
+        map<int, vector<StaffObjChange> >::iterator itP;
+        for (itP = changes.pending.begin(); itP != changes.pending.end(); ++itP)
+        {
+            ImoInstrument* pInstr = pScore->get_instrument(itP->first);
+            if (pInstr)
+                resolve_instrument(changes, pInstr, itP->second);
+            else
+                add_measures(changes, 0, k_end_of_score);
+        }
+        changes.pending.clear();
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void DocChangeSet::resolve_instrument(ScoreChanges& changes, ImoInstrument* pInstr,
+                                      vector<StaffObjChange>& objects)
+{
+    //measure for each staff object. It is the number of previous barlines
+    map<ImoId, int> measures;
+    set<ImoId> barlines;
+    ImoMusicData* pMD = pInstr->get_musicdata();
+    int measure = 0;
+    if (pMD)
+    {
+        ImoObj::children_iterator itC;
+        for (itC = pMD->begin(); itC != pMD->end(); ++itC)
+        {
+            measures[(*itC)->get_id()] = measure;
+            if ((*itC)->is_barline())
+            {
+                barlines.insert( (*itC)->get_id() );
+                ++measure;
+            }
+        }
+    }
+
+    vector<StaffObjChange>::iterator it;
+    for (it = objects.begin(); it != objects.end(); ++it)
+    {
+        int first;
+        map<ImoId, int>::iterator itM = measures.find((*it).id);
+        if (itM != measures.end())
+            first = itM->second;
+        else if ((*it).prevId == k_no_imoid)
+            first = 0;
+        else
+        {
+            //deleted object: locate it after the previous one
+            itM = measures.find((*it).prevId);
+            if (itM == measures.end())
+            {
+                add_measures(changes, 0, k_end_of_score);
+                return;
+            }
+            first = itM->second + (barlines.count((*it).prevId) ? 1 : 0);
+        }
+
+        //measures after a barline are renumbered when it is added or removed
+        add_measures(changes, first, ((*it).fBarline ? int(k_end_of_score) : first));
+    }
+}
+
+
 //=======================================================================================
 // Document implementation
 //=======================================================================================
@@ -152,7 +400,10 @@ Document::Document(LibraryScope& libraryScope, ostream& reporter)
     , m_modified(0)
     , m_beatType(k_beat_implied)
     , m_beatDuration( TimeUnits(k_duration_quarter) )
+    , m_changes(0)
+    , m_snapshotChanges(0)
 {
+    m_changeSet.set_all_changed();
 }
 
 //---------------------------------------------------------------------------------------
@@ -175,6 +426,8 @@ void Document::initialize()
     m_flags = k_dirty;
     m_pImoDoc = nullptr;
     m_modified = 0;
+    ++m_changes;
+    m_changeSet.set_all_changed();
 }
 
 //---------------------------------------------------------------------------------------
@@ -185,13 +438,15 @@ void Document::set_imo_doc(ImoDocument* pImoDoc)
 }
 
 //---------------------------------------------------------------------------------------
-int Document::from_file(const string& filename, int format)
+int Document::from_file(const string& filename, int format,
+                        CompilerMonitor* pMonitor)
 {
     initialize();
     int numErrors = 0;
     Compiler* pCompiler = get_compiler_for_format(format);
     if (pCompiler)
     {
+        pCompiler->set_monitor(pMonitor);
         m_pImoDoc = pCompiler->compile_file(filename);
         numErrors = pCompiler->get_num_errors();
         delete pCompiler;
@@ -244,6 +499,8 @@ int Document::from_checkpoint(const string& data)
     //delete old internal model
     m_pImoDoc = nullptr;
     m_flags = k_dirty;
+    ++m_changes;
+    m_changeSet.set_all_changed();
 
     //reset IdAssigner
     m_pIdAssigner->reset();
@@ -255,6 +512,15 @@ int Document::from_checkpoint(const string& data)
     //the Document, these actions could imply reviewing Document observers.
 
     //finally, load document from checkpoint source data
+    if (ImSnapshot::is_snapshot(data))
+    {
+        initialize();
+        ImSnapshot snapshot(this);
+        set_imo_doc( static_cast<ImoDocument*>(snapshot.restore(data)) );
+        ModelBuilder builder;
+        builder.build_model(m_pImoDoc);
+        return 0;
+    }
     return from_string(data, k_format_lmd);
 }
 
@@ -266,10 +532,18 @@ int Document::replace_object_from_checkpoint_data(ImoId id, const string& data)
     ImoObj* pParent = pOldImo->get_parent();
 
     //new object
+    bool fSnapshot = ImSnapshot::is_snapshot(data);
     IdAssigner assigner;
     IdAssigner* pSave = m_pIdAssigner;
     m_pIdAssigner = &assigner;
-    ImoObj* pNewImo = create_object_from_lmd(data);
+    ImoObj* pNewImo = nullptr;
+    if (fSnapshot)
+    {
+        ImSnapshot snapshot(this);
+        pNewImo = snapshot.restore(data, pSave);
+    }
+    else
+        pNewImo = create_object_from_lmd(data);
     m_pIdAssigner = pSave;
 
     //replace old object
@@ -277,9 +551,18 @@ int Document::replace_object_from_checkpoint_data(ImoId id, const string& data)
     ImoObj::depth_first_iterator it(pOldImo);
     pParent->replace_node(it, pNewImo);
     delete pOldImo;
+    pNewImo->set_dirty(true);
+
+    //add new ids. Snapshots only contain the restored objects and they keep
+    //their original ids
+    assigner.copy_ids_to(m_pIdAssigner, (fSnapshot ? k_no_imoid : id));
 
-    //add new ids
-    assigner.copy_ids_to(m_pIdAssigner, id);
+    //computed data is not included in snapshots
+    if (fSnapshot)
+    {
+        ModelBuilder builder;
+        builder.structurize(pNewImo);
+    }
 
     return 0;
 }
@@ -366,6 +649,22 @@ string Document::get_checkpoint_data_for(ImoId id)
     ImoObj* pImo = get_pointer_to_imo(id);
     //TODO: check that ImoObj is a terminal node?
 
+    //binary snapshot when possible, as it is faster to create and to restore
+    ImSnapshot snapshot(this);
+    string data = snapshot.save(pImo);
+    if (!data.empty())
+        return data;
+
+    return get_checkpoint_source_for(id);
+}
+
+//---------------------------------------------------------------------------------------
+string Document::get_checkpoint_source_for(ImoId id)
+{
+    //checkpoint as LMD source. It is also used for forensic analysis, as binary
+    //snapshots are not readable
+
+    ImoObj* pImo = get_pointer_to_imo(id);
     LmdExporter exporter(m_libraryScope);
     //exporter.set_remove_newlines(true);   //TODO: Commented out to facilitate debugging
     exporter.set_add_id(true);
@@ -379,6 +678,114 @@ string Document::get_checkpoint_data_for(ImoId id)
         //return exporter.get_source(m_pImo);
 }
 
+//---------------------------------------------------------------------------------------
+static void add_staffobj(ImoObj* pImo, vector<ImoObj*>& objects, set<ImoObj*>& included)
+{
+    if (included.insert(pImo).second)
+        objects.push_back(pImo);
+}
+
+//---------------------------------------------------------------------------------------
+string Document::get_checkpoint_data_for_objects(const list<ImoId>& ids)
+{
+    //Checkpoint for the staff objects affected by a command. It includes the staff
+    //objects owning the given objects and all other staff objects linked to them by
+    //relations (beams, chords, ties, tuplets, slurs, etc.), so that the relations
+    //can be restored. Returns an empty string when the snapshot is not possible.
+
+    vector<ImoObj*> objects;
+    set<ImoObj*> included;
+    list<ImoId>::const_iterator it;
+    for (it = ids.begin(); it != ids.end(); ++it)
+    {
+        ImoObj* pImo = get_pointer_to_imo(*it);
+        if (pImo && pImo->is_relobj())
+        {
+            ImoRelObj* pRO = static_cast<ImoRelObj*>(pImo);
+            list< pair<ImoStaffObj*, ImoRelDataObj*> >& related = pRO->get_related_objects();
+            list< pair<ImoStaffObj*, ImoRelDataObj*> >::iterator itR;
+            for (itR = related.begin(); itR != related.end(); ++itR)
+                add_staffobj((*itR).first, objects, included);
+            continue;
+        }
+
+        while (pImo && !pImo->is_staffobj())
+            pImo = pImo->get_parent_imo();
+        if (!pImo)
+            return "";
+        add_staffobj(pImo, objects, included);
+    }
+
+    //add the staff objects related to them. The vector grows while traversed
+    for (size_t i=0; i < objects.size(); ++i)
+    {
+        ImoStaffObj* pSO = static_cast<ImoStaffObj*>( objects[i] );
+        int numRelations = pSO->get_num_relations();
+        for (int iR=0; iR < numRelations; ++iR)
+        {
+            ImoRelObj* pRO = pSO->get_relation(iR);
+            list< pair<ImoStaffObj*, ImoRelDataObj*> >& related = pRO->get_related_objects();
+            list< pair<ImoStaffObj*, ImoRelDataObj*> >::iterator itR;
+            for (itR = related.begin(); itR != related.end(); ++itR)
+                add_staffobj((*itR).first, objects, included);
+        }
+    }
+
+    if (objects.empty())
+        return "";
+
+    ImSnapshot snapshot(this);
+    return snapshot.save(objects);
+}
+
+//---------------------------------------------------------------------------------------
+int Document::replace_objects_from_checkpoint_data(const string& data)
+{
+    //new objects. They keep their original ids
+    IdAssigner assigner;
+    IdAssigner* pSave = m_pIdAssigner;
+    m_pIdAssigner = &assigner;
+    ImSnapshot snapshot(this);
+    vector<ImoObj*> objects = snapshot.restore_objects(data, pSave);
+    m_pIdAssigner = pSave;
+
+    //replace old objects. Old objects are deleted after replacing all of them, as
+    //deleting an object also removes it from its relations
+    list<ImoObj*> oldObjects;
+    set<ImoScore*> scores;
+    vector<ImoObj*>::iterator it;
+    for (it = objects.begin(); it != objects.end(); ++it)
+    {
+        ImoObj* pNewImo = *it;
+        ImoObj* pOldImo = get_pointer_to_imo( pNewImo->get_id() );
+        if (!pOldImo || !pOldImo->get_parent_imo())
+        {
+            LOMSE_LOG_ERROR("Object to replace not found. Id: %d", pNewImo->get_id());
+            throw runtime_error("[Document::replace_objects_from_checkpoint_data] "
+                                "Object to replace not found.");
+        }
+
+        ImoObj::depth_first_iterator itOld(pOldImo);
+        pOldImo->get_parent_imo()->replace_node(itOld, pNewImo);
+        oldObjects.push_back(pOldImo);
+        pNewImo->set_dirty(true);
+        scores.insert( static_cast<ImoStaffObj*>(pNewImo)->get_score() );
+    }
+
+    list<ImoObj*>::iterator itOld;
+    for (itOld = oldObjects.begin(); itOld != oldObjects.end(); ++itOld)
+        delete *itOld;
+
+    assigner.copy_ids_to(m_pIdAssigner, k_no_imoid);
+
+    //computed data is not included in snapshots
+    set<ImoScore*>::iterator itS;
+    for (itS = scores.begin(); itS != scores.end(); ++itS)
+        (*itS)->end_of_changes();
+
+    return 0;
+}
+
 //---------------------------------------------------------------------------------------
 Compiler* Document::get_compiler_for_format(int format)
 {
@@ -406,13 +813,44 @@ Compiler* Document::get_compiler_for_format(int format)
 bool Document::is_editable()
 {
     //TODO: How to mark a document as 'not editable'?
-    //For now, all documents are editable
-    return true;
+    //For now, all documents are editable, except snapshots
+    return !is_snapshot();
+}
+
+//---------------------------------------------------------------------------------------
+SpDocument Document::get_snapshot(bool fShared)
+{
+    //cached full copy: the last shared snapshot is reused while it is in use and the
+    //document has not been modified. Otherwise, the whole document is copied
+
+    if (fShared && m_snapshotChanges == m_changes)
+    {
+        SpDocument spSnapshot = m_wpSnapshot.lock();
+        if (spSnapshot)
+            return spSnapshot;
+    }
+
+    if (m_pImoDoc == nullptr)
+        return SpDocument();
+
+    SpDocument spSnapshot( Injector::inject_Document(m_libraryScope, m_reporter) );
+    spSnapshot->from_checkpoint( get_checkpoint_data() );
+    spSnapshot->m_beatType = m_beatType;
+    spSnapshot->m_beatDuration = m_beatDuration;
+    spSnapshot->m_flags |= k_snapshot;
+
+    if (fShared)
+    {
+        m_wpSnapshot = spSnapshot;
+        m_snapshotChanges = m_changes;
+    }
+    return spSnapshot;
 }
 
 //---------------------------------------------------------------------------------------
 void Document::define_beat(int beatType, TimeUnits duration)
 {
+    ++m_changes;
     switch (beatType)
     {
         case k_beat_implied:
@@ -648,11 +1086,72 @@ void Document::notify_if_document_modified()
     if (!is_dirty())
         return;
 
+    m_changeSet.resolve_measures(this);
+    SpDocChangeSet spChanges( LOMSE_NEW DocChangeSet(m_changeSet) );
     clear_dirty();
-    SpEventDoc pEvent( LOMSE_NEW EventDoc(k_doc_modified_event, this) );
+
+    SpEventDoc pEvent( LOMSE_NEW EventDoc(k_doc_modified_event, this, spChanges) );
     notify_observers(pEvent, this);
 }
 
+//---------------------------------------------------------------------------------------
+void Document::set_dirty(ImoObj* pModified)
+{
+    m_flags |= k_dirty;
+    ++m_changes;
+    m_changeSet.add_change(pModified);
+}
+
+//---------------------------------------------------------------------------------------
+void Document::clear_dirty()
+{
+    if (is_dirty())
+        update_midi_tables();
+
+    m_flags &= ~k_dirty;
+    m_changeSet.clear();
+}
+
+//---------------------------------------------------------------------------------------
+void Document::update_midi_tables()
+{
+    //inform the modified scores about the modified measures, so that only the events
+    //for these measures are regenerated in their sound events tables
+
+    if (!m_pImoDoc)
+        return;
+
+    if (m_changeSet.is_all_changed())
+    {
+        ImoContent* pContent = m_pImoDoc->get_content();
+        if (!pContent)
+            return;
+        ImoObj::children_iterator it;
+        for (it = pContent->begin(); it != pContent->end(); ++it)
+        {
+            if ((*it)->is_score())
+                static_cast<ImoScore*>(*it)->update_midi_table(1, INT_MAX);
+        }
+        return;
+    }
+
+    m_changeSet.resolve_measures(this);
+    list<ImoId> scores = m_changeSet.get_changed_scores();
+    list<ImoId>::iterator it;
+    for (it = scores.begin(); it != scores.end(); ++it)
+    {
+        ImoScore* pScore = dynamic_cast<ImoScore*>( get_pointer_to_imo(*it) );
+        int first, last;
+        if (pScore && m_changeSet.get_changed_measures(*it, &first, &last))
+        {
+            //AWARE: measures in DocChangeSet are numbered 0..n-1
+            if (last != DocChangeSet::k_end_of_score)
+                ++last;
+            pScore->update_midi_table(first + 1, last);
+        }
+    }
+}
+
 //---------------------------------------------------------------------------------------
 Observable* Document::get_observable_child(int childType, ImoId childId)
 {
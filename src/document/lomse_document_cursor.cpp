@@ -2404,11 +2404,15 @@ void ScoreCursor::to_time(int iInstr, int iStaff, TimeUnits rTargetTime)
     m_currentState.instrument(iInstr);
     m_currentState.staff(iStaff);
 
-    //optimization: avoid search from start if current time lower than target time
-    if (!p_there_is_iter_object() || is_greater_time(p_iter_object_time(), rTargetTime))
-        m_it = m_pColStaffObjs->begin();
+    //search from current position if current time is not greater than target time.
+    //Otherwise, from start
+    ColStaffObjsEntry* pStart = nullptr;
+    if (p_there_is_iter_object() && !is_greater_time(p_iter_object_time(), rTargetTime))
+        pStart = *m_it;
 
-    p_forward_to_instr_with_time_not_lower_than(rTargetTime);
+    ColStaffObjsIndex* pIndex = m_pColStaffObjs->get_index();
+    m_it = ColStaffObjsIterator(
+                pIndex->find_entry_not_before(iInstr, -1, rTargetTime, pStart) );
 
     //here time is greater or equal. Instr is ok or not found
     if (p_there_is_iter_object())
@@ -2418,7 +2422,8 @@ void ScoreCursor::to_time(int iInstr, int iStaff, TimeUnits rTargetTime)
         TimeUnits timeFound = p_iter_object_time();
 
         //find staff
-        p_forward_to_instr_staff_with_time_not_lower_than(rTargetTime);
+        m_it = ColStaffObjsIterator(
+                    pIndex->find_entry_not_before(iInstr, iStaff, rTargetTime, *m_it) );
 
         //here time is greater or equal. Instr and staff are ok or not found
         if (p_there_is_iter_object() && p_iter_object_is_on_time(timeFound))
@@ -2459,44 +2464,41 @@ void ScoreCursor::to_measure(int measure, int instr, int staff)
         return;
     }
 
-    m_startOfBarTimepos = 0.0;
-    m_curBeatDuration = k_duration_quarter;
-
-    m_it = m_pColStaffObjs->begin();
-    while (p_there_is_iter_object())
-    {
-        if (p_iter_object_instrument() == m_currentState.instrument())
-        {
-            if (p_iter_object()->is_barline())
-            {
-                m_startOfBarTimepos = p_iter_object_time();
-                if (p_iter_object_measure() == measure - 1)
-                {
-                    m_currentState.time( p_iter_object_time() );
-                    p_update_pointed_object();
-                    to_next_staffobj(true);
-                    return;
-                }
-            }
-            if (p_iter_object()->is_time_signature())
-            {
-                ImoTimeSignature* pTS =
-                        static_cast<ImoTimeSignature*>( p_iter_object() );
-                m_curBeatDuration = pTS->get_beat_duration();
-            }
-        }
-        p_move_iterator_to_next();
-    }
-
-    if (p_there_is_iter_object())
+    //direct jump to the barline that ends previous measure
+    ColStaffObjsIndex* pIndex = m_pColStaffObjs->get_index();
+    ColStaffObjsEntry* pBarline = pIndex->find_barline(m_currentState.instrument(),
+                                                       measure - 1);
+    if (pBarline)
     {
+        m_it = ColStaffObjsIterator(pBarline);
         m_currentState.time( p_iter_object_time() );
         p_update_pointed_object();
+        to_next_staffobj(true);
+        return;
     }
-    else
+
+    //measure not found. Move to end of staff. Bar start and beat duration are
+    //those in force at the last staffobj of the instrument
+    p_to_end_of_staff();
+
+    m_startOfBarTimepos = 0.0;
+    m_curBeatDuration = k_duration_quarter;
+    int iInstr = m_currentState.instrument();
+    ColStaffObjsEntry* pLast = pIndex->last_entry(iInstr);
+    if (pLast)
     {
-        //end of collection reached. Measure not found
-        p_to_end_of_staff();
+        ColStaffObjsEntry* pEntry = (pLast->imo_object()->is_barline() ? pLast
+                                    : pIndex->find_barline_before(iInstr, pLast));
+        if (pEntry)
+            m_startOfBarTimepos = pEntry->time();
+
+        pEntry = (pLast->imo_object()->is_time_signature() ? pLast
+                  : pIndex->find_time_signature_before(iInstr, pLast));
+        if (pEntry)
+        {
+            ImoTimeSignature* pTS = static_cast<ImoTimeSignature*>( pEntry->imo_object() );
+            m_curBeatDuration = pTS->get_beat_duration();
+        }
     }
 }
 
@@ -2671,10 +2673,7 @@ void ScoreCursor::p_move_iterator_to(ImoId id)
     if (id <= k_no_imoid)
         m_it = m_pColStaffObjs->end();
     else
-    {
-        m_it = m_pColStaffObjs->begin();
-        for (; m_it != m_pColStaffObjs->end() && (*m_it)->element_id() != id; ++m_it);
-    }
+        m_it = ColStaffObjsIterator( m_pColStaffObjs->get_index()->find_entry(id) );
 }
 //
 ////---------------------------------------------------------------------------------------
@@ -3349,11 +3348,7 @@ void ScoreCursor::p_to_end_of_staff()
     m_it = ColStaffObjsIterator( m_pColStaffObjs->back() );
     if (p_there_is_iter_object())
     {
-        while ( p_there_is_iter_object()
-                && !p_iter_object_is_on_instrument(instr) )
-        {
-            p_move_iterator_to_prev();
-        }
+        m_it = ColStaffObjsIterator( m_pColStaffObjs->get_index()->last_entry(instr) );
         if (p_there_is_iter_object())
         {
             int measure = p_iter_object_measure();
@@ -3546,35 +3541,28 @@ void ScoreCursor::p_determine_total_duration()
 //---------------------------------------------------------------------------------------
 void ScoreCursor::p_find_start_of_measure_and_time_signature()
 {
-    bool fBarlineFound = false;
-    bool fTimeFound = false;
+    //previous barline and time signature in current instrument, before iterator
+    //position. Nothing is found when iterator is at end of collection
+
     m_startOfBarTimepos = 0.0;
     m_curBeatDuration = k_duration_quarter;
 
-    ColStaffObjsIterator itSave = m_it;
-    p_move_iterator_to_prev();
-    while (p_there_is_iter_object())
+    if (!p_there_is_iter_object())
+        return;
+
+    int instr = m_currentState.instrument();
+    ColStaffObjsIndex* pIndex = m_pColStaffObjs->get_index();
+
+    ColStaffObjsEntry* pBarline = pIndex->find_barline_before(instr, *m_it);
+    if (pBarline)
+        m_startOfBarTimepos = pBarline->time();
+
+    ColStaffObjsEntry* pEntry = pIndex->find_time_signature_before(instr, *m_it);
+    if (pEntry)
     {
-        if (p_iter_object_instrument() == m_currentState.instrument())
-        {
-            if (!fBarlineFound && p_iter_object()->is_barline())
-            {
-                m_startOfBarTimepos = p_iter_object_time();
-                fBarlineFound = true;
-            }
-            if (!fTimeFound && p_iter_object()->is_time_signature())
-            {
-                ImoTimeSignature* pTS =
-                        static_cast<ImoTimeSignature*>( p_iter_object() );
-                m_curBeatDuration = pTS->get_beat_duration();
-                fTimeFound = true;
-            }
-        }
-        if (fBarlineFound && fTimeFound)
-            break;
-        p_move_iterator_to_prev();
+        ImoTimeSignature* pTS = static_cast<ImoTimeSignature*>( pEntry->imo_object() );
+        m_curBeatDuration = pTS->get_beat_duration();
     }
-    m_it = itSave;
 }
 
 
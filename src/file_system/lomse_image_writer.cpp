@@ -0,0 +1,217 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include "lomse_image_writer.h"
+
+#include "lomse_logger.h"
+
+#if (LOMSE_ENABLE_PNG == 1)
+	#include <png.h>
+	#include <pngconf.h>
+#endif
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+using namespace std;
+
+
+namespace lomse
+{
+
+#if (LOMSE_ENABLE_PNG == 1)
+//declaration of some internal functions, to avoid compiler warnings
+void png_write_callback(png_structp png, png_bytep data, png_size_t length);
+void png_flush_callback(png_structp png);
+void png_encoder_error_callback(png_structp, png_const_charp);
+void png_encoder_warning_callback(png_structp, png_const_charp);
+#endif
+
+//=======================================================================================
+// ImageWriter implementation
+//=======================================================================================
+bool ImageWriter::save_as_png(RenderingBuffer& rbuf, EPixelFormat format,
+                              const string& filename)
+{
+#if (LOMSE_ENABLE_PNG == 1)
+    ofstream file(filename.c_str(), ios::out | ios::binary);
+    if (!file.good())
+    {
+        LOMSE_LOG_ERROR("Error opening file '%s' for writing.", filename.c_str());
+        return false;
+    }
+
+    PngImageEncoder encoder;
+    if (!encoder.can_encode(format))
+    {
+        LOMSE_LOG_ERROR("Pixel format %d not supported by PNG encoder.", int(format));
+        return false;
+    }
+    return encoder.encode(rbuf, format, file);
+#else
+    LOMSE_LOG_ERROR("Lomse was built without PNG support. Image '%s' not saved.",
+                    filename.c_str());
+    return false;
+#endif
+}
+
+
+#if (LOMSE_ENABLE_PNG == 1)
+
+//=======================================================================================
+// PngImageEncoder implementation
+//
+// See: http://www.libpng.org/pub/png/libpng-manual.txt, section IV
+//=======================================================================================
+
+
+//=======================================================================================
+//some helper internal functions, not declared as protected members to avoid
+//having to contaminate the lomse header files with PNG types
+//=======================================================================================
+void png_write_callback(png_structp png, png_bytep data, png_size_t length)
+{
+    ostream* pOut = static_cast<ostream*>( png_get_io_ptr(png) );
+    pOut->write(reinterpret_cast<const char*>(data), streamsize(length));
+}
+
+//---------------------------------------------------------------------------------------
+void png_flush_callback(png_structp png)
+{
+    static_cast<ostream*>( png_get_io_ptr(png) )->flush();
+}
+
+//---------------------------------------------------------------------------------------
+void png_encoder_error_callback(png_structp, png_const_charp msg)
+{
+    LOMSE_LOG_ERROR("error writing png image: %s", msg);
+    throw runtime_error("error writing png image");
+}
+
+//---------------------------------------------------------------------------------------
+void png_encoder_warning_callback(png_structp, png_const_charp msg)
+{
+    LOMSE_LOG_WARN("warning writing png image: %s", msg);
+}
+
+//=======================================================================================
+// PngImageEncoder members implementation
+//=======================================================================================
+bool PngImageEncoder::can_encode(EPixelFormat format)
+{
+    switch (format)
+    {
+        case k_pix_format_rgb24:
+        case k_pix_format_bgr24:
+        case k_pix_format_rgba32:
+        case k_pix_format_bgra32:
+        case k_pix_format_argb32:
+        case k_pix_format_abgr32:
+            return true;
+        default:
+            return false;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+bool PngImageEncoder::encode(RenderingBuffer& rbuf, EPixelFormat format, ostream& out)
+{
+    if (!can_encode(format) || rbuf.width() == 0 || rbuf.height() == 0)
+        return false;
+
+    //create write and info structs
+    png_structp pWriteStruct = png_create_write_struct(PNG_LIBPNG_VER_STRING,
+                                                       nullptr, nullptr, nullptr);
+    if (!pWriteStruct)
+    {
+        LOMSE_LOG_ERROR("out of memory creating write struct");
+        return false;
+    }
+
+    png_infop pInfoStruct = png_create_info_struct(pWriteStruct);
+    if (!pInfoStruct)
+    {
+        LOMSE_LOG_ERROR("out of memory creating info struct");
+        png_destroy_write_struct(&pWriteStruct, nullptr);
+        return false;
+    }
+
+    png_set_error_fn(pWriteStruct, nullptr, png_encoder_error_callback,
+                     png_encoder_warning_callback);
+
+    //we will take care of writing the data in our callback method
+    png_set_write_fn(pWriteStruct, &out, png_write_callback, png_flush_callback);
+
+    bool fHasAlpha = (format != k_pix_format_rgb24 && format != k_pix_format_bgr24);
+    png_uint_32 width = rbuf.width();
+    png_uint_32 height = rbuf.height();
+
+    //row pointers. Rows in the rendering buffer could be stored bottom-up
+    vector<png_bytep> rows(height);
+    for (unsigned y=0; y < height; ++y)
+        rows[y] = static_cast<png_bytep>( rbuf.row_ptr(int(y)) );
+
+    try
+    {
+        png_set_IHDR(pWriteStruct, pInfoStruct, width, height, 8,
+                     (fHasAlpha ? PNG_COLOR_TYPE_RGB_ALPHA : PNG_COLOR_TYPE_RGB),
+                     PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+                     PNG_FILTER_TYPE_DEFAULT);
+
+        if (m_compressionLevel >= 0)
+            png_set_compression_level(pWriteStruct, m_compressionLevel);
+
+        png_write_info(pWriteStruct, pInfoStruct);
+
+        //set transformations for converting pixels to PNG order (R-G-B-A)
+        if (format == k_pix_format_bgr24 || format == k_pix_format_bgra32
+            || format == k_pix_format_abgr32)
+        {
+            png_set_bgr(pWriteStruct);
+        }
+        if (format == k_pix_format_argb32 || format == k_pix_format_abgr32)
+            png_set_swap_alpha(pWriteStruct);
+
+        png_write_image(pWriteStruct, &rows[0]);
+        png_write_end(pWriteStruct, nullptr);
+    }
+    catch (...)
+    {
+        png_destroy_write_struct(&pWriteStruct, &pInfoStruct);
+        return false;
+    }
+
+    png_destroy_write_struct(&pWriteStruct, &pInfoStruct);
+    return out.good();
+}
+
+#endif // LOMSE_ENABLE_PNG
+
+}   //namespace lomse
@@ -56,6 +56,7 @@ Caret::Caret(GraphicView* view, LibraryScope& libraryScope)
 //---------------------------------------------------------------------------------------
 void Caret::on_draw(ScreenDrawer* pDrawer)
 {
+    m_viewBounds = URect(0.0, 0.0, 0.0, 0.0);
     if (!is_visible())
         return;
 
@@ -106,6 +107,7 @@ void Caret::draw_caret_as_top_level(ScreenDrawer* pDrawer)
 
     m_bounds = URect(UPoint(m_pos.x - 100, m_pos.y),
                      UPoint(m_pos.x - 50, m_pos.y + 500) );
+    add_view_bounds(m_bounds, UPoint(0.0f, 0.0f));
 }
 
 //---------------------------------------------------------------------------------------
@@ -134,9 +136,10 @@ void Caret::draw_caret_as_line(ScreenDrawer* pDrawer)
 
     pDrawer->end_path();
 
+    UPoint org(0.0f, 0.0f);
     if (m_pBoxSystem)
     {
-        UPoint org = m_pView->get_page_origin_for(m_pBoxSystem);
+        org = m_pView->get_page_origin_for(m_pBoxSystem);
         pDrawer->set_shift(-org.x, -org.y);
     }
     pDrawer->render();
@@ -144,6 +147,7 @@ void Caret::draw_caret_as_line(ScreenDrawer* pDrawer)
 
     m_bounds = URect(UPoint(Tenths(x1) - 100.0f, Tenths(y1)),
                      UPoint(Tenths(x2) + 100.0f, Tenths(y2)));
+    add_view_bounds(m_bounds, org);
 }
 
 //---------------------------------------------------------------------------------------
@@ -168,6 +172,7 @@ void Caret::draw_caret_as_box(ScreenDrawer* pDrawer)
     pDrawer->render();
 
     m_bounds = URect(m_pos, m_size);
+    add_view_bounds(m_bounds, UPoint(0.0f, 0.0f));
 }
 
 //---------------------------------------------------------------------------------------
@@ -186,6 +191,7 @@ void Caret::draw_top_level_box(ScreenDrawer* pDrawer)
     pDrawer->render();
 
     m_bounds = m_box;
+    add_view_bounds(m_bounds, UPoint(0.0f, 0.0f));
 }
 
 
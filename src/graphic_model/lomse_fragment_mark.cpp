@@ -289,6 +289,7 @@ FragmentMark* FragmentMark::thickness(Tenths value)
 //---------------------------------------------------------------------------------------
 void FragmentMark::on_draw(ScreenDrawer* pDrawer)
 {
+    m_viewBounds = URect(0.0, 0.0, 0.0, 0.0);
     if (!m_pBoxSystem)
         return;
 
@@ -408,6 +409,7 @@ void FragmentMark::on_draw(ScreenDrawer* pDrawer)
 
     pDrawer->render();
     pDrawer->remove_shift();
+    add_view_bounds(m_bounds, org);
 
 }
 
@@ -855,18 +855,12 @@ void GmoBoxDocPage::draw_page_background(Drawer* pDrawer, RenderOptions& UNUSED(
 //---------------------------------------------------------------------------------------
 void GmoBoxDocPage::add_to_tables(GmoShape* pShape)
 {
-    int layer = pShape->get_layer();
-    std::list<GmoShape*>::iterator it;
-    for (it = m_allShapes.begin(); it != m_allShapes.end(); ++it)
-    {
-        if ((*it)->get_layer() > layer)
-            break;
-    }
-
-    if (it == m_allShapes.end())
-        m_allShapes.push_back(pShape);
-    else
-        m_allShapes.insert(it, pShape);
+    //shapes are kept in a bucket per layer. As a shape is always appended at the
+    //end of its layer, insertion is O(1)
+    int layer = max(0, pShape->get_layer());
+    if (layer >= int(m_layers.size()))
+        m_layers.resize(layer + 1);
+    m_layers[layer].push_back(pShape);
 
     store_in_map_imo_shape(pShape);
 }
@@ -886,23 +880,35 @@ void GmoBoxDocPage::store_in_map_imo_shape(GmoShape* pShape)
 //---------------------------------------------------------------------------------------
 GmoShape* GmoBoxDocPage::get_first_shape_for_layer(int layer)
 {
-    std::list<GmoShape*>::reverse_iterator it;
-    for (it = m_allShapes.rbegin(); it != m_allShapes.rend(); ++it)
-    {
-        if ((*it)->get_layer() == layer)
-            return *it;
-    }
-    return nullptr;
+    //returns the last added shape in the layer, that is, the one on top
+
+    if (layer < 0 || layer >= int(m_layers.size()) || m_layers[layer].empty())
+        return nullptr;
+    return m_layers[layer].back();
+}
+
+//---------------------------------------------------------------------------------------
+int GmoBoxDocPage::get_num_shapes()
+{
+    size_t num = 0;
+    std::vector< std::vector<GmoShape*> >::const_iterator itL;
+    for (itL = m_layers.begin(); itL != m_layers.end(); ++itL)
+        num += itL->size();
+    return int(num);
 }
 
 //---------------------------------------------------------------------------------------
 GmoShape* GmoBoxDocPage::find_shape_at(LUnits x, LUnits y)
 {
-    std::list<GmoShape*>::reverse_iterator it;
-    for (it = m_allShapes.rbegin(); it != m_allShapes.rend(); ++it)
+    std::vector< std::vector<GmoShape*> >::reverse_iterator itL;
+    for (itL = m_layers.rbegin(); itL != m_layers.rend(); ++itL)
     {
-        if ((*it)->hit_test(x, y))
-            return *it;
+        std::vector<GmoShape*>::reverse_iterator it;
+        for (it = itL->rbegin(); it != itL->rend(); ++it)
+        {
+            if ((*it)->hit_test(x, y))
+                return *it;
+        }
     }
     return nullptr;
 }
@@ -910,11 +916,15 @@ GmoShape* GmoBoxDocPage::find_shape_at(LUnits x, LUnits y)
 //---------------------------------------------------------------------------------------
 GmoShape* GmoBoxDocPage::find_shape_for_object(ImoStaffObj* pSO)
 {
-    std::list<GmoShape*>::iterator it;
-    for (it = m_allShapes.begin(); it != m_allShapes.end(); ++it)
+    std::vector< std::vector<GmoShape*> >::iterator itL;
+    for (itL = m_layers.begin(); itL != m_layers.end(); ++itL)
     {
-        if ((*it)->was_created_by(pSO))
-            return *it;
+        std::vector<GmoShape*>::iterator it;
+        for (it = itL->begin(); it != itL->end(); ++it)
+        {
+            if ((*it)->was_created_by(pSO))
+                return *it;
+        }
     }
     return nullptr;
 }
@@ -939,14 +949,18 @@ void GmoBoxDocPage::select_objects_in_rectangle(SelectionSet* selection,
                                                 unsigned UNUSED(flags))
 {
     bool fSomethingSelected = false;
-    std::list<GmoShape*>::reverse_iterator it;
-    for (it = m_allShapes.rbegin(); it != m_allShapes.rend(); ++it)
+    std::vector< std::vector<GmoShape*> >::reverse_iterator itL;
+    for (itL = m_layers.rbegin(); itL != m_layers.rend(); ++itL)
     {
-        URect bbox = (*it)->get_bounds();
-        if (selRect.contains(bbox))
+        std::vector<GmoShape*>::reverse_iterator it;
+        for (it = itL->rbegin(); it != itL->rend(); ++it)
         {
-            selection->add(*it);
-            fSomethingSelected = true;
+            URect bbox = (*it)->get_bounds();
+            if (selRect.contains(bbox))
+            {
+                selection->add(*it);
+                fSomethingSelected = true;
+            }
         }
     }
 
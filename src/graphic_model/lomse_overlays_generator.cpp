@@ -33,11 +33,20 @@
 //#include "lomse_graphic_view.h"
 #include "lomse_logger.h"
 #include "lomse_visual_effect.h"
+#include "lomse_pixel_formats.h"
+
+#include <cstring>      //memcpy
+#include <vector>
+#include <cmath>        //floor, ceil
 
 
 namespace lomse
 {
 
+//maximum number of areas to restore individually. When exceeded, or when the
+//areas cover more than half of the rendering buffer, the whole buffer is restored
+const size_t k_max_restore_areas = 32;
+
 //=======================================================================================
 // OverlaysGenerator implementation
 //=======================================================================================
@@ -57,7 +66,7 @@ OverlaysGenerator::OverlaysGenerator(GraphicView* view, LibraryScope& librarySco
 //---------------------------------------------------------------------------------------
 OverlaysGenerator::~OverlaysGenerator()
 {
-    delete m_pSaveBytes;
+    free(m_pSaveBytes);
 
     //delete all VisualEffects
     list<VisualEffect*>::iterator it = m_effects.begin();
@@ -79,47 +88,80 @@ void OverlaysGenerator::add_visual_effect(VisualEffect* pEffect)
 void OverlaysGenerator::remove_visual_effect(VisualEffect* pEffect)
 {
     m_effects.remove(pEffect);
+
+    //keep the area it covered, as it must be restored on next update
+    map<VisualEffect*, URect>::iterator it = m_drawnAreas.find(pEffect);
+    if (it != m_drawnAreas.end())
+    {
+        URect area = it->second;
+        m_drawnAreas.erase(it);
+        m_drawnAreas[nullptr].Union(area);
+    }
 }
 
 //---------------------------------------------------------------------------------------
 void OverlaysGenerator::update_all_visual_effects(ScreenDrawer* pDrawer)
 {
+    redraw_visual_effects(pDrawer, nullptr);
+}
+
+//---------------------------------------------------------------------------------------
+void OverlaysGenerator::update_visual_effect(VisualEffect* pEffect,
+                                             ScreenDrawer* pDrawer)
+{
+    redraw_visual_effects(pDrawer, pEffect);
+}
+
+//---------------------------------------------------------------------------------------
+void OverlaysGenerator::redraw_visual_effects(ScreenDrawer* pDrawer,
+                                              VisualEffect* pUpdated)
+{
+    //All visible effects are drawn again, but the rendering buffer is only cleaned
+    //in the areas covered by effects the last time they were drawn. The damaged
+    //rectangle includes the old and new areas of pUpdated (all effects when nullptr)
+    //and of any other effect whose area has changed.
+
     if (m_fBackgroundDirty)
-        m_pCanvasBuffer->copy_from(m_savedBuffer);
+        restore_rendering_buffer(pDrawer);
+
+    map<VisualEffect*, URect> prevAreas;
+    prevAreas.swap(m_drawnAreas);
 
-    m_damagedRect = URect(0.0, 0.0, 0.0, 0.0);
-    int overlays = 0;
     list<VisualEffect*>::const_iterator it;
     for (it = m_effects.begin(); it != m_effects.end(); ++it)
     {
         if ((*it)->is_visible())
         {
             (*it)->on_draw(pDrawer);
-            ++overlays;
-            m_damagedRect.Union( (*it)->get_bounds() );
+            URect area = expand_damaged_rectangle( (*it)->get_view_bounds() );
+            if (!area.is_empty())
+                m_drawnAreas[*it] = area;
         }
     }
 
-    if (overlays == 0)
-        m_damagedRect = m_prevDamagedRect;
-    else
-        expand_damaged_rectangle();
-
-    m_fBackgroundDirty = (overlays > 0);
-}
-
-//---------------------------------------------------------------------------------------
-void OverlaysGenerator::update_visual_effect(VisualEffect* pEffect,
-                                             ScreenDrawer* pDrawer)
-{
-    update_all_visual_effects(pDrawer);
-    if (pEffect->is_visible())
+    //compare new areas with previous ones
+    map<VisualEffect*, URect>::const_iterator itA;
+    for (itA = m_drawnAreas.begin(); itA != m_drawnAreas.end(); ++itA)
     {
-        m_damagedRect = pEffect->get_bounds();
-        expand_damaged_rectangle();
+        map<VisualEffect*, URect>::iterator itPrev = prevAreas.find(itA->first);
+        if (itPrev == prevAreas.end())
+            m_damagedRect.Union(itA->second);
+        else
+        {
+            if (pUpdated == nullptr || itA->first == pUpdated
+                || itA->second != itPrev->second)
+            {
+                m_damagedRect.Union(itA->second);
+                m_damagedRect.Union(itPrev->second);
+            }
+            prevAreas.erase(itPrev);
+        }
     }
-    else
-        m_damagedRect = m_prevDamagedRect;
+    //effects no longer displayed
+    for (itA = prevAreas.begin(); itA != prevAreas.end(); ++itA)
+        m_damagedRect.Union(itA->second);
+
+    m_fBackgroundDirty = !m_drawnAreas.empty();
 }
 
 //---------------------------------------------------------------------------------------
@@ -128,6 +170,7 @@ void OverlaysGenerator::set_rendering_buffer(RenderingBuffer* rbuf)
     m_pCanvasBuffer = rbuf;
     m_fBackgroundDirty = false;
     m_fFullRectangle = true;
+    m_drawnAreas.clear();
 }
 
 //---------------------------------------------------------------------------------------
@@ -135,6 +178,7 @@ void OverlaysGenerator::on_new_background()
 {
     save_rendering_buffer();
     m_fFullRectangle = true;
+    m_drawnAreas.clear();
 }
 
 //---------------------------------------------------------------------------------------
@@ -147,7 +191,7 @@ void OverlaysGenerator::save_rendering_buffer()
     size_t bytes = h * abs(stride);
     if (m_pSaveBytes == nullptr || bytes != m_savedBuffer.height() * m_savedBuffer.stride())
     {
-        delete m_pSaveBytes;
+        free(m_pSaveBytes);
         m_pSaveBytes = static_cast<int8u*>( malloc(bytes) );
         m_savedBuffer.attach(m_pSaveBytes, w, h, stride);
 
@@ -162,38 +206,148 @@ void OverlaysGenerator::save_rendering_buffer()
 }
 
 //---------------------------------------------------------------------------------------
-void OverlaysGenerator::expand_damaged_rectangle()
+void OverlaysGenerator::restore_rendering_buffer(ScreenDrawer* pDrawer)
+{
+    int bytesPerPixel = bytes_per_pixel();
+    if (bytesPerPixel > 0 && m_drawnAreas.size() <= k_max_restore_areas
+        && m_savedBuffer.width() == m_pCanvasBuffer->width()
+        && m_savedBuffer.height() == m_pCanvasBuffer->height())
+    {
+        vector<VRect> areas;
+        areas.reserve(m_drawnAreas.size());
+        double pixels = 0.0;
+        map<VisualEffect*, URect>::const_iterator it;
+        for (it = m_drawnAreas.begin(); it != m_drawnAreas.end(); ++it)
+        {
+            VRect area = area_to_pixels(it->second, pDrawer);
+            if (!area.is_empty())
+            {
+                areas.push_back(area);
+                pixels += double(area.width) * double(area.height);
+            }
+        }
+
+        double total = double(m_pCanvasBuffer->width())
+                       * double(m_pCanvasBuffer->height());
+        if (pixels * 2.0 <= total)
+        {
+            vector<VRect>::const_iterator itV;
+            for (itV = areas.begin(); itV != areas.end(); ++itV)
+                restore_area(*itV, bytesPerPixel);
+            return;
+        }
+    }
+
+    m_pCanvasBuffer->copy_from(m_savedBuffer);
+}
+
+//---------------------------------------------------------------------------------------
+void OverlaysGenerator::restore_area(const VRect& area, int bytesPerPixel)
+{
+    size_t offset = size_t(area.x) * size_t(bytesPerPixel);
+    size_t length = size_t(area.width) * size_t(bytesPerPixel);
+    for (int y = area.y; y < area.bottom(); ++y)
+    {
+        memcpy(m_pCanvasBuffer->row_ptr(y) + offset,
+               m_savedBuffer.row_ptr(y) + offset, length);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+VRect OverlaysGenerator::area_to_pixels(const URect& area, ScreenDrawer* pDrawer)
+{
+    double left = area.left();
+    double top = area.top();
+    double right = area.right();
+    double bottom = area.bottom();
+    pDrawer->model_point_to_screen(&left, &top);
+    pDrawer->model_point_to_screen(&right, &bottom);
+
+    //trim rectangle to rendering buffer limits
+    Pixels x1 = max(0, Pixels(floor(min(left, right))));
+    Pixels y1 = max(0, Pixels(floor(min(top, bottom))));
+    Pixels x2 = min(Pixels(ceil(max(left, right))) + 1, int(m_pCanvasBuffer->width()) );
+    Pixels y2 = min(Pixels(ceil(max(top, bottom))) + 1, int(m_pCanvasBuffer->height()) );
+
+    if (x2 <= x1 || y2 <= y1)
+        return VRect(0, 0, 0, 0);
+    return VRect(VPoint(x1, y1), VPoint(x2, y2));
+}
+
+//---------------------------------------------------------------------------------------
+int OverlaysGenerator::bytes_per_pixel()
+{
+    //returns 0 when unknown. In this case the full buffer will be restored
+
+    switch (m_libraryScope.get_pixel_format())
+    {
+        case k_pix_format_gray8:
+            return 1;
+        case k_pix_format_gray16:
+        case k_pix_format_rgb555:
+        case k_pix_format_rgb565:
+            return 2;
+        case k_pix_format_rgb24:
+        case k_pix_format_bgr24:
+            return 3;
+        case k_pix_format_rgbAAA:
+        case k_pix_format_rgbBBA:
+        case k_pix_format_bgrAAA:
+        case k_pix_format_bgrABB:
+        case k_pix_format_rgba32:
+        case k_pix_format_argb32:
+        case k_pix_format_abgr32:
+        case k_pix_format_bgra32:
+            return 4;
+        case k_pix_format_rgb48:
+        case k_pix_format_bgr48:
+            return 6;
+        case k_pix_format_rgba64:
+        case k_pix_format_argb64:
+        case k_pix_format_abgr64:
+        case k_pix_format_bgra64:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+URect OverlaysGenerator::expand_damaged_rectangle(const URect& rect)
 {
     //increase damaged rectangle (1mm increment at each side) to take into account
     //any additional pixels due to anti-aliasing.
 
-    m_damagedRect.x -= 100.0;   //1mm = 100 LUnits
-    m_damagedRect.y -= 100.0;
-    m_damagedRect.width += 200.0;
-    m_damagedRect.height += 200.0;
+    if (rect.is_empty())
+        return rect;
+
+    URect expanded(rect);
+    expanded.x -= 100.0;   //1mm = 100 LUnits
+    expanded.y -= 100.0;
+    expanded.width += 200.0;
+    expanded.height += 200.0;
+    return expanded;
 }
 
 //---------------------------------------------------------------------------------------
 URect OverlaysGenerator::get_damaged_rectangle()
 {
+    //Returns the union of all areas damaged since last invocation. An empty rectangle
+    //means that the whole rendering buffer must be updated
+
     if (m_fFullRectangle)
     {
         m_fFullRectangle = false;
-        m_prevDamagedRect = m_damagedRect;
+        m_damagedRect = URect(0.0, 0.0, 0.0, 0.0);
+        m_prevDamagedRect = URect(0.0, 0.0, 0.0, 0.0);
         return URect(0.0, 0.0, 0.0, 0.0);
     }
-    else if (m_prevDamagedRect != URect(0.0, 0.0, 0.0, 0.0))
-    {
-        URect total = m_damagedRect;
-        total.Union(m_prevDamagedRect);
-        m_prevDamagedRect = m_damagedRect;
-        return total;
-    }
-    else
-    {
+
+    if (!m_damagedRect.is_empty())
         m_prevDamagedRect = m_damagedRect;
-        return m_damagedRect;
-    }
+
+    m_damagedRect = URect(0.0, 0.0, 0.0, 0.0);
+    return m_prevDamagedRect;
 }
 
 
@@ -69,6 +69,7 @@ void TempoLine::move_to(LUnits xPos, GmoBoxSystem* pBoxSystem, int iPage)
 //---------------------------------------------------------------------------------------
 void TempoLine::on_draw(ScreenDrawer* pDrawer)
 {
+    m_viewBounds = URect(0.0, 0.0, 0.0, 0.0);
     if (!m_pBoxSystem)
         return;
 
@@ -102,6 +103,10 @@ void TempoLine::on_draw(ScreenDrawer* pDrawer)
     pDrawer->end_path();
     pDrawer->render();
     pDrawer->remove_shift();
+
+    URect drawn(UPoint(LUnits(xLeft) - m_width / 2.0f, LUnits(yTop)),
+                UPoint(LUnits(xLeft) + m_width / 2.0f, LUnits(yBottom)) );
+    add_view_bounds(drawn, org);
 }
 
 //---------------------------------------------------------------------------------------
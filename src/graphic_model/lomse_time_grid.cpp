@@ -53,6 +53,7 @@ TimeGrid::TimeGrid(GraphicView* view, LibraryScope& libraryScope)
 void TimeGrid::on_draw(ScreenDrawer* pDrawer)
 {
     m_bounds = URect(0.0, 0.0, 0.0, 0.0);
+    m_viewBounds = URect(0.0, 0.0, 0.0, 0.0);
     if (!m_pBoxSystem)
         return;
 
@@ -82,17 +83,17 @@ void TimeGrid::on_draw(ScreenDrawer* pDrawer)
     }
     pDrawer->end_path();
 
-    if (m_pBoxSystem)
-    {
-        UPoint org = m_pView->get_page_origin_for(m_pBoxSystem);
-        pDrawer->set_shift(-org.x, -org.y);
-    }
+    UPoint org = m_pView->get_page_origin_for(m_pBoxSystem);
+    pDrawer->set_shift(-org.x, -org.y);
     pDrawer->render();
     pDrawer->remove_shift();
 
     if (iMax > 0)
+    {
         m_bounds = URect(UPoint(pGridTable->get_x_pos(0)-8, Tenths(yTop)),
                          UPoint(pGridTable->get_x_pos(iMax-1)+8, Tenths(yBottom)) );
+        add_view_bounds(m_bounds, org);
+    }
 }
 
 
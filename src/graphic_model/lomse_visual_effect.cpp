@@ -47,9 +47,22 @@ VisualEffect::VisualEffect(GraphicView* view, LibraryScope& libraryScope)
     , m_pView(view)
     , m_fVisible(false)
     , m_fEnabled(true)
+    , m_viewBounds(0.0, 0.0, 0.0, 0.0)
 {
 }
 
+//---------------------------------------------------------------------------------------
+void VisualEffect::add_view_bounds(const URect& bounds, const UPoint& org)
+{
+    if (bounds.is_empty())
+        return;
+
+    URect rect(bounds);
+    rect.x += org.x;
+    rect.y += org.y;
+    m_viewBounds.Union(rect);
+}
+
 
 //=======================================================================================
 // DraggedImage implementation
@@ -226,6 +239,7 @@ void PlaybackHighlight::remove_all_highlight()
 void PlaybackHighlight::on_draw(ScreenDrawer* pDrawer)
 {
     m_bounds = URect(0.0, 0.0, 0.0, 0.0);
+    m_viewBounds = URect(0.0, 0.0, 0.0, 0.0);
     RenderOptions options;
     options.draw_shapes_highlighted = true;
     Color savedColor = options.highlighted_color;
@@ -240,6 +254,7 @@ void PlaybackHighlight::on_draw(ScreenDrawer* pDrawer)
             pDrawer->set_shift(-org.x, -org.y);
             pShape->on_draw(pDrawer, options);
             m_bounds.Union( pShape->get_bounds() );
+            add_view_bounds(pShape->get_bounds(), org);
 //            LOMSE_LOG_DEBUG(Logger::k_events, "draw note: xPos=%f, org=%f",
 //                            m_bounds.x, org.x);
         }
@@ -271,6 +286,7 @@ SelectionHighlight::SelectionHighlight(GraphicView* view, LibraryScope& libraryS
 void SelectionHighlight::on_draw(ScreenDrawer* pDrawer)
 {
     m_bounds = URect(0.0, 0.0, 0.0, 0.0);
+    m_viewBounds = URect(0.0, 0.0, 0.0, 0.0);
     RenderOptions options;
     options.draw_shapes_selected = true;
 //    options.selected_color = Color(255, 255, 0);       //just a test
@@ -285,6 +301,7 @@ void SelectionHighlight::on_draw(ScreenDrawer* pDrawer)
             pDrawer->set_shift(-org.x, -org.y);
             pShape->on_draw(pDrawer, options);
             m_bounds.Union( pShape->get_bounds() );
+            add_view_bounds(pShape->get_bounds(), org);
         }
     }
     pDrawer->render();
@@ -60,6 +60,7 @@ ImoObj* ImFactory::inject(int type, Document* pDoc, ImoId id)
         case k_imo_attachments:         pObj = LOMSE_NEW ImoAttachments();        break;
         case k_imo_barline:             pObj = LOMSE_NEW ImoBarline();            break;
         case k_imo_beam:                pObj = LOMSE_NEW ImoBeam();               break;
+        case k_imo_beam_data:           pObj = LOMSE_NEW ImoBeamData();           break;
         case k_imo_beam_dto:            pObj = LOMSE_NEW ImoBeamDto();            break;
         case k_imo_bezier_info:         pObj = LOMSE_NEW ImoBezierInfo();         break;
         case k_imo_button:              pObj = LOMSE_NEW ImoButton();             break;
@@ -111,6 +112,7 @@ ImoObj* ImFactory::inject(int type, Document* pDoc, ImoId id)
         case k_imo_score_text:          pObj = LOMSE_NEW ImoScoreText();          break;
         case k_imo_score_title:         pObj = LOMSE_NEW ImoScoreTitle();         break;
         case k_imo_slur:                pObj = LOMSE_NEW ImoSlur();               break;
+        case k_imo_slur_data:           pObj = LOMSE_NEW ImoSlurData();           break;
         case k_imo_slur_dto:            pObj = LOMSE_NEW ImoSlurDto();            break;
         case k_imo_sound_change:        pObj = LOMSE_NEW ImoSoundChange();        break;
         case k_imo_sound_info:          pObj = LOMSE_NEW ImoSoundInfo();          break;
@@ -133,6 +135,7 @@ ImoObj* ImFactory::inject(int type, Document* pDoc, ImoId id)
         case k_imo_text_item:           pObj = LOMSE_NEW ImoTextItem();           break;
         case k_imo_text_repetition_mark:   pObj = LOMSE_NEW ImoTextRepetitionMark();   break;
         case k_imo_tie:                 pObj = LOMSE_NEW ImoTie();                break;
+        case k_imo_tie_data:            pObj = LOMSE_NEW ImoTieData();            break;
         case k_imo_tie_dto:             pObj = LOMSE_NEW ImoTieDto();             break;
         case k_imo_time_modification_dto:  pObj = LOMSE_NEW ImoTimeModificationDto();  break;
         case k_imo_time_signature:      pObj = LOMSE_NEW ImoTimeSignature();      break;
@@ -0,0 +1,1722 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2016. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include "lomse_im_snapshot.h"
+
+#include "lomse_internal_model.h"
+#include "lomse_im_note.h"
+#include "lomse_im_factory.h"
+#include "lomse_document.h"
+#include "lomse_id_assigner.h"
+#include "lomse_logger.h"
+
+#include <cmath>        //floor, signbit
+#include <cstring>      //memcpy
+#include <stdexcept>
+
+namespace lomse
+{
+
+//signature for snapshot data. LMD and LDP sources never start with this char
+static const char k_snapshot_magic[] = "\x01IMS";
+static const size_t k_snapshot_magic_size = 4;
+static const unsigned k_snapshot_version = 3;
+
+//=======================================================================================
+// ImSnapshot implementation
+//=======================================================================================
+ImSnapshot::ImSnapshot(Document* pDoc)
+    : m_pDoc(pDoc)
+    , m_fSaving(true)
+    , m_fSupported(true)
+    , m_lastIndex(-1)
+    , m_lastId(k_no_imoid)
+    , m_pCur(nullptr)
+    , m_pEnd(nullptr)
+    , m_pExternalIds(nullptr)
+{
+}
+
+//---------------------------------------------------------------------------------------
+bool ImSnapshot::is_snapshot(const string& data)
+{
+    return data.size() > k_snapshot_magic_size
+           && data.compare(0, k_snapshot_magic_size, k_snapshot_magic) == 0;
+}
+
+//---------------------------------------------------------------------------------------
+string ImSnapshot::save(ImoObj* pImo)
+{
+    vector<ImoObj*> objects(1, pImo);
+    return save(objects);
+}
+
+//---------------------------------------------------------------------------------------
+string ImSnapshot::save(const vector<ImoObj*>& objects)
+{
+    m_fSaving = true;
+    m_fSupported = true;
+    m_data.clear();
+    m_indexes.clear();
+    m_referenced.clear();
+    m_fSaved.clear();
+    m_lastIndex = -1;
+    m_lastId = k_no_imoid;
+
+    write_bytes(k_snapshot_magic, k_snapshot_magic_size);
+    write_uint(k_snapshot_version);
+    write_uint(objects.size());
+    vector<ImoObj*>::const_iterator it;
+    for (it = objects.begin(); it != objects.end(); ++it)
+        save_node(*it);
+
+    if (m_fSupported)
+        m_fSupported = save_external_refs();
+
+    string data;
+    if (m_fSupported)
+        data.swap(m_data);
+    m_data.clear();
+    return data;
+}
+
+//---------------------------------------------------------------------------------------
+ImoObj* ImSnapshot::restore(const string& data, IdAssigner* pExternalIds)
+{
+    vector<ImoObj*> objects = restore_objects(data, pExternalIds);
+    if (objects.size() != 1)
+    {
+        vector<ImoObj*>::iterator it;
+        for (it = objects.begin(); it != objects.end(); ++it)
+            delete *it;
+
+        LOMSE_LOG_ERROR("Snapshot does not contain a single object.");
+        throw runtime_error("[ImSnapshot::restore] Snapshot does not contain a single object.");
+    }
+    return objects.front();
+}
+
+//---------------------------------------------------------------------------------------
+vector<ImoObj*> ImSnapshot::restore_objects(const string& data,
+                                            IdAssigner* pExternalIds)
+{
+    if (!is_snapshot(data))
+    {
+        LOMSE_LOG_ERROR("Data is not an internal model snapshot.");
+        throw runtime_error("[ImSnapshot::restore_objects] Data is not an internal model snapshot.");
+    }
+
+    m_fSaving = false;
+    m_pExternalIds = pExternalIds;
+    m_restored.clear();
+    m_pending.clear();
+    m_lastIndex = -1;
+    m_lastId = k_no_imoid;
+    m_pCur = reinterpret_cast<const unsigned char*>(data.data()) + k_snapshot_magic_size;
+    m_pEnd = reinterpret_cast<const unsigned char*>(data.data()) + data.size();
+
+    if (read_uint() != k_snapshot_version)
+    {
+        LOMSE_LOG_ERROR("Unsupported snapshot version.");
+        throw runtime_error("[ImSnapshot::restore_objects] Unsupported snapshot version.");
+    }
+
+    vector<ImoObj*> objects;
+    unsigned long long numObjects = read_uint();
+    for (; numObjects > 0; --numObjects)
+        objects.push_back( restore_node() );
+    restore_external_refs();
+
+    //all objects created. Now references can be resolved
+    vector< std::function<void()> >::iterator it;
+    for (it = m_pending.begin(); it != m_pending.end(); ++it)
+        (*it)();
+
+    m_pending.clear();
+    m_restored.clear();
+    return objects;
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::save_node(ImoObj* pImo)
+{
+    if (!m_fSupported)
+        return;
+
+    int i = index_of(pImo);
+    m_fSaved[i] = true;
+
+    write_uint(pImo->m_objtype);
+    write_int(i - m_lastIndex - 1);
+    write_int(pImo->m_id - m_lastId - 1);
+    m_lastIndex = i;
+    m_lastId = pImo->m_id;
+    write_uint(pImo->m_flags);
+    transfer_attributes(pImo);
+    transfer_fields(pImo);
+
+    write_uint(pImo->get_num_children());
+    ImoObj* pChild = pImo->get_first_child();
+    for (; pChild; pChild = pChild->get_next_sibling())
+        save_node(pChild);
+}
+
+//---------------------------------------------------------------------------------------
+ImoObj* ImSnapshot::restore_node()
+{
+    int type = int(read_uint());
+    int i = m_lastIndex + 1 + int(read_int());
+    ImoId id = m_lastId + 1 + ImoId(read_int());
+    if (i < 0)
+        check_available(size_t(-1));    //corrupted data
+    m_lastIndex = i;
+    m_lastId = id;
+    unsigned int flags = (unsigned int)(read_uint());
+
+    ImoObj* pImo = create_object(type, id);
+    pImo->m_flags = flags | ImoObj::k_dirty;
+    if (size_t(i) >= m_restored.size())
+        m_restored.resize(i + 1, nullptr);
+    m_restored[i] = pImo;
+
+    transfer_attributes(pImo);
+    transfer_fields(pImo);
+
+    unsigned long long numChildren = read_uint();
+    for (; numChildren > 0; --numChildren)
+        pImo->append_child( restore_node() );
+
+    return pImo;
+}
+
+//---------------------------------------------------------------------------------------
+ImoObj* ImSnapshot::create_object(int type, ImoId id)
+{
+    ImoObj* pImo = ImFactory::inject(type, m_pDoc, id);
+
+    //remove default content created by constructors. It will be restored from the
+    //snapshot
+    ImoObj* pChild = pImo->get_first_child();
+    while (pChild)
+    {
+        pImo->remove_child(pChild);
+        delete pChild;
+        pChild = pImo->get_first_child();
+    }
+
+    switch (type)
+    {
+        case k_imo_instrument:
+        {
+            ImoInstrument* pInstr = static_cast<ImoInstrument*>(pImo);
+            std::list<ImoStaffInfo*>::iterator it;
+            for (it = pInstr->m_staves.begin(); it != pInstr->m_staves.end(); ++it)
+                delete *it;
+            pInstr->m_staves.clear();
+            break;
+        }
+        case k_imo_score:
+            static_cast<ImoScore*>(pImo)->delete_text_styles();
+            break;
+        case k_imo_styles:
+            static_cast<ImoStyles*>(pImo)->delete_text_styles();
+            break;
+        default:
+            break;
+    }
+
+    //objects without id were assigned a new one by ImFactory
+    if (id == k_no_imoid)
+        m_pDoc->on_removed_from_model(pImo);
+
+    return pImo;
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer_attributes(ImoObj* pImo)
+{
+    if (m_fSaving)
+    {
+        unsigned numAttribs = 0;
+        ImoAttr* pAttr = pImo->m_pAttribs;
+        for (; pAttr; pAttr = pAttr->m_next)
+            ++numAttribs;
+        write_uint(numAttribs);
+
+        for (pAttr = pImo->m_pAttribs; pAttr; pAttr = pAttr->m_next)
+        {
+            AttribValue& value = pAttr->m_value;
+            write_uint(pAttr->m_attrbIdx);
+            write_uint(value.m_type);
+            switch (value.m_type)
+            {
+                case AttribValue::vt_int:       transfer(value.intValue);       break;
+                case AttribValue::vt_string:    transfer(value.stringValue);    break;
+                case AttribValue::vt_bool:      transfer(value.boolValue);      break;
+                case AttribValue::vt_float:     transfer(value.floatValue);     break;
+                case AttribValue::vt_double:    transfer(value.doubleValue);    break;
+                case AttribValue::vt_color:     transfer(value.colorValue);     break;
+                default:
+                    break;
+            }
+        }
+    }
+    else
+    {
+        unsigned long long numAttribs = read_uint();
+        ImoAttr* pLast = nullptr;
+        for (; numAttribs > 0; --numAttribs)
+        {
+            int idx = int(read_uint());
+            int type = int(read_uint());
+            ImoAttr* pAttr = LOMSE_NEW ImoAttr(idx);
+            switch (type)
+            {
+                case AttribValue::vt_int:
+                {
+                    int value;
+                    transfer(value);
+                    pAttr->m_value = value;
+                    break;
+                }
+                case AttribValue::vt_string:
+                {
+                    string value;
+                    transfer(value);
+                    pAttr->m_value = value;
+                    break;
+                }
+                case AttribValue::vt_bool:
+                {
+                    bool value;
+                    transfer(value);
+                    pAttr->m_value = value;
+                    break;
+                }
+                case AttribValue::vt_float:
+                {
+                    float value;
+                    transfer(value);
+                    pAttr->m_value = value;
+                    break;
+                }
+                case AttribValue::vt_double:
+                {
+                    double value;
+                    transfer(value);
+                    pAttr->m_value = value;
+                    break;
+                }
+                case AttribValue::vt_color:
+                {
+                    Color value;
+                    transfer(value);
+                    pAttr->m_value = value;
+                    break;
+                }
+                default:
+                    break;
+            }
+
+            if (pLast)
+                pLast->m_next = pAttr;
+            else
+                pImo->m_pAttribs = pAttr;
+            pLast = pAttr;
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer_fields(ImoObj* pImo)
+{
+    switch (pImo->m_objtype)
+    {
+        //collections and objects without specific data
+        case k_imo_attachments:
+        case k_imo_instruments:
+        case k_imo_instrument_groups:
+        case k_imo_music_data:
+        case k_imo_options:
+        case k_imo_sounds:
+        case k_imo_table_head:
+        case k_imo_table_body:
+            break;
+
+        case k_imo_relations:
+            transfer_relations(static_cast<ImoRelations*>(pImo));
+            break;
+
+        //simple objects --------------------------------------------------------------
+        case k_imo_bezier_info:
+        {
+            ImoBezierInfo* pInfo = static_cast<ImoBezierInfo*>(pImo);
+            for (int i=0; i < 4; ++i)
+                transfer(pInfo->m_tPoints[i]);
+            break;
+        }
+        case k_imo_instr_group:
+        {
+            ImoInstrGroup* pGroup = static_cast<ImoInstrGroup*>(pImo);
+            transfer_ref(pGroup->m_pScore);
+            transfer(pGroup->m_joinBarlines);
+            transfer(pGroup->m_symbol);
+            transfer_embedded(&pGroup->m_name);
+            transfer_score_text(&pGroup->m_name);
+            transfer_embedded(&pGroup->m_abbrev);
+            transfer_score_text(&pGroup->m_abbrev);
+            if (m_fSaving)
+            {
+                write_uint(pGroup->m_instruments.size());
+                std::list<ImoInstrument*>::iterator it;
+                for (it = pGroup->m_instruments.begin(); it != pGroup->m_instruments.end(); ++it)
+                    write_ref(*it);
+            }
+            else
+            {
+                unsigned long long numInstrs = read_uint();
+                for (; numInstrs > 0; --numInstrs)
+                {
+                    int i = read_ref();
+                    m_pending.push_back([this, pGroup, i]() {
+                        pGroup->m_instruments.push_back(
+                            static_cast<ImoInstrument*>( object_at(i - 1) ));
+                    });
+                }
+            }
+            break;
+        }
+        case k_imo_line_style:
+            transfer_line_style(static_cast<ImoLineStyle*>(pImo));
+            break;
+        case k_imo_lyrics_text_info:
+        {
+            ImoLyricsTextInfo* pInfo = static_cast<ImoLyricsTextInfo*>(pImo);
+            transfer(pInfo->m_syllableType);
+            transfer_embedded(&pInfo->m_text);
+            transfer_text_info(&pInfo->m_text);
+            transfer(pInfo->m_elision);
+            break;
+        }
+        case k_imo_midi_info:
+        {
+            ImoMidiInfo* pInfo = static_cast<ImoMidiInfo*>(pImo);
+            transfer(pInfo->m_soundId);
+            transfer(pInfo->m_port);
+            transfer(pInfo->m_midiDeviceName);
+            transfer(pInfo->m_midiName);
+            transfer(pInfo->m_bank);
+            transfer(pInfo->m_channel);
+            transfer(pInfo->m_program);
+            transfer(pInfo->m_unpitched);
+            transfer(pInfo->m_volume);
+            transfer(pInfo->m_pan);
+            transfer(pInfo->m_elevation);
+            break;
+        }
+        case k_imo_page_info:
+            transfer_page_info(static_cast<ImoPageInfo*>(pImo));
+            break;
+        case k_imo_sound_info:
+        {
+            ImoSoundInfo* pInfo = static_cast<ImoSoundInfo*>(pImo);
+            transfer(pInfo->m_soundId);
+            transfer(pInfo->m_instrName);
+            transfer(pInfo->m_instrAbbrev);
+            transfer(pInfo->m_instrSound);
+            transfer(pInfo->m_fSolo);
+            transfer(pInfo->m_fEnsemble);
+            transfer(pInfo->m_ensembleSize);
+            transfer(pInfo->m_virtualLibrary);
+            transfer(pInfo->m_virtualName);
+            transfer(pInfo->m_playTechnique);
+            break;
+        }
+        case k_imo_staff_info:
+        {
+            ImoStaffInfo* pInfo = static_cast<ImoStaffInfo*>(pImo);
+            transfer(pInfo->m_numStaff);
+            transfer(pInfo->m_nNumLines);
+            transfer(pInfo->m_staffType);
+            transfer(pInfo->m_uSpacing);
+            transfer(pInfo->m_uLineThickness);
+            transfer(pInfo->m_uMarging);
+            break;
+        }
+        case k_imo_system_info:
+            transfer_system_info(static_cast<ImoSystemInfo*>(pImo));
+            break;
+        case k_imo_text_info:
+            transfer_text_info(static_cast<ImoTextInfo*>(pImo));
+            break;
+        case k_imo_textblock_info:
+            transfer_textblock_info(static_cast<ImoTextBlockInfo*>(pImo));
+            break;
+        case k_imo_option:
+        {
+            ImoOptionInfo* pOpt = static_cast<ImoOptionInfo*>(pImo);
+            transfer(pOpt->m_type);
+            transfer(pOpt->m_name);
+            transfer(pOpt->m_sValue);
+            transfer(pOpt->m_fValue);
+            transfer(pOpt->m_nValue);
+            transfer(pOpt->m_rValue);
+            break;
+        }
+        case k_imo_param_info:
+        {
+            ImoParamInfo* pParam = static_cast<ImoParamInfo*>(pImo);
+            transfer(pParam->m_name);
+            transfer(pParam->m_value);
+            break;
+        }
+        case k_imo_style:
+            transfer_style(static_cast<ImoStyle*>(pImo));
+            break;
+        case k_imo_styles:
+        {
+            ImoStyles* pStyles = static_cast<ImoStyles*>(pImo);
+            if (m_fSaving)
+            {
+                write_uint(pStyles->m_nameToStyle.size());
+                map<std::string, ImoStyle*>::iterator it;
+                for (it = pStyles->m_nameToStyle.begin(); it != pStyles->m_nameToStyle.end(); ++it)
+                {
+                    transfer(const_cast<string&>(it->first));
+                    save_node(it->second);
+                }
+            }
+            else
+            {
+                unsigned long long numStyles = read_uint();
+                for (; numStyles > 0; --numStyles)
+                {
+                    string name;
+                    transfer(name);
+                    pStyles->m_nameToStyle[name] = static_cast<ImoStyle*>( restore_node() );
+                }
+            }
+            break;
+        }
+
+        //relation data ---------------------------------------------------------------
+        case k_imo_beam_data:
+        {
+            ImoBeamData* pData = static_cast<ImoBeamData*>(pImo);
+            transfer(pData->m_beamNum);
+            for (int i=0; i < 6; ++i)
+            {
+                transfer(pData->m_beamType[i]);
+                transfer(pData->m_repeat[i]);
+            }
+            break;
+        }
+        case k_imo_slur_data:
+        {
+            ImoSlurData* pData = static_cast<ImoSlurData*>(pImo);
+            transfer(pData->m_fStart);
+            transfer(pData->m_slurNum);
+            transfer(pData->m_orientation);
+            transfer_bezier(pData->m_pBezier);
+            break;
+        }
+        case k_imo_tie_data:
+        {
+            ImoTieData* pData = static_cast<ImoTieData*>(pImo);
+            transfer(pData->m_fStart);
+            transfer(pData->m_tieNum);
+            transfer(pData->m_orientation);
+            transfer_bezier(pData->m_pBezier);
+            break;
+        }
+
+        //containers ------------------------------------------------------------------
+        case k_imo_instrument:
+        {
+            ImoInstrument* pInstr = static_cast<ImoInstrument*>(pImo);
+            transfer_ref(pInstr->m_pScore);
+            transfer_embedded(&pInstr->m_name);
+            transfer_score_text(&pInstr->m_name);
+            transfer_embedded(&pInstr->m_abbrev);
+            transfer_score_text(&pInstr->m_abbrev);
+            transfer(pInstr->m_partId);
+            transfer(pInstr->m_barlineLayout);
+            transfer(pInstr->m_measuresNumbering);
+            if (m_fSaving)
+            {
+                write_uint(pInstr->m_staves.size());
+                std::list<ImoStaffInfo*>::iterator it;
+                for (it = pInstr->m_staves.begin(); it != pInstr->m_staves.end(); ++it)
+                    save_node(*it);
+            }
+            else
+            {
+                unsigned long long numStaves = read_uint();
+                for (; numStaves > 0; --numStaves)
+                    pInstr->m_staves.push_back( static_cast<ImoStaffInfo*>(restore_node()) );
+            }
+            break;
+        }
+
+        //staff objects ---------------------------------------------------------------
+        case k_imo_barline:
+        {
+            ImoBarline* pBarline = static_cast<ImoBarline*>(pImo);
+            transfer_staffobj(pBarline);
+            transfer(pBarline->m_barlineType);
+            transfer(pBarline->m_fMiddle);
+            transfer(pBarline->m_times);
+            transfer(pBarline->m_winged);
+            break;
+        }
+        case k_imo_clef:
+        {
+            ImoClef* pClef = static_cast<ImoClef*>(pImo);
+            transfer_staffobj(pClef);
+            transfer(pClef->m_clefType);
+            transfer(pClef->m_symbolSize);
+            break;
+        }
+        case k_imo_direction:
+        {
+            ImoDirection* pDir = static_cast<ImoDirection*>(pImo);
+            transfer_staffobj(pDir);
+            transfer(pDir->m_space);
+            transfer(pDir->m_placement);
+            transfer(pDir->m_displayRepeat);
+            transfer(pDir->m_soundRepeat);
+            break;
+        }
+        case k_imo_go_back_fwd:
+        {
+            ImoGoBackFwd* pGBF = static_cast<ImoGoBackFwd*>(pImo);
+            transfer_staffobj(pGBF);
+            transfer(pGBF->m_fFwd);
+            transfer(pGBF->m_rTimeShift);
+            break;
+        }
+        case k_imo_key_signature:
+        {
+            ImoKeySignature* pKey = static_cast<ImoKeySignature*>(pImo);
+            transfer_staffobj(pKey);
+            transfer(pKey->m_fifths);
+            transfer(pKey->m_keyMode);
+            break;
+        }
+        case k_imo_note:
+        {
+            ImoNote* pNote = static_cast<ImoNote*>(pImo);
+            transfer_noterest(pNote);
+            transfer(pNote->m_step);
+            transfer(pNote->m_octave);
+            transfer(pNote->m_actual_acc);
+            transfer_enum(pNote->m_notated_acc);
+            transfer(pNote->m_options);
+            transfer(pNote->m_stemDirection);
+            transfer_ref(pNote->m_pTieNext);
+            transfer_ref(pNote->m_pTiePrev);
+            break;
+        }
+        case k_imo_rest:
+        {
+            ImoRest* pRest = static_cast<ImoRest*>(pImo);
+            transfer_noterest(pRest);
+            transfer(pRest->m_fGoFwd);
+            transfer(pRest->m_fFullMeasureRest);
+            break;
+        }
+        case k_imo_sound_change:
+        case k_imo_system_break:
+            transfer_staffobj(static_cast<ImoStaffObj*>(pImo));
+            break;
+        case k_imo_time_signature:
+        {
+            ImoTimeSignature* pTime = static_cast<ImoTimeSignature*>(pImo);
+            transfer_staffobj(pTime);
+            transfer(pTime->m_top);
+            transfer(pTime->m_bottom);
+            transfer(pTime->m_type);
+            break;
+        }
+
+        //auxiliary objects -----------------------------------------------------------
+        case k_imo_articulation_line:
+        {
+            ImoArticulationLine* pArt = static_cast<ImoArticulationLine*>(pImo);
+            transfer_scoreobj(pArt);
+            transfer(pArt->m_articulationType);
+            transfer(pArt->m_placement);
+            transfer(pArt->m_lineShape);
+            transfer(pArt->m_lineType);
+            transfer(pArt->m_dashLength);
+            transfer(pArt->m_dashSpace);
+            break;
+        }
+        case k_imo_articulation_symbol:
+        {
+            ImoArticulationSymbol* pArt = static_cast<ImoArticulationSymbol*>(pImo);
+            transfer_scoreobj(pArt);
+            transfer(pArt->m_articulationType);
+            transfer(pArt->m_placement);
+            transfer(pArt->m_fUp);
+            transfer(pArt->m_symbol);
+            break;
+        }
+        case k_imo_dynamics_mark:
+        {
+            ImoDynamicsMark* pMark = static_cast<ImoDynamicsMark*>(pImo);
+            transfer_scoreobj(pMark);
+            transfer(pMark->m_markType);
+            transfer(pMark->m_placement);
+            break;
+        }
+        case k_imo_fermata:
+        {
+            ImoFermata* pFermata = static_cast<ImoFermata*>(pImo);
+            transfer_scoreobj(pFermata);
+            transfer(pFermata->m_placement);
+            transfer(pFermata->m_symbol);
+            break;
+        }
+        case k_imo_line:
+        {
+            ImoLine* pLine = static_cast<ImoLine*>(pImo);
+            transfer_scoreobj(pLine);
+            bool fHasStyle = (pLine->m_pStyle != nullptr);
+            transfer(fHasStyle);
+            if (fHasStyle)
+            {
+                if (!m_fSaving)
+                {
+                    delete pLine->m_pStyle;
+                    pLine->m_pStyle = LOMSE_NEW ImoLineStyle();
+                }
+                transfer_embedded(pLine->m_pStyle);
+                transfer_line_style(pLine->m_pStyle);
+            }
+            break;
+        }
+        case k_imo_lyric:
+        {
+            ImoLyric* pLyric = static_cast<ImoLyric*>(pImo);
+            transfer_scoreobj(pLyric);
+            transfer_ref(pLyric->m_prevARO);
+            transfer_ref(pLyric->m_nextARO);
+            transfer(pLyric->m_number);
+            transfer(pLyric->m_placement);
+            transfer(pLyric->m_numTextItems);
+            transfer(pLyric->m_fLaughing);
+            transfer(pLyric->m_fHumming);
+            transfer(pLyric->m_fEndLine);
+            transfer(pLyric->m_fEndParagraph);
+            transfer(pLyric->m_fMelisma);
+            transfer(pLyric->m_fHyphenation);
+            break;
+        }
+        case k_imo_metronome_mark:
+        {
+            ImoMetronomeMark* pMark = static_cast<ImoMetronomeMark*>(pImo);
+            transfer_scoreobj(pMark);
+            transfer(pMark->m_markType);
+            transfer(pMark->m_ticksPerMinute);
+            transfer(pMark->m_leftNoteType);
+            transfer(pMark->m_leftDots);
+            transfer(pMark->m_rightNoteType);
+            transfer(pMark->m_rightDots);
+            transfer(pMark->m_fParenthesis);
+            break;
+        }
+        case k_imo_ornament:
+        {
+            ImoOrnament* pOrnament = static_cast<ImoOrnament*>(pImo);
+            transfer_scoreobj(pOrnament);
+            transfer(pOrnament->m_ornamentType);
+            transfer(pOrnament->m_placement);
+            break;
+        }
+        case k_imo_score_line:
+        {
+            ImoScoreLine* pLine = static_cast<ImoScoreLine*>(pImo);
+            transfer_scoreobj(pLine);
+            transfer(pLine->m_startPoint);
+            transfer(pLine->m_endPoint);
+            transfer_embedded(&pLine->m_style);
+            transfer_line_style(&pLine->m_style);
+            break;
+        }
+        case k_imo_score_text:
+            transfer_score_text(static_cast<ImoScoreText*>(pImo));
+            break;
+        case k_imo_score_title:
+        {
+            ImoScoreTitle* pTitle = static_cast<ImoScoreTitle*>(pImo);
+            transfer_score_text(pTitle);
+            transfer(pTitle->m_hAlign);
+            break;
+        }
+        case k_imo_symbol_repetition_mark:
+        {
+            ImoSymbolRepetitionMark* pMark = static_cast<ImoSymbolRepetitionMark*>(pImo);
+            transfer_scoreobj(pMark);
+            transfer(pMark->m_symbol);
+            break;
+        }
+        case k_imo_technical:
+        {
+            ImoTechnical* pTechnical = static_cast<ImoTechnical*>(pImo);
+            transfer_scoreobj(pTechnical);
+            transfer(pTechnical->m_technicalType);
+            transfer(pTechnical->m_placement);
+            break;
+        }
+        case k_imo_text_box:
+        {
+            ImoTextBox* pBox = static_cast<ImoTextBox*>(pImo);
+            transfer_scoreobj(pBox);
+            transfer_embedded(&pBox->m_box);
+            transfer_textblock_info(&pBox->m_box);
+            transfer(pBox->m_text);
+            transfer_embedded(&pBox->m_line);
+            transfer_line_style(&pBox->m_line);
+            transfer(pBox->m_fHasAnchorLine);
+            break;
+        }
+        case k_imo_text_repetition_mark:
+        {
+            ImoTextRepetitionMark* pMark = static_cast<ImoTextRepetitionMark*>(pImo);
+            transfer_score_text(pMark);
+            transfer(pMark->m_repeatType);
+            break;
+        }
+
+        //relation objects ------------------------------------------------------------
+        case k_imo_beam:
+        case k_imo_chord:
+            transfer_relobj(static_cast<ImoRelObj*>(pImo));
+            break;
+        case k_imo_octave_shift:
+        {
+            ImoOctaveShift* pShift = static_cast<ImoOctaveShift*>(pImo);
+            transfer_relobj(pShift);
+            transfer(pShift->m_steps);
+            transfer(pShift->m_octaveShiftNum);
+            break;
+        }
+        case k_imo_slur:
+        {
+            ImoSlur* pSlur = static_cast<ImoSlur*>(pImo);
+            transfer_relobj(pSlur);
+            transfer(pSlur->m_slurNum);
+            transfer(pSlur->m_orientation);
+            transfer(pSlur->m_color);
+            break;
+        }
+        case k_imo_tie:
+        {
+            ImoTie* pTie = static_cast<ImoTie*>(pImo);
+            transfer_relobj(pTie);
+            transfer(pTie->m_tieNum);
+            transfer(pTie->m_orientation);
+            transfer(pTie->m_color);
+            break;
+        }
+        case k_imo_tuplet:
+        {
+            ImoTuplet* pTuplet = static_cast<ImoTuplet*>(pImo);
+            transfer_relobj(pTuplet);
+            transfer(pTuplet->m_nActualNum);
+            transfer(pTuplet->m_nNormalNum);
+            transfer(pTuplet->m_nShowBracket);
+            transfer(pTuplet->m_nShowNumber);
+            transfer(pTuplet->m_nPlacement);
+            break;
+        }
+        case k_imo_volta_bracket:
+        {
+            ImoVoltaBracket* pVolta = static_cast<ImoVoltaBracket*>(pImo);
+            transfer_relobj(pVolta);
+            transfer(pVolta->m_fStopJog);
+            transfer(pVolta->m_voltaNum);
+            transfer(pVolta->m_voltaText);
+            transfer(pVolta->m_numVoltas);
+            if (m_fSaving)
+            {
+                write_uint(pVolta->m_repetitions.size());
+                vector<int>::iterator it;
+                for (it = pVolta->m_repetitions.begin(); it != pVolta->m_repetitions.end(); ++it)
+                    write_int(*it);
+            }
+            else
+            {
+                pVolta->m_repetitions.resize( size_t(read_uint()) );
+                vector<int>::iterator it;
+                for (it = pVolta->m_repetitions.begin(); it != pVolta->m_repetitions.end(); ++it)
+                    *it = int(read_int());
+            }
+            break;
+        }
+        case k_imo_wedge:
+        {
+            ImoWedge* pWedge = static_cast<ImoWedge*>(pImo);
+            transfer_relobj(pWedge);
+            transfer(pWedge->m_startSpread);
+            transfer(pWedge->m_endSpread);
+            transfer(pWedge->m_fNiente);
+            transfer(pWedge->m_fCrescendo);
+            transfer(pWedge->m_wedgeNum);
+            break;
+        }
+
+        //block level objects ---------------------------------------------------------
+        case k_imo_anonymous_block:
+        case k_imo_content:
+        case k_imo_listitem:
+        case k_imo_para:
+        case k_imo_table_row:
+            transfer_contentobj(static_cast<ImoContentObj*>(pImo));
+            break;
+        case k_imo_document:
+        {
+            ImoDocument* pDoc = static_cast<ImoDocument*>(pImo);
+            transfer_contentobj(pDoc);
+            transfer(pDoc->m_scale);
+            transfer(pDoc->m_version);
+            transfer(pDoc->m_language);
+            transfer_embedded(&pDoc->m_pageInfo);
+            transfer_page_info(&pDoc->m_pageInfo);
+            if (m_fSaving)
+            {
+                write_uint(pDoc->m_privateStyles.size());
+                std::list<ImoStyle*>::iterator it;
+                for (it = pDoc->m_privateStyles.begin(); it != pDoc->m_privateStyles.end(); ++it)
+                    save_node(*it);
+            }
+            else
+            {
+                unsigned long long numStyles = read_uint();
+                for (; numStyles > 0; --numStyles)
+                    pDoc->m_privateStyles.push_back( static_cast<ImoStyle*>(restore_node()) );
+            }
+            break;
+        }
+        case k_imo_heading:
+        {
+            ImoHeading* pHeading = static_cast<ImoHeading*>(pImo);
+            transfer_contentobj(pHeading);
+            transfer(pHeading->m_level);
+            break;
+        }
+        case k_imo_list:
+        {
+            ImoList* pList = static_cast<ImoList*>(pImo);
+            transfer_contentobj(pList);
+            transfer(pList->m_listType);
+            break;
+        }
+        case k_imo_multicolumn:
+        {
+            ImoMultiColumn* pMC = static_cast<ImoMultiColumn*>(pImo);
+            transfer_contentobj(pMC);
+            if (m_fSaving)
+                write_uint(pMC->m_widths.size());
+            else
+                pMC->m_widths.resize( size_t(read_uint()) );
+            vector<float>::iterator it;
+            for (it = pMC->m_widths.begin(); it != pMC->m_widths.end(); ++it)
+                transfer(*it);
+            break;
+        }
+        case k_imo_score:
+        {
+            ImoScore* pScore = static_cast<ImoScore*>(pImo);
+            transfer_contentobj(pScore);
+            transfer(pScore->m_version);
+            transfer_embedded(&pScore->m_systemInfoFirst);
+            transfer_system_info(&pScore->m_systemInfoFirst);
+            transfer_embedded(&pScore->m_systemInfoOther);
+            transfer_system_info(&pScore->m_systemInfoOther);
+            transfer_embedded(&pScore->m_pageInfo);
+            transfer_page_info(&pScore->m_pageInfo);
+            if (m_fSaving)
+            {
+                write_uint(pScore->m_nameToStyle.size());
+                map<string, ImoStyle*>::iterator it;
+                for (it = pScore->m_nameToStyle.begin(); it != pScore->m_nameToStyle.end(); ++it)
+                {
+                    transfer(const_cast<string&>(it->first));
+                    save_node(it->second);
+                }
+
+                write_uint(pScore->m_titles.size());
+                std::list<ImoScoreTitle*>::iterator itT;
+                for (itT = pScore->m_titles.begin(); itT != pScore->m_titles.end(); ++itT)
+                    write_ref(*itT);
+            }
+            else
+            {
+                unsigned long long numStyles = read_uint();
+                for (; numStyles > 0; --numStyles)
+                {
+                    string name;
+                    transfer(name);
+                    pScore->m_nameToStyle[name] = static_cast<ImoStyle*>( restore_node() );
+                }
+
+                unsigned long long numTitles = read_uint();
+                for (; numTitles > 0; --numTitles)
+                {
+                    int i = read_ref();
+                    m_pending.push_back([this, pScore, i]() {
+                        pScore->m_titles.push_back(
+                            static_cast<ImoScoreTitle*>( object_at(i - 1) ));
+                    });
+                }
+            }
+            break;
+        }
+        case k_imo_table:
+        {
+            ImoTable* pTable = static_cast<ImoTable*>(pImo);
+            transfer_contentobj(pTable);
+            if (m_fSaving)
+            {
+                write_uint(pTable->m_colStyles.size());
+                std::list<ImoStyle*>::iterator it;
+                for (it = pTable->m_colStyles.begin(); it != pTable->m_colStyles.end(); ++it)
+                    write_ref(*it);
+            }
+            else
+            {
+                unsigned long long numStyles = read_uint();
+                for (; numStyles > 0; --numStyles)
+                {
+                    int i = read_ref();
+                    m_pending.push_back([this, pTable, i]() {
+                        pTable->m_colStyles.push_back(
+                            static_cast<ImoStyle*>( object_at(i - 1) ));
+                    });
+                }
+            }
+            break;
+        }
+        case k_imo_table_cell:
+        {
+            ImoTableCell* pCell = static_cast<ImoTableCell*>(pImo);
+            transfer_contentobj(pCell);
+            transfer(pCell->m_rowspan);
+            transfer(pCell->m_colspan);
+            break;
+        }
+
+        //inline level objects --------------------------------------------------------
+        case k_imo_inline_wrapper:
+        {
+            ImoInlineWrapper* pWrapper = static_cast<ImoInlineWrapper*>(pImo);
+            transfer_contentobj(pWrapper);
+            transfer(pWrapper->m_size);
+            break;
+        }
+        case k_imo_link:
+        {
+            ImoLink* pLink = static_cast<ImoLink*>(pImo);
+            transfer_contentobj(pLink);
+            transfer(pLink->m_size);
+            transfer(pLink->m_url);
+            transfer(pLink->m_language);
+            break;
+        }
+        case k_imo_text_item:
+        {
+            ImoTextItem* pItem = static_cast<ImoTextItem*>(pImo);
+            transfer_contentobj(pItem);
+            transfer(pItem->m_text);
+            transfer(pItem->m_language);
+            break;
+        }
+
+        //not supported: images, controls, dynamic content, DTOs, etc.
+        default:
+        {
+            if (m_fSaving)
+                m_fSupported = false;
+            else
+            {
+                LOMSE_LOG_ERROR("Invalid object type in snapshot.");
+                throw runtime_error("[ImSnapshot::transfer_fields] Invalid object type.");
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer_embedded(ImoObj* pImo)
+{
+    //embedded objects are not tree nodes and are not registered in the IdAssigner.
+    //Only their ids and flags are saved.
+    transfer(pImo->m_id);
+    int flags = int(pImo->m_flags);
+    transfer(flags);
+    bool fHasDoc = (pImo->m_pDoc != nullptr);
+    transfer(fHasDoc);
+    if (!m_fSaving)
+    {
+        pImo->m_flags = (unsigned int)(flags);
+        pImo->m_pDoc = (fHasDoc ? m_pDoc : nullptr);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer_contentobj(ImoContentObj* pImo)
+{
+    transfer_ref(pImo->m_pStyle);
+    transfer(pImo->m_txUserLocation);
+    transfer(pImo->m_tyUserLocation);
+    transfer(pImo->m_txUserRefPoint);
+    transfer(pImo->m_tyUserRefPoint);
+    transfer(pImo->m_fVisible);
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer_scoreobj(ImoScoreObj* pImo)
+{
+    transfer_contentobj(pImo);
+    transfer(pImo->m_color);
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer_staffobj(ImoStaffObj* pImo)
+{
+    transfer_scoreobj(pImo);
+    transfer(pImo->m_staff);
+    transfer(pImo->m_measure);
+    transfer(pImo->m_time);
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer_noterest(ImoNoteRest* pImo)
+{
+    transfer_staffobj(pImo);
+    transfer(pImo->m_nNoteType);
+    transfer(pImo->m_nDots);
+    transfer(pImo->m_nVoice);
+    transfer(pImo->m_timeModifierTop);
+    transfer(pImo->m_timeModifierBottom);
+    transfer(pImo->m_duration);
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer_relobj(ImoRelObj* pImo)
+{
+    //participants and their relation data, in the same order
+
+    transfer_scoreobj(pImo);
+    if (m_fSaving)
+    {
+        write_uint(pImo->m_relatedObjects.size());
+        std::list< pair<ImoStaffObj*, ImoRelDataObj*> >::iterator it;
+        for (it = pImo->m_relatedObjects.begin(); it != pImo->m_relatedObjects.end(); ++it)
+        {
+            write_ref((*it).first);
+            write_uint((*it).second != nullptr ? 1 : 0);
+            if ((*it).second)
+                save_node((*it).second);
+        }
+    }
+    else
+    {
+        unsigned long long numObjects = read_uint();
+        for (; numObjects > 0; --numObjects)
+        {
+            int i = read_ref();
+            ImoRelDataObj* pData = nullptr;
+            if (read_uint() != 0)
+                pData = static_cast<ImoRelDataObj*>( restore_node() );
+
+            m_pending.push_back([this, pImo, i, pData]() {
+                pImo->m_relatedObjects.push_back(
+                    make_pair(static_cast<ImoStaffObj*>( object_at(i - 1) ), pData) );
+            });
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer_relations(ImoRelations* pImo)
+{
+    //a relation is saved the first time it is found. Next times only a reference
+    //to it is saved
+
+    if (m_fSaving)
+    {
+        write_uint(pImo->m_relations.size());
+        std::list<ImoRelObj*>::iterator it;
+        for (it = pImo->m_relations.begin(); it != pImo->m_relations.end(); ++it)
+        {
+            if (m_fSaved[index_of(*it)])
+            {
+                write_uint(0);
+                write_ref(*it);
+            }
+            else
+            {
+                write_uint(1);
+                save_node(*it);
+            }
+        }
+    }
+    else
+    {
+        unsigned long long numRelations = read_uint();
+        for (; numRelations > 0; --numRelations)
+        {
+            ImoRelObj* pRO = nullptr;
+            if (read_uint() != 0)
+                pRO = static_cast<ImoRelObj*>( restore_node() );
+            else
+                pRO = static_cast<ImoRelObj*>( object_at(read_ref() - 1) );
+
+            if (!pRO)
+            {
+                LOMSE_LOG_ERROR("Invalid reference to relation in snapshot.");
+                throw runtime_error("[ImSnapshot::transfer_relations] Invalid reference.");
+            }
+            pImo->m_relations.push_back(pRO);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer_style(ImoStyle* pImo)
+{
+    transfer(pImo->m_name);
+    transfer_ref(pImo->m_pParent);
+
+    if (m_fSaving)
+    {
+        write_uint(pImo->m_lunitsProps.size());
+        std::map<int, LUnits>::iterator itL;
+        for (itL = pImo->m_lunitsProps.begin(); itL != pImo->m_lunitsProps.end(); ++itL)
+        {
+            write_int(itL->first);
+            transfer(itL->second);
+        }
+
+        write_uint(pImo->m_floatProps.size());
+        std::map<int, float>::iterator itF;
+        for (itF = pImo->m_floatProps.begin(); itF != pImo->m_floatProps.end(); ++itF)
+        {
+            write_int(itF->first);
+            transfer(itF->second);
+        }
+
+        write_uint(pImo->m_stringProps.size());
+        std::map<int, string>::iterator itS;
+        for (itS = pImo->m_stringProps.begin(); itS != pImo->m_stringProps.end(); ++itS)
+        {
+            write_int(itS->first);
+            transfer(itS->second);
+        }
+
+        write_uint(pImo->m_intProps.size());
+        std::map<int, int>::iterator itI;
+        for (itI = pImo->m_intProps.begin(); itI != pImo->m_intProps.end(); ++itI)
+        {
+            write_int(itI->first);
+            transfer(itI->second);
+        }
+
+        write_uint(pImo->m_colorProps.size());
+        std::map<int, Color>::iterator itC;
+        for (itC = pImo->m_colorProps.begin(); itC != pImo->m_colorProps.end(); ++itC)
+        {
+            write_int(itC->first);
+            transfer(itC->second);
+        }
+    }
+    else
+    {
+        pImo->m_lunitsProps.clear();
+        pImo->m_floatProps.clear();
+        pImo->m_stringProps.clear();
+        pImo->m_intProps.clear();
+        pImo->m_colorProps.clear();
+
+        unsigned long long numProps = read_uint();
+        for (; numProps > 0; --numProps)
+        {
+            int prop = int(read_int());
+            transfer(pImo->m_lunitsProps[prop]);
+        }
+
+        numProps = read_uint();
+        for (; numProps > 0; --numProps)
+        {
+            int prop = int(read_int());
+            transfer(pImo->m_floatProps[prop]);
+        }
+
+        numProps = read_uint();
+        for (; numProps > 0; --numProps)
+        {
+            int prop = int(read_int());
+            transfer(pImo->m_stringProps[prop]);
+        }
+
+        numProps = read_uint();
+        for (; numProps > 0; --numProps)
+        {
+            int prop = int(read_int());
+            transfer(pImo->m_intProps[prop]);
+        }
+
+        numProps = read_uint();
+        for (; numProps > 0; --numProps)
+        {
+            int prop = int(read_int());
+            transfer(pImo->m_colorProps[prop]);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer_text_info(ImoTextInfo* pImo)
+{
+    transfer(pImo->m_text);
+    transfer(pImo->m_language);
+    transfer_ref(pImo->m_pStyle);
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer_score_text(ImoScoreText* pImo)
+{
+    transfer_scoreobj(pImo);
+    transfer_embedded(&pImo->m_text);
+    transfer_text_info(&pImo->m_text);
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer_line_style(ImoLineStyle* pImo)
+{
+    transfer_enum(pImo->m_lineStyle);
+    transfer_enum(pImo->m_startEdge);
+    transfer_enum(pImo->m_endEdge);
+    transfer_enum(pImo->m_startStyle);
+    transfer_enum(pImo->m_endStyle);
+    transfer(pImo->m_color);
+    transfer(pImo->m_width);
+    transfer(pImo->m_startPoint);
+    transfer(pImo->m_endPoint);
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer_textblock_info(ImoTextBlockInfo* pImo)
+{
+    transfer(pImo->m_size);
+    transfer(pImo->m_topLeftPoint);
+    transfer(pImo->m_bgColor);
+    transfer(pImo->m_borderColor);
+    transfer(pImo->m_borderWidth);
+    transfer_enum(pImo->m_borderStyle);
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer_page_info(ImoPageInfo* pImo)
+{
+    transfer(pImo->m_uLeftMargin);
+    transfer(pImo->m_uRightMargin);
+    transfer(pImo->m_uTopMargin);
+    transfer(pImo->m_uBottomMargin);
+    transfer(pImo->m_uBindingMargin);
+    transfer(pImo->m_uPageSize);
+    transfer(pImo->m_fPortrait);
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer_system_info(ImoSystemInfo* pImo)
+{
+    transfer(pImo->m_fFirst);
+    transfer(pImo->m_leftMargin);
+    transfer(pImo->m_rightMargin);
+    transfer(pImo->m_systemDistance);
+    transfer(pImo->m_topSystemDistance);
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer_bezier(ImoBezierInfo*& pBezier)
+{
+    bool fHasBezier = (pBezier != nullptr);
+    transfer(fHasBezier);
+    if (!m_fSaving)
+    {
+        delete pBezier;
+        pBezier = (fHasBezier ? LOMSE_NEW ImoBezierInfo(nullptr) : nullptr);
+    }
+    if (fHasBezier)
+    {
+        transfer_embedded(pBezier);
+        for (int i=0; i < 4; ++i)
+            transfer(pBezier->m_tPoints[i]);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+template <class T>
+void ImSnapshot::transfer_ref(T*& pImo)
+{
+    //references are resolved after all objects have been created
+
+    if (m_fSaving)
+    {
+        write_ref(pImo);
+    }
+    else
+    {
+        int i = read_ref();
+        pImo = nullptr;
+        if (i > 0)
+        {
+            T** ppImo = &pImo;
+            m_pending.push_back([this, ppImo, i]() {
+                *ppImo = static_cast<T*>( object_at(i - 1) );
+            });
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------
+template <class T>
+void ImSnapshot::transfer_enum(T& value)
+{
+    int intValue = int(value);
+    transfer(intValue);
+    if (!m_fSaving)
+        value = static_cast<T>(intValue);
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::write_ref(ImoObj* pImo)
+{
+    //references are saved as the distance between the index of the referenced object
+    //and the index of current node, so that a change in the tree does not alter the
+    //references in other places. Zero is for null references
+    if (pImo)
+    {
+        long long dist = index_of(pImo) - m_lastIndex;
+        write_uint( ((static_cast<unsigned long long>(dist) << 1) ^ (dist < 0 ? ~0ULL : 0ULL)) + 1 );
+    }
+    else
+        write_uint(0);
+}
+
+//---------------------------------------------------------------------------------------
+int ImSnapshot::read_ref()
+{
+    //returns the index of the referenced object plus one, or zero for null references
+    unsigned long long value = read_uint();
+    if (value == 0)
+        return 0;
+    --value;
+    long long dist = static_cast<long long>(value >> 1) ^ -static_cast<long long>(value & 1);
+    return int(m_lastIndex + dist + 1);
+}
+
+//---------------------------------------------------------------------------------------
+int ImSnapshot::index_of(ImoObj* pImo)
+{
+    map<ImoObj*, int>::iterator it = m_indexes.find(pImo);
+    if (it != m_indexes.end())
+        return it->second;
+
+    int i = int(m_referenced.size());
+    m_indexes[pImo] = i;
+    m_referenced.push_back(pImo);
+    m_fSaved.push_back(false);
+    return i;
+}
+
+//---------------------------------------------------------------------------------------
+ImoObj* ImSnapshot::object_at(int i)
+{
+    if (i >= 0 && size_t(i) < m_restored.size())
+        return m_restored[i];
+    return nullptr;
+}
+
+//---------------------------------------------------------------------------------------
+bool ImSnapshot::save_external_refs()
+{
+    //Referenced objects not included in the snapshot. Only styles defined in the
+    //Document are allowed, and they are saved by id.
+
+    vector<size_t> external;
+    for (size_t i=0; i < m_referenced.size(); ++i)
+    {
+        if (!m_fSaved[i])
+        {
+            ImoObj* pImo = m_referenced[i];
+            if (!pImo->is_style() || pImo->get_id() == k_no_imoid
+                || m_pDoc->get_pointer_to_imo(pImo->get_id()) != pImo)
+            {
+                return false;
+            }
+            external.push_back(i);
+        }
+    }
+
+    write_uint(external.size());
+    vector<size_t>::iterator it;
+    for (it = external.begin(); it != external.end(); ++it)
+    {
+        write_uint(*it);
+        write_int(m_referenced[*it]->get_id());
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::restore_external_refs()
+{
+    unsigned long long numRefs = read_uint();
+    for (; numRefs > 0; --numRefs)
+    {
+        size_t i = size_t(read_uint());
+        ImoId id = ImoId(read_int());
+        ImoObj* pImo = (m_pExternalIds ? m_pExternalIds->get_pointer_to_imo(id)
+                                       : m_pDoc->get_pointer_to_imo(id) );
+        if (i >= m_restored.size())
+            m_restored.resize(i + 1, nullptr);
+        m_restored[i] = pImo;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer(int& value)
+{
+    if (m_fSaving)
+        write_int(value);
+    else
+        value = int(read_int());
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer(long& value)
+{
+    if (m_fSaving)
+        write_int(value);
+    else
+        value = long(read_int());
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer(bool& value)
+{
+    if (m_fSaving)
+        m_data.push_back(value ? 1 : 0);
+    else
+    {
+        check_available(1);
+        value = (*m_pCur++ != 0);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer(float& value)
+{
+    if (m_fSaving)
+    {
+        if (!write_integral(value))
+            write_bytes(&value, sizeof(float));
+    }
+    else
+    {
+        long long integral;
+        if (read_integral(&integral))
+            value = float(integral);
+        else
+            read_bytes(&value, sizeof(float));
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer(double& value)
+{
+    if (m_fSaving)
+    {
+        if (!write_integral(value))
+            write_bytes(&value, sizeof(double));
+    }
+    else
+    {
+        long long integral;
+        if (read_integral(&integral))
+            value = double(integral);
+        else
+            read_bytes(&value, sizeof(double));
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer(string& value)
+{
+    if (m_fSaving)
+    {
+        write_uint(value.size());
+        m_data.append(value);
+    }
+    else
+    {
+        size_t size = size_t(read_uint());
+        check_available(size);
+        value.assign(reinterpret_cast<const char*>(m_pCur), size);
+        m_pCur += size;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer(Color& value)
+{
+    unsigned char rgba[4] = { value.r, value.g, value.b, value.a };
+    if (m_fSaving)
+        write_bytes(rgba, 4);
+    else
+    {
+        read_bytes(rgba, 4);
+        value = Color(rgba[0], rgba[1], rgba[2], rgba[3]);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer(Point<float>& value)
+{
+    transfer(value.x);
+    transfer(value.y);
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::transfer(Size<float>& value)
+{
+    transfer(value.width);
+    transfer(value.height);
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::write_int(long long value)
+{
+    //zigzag encoding, so that small negative values also take few bytes
+    write_uint( (static_cast<unsigned long long>(value) << 1) ^ (value < 0 ? ~0ULL : 0ULL) );
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::write_uint(unsigned long long value)
+{
+    //variable length: 7 bits per byte, high bit set when more bytes follow
+    while (value >= 0x80)
+    {
+        m_data.push_back( char((value & 0x7F) | 0x80) );
+        value >>= 7;
+    }
+    m_data.push_back( char(value) );
+}
+
+//---------------------------------------------------------------------------------------
+bool ImSnapshot::write_integral(double value)
+{
+    //most positions and durations have integer values. They are saved as a tagged
+    //varint (even), and any other value as tag 1 followed by the raw bytes
+    if (value >= -1073741824.0 && value <= 1073741823.0 && value == floor(value)
+        && !(value == 0.0 && signbit(value)))
+    {
+        write_int( static_cast<long long>(value) * 2 );
+        return true;
+    }
+    write_int(1LL);     //NaN and non integral values
+    return false;
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::write_bytes(const void* pData, size_t size)
+{
+    m_data.append(static_cast<const char*>(pData), size);
+}
+
+//---------------------------------------------------------------------------------------
+long long ImSnapshot::read_int()
+{
+    unsigned long long value = read_uint();
+    return static_cast<long long>(value >> 1) ^ -static_cast<long long>(value & 1);
+}
+
+//---------------------------------------------------------------------------------------
+unsigned long long ImSnapshot::read_uint()
+{
+    unsigned long long value = 0;
+    int shift = 0;
+    while (true)
+    {
+        check_available(1);
+        unsigned char byte = *m_pCur++;
+        value |= static_cast<unsigned long long>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return value;
+        shift += 7;
+        if (shift > 63)
+            check_available(size_t(-1));    //corrupted data
+    }
+}
+
+//---------------------------------------------------------------------------------------
+bool ImSnapshot::read_integral(long long* pValue)
+{
+    long long tag = read_int();
+    if (tag == 1LL)
+        return false;
+    *pValue = tag / 2;
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::read_bytes(void* pData, size_t size)
+{
+    check_available(size);
+    memcpy(pData, m_pCur, size);
+    m_pCur += size;
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::check_available(size_t size)
+{
+    if (size > size_t(m_pEnd - m_pCur))
+    {
+        LOMSE_LOG_ERROR("Unexpected end of snapshot data.");
+        throw runtime_error("[ImSnapshot] Unexpected end of snapshot data.");
+    }
+}
+
+
+}  //namespace lomse
@@ -31,6 +31,7 @@
 
 #include <algorithm>
 #include <math.h>                   //pow
+#include <climits>                  //INT_MAX
 #include "lomse_staffobjs_table.h"
 #include "lomse_im_note.h"
 #include "lomse_midi_table.h"
@@ -388,6 +389,10 @@ ImoObj::ImoObj(int objtype, ImoId id)
 //---------------------------------------------------------------------------------------
 ImoObj::~ImoObj()
 {
+    //AWARE: children are not unlinked before deleting them. Siblings are not valid
+    //while deleting the children
+    m_flags |= k_being_deleted;
+
     TreeNode<ImoObj>::children_iterator it(this);
     it = begin();
     while (it != end())
@@ -761,7 +766,7 @@ void ImoObj::set_dirty(bool dirty)
     if (dirty)
     {
         m_flags |= k_dirty;
-        propagate_dirty();
+        propagate_dirty(this);
     }
     else
         m_flags &= ~k_dirty;
@@ -774,20 +779,20 @@ void ImoObj::set_children_dirty(bool value)
 }
 
 //---------------------------------------------------------------------------------------
-void ImoObj::propagate_dirty()
+void ImoObj::propagate_dirty(ImoObj* pModified)
 {
     ImoObj* pParent = get_parent_imo();
     if (pParent)
     {
         pParent->set_children_dirty(true);
-        pParent->propagate_dirty();
+        pParent->propagate_dirty(pModified);
     }
 
     if (this->is_document())
     {
         ImoDocument* pImoDoc = static_cast<ImoDocument*>(this);
         Document* pDoc = pImoDoc->get_the_document();
-        pDoc->set_dirty();
+        pDoc->set_dirty(pModified);
     }
 }
 
@@ -1288,6 +1293,18 @@ list<TIntAttribute> ImoStaffObj::get_supported_attributes()
 //=======================================================================================
 // ImoBeamData implementation
 //=======================================================================================
+ImoBeamData::ImoBeamData()
+    : ImoRelDataObj(k_imo_beam_data)
+    , m_beamNum(0)
+{
+    for (int i=0; i < 6; ++i)
+    {
+        m_beamType[i] = ImoBeam::k_none;
+        m_repeat[i] = false;
+    }
+}
+
+//---------------------------------------------------------------------------------------
 ImoBeamData::ImoBeamData(ImoBeamDto* pDto)
     : ImoRelDataObj(k_imo_beam_data)
     , m_beamNum( pDto->get_beam_number() )
@@ -2711,7 +2728,9 @@ ImoStaffObj* ImoInstrument::insert_staffobj_at(ImoStaffObj* pAt, ImoStaffObj* pI
     else
     {
         ImoMusicData* pMD = get_musicdata();
-        pMD->append_child_imo(pImo);
+        pMD->append_child(pImo);
+        pImo->set_dirty(true);
+        set_dirty_flag();
     }
     return pImo;
 }
@@ -2757,12 +2776,13 @@ void ImoInstrument::delete_staffobj(ImoStaffObj* pSO)
         pColStaffObjs->delete_entry_for(pSO);
     }
 
-    //remove from ImoTree
+    //remove from ImoTree. The object is marked as modified before, for recording
+    //the changed measure
+    pSO->set_dirty(true);
     ImoMusicData* pMusicData = get_musicdata();
     pMusicData->remove_child(pSO);
     delete pSO;
-
-    set_dirty(true);
+    set_dirty_flag();
 }
 
 //---------------------------------------------------------------------------------------
@@ -2773,7 +2793,8 @@ void ImoInstrument::insert_staffobj(ImoStaffObj* pPos, ImoStaffObj* pImo)
     TreeNode<ImoObj>::iterator it(pPos);
     ImoMusicData* pMD = get_musicdata();
     pMD->insert(it, pImo);
-    set_dirty(true);
+    pImo->set_dirty(true);
+    set_dirty_flag();
 }
 
 //---------------------------------------------------------------------------------------
@@ -2787,7 +2808,8 @@ void ImoInstrument::insert_staffobj_after(ImoStaffObj* pPos, ImoStaffObj* pImo)
         pMD->insert(it, pImo);
     else
         pMD->append_child(pImo);
-    set_dirty(true);
+    pImo->set_dirty(true);
+    set_dirty_flag();
 }
 
 //---------------------------------------------------------------------------------------
@@ -2829,7 +2851,11 @@ list<ImoStaffObj*> ImoInstrument::insert_staff_objects_at(ImoStaffObj* pAt,
         it = pObjects->begin();
     }
     delete pObjects;
-    set_dirty(true);
+
+    list<ImoStaffObj*>::iterator itSO;
+    for (itSO = objects.begin(); itSO != objects.end(); ++itSO)
+        (*itSO)->set_dirty(true);
+    set_dirty_flag();
     return objects;
 }
 
@@ -3213,7 +3239,10 @@ ImoScore::ImoScore(Document* pDoc)
     : ImoBlockLevelObj(k_imo_score)
     , m_version(0)
     , m_pColStaffObjs(nullptr)
-    , m_pMidiTable(nullptr)
+    , m_spMidiTable()
+    , m_fMidiTableOutdated(false)
+    , m_midiFirstMeasure(INT_MAX)
+    , m_midiLastMeasure(0)
     , m_systemInfoFirst()
     , m_systemInfoOther()
     , m_pageInfo()
@@ -3231,7 +3260,6 @@ ImoScore::~ImoScore()
 {
     delete m_pColStaffObjs;
     delete_text_styles();
-    delete m_pMidiTable;
 }
 
 //---------------------------------------------------------------------------------------
@@ -3352,6 +3380,21 @@ void ImoScore::set_staffobjs_table(ColStaffObjs* pColStaffObjs)
 {
     delete m_pColStaffObjs;
     m_pColStaffObjs = pColStaffObjs;
+
+    //the score has been modified. The sound events table will be updated when needed.
+    //AWARE: if the Document has registered changes in this score, the modified
+    //measures will be informed when the Document changes are cleared (see
+    //update_midi_table()). Otherwise, the modification is unknown and the whole
+    //table must be created again.
+    if (m_spMidiTable)
+    {
+        m_fMidiTableOutdated = true;
+        if (!m_pDoc || !m_pDoc->get_change_set().is_score_changed(get_id()))
+        {
+            m_midiFirstMeasure = 1;
+            m_midiLastMeasure = INT_MAX;
+        }
+    }
 }
 
 //---------------------------------------------------------------------------------------
@@ -3787,12 +3830,56 @@ void ImoScore::add_required_text_styles()
 //---------------------------------------------------------------------------------------
 SoundEventsTable* ImoScore::get_midi_table()
 {
-    if (!m_pMidiTable)
+    return get_shared_midi_table().get();
+}
+
+//---------------------------------------------------------------------------------------
+std::shared_ptr<SoundEventsTable> ImoScore::get_shared_midi_table()
+{
+    if (!m_spMidiTable)
     {
-        m_pMidiTable = LOMSE_NEW SoundEventsTable(this);
-        m_pMidiTable->create_table();
+        m_spMidiTable.reset( LOMSE_NEW SoundEventsTable(this) );
+        m_spMidiTable->create_table();
+    }
+    else if (m_fMidiTableOutdated)
+    {
+        //when the modified measures are not known, the whole table is created again
+        bool fUpdate = m_midiFirstMeasure <= m_midiLastMeasure
+                       && !(m_midiFirstMeasure <= 1 && m_midiLastMeasure == INT_MAX);
+
+        //AWARE: the table could be in use by the playback thread. When shared, an
+        //outdated table is not modified but replaced by a new one
+        if (m_spMidiTable.use_count() > 1)
+        {
+            std::shared_ptr<SoundEventsTable> spTable(LOMSE_NEW SoundEventsTable(this));
+            if (fUpdate)
+                spTable->update_table(*m_spMidiTable, m_midiFirstMeasure,
+                                      m_midiLastMeasure);
+            else
+                spTable->create_table();
+            m_spMidiTable = spTable;
+        }
+        else if (fUpdate)
+            m_spMidiTable->update_table(m_midiFirstMeasure, m_midiLastMeasure);
+        else
+            m_spMidiTable->create_table();
+    }
+    m_fMidiTableOutdated = false;
+    m_midiFirstMeasure = INT_MAX;
+    m_midiLastMeasure = 0;
+    return m_spMidiTable;
+}
+
+//---------------------------------------------------------------------------------------
+void ImoScore::update_midi_table(int firstMeasure, int lastMeasure)
+{
+    //the table is updated when needed
+    if (m_spMidiTable)
+    {
+        m_fMidiTableOutdated = true;
+        m_midiFirstMeasure = min(m_midiFirstMeasure, firstMeasure);
+        m_midiLastMeasure = max(m_midiLastMeasure, lastMeasure);
     }
-    return m_pMidiTable;
 }
 
 //---------------------------------------------------------------------------------------
@@ -5061,6 +5148,16 @@ void ImoSlur::reorganize_after_object_deletion()
 //=======================================================================================
 // ImoSlurData implementation
 //=======================================================================================
+ImoSlurData::ImoSlurData()
+    : ImoRelDataObj(k_imo_slur_data)
+    , m_fStart(false)
+    , m_slurNum(0)
+    , m_orientation(k_orientation_default)
+    , m_pBezier(nullptr)
+{
+}
+
+//---------------------------------------------------------------------------------------
 ImoSlurData::ImoSlurData(ImoSlurDto* pDto)
     : ImoRelDataObj(k_imo_slur_data)
     , m_fStart( pDto->is_start() )
@@ -5328,6 +5425,16 @@ void ImoTie::reorganize_after_object_deletion()
 //=======================================================================================
 // ImoTieData implementation
 //=======================================================================================
+ImoTieData::ImoTieData()
+    : ImoRelDataObj(k_imo_tie_data)
+    , m_fStart(false)
+    , m_tieNum(0)
+    , m_orientation(k_orientation_default)
+    , m_pBezier(nullptr)
+{
+}
+
+//---------------------------------------------------------------------------------------
 ImoTieData::ImoTieData(ImoTieDto* pDto)
     : ImoRelDataObj(k_imo_tie_data)
     , m_fStart( pDto->is_start() )
@@ -78,6 +78,7 @@ ColStaffObjs::ColStaffObjs()
     , m_minNoteDuration(LOMSE_NO_NOTE_DURATION)
     , m_pFirst(nullptr)
     , m_pLast(nullptr)
+    , m_pIndex(nullptr)
 {
 }
 
@@ -87,6 +88,22 @@ ColStaffObjs::~ColStaffObjs()
     ColStaffObjs::iterator it;
     for (it=begin(); it != end(); ++it)
         delete *it;
+    delete m_pIndex;
+}
+
+//---------------------------------------------------------------------------------------
+ColStaffObjsIndex* ColStaffObjs::get_index()
+{
+    if (!m_pIndex)
+        m_pIndex = LOMSE_NEW ColStaffObjsIndex(this);
+    return m_pIndex;
+}
+
+//---------------------------------------------------------------------------------------
+void ColStaffObjs::invalidate_index()
+{
+    delete m_pIndex;
+    m_pIndex = nullptr;
 }
 
 //---------------------------------------------------------------------------------------
@@ -97,6 +114,7 @@ void ColStaffObjs::add_entry(int measure, int instr, int voice, int staff,
         LOMSE_NEW ColStaffObjsEntry(measure, instr, voice, staff, pImo);
     add_entry_to_list(pEntry);
     ++m_numEntries;
+    invalidate_index();
 }
 
 //---------------------------------------------------------------------------------------
@@ -222,6 +240,7 @@ void ColStaffObjs::delete_entry_for(ImoStaffObj* pSO)
         throw runtime_error("[ColStaffObjs::delete_entry_for] entry not found!");
     }
 
+    invalidate_index();
     ColStaffObjsEntry* pPrev = pEntry->get_prev();
     ColStaffObjsEntry* pNext = pEntry->get_next();
     delete pEntry;
@@ -271,6 +290,7 @@ void ColStaffObjs::sort_table()
     //   such as the bubble sort
     // * in-place sort (does not require extra memory)
 
+    invalidate_index();
     ColStaffObjsEntry* pUnsorted = m_pFirst;
     m_pFirst = nullptr;
     m_pLast = nullptr;
@@ -288,6 +308,167 @@ void ColStaffObjs::sort_table()
 
 
 
+//=======================================================================================
+// ColStaffObjsIndex implementation
+//=======================================================================================
+ColStaffObjsIndex::ColStaffObjsIndex(ColStaffObjs* pColStaffObjs)
+{
+    build(pColStaffObjs);
+}
+
+//---------------------------------------------------------------------------------------
+void ColStaffObjsIndex::build(ColStaffObjs* pColStaffObjs)
+{
+    //first pass: number the entries and determine instruments and staves
+    vector<int> numStaves;
+    int index = 0;
+    ColStaffObjsIterator it;
+    for (it=pColStaffObjs->begin(); it != pColStaffObjs->end(); ++it, ++index)
+    {
+        ColStaffObjsEntry* pEntry = *it;
+        pEntry->set_index(index);
+        int instr = pEntry->num_instrument();
+        if (instr >= int(numStaves.size()))
+            numStaves.resize(instr + 1, 0);
+        numStaves[instr] = max(numStaves[instr], pEntry->staff() + 1);
+    }
+
+    int numInstrs = int(numStaves.size());
+    m_ids.reserve( size_t(index) );
+    m_instruments.resize(numInstrs);
+    m_staves.resize(numInstrs);
+    m_barlines.resize(numInstrs);
+    m_timeSignatures.resize(numInstrs);
+    m_measures.resize(numInstrs);
+    for (int i=0; i < numInstrs; ++i)
+        m_staves[i].resize(numStaves[i]);
+
+    //second pass: collect entries
+    for (it=pColStaffObjs->begin(); it != pColStaffObjs->end(); ++it)
+    {
+        ColStaffObjsEntry* pEntry = *it;
+        ImoStaffObj* pSO = pEntry->imo_object();
+        int instr = pEntry->num_instrument();
+
+        m_ids.emplace(pEntry->element_id(), pEntry);    //first entry for the id
+        m_instruments[instr].push_back(pEntry);
+
+        if (pSO->is_barline())
+        {
+            //barlines are on all staves
+            for (size_t iStaff=0; iStaff < m_staves[instr].size(); ++iStaff)
+                m_staves[instr][iStaff].push_back(pEntry);
+
+            m_barlines[instr].push_back(pEntry);
+            m_measures[instr].emplace(pEntry->measure(), pEntry);
+        }
+        else
+        {
+            m_staves[instr][pEntry->staff()].push_back(pEntry);
+            if (pSO->is_time_signature())
+                m_timeSignatures[instr].push_back(pEntry);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------
+ColStaffObjsEntry* ColStaffObjsIndex::find_entry(ImoId id)
+{
+    std::unordered_map<ImoId, ColStaffObjsEntry*>::iterator it = m_ids.find(id);
+    return (it != m_ids.end() ? it->second : nullptr);
+}
+
+//---------------------------------------------------------------------------------------
+ColStaffObjsEntry* ColStaffObjsIndex::find_barline(int instr, int measure)
+{
+    if (!is_valid_instrument(instr))
+        return nullptr;
+
+    map<int, ColStaffObjsEntry*>::iterator it = m_measures[instr].find(measure);
+    return (it != m_measures[instr].end() ? it->second : nullptr);
+}
+
+//---------------------------------------------------------------------------------------
+ColStaffObjsEntry* ColStaffObjsIndex::find_entry_not_before(int instr, int staff,
+                                                            TimeUnits time,
+                                                            ColStaffObjsEntry* pStart)
+{
+    if (!is_valid_instrument(instr))
+        return nullptr;
+
+    Entries* pEntries = &m_instruments[instr];
+    if (staff >= 0)
+    {
+        if (staff >= int(m_staves[instr].size()))
+            return nullptr;
+        pEntries = &m_staves[instr][staff];
+    }
+
+    //entries are ordered by position and, therefore, by timepos. Both conditions
+    //are satisfied from the greatest of both lower bounds
+    Entries::iterator itTime =
+        std::partition_point(pEntries->begin(), pEntries->end(),
+            [time](ColStaffObjsEntry* pEntry) {
+                return is_greater_time(time, pEntry->time());
+            });
+
+    Entries::iterator it = itTime;
+    if (pStart)
+    {
+        int start = pStart->index();
+        Entries::iterator itStart =
+            std::partition_point(pEntries->begin(), pEntries->end(),
+                [start](ColStaffObjsEntry* pEntry) {
+                    return pEntry->index() < start;
+                });
+        it = max(itTime, itStart);
+    }
+
+    return (it != pEntries->end() ? *it : nullptr);
+}
+
+//---------------------------------------------------------------------------------------
+ColStaffObjsEntry* ColStaffObjsIndex::find_barline_before(int instr,
+                                                          ColStaffObjsEntry* pEntry)
+{
+    if (!is_valid_instrument(instr))
+        return nullptr;
+    return find_last_before(m_barlines[instr], pEntry);
+}
+
+//---------------------------------------------------------------------------------------
+ColStaffObjsEntry* ColStaffObjsIndex::find_time_signature_before(int instr,
+                                                                 ColStaffObjsEntry* pEntry)
+{
+    if (!is_valid_instrument(instr))
+        return nullptr;
+    return find_last_before(m_timeSignatures[instr], pEntry);
+}
+
+//---------------------------------------------------------------------------------------
+ColStaffObjsEntry* ColStaffObjsIndex::find_last_before(Entries& entries,
+                                                       ColStaffObjsEntry* pEntry)
+{
+    int index = pEntry->index();
+    Entries::iterator it =
+        std::partition_point(entries.begin(), entries.end(),
+            [index](ColStaffObjsEntry* pItem) {
+                return pItem->index() < index;
+            });
+
+    return (it != entries.begin() ? *(it - 1) : nullptr);
+}
+
+//---------------------------------------------------------------------------------------
+ColStaffObjsEntry* ColStaffObjsIndex::last_entry(int instr)
+{
+    if (!is_valid_instrument(instr) || m_instruments[instr].empty())
+        return nullptr;
+    return m_instruments[instr].back();
+}
+
+
+
 //=======================================================================================
 // ColStaffObjsBuilder implementation: algorithm to create a ColStaffObjs
 //=======================================================================================
@@ -34,6 +34,9 @@
 #include "lomse_presenter.h"
 #include "lomse_import_options.h"
 #include "lomse_graphic_view.h"
+#include "lomse_batch_renderer.h"
+#include "lomse_midi_file.h"
+#include "lomse_document_loader.h"
 
 #include "agg_basics.h"
 #include "agg_pixfmt_rgba.h"
@@ -109,6 +112,26 @@ Presenter* LomseDoorway::open_document(int viewType, LdpReader& reader,
     return builder.open_document(viewType, reader, reporter);
 }
 
+//---------------------------------------------------------------------------------------
+DocumentLoader* LomseDoorway::create_document_loader(int viewType,
+                                                     const string& filename,
+                                                     ostream& reporter)
+{
+    return LOMSE_NEW DocumentLoader(*m_pLibraryScope, viewType, filename, reporter);
+}
+
+//---------------------------------------------------------------------------------------
+BatchRenderer* LomseDoorway::create_batch_renderer()
+{
+    return LOMSE_NEW BatchRenderer(*m_pLibraryScope);
+}
+
+//---------------------------------------------------------------------------------------
+MidiFileRenderer* LomseDoorway::create_midi_file_renderer()
+{
+    return LOMSE_NEW MidiFileRenderer(*m_pLibraryScope);
+}
+
 //---------------------------------------------------------------------------------------
 void LomseDoorway::init_library(int pixel_format, int ppi, bool reverse_y_axis,
                                ostream& reporter)
@@ -199,6 +222,12 @@ ScorePlayer* LomseDoorway::create_score_player(MidiServerBase* pSoundServer)
     return Injector::inject_ScorePlayer(*m_pLibraryScope, pSoundServer);
 }
 
+//---------------------------------------------------------------------------------------
+void LomseDoorway::enable_events_thread(bool fValue)
+{
+    m_pLibraryScope->enable_events_thread(fValue);
+}
+
 //---------------------------------------------------------------------------------------
 void LomseDoorway::set_global_metronome_and_replace_local(Metronome* pMtr)
 {
@@ -29,24 +29,32 @@
 
 #include "lomse_events_dispatcher.h"
 
+#include <cassert>
+
 namespace lomse
 {
 
-//TODO: For now, direct invocation without enqueuing the event in the thread.
-#define LOMSE_DIRECT_INVOCATION     1       //1=do not use events thread
-
 //=======================================================================================
 // EventsDispatcher implementation
 //=======================================================================================
-EventsDispatcher::EventsDispatcher()
+EventsDispatcher::EventsDispatcher(bool fDirectInvocation)
     : m_pThread(nullptr)
     , m_fStopLoop(false)
+    , m_fDirectInvocation(fDirectInvocation)
+    , m_coalescing(k_coalesce_update_window)
 {
 }
 
 //---------------------------------------------------------------------------------------
 EventsDispatcher::~EventsDispatcher()
 {
+    //AWARE: the dispatcher can not be deleted from the events thread (i.e. by an event
+    //handler destroying the library), as the thread would continue running on a
+    //deleted object. Deleting a running thread aborts the program.
+    assert( !is_events_thread() );
+
+    stop_events_loop();
+    delete m_pThread;
 }
 
 //---------------------------------------------------------------------------------------
@@ -56,45 +64,136 @@ void EventsDispatcher::start_events_loop()
     //run_events_loop())
 
     //AWARE: this method is only intended to be invoked by Lomse, when the library is
-    //initialized. This method only returns when the stop_events_loop() method
+    //initialized. The thread only finishes when the stop_events_loop() method
     //is invoked.
 
-#if (LOMSE_DIRECT_INVOCATION == 0)
-    delete m_pThread;
+    if (m_fDirectInvocation || m_pThread)
+        return;
+
+    {
+        QueueLock lock(m_mutex);
+        m_fStopLoop = false;
+    }
     m_pThread = LOMSE_NEW EventsThread(&EventsDispatcher::thread_main, this);
-#endif
 }
 
 //---------------------------------------------------------------------------------------
 void EventsDispatcher::stop_events_loop()
 {
-    //stops the events dispatch loop
+    //stops the events dispatch loop and waits for the thread to finish. Pending events
+    //are discarded.
 
     //AWARE: this method is only intended to be run by Lomse, when the
     //Lomse LibraryScope object is destroyed.
 
-    m_fStopLoop = true;
+    {
+        QueueLock lock(m_mutex);
+        m_fStopLoop = true;
+        m_events.clear();
+    }
+    m_condition.notify_all();
+
+    //When invoked from an event handler, the events thread can not wait for itself.
+    //The stop is only requested: the loop finishes when the handler returns and the
+    //thread is joined when this method is invoked again from other thread.
+    if (is_events_thread())
+        return;
+
+    if (m_pThread)
+    {
+        if (m_pThread->joinable())
+            m_pThread->join();
+        delete m_pThread;
+        m_pThread = nullptr;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void EventsDispatcher::set_direct_invocation(bool fValue)
+{
+    //AWARE: this method is only intended to be invoked by Lomse, when the library is
+    //initialized, before posting any event
+
+    if (fValue == m_fDirectInvocation)
+        return;
+
+    if (fValue)
+    {
+        stop_events_loop();
+        m_fDirectInvocation = true;
+    }
+    else
+    {
+        m_fDirectInvocation = false;
+        start_events_loop();
+    }
+}
+
+//---------------------------------------------------------------------------------------
+bool EventsDispatcher::is_events_thread()
+{
+    return m_pThread && m_pThread->get_id() == std::this_thread::get_id();
 }
 
 //---------------------------------------------------------------------------------------
 void EventsDispatcher::thread_main()
 {
-#if (LOMSE_DIRECT_INVOCATION == 0)
     run_events_loop();
-#endif
 }
 
 //---------------------------------------------------------------------------------------
 void EventsDispatcher::post_event(Observer* pObserver, SpEventInfo pEvent)
 {
-#if (LOMSE_DIRECT_INVOCATION == 1)
-    pObserver->notify(pEvent);
-#else
+    if (m_fDirectInvocation)
+    {
+        pObserver->notify(pEvent);
+        return;
+    }
+
     {
         QueueLock lock(m_mutex);
-        m_events.push( make_pair(pEvent, pObserver));
+        if (coalesce_event(pObserver, pEvent))
+            return;
+        m_events.push_back( make_pair(pEvent, pObserver));
+    }
+    m_condition.notify_one();
+}
+
+//---------------------------------------------------------------------------------------
+bool EventsDispatcher::coalesce_event(Observer* pObserver, SpEventInfo pEvent)
+{
+    //Merges the event into an equivalent pending event, if the coalescing policy
+    //allows it. Returns true if the event has been merged and, therefore, must not
+    //be enqueued. Must be invoked with the queue locked.
+
+    if (m_coalescing != k_coalesce_update_window || !pEvent->is_update_window_event())
+        return false;
+
+    SpEventPaint pPaint( static_pointer_cast<EventPaint>(pEvent) );
+    WpInteractor wpIntor = pPaint->get_interactor();
+
+    EventsQueue::reverse_iterator it;
+    for (it = m_events.rbegin(); it != m_events.rend(); ++it)
+    {
+        if ((*it).second == pObserver && (*it).first->is_update_window_event())
+        {
+            SpEventPaint pPending( static_pointer_cast<EventPaint>((*it).first) );
+            WpInteractor wpPending = pPending->get_interactor();
+            if (!wpPending.owner_before(wpIntor) && !wpIntor.owner_before(wpPending))
+            {
+                pPending->merge( pPaint.get() );
+                return true;
+            }
+        }
     }
-#endif
+    return false;
+}
+
+//---------------------------------------------------------------------------------------
+size_t EventsDispatcher::num_pending_events()
+{
+    QueueLock lock(m_mutex);
+    return m_events.size();
 }
 
 //---------------------------------------------------------------------------------------
@@ -103,31 +202,33 @@ void EventsDispatcher::post_event(Observer* pObserver, SpEventInfo pEvent)
 
 void EventsDispatcher::run_events_loop()
 {
-    std::chrono::milliseconds waitTime(5);   //5ms
+    EventsQueue batch;
 
-    while (!stop_event_received())
+    while (true)
     {
-        if (pending_events())
-            dispatch_next_event();
-        else
-            std::this_thread::sleep_for(waitTime);
+        {
+            QueueLock lock(m_mutex);
+            m_condition.wait(lock, [this]{ return m_fStopLoop || !m_events.empty(); });
+            if (m_fStopLoop)
+                return;
+
+            batch.swap(m_events);
+        }
+
+        dispatch_events(batch);
+        batch.clear();
     }
 }
 
 //---------------------------------------------------------------------------------------
-void EventsDispatcher::dispatch_next_event()
+void EventsDispatcher::dispatch_events(EventsQueue& events)
 {
-    pair<SpEventInfo, Observer*> event;
-
+    EventsQueue::iterator it;
+    for (it = events.begin(); it != events.end(); ++it)
     {
-        QueueLock lock(m_mutex);
-        event = m_events.front();
-        m_events.pop();
+        Observer* pObserver = (*it).second;
+        pObserver->notify( (*it).first );
     }
-
-    SpEventInfo pEvent = event.first;
-    Observer* pObserver = event.second;
-    pObserver->notify(pEvent);
 }
 
 
@@ -0,0 +1,308 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2016. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include "lomse_forensic_log.h"
+
+#include <cstdio>
+#include <fstream>
+#include <set>
+
+namespace lomse
+{
+
+//default capacity of the ring of pending records, in bytes
+static const size_t k_default_capacity = 4 * 1024 * 1024;
+
+//---------------------------------------------------------------------------------------
+// Logs in asynchronous mode, for writing their pending records if the program crashes
+static std::mutex s_registryMutex;
+static std::set<ForensicLog*> s_asyncLogs;
+
+
+//=======================================================================================
+// ForensicLog implementation
+//=======================================================================================
+ForensicLog::ForensicLog(const string& path, int mode)
+    : m_path(path)
+    , m_mode(k_disabled)
+    , m_capacity(k_default_capacity)
+    , m_pThread(nullptr)
+    , m_pendingBytes(0)
+    , m_numLost(0)
+    , m_numLostReported(0)
+    , m_fStop(false)
+{
+    set_mode(mode);
+}
+
+//---------------------------------------------------------------------------------------
+ForensicLog::~ForensicLog()
+{
+    set_mode(k_disabled);
+}
+
+//---------------------------------------------------------------------------------------
+void ForensicLog::set_mode(int mode)
+{
+    //AWARE: mode must not be changed while other threads are writing records
+
+    if (mode == m_mode)
+        return;
+
+    if (m_mode == k_asynchronous)
+    {
+        stop_thread();
+        unregister_log(this);
+        write_pending_records();
+    }
+
+    m_mode = mode;
+
+    if (m_mode == k_asynchronous)
+    {
+        register_log(this);
+        start_thread();
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ForensicLog::set_capacity(size_t maxBytes)
+{
+    ForensicLogLock lock(m_mutex);
+    m_capacity = maxBytes;
+    discard_oldest_records();
+}
+
+//---------------------------------------------------------------------------------------
+void ForensicLog::write(const string& record)
+{
+    if (m_mode == k_synchronous)
+    {
+        ForensicLogLock lock(m_fileMutex);
+        ofstream file(m_path, std::ofstream::out | std::ofstream::app);
+        file << record;
+    }
+    else if (m_mode == k_asynchronous)
+    {
+        {
+            ForensicLogLock lock(m_mutex);
+            m_records.push_back(record);
+            m_pendingBytes += record.size();
+            discard_oldest_records();
+        }
+        m_condition.notify_one();
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ForensicLog::flush()
+{
+    write_pending_records();
+}
+
+//---------------------------------------------------------------------------------------
+void ForensicLog::clear()
+{
+    //discard pending records and truncate the log file
+
+    ForensicLogLock fileLock(m_fileMutex);
+    {
+        ForensicLogLock lock(m_mutex);
+        m_records.clear();
+        m_pendingBytes = 0;
+        m_numLostReported = m_numLost;
+    }
+    ofstream file(m_path, std::ofstream::out | std::ofstream::trunc);
+}
+
+//---------------------------------------------------------------------------------------
+size_t ForensicLog::num_pending_records()
+{
+    ForensicLogLock lock(m_mutex);
+    return m_records.size();
+}
+
+//---------------------------------------------------------------------------------------
+size_t ForensicLog::num_lost_records()
+{
+    ForensicLogLock lock(m_mutex);
+    return m_numLost;
+}
+
+//---------------------------------------------------------------------------------------
+void ForensicLog::discard_oldest_records()
+{
+    //Must be invoked with the queue locked. The most recent record is never discarded
+
+    while (m_pendingBytes > m_capacity && m_records.size() > 1)
+    {
+        m_pendingBytes -= m_records.front().size();
+        m_records.pop_front();
+        ++m_numLost;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ForensicLog::write_pending_records()
+{
+    //the file lock is acquired before taking the records, to ensure that batches
+    //are written in order
+
+    ForensicLogLock fileLock(m_fileMutex);
+    ForensicRecords records;
+    size_t numLost;
+    {
+        ForensicLogLock lock(m_mutex);
+        records.swap(m_records);
+        m_pendingBytes = 0;
+        numLost = m_numLost - m_numLostReported;
+        m_numLostReported = m_numLost;
+    }
+    write_records(records, numLost);
+}
+
+//---------------------------------------------------------------------------------------
+void ForensicLog::write_records(ForensicRecords& records, size_t numLost)
+{
+    if (records.empty() && numLost == 0)
+        return;
+
+    ofstream file(m_path, std::ofstream::out | std::ofstream::app);
+    if (numLost > 0)
+        file << "[ForensicLog] " << numLost << " records discarded. Ring full." << endl;
+
+    ForensicRecords::iterator it;
+    for (it = records.begin(); it != records.end(); ++it)
+        file << *it;
+}
+
+//---------------------------------------------------------------------------------------
+void ForensicLog::start_thread()
+{
+    {
+        ForensicLogLock lock(m_mutex);
+        m_fStop = false;
+    }
+    m_pThread = LOMSE_NEW ForensicLogThread(&ForensicLog::thread_main, this);
+}
+
+//---------------------------------------------------------------------------------------
+void ForensicLog::stop_thread()
+{
+    {
+        ForensicLogLock lock(m_mutex);
+        m_fStop = true;
+    }
+    m_condition.notify_all();
+
+    if (m_pThread)
+    {
+        if (m_pThread->joinable())
+            m_pThread->join();
+        delete m_pThread;
+        m_pThread = nullptr;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ForensicLog::thread_main()
+{
+    while (true)
+    {
+        {
+            ForensicLogLock lock(m_mutex);
+            m_condition.wait(lock, [this]{ return m_fStop || !m_records.empty(); });
+            if (m_fStop)
+                return;
+        }
+        write_pending_records();
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ForensicLog::flush_on_crash()
+{
+    //AWARE: invoked when the program is crashing. As program state could be corrupted,
+    //locks are not waited for and the C library is used for writing
+
+    if (!m_fileMutex.try_lock())
+        return;
+    if (!m_mutex.try_lock())
+    {
+        m_fileMutex.unlock();
+        return;
+    }
+
+    FILE* pFile = fopen(m_path.c_str(), "a");
+    if (pFile)
+    {
+        ForensicRecords::iterator it;
+        for (it = m_records.begin(); it != m_records.end(); ++it)
+            fwrite((*it).data(), 1, (*it).size(), pFile);
+        fclose(pFile);
+    }
+    m_records.clear();
+    m_pendingBytes = 0;
+
+    m_mutex.unlock();
+    m_fileMutex.unlock();
+}
+
+//---------------------------------------------------------------------------------------
+void ForensicLog::flush_all_on_crash()
+{
+    //Lomse does not install signal handlers. The application can invoke this method
+    //from its own crash handler.
+
+    if (!s_registryMutex.try_lock())
+        return;
+
+    std::set<ForensicLog*>::iterator it;
+    for (it = s_asyncLogs.begin(); it != s_asyncLogs.end(); ++it)
+        (*it)->flush_on_crash();
+
+    s_registryMutex.unlock();
+}
+
+//---------------------------------------------------------------------------------------
+void ForensicLog::register_log(ForensicLog* pLog)
+{
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    s_asyncLogs.insert(pLog);
+}
+
+//---------------------------------------------------------------------------------------
+void ForensicLog::unregister_log(ForensicLog* pLog)
+{
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    s_asyncLogs.erase(pLog);
+}
+
+
+}   //namespace lomse
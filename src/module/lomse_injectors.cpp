@@ -59,6 +59,7 @@
 #include "lomse_caret_positioner.h"
 #include "lomse_glyphs.h"
 #include "lomse_engraving_options.h"
+#include "lomse_forensic_log.h"
 
 #include <sstream>
 using namespace std;
@@ -79,12 +80,14 @@ LibraryScope::LibraryScope(ostream& reporter, LomseDoorway* pDoorway)
     , m_pFontSelector(nullptr)     //lazzy instantiation. Singleton scope.
     , m_pGlobalMetronome(nullptr)
     , m_pDispatcher(nullptr)
+    , m_pForensicLog(nullptr)      //lazzy instantiation. Singleton scope.
     , m_sMusicFontFile("Bravura.otf")
     , m_sMusicFontName("Bravura")
     , m_sMusicFontPath(LOMSE_FONTS_PATH)
     , m_sFontsPath(LOMSE_FONTS_PATH)
     , m_pMusicGlyphs(nullptr)      //lazzy instantiation. Singleton scope.
     , m_fReplaceLocalMetronome(false)
+    , m_fEventsThread(false)
     , m_importOptions()
     , m_fJustifySystems(true)
     , m_fDumpColumnTables(false)
@@ -121,6 +124,21 @@ LibraryScope::~LibraryScope()
         m_pDispatcher->stop_events_loop();
         delete m_pDispatcher;
     }
+    delete m_pForensicLog;
+}
+
+//---------------------------------------------------------------------------------------
+ForensicLog* LibraryScope::get_forensic_log()
+{
+    if (!m_pForensicLog)
+        m_pForensicLog = LOMSE_NEW ForensicLog();
+    return m_pForensicLog;
+}
+
+//---------------------------------------------------------------------------------------
+void LibraryScope::set_forensic_log_mode(int mode)
+{
+    get_forensic_log()->set_mode(mode);
 }
 
 //---------------------------------------------------------------------------------------
@@ -187,12 +205,20 @@ EventsDispatcher* LibraryScope::get_events_dispatcher()
 {
     if (!m_pDispatcher)
     {
-        m_pDispatcher = LOMSE_NEW EventsDispatcher();
+        m_pDispatcher = LOMSE_NEW EventsDispatcher(!m_fEventsThread);
         m_pDispatcher->start_events_loop();
     }
     return m_pDispatcher;
 }
 
+//---------------------------------------------------------------------------------------
+void LibraryScope::enable_events_thread(bool fValue)
+{
+    m_fEventsThread = fValue;
+    if (m_pDispatcher)
+        m_pDispatcher->set_direct_invocation(!fValue);
+}
+
 //---------------------------------------------------------------------------------------
 double LibraryScope::get_screen_ppi() const
 {
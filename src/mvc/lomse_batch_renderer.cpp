@@ -0,0 +1,244 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include "lomse_batch_renderer.h"
+
+#include "lomse_injectors.h"
+#include "lomse_presenter.h"
+#include "lomse_interactor.h"
+#include "lomse_graphic_view.h"
+#include "lomse_graphical_model.h"
+#include "lomse_gm_basic.h"
+#include "lomse_image_writer.h"
+#include "lomse_logger.h"
+
+#include <sstream>
+using namespace std;
+
+
+namespace lomse
+{
+
+//=======================================================================================
+// BatchRenderer implementation
+//=======================================================================================
+BatchRenderer::BatchRenderer(LibraryScope& libraryScope)
+    : m_libScope(libraryScope)
+    , m_pPresenter(nullptr)
+    , m_format( EPixelFormat(libraryScope.get_pixel_format()) )
+    , m_compressionLevel(-1)
+{
+}
+
+//---------------------------------------------------------------------------------------
+BatchRenderer::~BatchRenderer()
+{
+    close_document();
+}
+
+//---------------------------------------------------------------------------------------
+bool BatchRenderer::open_document(const string& filename, ostream& reporter)
+{
+    close_document();
+
+    PresenterBuilder builder(m_libScope);
+    m_pPresenter = builder.open_document(k_view_vertical_book, filename, reporter);
+    return m_pPresenter != nullptr;
+}
+
+//---------------------------------------------------------------------------------------
+bool BatchRenderer::new_document(const string& source, int format, ostream& reporter)
+{
+    close_document();
+
+    PresenterBuilder builder(m_libScope);
+    m_pPresenter = builder.new_document(k_view_vertical_book, source, reporter, format);
+    return m_pPresenter != nullptr;
+}
+
+//---------------------------------------------------------------------------------------
+void BatchRenderer::close_document()
+{
+    delete m_pPresenter;
+    m_pPresenter = nullptr;
+}
+
+//---------------------------------------------------------------------------------------
+int BatchRenderer::get_num_pages()
+{
+    if (!m_pPresenter)
+        return 0;
+
+    if (SpInteractor spInteractor = m_pPresenter->get_interactor(0).lock())
+        return spInteractor->get_num_pages();
+    return 0;
+}
+
+//---------------------------------------------------------------------------------------
+bool BatchRenderer::is_valid_page(int iPage)
+{
+    return iPage >= 0 && iPage < get_num_pages();
+}
+
+//---------------------------------------------------------------------------------------
+USize BatchRenderer::get_page_size(int iPage)
+{
+    if (!is_valid_page(iPage))
+        return USize(0.0f, 0.0f);
+
+    SpInteractor spInteractor = m_pPresenter->get_interactor(0).lock();
+    GraphicModel* pGModel = spInteractor->get_graphic_model();
+    return pGModel->get_page(iPage)->get_size();
+}
+
+//---------------------------------------------------------------------------------------
+VSize BatchRenderer::get_page_size_in_pixels(int iPage, double dpi)
+{
+    //pixels = size(mm) * resolution(dpi) / 25.4. LUnits are cents of millimeter
+    USize size = get_page_size(iPage);
+    double factor = dpi / 2540.0;
+    return VSize(Pixels(double(size.width) * factor + 0.5),
+                 Pixels(double(size.height) * factor + 0.5));
+}
+
+//---------------------------------------------------------------------------------------
+int BatchRenderer::bytes_per_pixel()
+{
+    switch (m_format)
+    {
+        case k_pix_format_rgb555:
+        case k_pix_format_rgb565:
+            return 2;
+        case k_pix_format_rgb24:
+        case k_pix_format_bgr24:
+            return 3;
+        default:
+            return 4;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+bool BatchRenderer::render_page(int iPage, double dpi, RenderingBuffer* pBitmap)
+{
+    if (!is_valid_page(iPage) || pBitmap == nullptr)
+        return false;
+
+    if (SpInteractor spInteractor = m_pPresenter->get_interactor(0).lock())
+    {
+        spInteractor->set_print_ppi(dpi);
+        spInteractor->set_print_buffer(pBitmap);
+        spInteractor->print_page(iPage);
+        spInteractor->set_print_buffer(nullptr);
+        return true;
+    }
+    return false;
+}
+
+//---------------------------------------------------------------------------------------
+RenderingBuffer* BatchRenderer::render_page(int iPage, double dpi)
+{
+    if (!is_valid_page(iPage))
+        return nullptr;
+
+    //determine bitmap size and grow the pool only when needed
+    VSize size = get_page_size_in_pixels(iPage, dpi);
+    if (size.width <= 0 || size.height <= 0)
+        return nullptr;
+
+    int stride = size.width * bytes_per_pixel();
+    size_t bytes = size_t(stride) * size_t(size.height);
+    if (m_pool.size() < bytes)
+        m_pool.resize(bytes);
+
+    m_rbuf.attach(&m_pool[0], unsigned(size.width), unsigned(size.height), stride);
+
+    if (render_page(iPage, dpi, &m_rbuf))
+        return &m_rbuf;
+    return nullptr;
+}
+
+//---------------------------------------------------------------------------------------
+bool BatchRenderer::render_page_to_png(int iPage, double dpi, ostream& out)
+{
+#if (LOMSE_ENABLE_PNG == 1)
+    PngImageEncoder encoder(m_compressionLevel);
+    if (!encoder.can_encode(m_format))
+    {
+        LOMSE_LOG_ERROR("Pixel format %d not supported by PNG encoder.", int(m_format));
+        return false;
+    }
+
+    RenderingBuffer* pBitmap = render_page(iPage, dpi);
+    if (!pBitmap)
+        return false;
+
+    return encoder.encode(*pBitmap, m_format, out);
+#else
+    LOMSE_LOG_ERROR("Lomse was built without PNG support.");
+    return false;
+#endif
+}
+
+//---------------------------------------------------------------------------------------
+bool BatchRenderer::render_page_to_png(int iPage, double dpi, const string& filename)
+{
+    //do not create the file when the page does not exist
+    if (!is_valid_page(iPage))
+        return false;
+
+    ofstream file(filename.c_str(), ios::out | ios::binary);
+    if (!file.good())
+    {
+        LOMSE_LOG_ERROR("Error opening file '%s' for writing.", filename.c_str());
+        return false;
+    }
+    return render_page_to_png(iPage, dpi, file);
+}
+
+//---------------------------------------------------------------------------------------
+int BatchRenderer::render_pages_to_png(const string& basename, double dpi,
+                                       int firstPage, int lastPage)
+{
+    int numPages = get_num_pages();
+    if (lastPage < 0 || lastPage >= numPages)
+        lastPage = numPages - 1;
+
+    int numSaved = 0;
+    for (int iPage = max(0, firstPage); iPage <= lastPage; ++iPage)
+    {
+        stringstream filename;
+        filename << basename << "-" << (iPage + 1) << ".png";
+        if (render_page_to_png(iPage, dpi, filename.str()))
+            ++numSaved;
+    }
+    return numSaved;
+}
+
+
+}   //namespace lomse
@@ -0,0 +1,196 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2016. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include "lomse_document_loader.h"
+
+#include "lomse_injectors.h"
+#include "lomse_document.h"
+#include "lomse_presenter.h"
+#include "lomse_logger.h"
+
+using namespace std;
+
+namespace lomse
+{
+
+//=======================================================================================
+// DocumentLoader implementation
+//=======================================================================================
+DocumentLoader::DocumentLoader(LibraryScope& libraryScope, int viewType,
+                               const string& filename, ostream& reporter)
+    : EventNotifier(libraryScope.get_events_dispatcher())
+    , Observable()
+    , CompilerMonitor()
+    , m_libScope(libraryScope)
+    , m_viewType(viewType)
+    , m_filename(filename)
+    , m_reporter(reporter)
+    , m_pThread(nullptr)
+    , m_fCancel(false)
+    , m_stage(EventLoad::k_stage_parsing)
+    , m_pDoc(nullptr)
+    , m_numErrors(0)
+{
+}
+
+//---------------------------------------------------------------------------------------
+DocumentLoader::~DocumentLoader()
+{
+    cancel();
+    terminate_thread();
+    delete m_pDoc;
+}
+
+//---------------------------------------------------------------------------------------
+void DocumentLoader::start()
+{
+    //Create the thread. It starts inmediately to load the document (method
+    //thread_main()) and finishes when the document is loaded
+
+    if (m_pThread)
+        return;
+
+    m_pThread = LOMSE_NEW std::thread(&DocumentLoader::thread_main, this);
+}
+
+//---------------------------------------------------------------------------------------
+void DocumentLoader::cancel()
+{
+    m_fCancel = true;
+}
+
+//---------------------------------------------------------------------------------------
+void DocumentLoader::wait()
+{
+    if (m_pThread && !is_loader_thread() && m_pThread->joinable())
+        m_pThread->join();
+}
+
+//---------------------------------------------------------------------------------------
+void DocumentLoader::terminate_thread()
+{
+    if (!m_pThread)
+        return;
+
+    //AWARE: an event handler, invoked from the loader thread, could delete the loader
+    if (is_loader_thread())
+        m_pThread->detach();
+    else if (m_pThread->joinable())
+        m_pThread->join();
+    delete m_pThread;
+    m_pThread = nullptr;
+}
+
+//---------------------------------------------------------------------------------------
+bool DocumentLoader::is_loader_thread()
+{
+    return m_pThread && m_pThread->get_id() == std::this_thread::get_id();
+}
+
+//---------------------------------------------------------------------------------------
+Presenter* DocumentLoader::get_presenter()
+{
+    Document* pDoc = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        pDoc = m_pDoc;
+        m_pDoc = nullptr;
+    }
+
+    if (pDoc == nullptr)
+        return nullptr;
+
+    return Injector::inject_Presenter(m_libScope, m_viewType, pDoc);
+}
+
+//---------------------------------------------------------------------------------------
+void DocumentLoader::notify_stage(EEventType type, int stage, int numErrors)
+{
+    m_stage = stage;
+    SpEventLoad pEvent( LOMSE_NEW EventLoad(type, this, stage, numErrors) );
+    notify_observers(pEvent, this);
+}
+
+//---------------------------------------------------------------------------------------
+// Methods to be executed in the loader thread
+//---------------------------------------------------------------------------------------
+
+bool DocumentLoader::on_compiler_stage(int stage)
+{
+    if (m_fCancel)
+        return false;
+
+    notify_stage(k_load_progress_event, stage);
+    return !m_fCancel;
+}
+
+//---------------------------------------------------------------------------------------
+void DocumentLoader::thread_main()
+{
+    if (!on_compiler_stage(EventLoad::k_stage_parsing))
+    {
+        notify_stage(k_load_end_event, EventLoad::k_stage_cancelled);
+        return;
+    }
+
+    Document* pDoc = Injector::inject_Document(m_libScope, m_reporter);
+    int numErrors = 0;
+    try
+    {
+        int format = PresenterBuilder::determine_format(m_filename);
+        numErrors = pDoc->from_file(m_filename, format, this);
+    }
+    catch (std::exception& e)
+    {
+        LOMSE_LOG_ERROR("Loading '%s' failed: %s", m_filename.c_str(), e.what());
+        delete pDoc;
+        notify_stage(k_load_end_event, EventLoad::k_stage_failed);
+        return;
+    }
+
+    if (m_fCancel)
+    {
+        delete pDoc;
+        notify_stage(k_load_end_event, EventLoad::k_stage_cancelled);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pDoc = pDoc;
+        m_numErrors = numErrors;
+    }
+
+    //AWARE: the loader could be deleted by the event handler. Nothing can be
+    //accessed after notifying the end event
+    notify_stage(k_load_end_event, EventLoad::k_stage_ready, numErrors);
+}
+
+
+}   //namespace lomse
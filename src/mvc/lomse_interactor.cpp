@@ -43,6 +43,7 @@
 #include "lomse_graphic_view.h"
 #include "lomse_events.h"
 #include "lomse_player_gui.h"
+#include "lomse_score_player.h"
 #include "lomse_document_cursor.h"
 #include "lomse_command.h"
 #include "lomse_logger.h"
@@ -54,6 +55,7 @@
 #include "lomse_score_algorithms.h"
 
 #include <sstream>
+#include <map>
 #include <chrono>
 using namespace std;
 
@@ -62,8 +64,8 @@ namespace lomse
 
 ptime::duration ptime::operator-(const ptime rhs)
 {
-    long long millis = chrono::duration_cast<chrono::milliseconds>(timepoint - rhs.timepoint).count();
-    return ptime::duration(millis);
+    //milliseconds, with sub-millisecond resolution
+    return chrono::duration<double, milli>(timepoint - rhs.timepoint).count();
 }
 
 //=======================================================================================
@@ -965,7 +967,10 @@ void Interactor::request_window_update()
 
     SpInteractor sp = get_shared_ptr_from_this();
     WpInteractor wpIntor(sp);
-    SpEventPaint pEvent( LOMSE_NEW EventPaint(wpIntor, get_damaged_rectangle()) );
+    //the View reports an empty rectangle when the whole buffer has to be updated
+    VRect damagedRect = get_damaged_rectangle();
+    SpEventPaint pEvent( LOMSE_NEW EventPaint(wpIntor, damagedRect,
+                                              damagedRect.is_empty()) );
     notify_observers(pEvent, this);
 }
 
@@ -1608,6 +1613,98 @@ void Interactor::on_visual_tracking(SpEventVisualTracking pEvent)
     }
 }
 
+//---------------------------------------------------------------------------------------
+bool Interactor::update_visual_tracking(ScorePlayer* pPlayer)
+{
+    //Drain the records stored by the playback thread and merge them: only the final
+    //state for each note/rest and the last tempo line position are relevant for the
+    //next frame. An end of tracking record cancels all previous records.
+
+    VisualTrackingRing* pRing = pPlayer->get_tracking_ring();
+    VisualTrackingRecord record;
+    ImoId scoreId = k_no_imoid;
+    bool fRemoveAll = false;
+    bool fMoveTempoLine = false;
+    TimeUnits timepos = 0.0;
+    vector< pair<ImoId, int> > highlight;       //id, last sub-event type
+    map<ImoId, size_t> index;                   //id -> index in highlight
+    bool fPending = false;
+    while (pRing->pop(record))
+    {
+        fPending = true;
+        scoreId = record.scoreId;
+        switch (record.type)
+        {
+            case EventVisualTracking::k_end_of_visual_tracking:
+                fRemoveAll = true;
+                fMoveTempoLine = false;
+                highlight.clear();
+                index.clear();
+                break;
+
+            case EventVisualTracking::k_highlight_on:
+            case EventVisualTracking::k_highlight_off:
+            {
+                map<ImoId, size_t>::iterator it = index.find(record.id);
+                if (it == index.end())
+                {
+                    index[record.id] = highlight.size();
+                    highlight.push_back( make_pair(record.id, record.type) );
+                }
+                else
+                    highlight[it->second].second = record.type;
+                break;
+            }
+
+            case EventVisualTracking::k_move_tempo_line:
+                fMoveTempoLine = true;
+                timepos = record.timepos;
+                break;
+
+            default:
+                LOMSE_LOG_ERROR("Unknown visual tracking record type %d", record.type);
+        }
+    }
+
+    if (!fPending)
+        return false;
+
+    GraphicView* pGView = dynamic_cast<GraphicView*>(m_pView);
+    if (!pGView)
+        return true;
+
+    if (SpDocument spDoc = m_wpDoc.lock())
+    {
+        if (discard_visual_tracking_event_if_not_valid(scoreId))
+            return true;
+
+        if (fRemoveAll)
+            pGView->remove_all_visual_tracking();
+
+        vector< pair<ImoId, int> >::iterator it;
+        for (it = highlight.begin(); it != highlight.end(); ++it)
+        {
+            //the note/rest could have been deleted after the record was stored
+            ImoStaffObj* pSO = static_cast<ImoStaffObj*>(
+                                    spDoc->get_pointer_to_imo((*it).first) );
+            if (pSO == nullptr)
+                continue;
+
+            if ((*it).second == EventVisualTracking::k_highlight_on)
+                pGView->highlight_object(pSO);
+            else
+                pGView->remove_highlight_from_object(pSO);
+        }
+
+        if (fMoveTempoLine)
+            pGView->move_tempo_line_and_change_viewport(scoreId, timepos);
+
+        pGView->draw_visual_tracking();
+        request_window_update();
+    }
+    return true;
+}
+
 //---------------------------------------------------------------------------------------
 void Interactor::on_end_of_play_event(ImoScore* pScore, PlayerGui* pPlayCtrl)
 {
@@ -2017,7 +2114,41 @@ void Interactor::set_drag_image(GmoShape* pShape, bool fGetOwnership, UPoint off
 //---------------------------------------------------------------------------------------
 void Interactor::exec_command(DocCommand* pCmd)
 {
-    m_pExec->execute(m_pCursor, pCmd, m_pSelections);
+    int result = m_pExec->execute(m_pCursor, pCmd, m_pSelections);
+
+    //the executer only keeps reversible commands successfully executed
+    if (result != k_success || !pCmd->is_reversible())
+        delete pCmd;
+
+    //when commands are grouped, views are updated only when the group is closed
+    if (m_pExec->is_transaction_open())
+        return;
+
+    update_caret_and_view();
+    send_update_UI_event(k_pointed_object_change);
+}
+
+//---------------------------------------------------------------------------------------
+void Interactor::begin_commands_group(const string& name)
+{
+    m_pExec->begin_transaction(m_pCursor, m_pSelections, name);
+}
+
+//---------------------------------------------------------------------------------------
+void Interactor::commit_commands_group()
+{
+    m_pExec->commit_transaction(m_pCursor, m_pSelections);
+    if (m_pExec->is_transaction_open())
+        return;
+
+    update_caret_and_view();
+    send_update_UI_event(k_pointed_object_change);
+}
+
+//---------------------------------------------------------------------------------------
+void Interactor::rollback_commands_group()
+{
+    m_pExec->rollback_transaction(m_pCursor, m_pSelections);
     update_caret_and_view();
     send_update_UI_event(k_pointed_object_change);
 }
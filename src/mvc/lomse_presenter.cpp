@@ -115,6 +115,12 @@ Presenter* PresenterBuilder::open_document(int viewType, const std::string& file
     return Injector::inject_Presenter(m_libScope, viewType, pDoc);
 }
 
+//---------------------------------------------------------------------------------------
+int PresenterBuilder::determine_format(const std::string& filename)
+{
+    return FileFormatFinder::determine_format(filename);
+}
+
 //---------------------------------------------------------------------------------------
 Presenter* PresenterBuilder::open_document(int viewType, LdpReader& reader,
                                            ostream& reporter)
@@ -36,6 +36,7 @@
 #include "lomse_injectors.h"
 #include "lomse_internal_model.h"
 #include "lomse_document.h"
+#include "lomse_events.h"
 
 
 using namespace std;
@@ -125,9 +126,23 @@ ImoDocument* LdpCompiler::compile_parsed_tree(LdpTree* tree)
     if (tree->get_root()->is_type(k_score))
         tree = wrap_score_in_lenmusdoc(tree);
 
+    if (!continue_with(EventLoad::k_stage_analysing))
+    {
+        delete tree->get_root();
+        return nullptr;
+    }
+
     ImoDocument* pRoot = dynamic_cast<ImoDocument*>(
                                 m_pLdpAnalyser->analyse_tree(tree, m_fileLocator));
-    m_pModelBuilder->build_model(pRoot);
+
+    if (!continue_with(EventLoad::k_stage_building_model))
+    {
+        delete pRoot;
+        pRoot = nullptr;
+    }
+    else
+        m_pModelBuilder->build_model(pRoot);
+
     delete tree->get_root();
     return pRoot;
 }
@@ -36,6 +36,7 @@
 #include "lomse_injectors.h"
 #include "lomse_internal_model.h"
 #include "lomse_document.h"
+#include "lomse_events.h"
 #include "lomse_file_system.h"
 
 #if (LOMSE_ENABLE_COMPRESSION == 1)
@@ -135,8 +136,17 @@ ImoDocument* LmdCompiler::create_with_empty_score()
 //---------------------------------------------------------------------------------------
 ImoDocument* LmdCompiler::compile_parsed_tree(XmlNode* root)
 {
+    if (!continue_with(EventLoad::k_stage_analysing))
+        return nullptr;
+
     ImoDocument* pDoc = dynamic_cast<ImoDocument*>(
                                 m_pLmdAnalyser->analyse_tree(root, m_fileLocator));
+    if (pDoc && !continue_with(EventLoad::k_stage_building_model))
+    {
+        delete pDoc;
+        return nullptr;
+    }
+
     if (pDoc)
         m_pModelBuilder->build_model(pDoc);
     return pDoc;
@@ -43,6 +43,7 @@ Compiler::Compiler(Parser* p, Analyser* a, ModelBuilder* mb, Document* pDoc)
     , m_pModelBuilder(mb)
     , m_pDoc(pDoc)
     , m_fileLocator("")
+    , m_pMonitor(nullptr)
 {
 }
 
@@ -60,5 +61,14 @@ int Compiler::get_num_errors()
     return m_pParser->get_num_errors();
 }
 
+//---------------------------------------------------------------------------------------
+bool Compiler::continue_with(int stage)
+{
+    //informs the monitor, if any, that a new stage starts. Returns false if the
+    //compilation must be aborted
+
+    return m_pMonitor == nullptr || m_pMonitor->on_compiler_stage(stage);
+}
+
 
 }  //namespace lomse
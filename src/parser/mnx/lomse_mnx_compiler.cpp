@@ -37,6 +37,7 @@
 #include "lomse_injectors.h"
 #include "lomse_internal_model.h"
 #include "lomse_document.h"
+#include "lomse_events.h"
 #include "lomse_file_system.h"
 #include "lomse_ldp_compiler.h"
 
@@ -123,8 +124,17 @@ ImoDocument* MnxCompiler::compile_string(const std::string& source)
 //---------------------------------------------------------------------------------------
 ImoDocument* MnxCompiler::compile_parsed_tree(XmlNode* root)
 {
+    if (!continue_with(EventLoad::k_stage_analysing))
+        return nullptr;
+
     ImoDocument* pDoc = dynamic_cast<ImoDocument*>(
                             m_pMnxAnalyser->analyse_tree(root, m_fileLocator));
+    if (pDoc && !continue_with(EventLoad::k_stage_building_model))
+    {
+        delete pDoc;
+        return nullptr;
+    }
+
     if (pDoc)
         m_pModelBuilder->build_model(pDoc);
     return pDoc;
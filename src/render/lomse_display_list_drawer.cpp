@@ -0,0 +1,898 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include "lomse_display_list_drawer.h"
+
+#include "lomse_graphical_model.h"
+#include "lomse_gm_basic.h"
+#include "lomse_logger.h"
+#include "agg_basics.h"         //is_stop
+
+
+namespace lomse
+{
+
+//=======================================================================================
+// RecordedPath: a VertexSource for replaying a path recorded in a DisplayList
+//=======================================================================================
+class RecordedPath : public VertexSource
+{
+protected:
+    const double* m_pFirst;
+    size_t m_numVertices;
+    size_t m_iNext;
+
+public:
+    RecordedPath(const double* pFirst, size_t numVertices)
+        : VertexSource()
+        , m_pFirst(pFirst)
+        , m_numVertices(numVertices)
+        , m_iNext(0)
+    {
+    }
+    virtual ~RecordedPath() {}
+
+    //VertexSource
+    void rewind(int UNUSED(pathId) = 0) override { m_iNext = 0; }
+
+    unsigned vertex(double* px, double* py) override
+    {
+        if (m_iNext >= m_numVertices)
+            return agg::path_cmd_stop;
+
+        const double* pVertex = m_pFirst + 3 * m_iNext;
+        ++m_iNext;
+        *px = *(pVertex + 1);
+        *py = *(pVertex + 2);
+        return static_cast<unsigned>(*pVertex);
+    }
+};
+
+
+//=======================================================================================
+// DisplayList implementation
+//=======================================================================================
+void DisplayList::clear()
+{
+    m_ops.clear();
+    m_args.clear();
+    m_strings.clear();
+    m_wstrings.clear();
+    m_bitmaps.clear();
+}
+
+//---------------------------------------------------------------------------------------
+size_t DisplayList::get_memory_size() const
+{
+    size_t size = m_ops.capacity() * sizeof(unsigned char)
+                  + m_args.capacity() * sizeof(double)
+                  + m_bitmaps.capacity() * sizeof(RenderingBuffer);
+
+    for (const string& str : m_strings)
+        size += sizeof(string) + str.capacity();
+    for (const wstring& str : m_wstrings)
+        size += sizeof(wstring) + str.capacity() * sizeof(wchar_t);
+
+    return size;
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayList::add_color(Color color)
+{
+    m_args.push_back( double( (unsigned(color.r) << 24) | (unsigned(color.g) << 16)
+                              | (unsigned(color.b) << 8) | unsigned(color.a) ) );
+}
+
+//---------------------------------------------------------------------------------------
+size_t DisplayList::add_string(const std::string& str)
+{
+    m_strings.push_back(str);
+    return m_strings.size() - 1;
+}
+
+//---------------------------------------------------------------------------------------
+size_t DisplayList::add_wstring(const std::wstring& str)
+{
+    m_wstrings.push_back(str);
+    return m_wstrings.size() - 1;
+}
+
+//---------------------------------------------------------------------------------------
+size_t DisplayList::add_bitmap(RenderingBuffer& bmap)
+{
+    m_bitmaps.push_back(bmap);
+    return m_bitmaps.size() - 1;
+}
+
+//---------------------------------------------------------------------------------------
+static inline Color to_color(double value)
+{
+    unsigned rgba = static_cast<unsigned>(value);
+    return Color((rgba >> 24) & 0xFF, (rgba >> 16) & 0xFF, (rgba >> 8) & 0xFF,
+                 rgba & 0xFF);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayList::replay(Drawer* pDrawer, UPoint origin)
+{
+    const double* a = m_args.data();
+    vector<UPoint> points;
+
+    pDrawer->set_shift(-origin.x, -origin.y);
+
+    for (unsigned char op : m_ops)
+    {
+        switch (op)
+        {
+            case k_op_begin_path:       pDrawer->begin_path();              break;
+            case k_op_end_path:         pDrawer->end_path();                break;
+            case k_op_close_subpath:    pDrawer->close_subpath();           break;
+            case k_op_move_to:          pDrawer->move_to(a[0], a[1]);       a += 2; break;
+            case k_op_move_to_rel:      pDrawer->move_to_rel(a[0], a[1]);   a += 2; break;
+            case k_op_line_to:          pDrawer->line_to(a[0], a[1]);       a += 2; break;
+            case k_op_line_to_rel:      pDrawer->line_to_rel(a[0], a[1]);   a += 2; break;
+            case k_op_hline_to:         pDrawer->hline_to(a[0]);            a += 1; break;
+            case k_op_hline_to_rel:     pDrawer->hline_to_rel(a[0]);        a += 1; break;
+            case k_op_vline_to:         pDrawer->vline_to(a[0]);            a += 1; break;
+            case k_op_vline_to_rel:     pDrawer->vline_to_rel(a[0]);        a += 1; break;
+
+            case k_op_cubic_bezier:
+                pDrawer->cubic_bezier(a[0], a[1], a[2], a[3]);
+                a += 4;
+                break;
+            case k_op_cubic_bezier_rel:
+                pDrawer->cubic_bezier_rel(a[0], a[1], a[2], a[3]);
+                a += 4;
+                break;
+            case k_op_cubic_bezier_short:
+                pDrawer->cubic_bezier(a[0], a[1]);
+                a += 2;
+                break;
+            case k_op_cubic_bezier_short_rel:
+                pDrawer->cubic_bezier_rel(a[0], a[1]);
+                a += 2;
+                break;
+            case k_op_quadratic_bezier:
+                pDrawer->quadratic_bezier(a[0], a[1], a[2], a[3], a[4], a[5]);
+                a += 6;
+                break;
+            case k_op_quadratic_bezier_rel:
+                pDrawer->quadratic_bezier_rel(a[0], a[1], a[2], a[3], a[4], a[5]);
+                a += 6;
+                break;
+            case k_op_quadratic_bezier_short:
+                pDrawer->quadratic_bezier(a[0], a[1], a[2], a[3]);
+                a += 4;
+                break;
+            case k_op_quadratic_bezier_short_rel:
+                pDrawer->quadratic_bezier_rel(a[0], a[1], a[2], a[3]);
+                a += 4;
+                break;
+
+            case k_op_rect:
+                pDrawer->rect(UPoint(LUnits(a[0]), LUnits(a[1])),
+                              USize(LUnits(a[2]), LUnits(a[3])), LUnits(a[4]));
+                a += 5;
+                break;
+            case k_op_circle:
+                pDrawer->circle(LUnits(a[0]), LUnits(a[1]), LUnits(a[2]));
+                a += 3;
+                break;
+            case k_op_line:
+                pDrawer->line(LUnits(a[0]), LUnits(a[1]), LUnits(a[2]), LUnits(a[3]),
+                              LUnits(a[4]), static_cast<ELineEdge>(int(a[5])));
+                a += 6;
+                break;
+            case k_op_polygon:
+            {
+                int n = int(a[0]);
+                ++a;
+                points.resize(size_t(n));
+                for (int i=0; i < n; ++i, a += 2)
+                    points[size_t(i)] = UPoint(LUnits(a[0]), LUnits(a[1]));
+                pDrawer->polygon(n, points.data());
+                break;
+            }
+            case k_op_add_path:
+            {
+                unsigned pathId = unsigned(a[0]);
+                bool fSolid = (a[1] != 0.0);
+                size_t numVertices = size_t(a[2]);
+                a += 3;
+                RecordedPath path(a, numVertices);
+                pDrawer->add_path(path, pathId, fSolid);
+                a += 3 * numVertices;
+                break;
+            }
+
+            case k_op_select_font:
+            case k_op_select_raster_font:
+            case k_op_select_vector_font:
+            {
+                const string& language = m_strings[size_t(a[0])];
+                const string& fontFile = m_strings[size_t(a[1])];
+                const string& fontName = m_strings[size_t(a[2])];
+                bool fBold = (a[4] != 0.0);
+                bool fItalic = (a[5] != 0.0);
+                if (op == k_op_select_font)
+                    pDrawer->select_font(language, fontFile, fontName, a[3], fBold, fItalic);
+                else if (op == k_op_select_raster_font)
+                    pDrawer->select_raster_font(language, fontFile, fontName, a[3],
+                                                fBold, fItalic);
+                else
+                    pDrawer->select_vector_font(language, fontFile, fontName, a[3],
+                                                fBold, fItalic);
+                a += 6;
+                break;
+            }
+            case k_op_set_text_color:
+                pDrawer->set_text_color( to_color(a[0]) );
+                a += 1;
+                break;
+            case k_op_draw_text:
+                pDrawer->draw_text(a[0], a[1], m_strings[size_t(a[2])]);
+                a += 3;
+                break;
+            case k_op_draw_wtext:
+                pDrawer->draw_text(a[0], a[1], m_wstrings[size_t(a[2])]);
+                a += 3;
+                break;
+            case k_op_draw_glyph:
+                pDrawer->draw_glyph(a[0], a[1], unsigned(a[2]));
+                a += 3;
+                break;
+
+            case k_op_copy_bitmap:
+                pDrawer->copy_bitmap(m_bitmaps[size_t(a[0])],
+                                     UPoint(LUnits(a[1]), LUnits(a[2])));
+                a += 3;
+                break;
+            case k_op_copy_bitmap_area:
+                pDrawer->copy_bitmap(m_bitmaps[size_t(a[0])],
+                                     Pixels(a[1]), Pixels(a[2]), Pixels(a[3]), Pixels(a[4]),
+                                     UPoint(LUnits(a[5]), LUnits(a[6])));
+                a += 7;
+                break;
+            case k_op_draw_bitmap:
+                pDrawer->draw_bitmap(m_bitmaps[size_t(a[0])], a[1] != 0.0,
+                                     Pixels(a[2]), Pixels(a[3]), Pixels(a[4]), Pixels(a[5]),
+                                     LUnits(a[6]), LUnits(a[7]), LUnits(a[8]), LUnits(a[9]),
+                                     static_cast<EResamplingQuality>(int(a[10])),
+                                     a[11]);
+                a += 12;
+                break;
+
+            case k_op_line_with_markers:
+                pDrawer->line_with_markers(UPoint(LUnits(a[0]), LUnits(a[1])),
+                                           UPoint(LUnits(a[2]), LUnits(a[3])),
+                                           LUnits(a[4]),
+                                           static_cast<ELineCap>(int(a[5])),
+                                           static_cast<ELineCap>(int(a[6])) );
+                a += 7;
+                break;
+
+            case k_op_fill:             pDrawer->fill( to_color(a[0]) );      a += 1; break;
+            case k_op_stroke:           pDrawer->stroke( to_color(a[0]) );    a += 1; break;
+            case k_op_even_odd:         pDrawer->even_odd(a[0] != 0.0);       a += 1; break;
+            case k_op_stroke_width:     pDrawer->stroke_width(a[0]);          a += 1; break;
+            case k_op_fill_none:        pDrawer->fill_none();                 break;
+            case k_op_stroke_none:      pDrawer->stroke_none();               break;
+            case k_op_fill_opacity:     pDrawer->fill_opacity(unsigned(a[0])); a += 1; break;
+            case k_op_stroke_opacity:   pDrawer->stroke_opacity(unsigned(a[0])); a += 1; break;
+            case k_op_line_join:
+                pDrawer->line_join( static_cast<line_join_e>(int(a[0])) );
+                a += 1;
+                break;
+            case k_op_line_cap:
+                pDrawer->line_cap( static_cast<line_cap_e>(int(a[0])) );
+                a += 1;
+                break;
+            case k_op_miter_limit:      pDrawer->miter_limit(a[0]);           a += 1; break;
+            case k_op_fill_linear_gradient:
+                pDrawer->fill_linear_gradient(LUnits(a[0]), LUnits(a[1]),
+                                              LUnits(a[2]), LUnits(a[3]));
+                a += 4;
+                break;
+            case k_op_gradient_color2:
+                pDrawer->gradient_color(to_color(a[0]), to_color(a[1]), a[2], a[3]);
+                a += 4;
+                break;
+            case k_op_gradient_color:
+                pDrawer->gradient_color(to_color(a[0]), a[1], a[2]);
+                a += 3;
+                break;
+
+            case k_op_set_shift:
+                pDrawer->set_shift(LUnits(a[0]), LUnits(a[1]));
+                a += 2;
+                break;
+            case k_op_remove_shift:     pDrawer->remove_shift();              break;
+            case k_op_render:           pDrawer->render();                    break;
+
+            default:
+                LOMSE_LOG_ERROR("Invalid opcode %d in display list.", int(op));
+                return;
+        }
+    }
+
+    pDrawer->render();
+    pDrawer->remove_shift();
+}
+
+
+//=======================================================================================
+// DisplayListDrawer implementation
+//=======================================================================================
+DisplayListDrawer::DisplayListDrawer(LibraryScope& libraryScope)
+    : Drawer(libraryScope)
+    , m_pList(nullptr)
+{
+}
+
+//---------------------------------------------------------------------------------------
+DisplayList* DisplayListDrawer::record_page(GraphicModel* pGModel, int iPage,
+                                            RenderOptions& opt)
+{
+    DisplayList* pList = LOMSE_NEW DisplayList();
+    start_recording(pList);
+    pGModel->get_page(iPage)->on_draw(this, opt);
+    stop_recording();
+    return pList;
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::record(DisplayList::EOpcode op)
+{
+    if (m_pList)
+        m_pList->add_op(op);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::record(DisplayList::EOpcode op, double a1)
+{
+    if (m_pList)
+    {
+        m_pList->add_op(op);
+        m_pList->add_arg(a1);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::record(DisplayList::EOpcode op, double a1, double a2)
+{
+    if (m_pList)
+    {
+        m_pList->add_op(op);
+        m_pList->add_arg(a1);
+        m_pList->add_arg(a2);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::record(DisplayList::EOpcode op, double a1, double a2,
+                               double a3, double a4)
+{
+    if (m_pList)
+    {
+        m_pList->add_op(op);
+        m_pList->add_arg(a1);
+        m_pList->add_arg(a2);
+        m_pList->add_arg(a3);
+        m_pList->add_arg(a4);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::record(DisplayList::EOpcode op, double a1, double a2,
+                               double a3, double a4, double a5, double a6)
+{
+    if (m_pList)
+    {
+        m_pList->add_op(op);
+        m_pList->add_arg(a1);
+        m_pList->add_arg(a2);
+        m_pList->add_arg(a3);
+        m_pList->add_arg(a4);
+        m_pList->add_arg(a5);
+        m_pList->add_arg(a6);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::begin_path()
+{
+    record(DisplayList::k_op_begin_path);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::end_path()
+{
+    record(DisplayList::k_op_end_path);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::close_subpath()
+{
+    record(DisplayList::k_op_close_subpath);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::move_to(double x, double y)
+{
+    record(DisplayList::k_op_move_to, x, y);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::move_to_rel(double x, double y)
+{
+    record(DisplayList::k_op_move_to_rel, x, y);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::line_to(double x,  double y)
+{
+    record(DisplayList::k_op_line_to, x, y);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::line_to_rel(double x,  double y)
+{
+    record(DisplayList::k_op_line_to_rel, x, y);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::hline_to(double x)
+{
+    record(DisplayList::k_op_hline_to, x);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::hline_to_rel(double x)
+{
+    record(DisplayList::k_op_hline_to_rel, x);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::vline_to(double y)
+{
+    record(DisplayList::k_op_vline_to, y);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::vline_to_rel(double y)
+{
+    record(DisplayList::k_op_vline_to_rel, y);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::cubic_bezier(double x1, double y1, double x, double y)
+{
+    record(DisplayList::k_op_cubic_bezier, x1, y1, x, y);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::cubic_bezier_rel(double x1, double y1, double x, double y)
+{
+    record(DisplayList::k_op_cubic_bezier_rel, x1, y1, x, y);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::cubic_bezier(double x, double y)
+{
+    record(DisplayList::k_op_cubic_bezier_short, x, y);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::cubic_bezier_rel(double x, double y)
+{
+    record(DisplayList::k_op_cubic_bezier_short_rel, x, y);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::quadratic_bezier(double x1, double y1, double x2, double y2,
+                                         double x, double y)
+{
+    record(DisplayList::k_op_quadratic_bezier, x1, y1, x2, y2, x, y);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::quadratic_bezier_rel(double x1, double y1, double x2, double y2,
+                                             double x, double y)
+{
+    record(DisplayList::k_op_quadratic_bezier_rel, x1, y1, x2, y2, x, y);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::quadratic_bezier(double x2, double y2, double x, double y)
+{
+    record(DisplayList::k_op_quadratic_bezier_short, x2, y2, x, y);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::quadratic_bezier_rel(double x2, double y2, double x, double y)
+{
+    record(DisplayList::k_op_quadratic_bezier_short_rel, x2, y2, x, y);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::rect(UPoint pos, USize size, LUnits radius)
+{
+    if (m_pList)
+    {
+        record(DisplayList::k_op_rect, pos.x, pos.y, size.width, size.height);
+        m_pList->add_arg(radius);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::circle(LUnits xCenter, LUnits yCenter, LUnits radius)
+{
+    if (m_pList)
+    {
+        record(DisplayList::k_op_circle, xCenter, yCenter);
+        m_pList->add_arg(radius);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::line(LUnits x1, LUnits y1, LUnits x2, LUnits y2,
+                             LUnits width, ELineEdge nEdge)
+{
+    record(DisplayList::k_op_line, x1, y1, x2, y2, width, double(nEdge));
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::polygon(int n, UPoint points[])
+{
+    if (m_pList)
+    {
+        record(DisplayList::k_op_polygon, double(n));
+        for (int i=0; i < n; ++i)
+        {
+            m_pList->add_arg(points[i].x);
+            m_pList->add_arg(points[i].y);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::add_path(VertexSource& vs, unsigned path_id, bool solid_path)
+{
+    //The vertex source is usually the shape itself, and its vertices are computed
+    //on the fly. Therefore, vertices must be flattened and stored in the list.
+    if (!m_pList)
+        return;
+
+    m_pList->add_op(DisplayList::k_op_add_path);
+    m_pList->add_arg(double(path_id));
+    m_pList->add_arg(solid_path ? 1.0 : 0.0);
+    size_t iCount = m_pList->m_args.size();
+    m_pList->add_arg(0.0);      //placeholder for number of vertices
+
+    size_t numVertices = 0;
+    double x, y;
+    unsigned cmd;
+    vs.rewind(path_id);
+    while(!agg::is_stop(cmd = vs.vertex(&x, &y)))
+    {
+        m_pList->add_arg(double(cmd));
+        m_pList->add_arg(x);
+        m_pList->add_arg(y);
+        ++numVertices;
+    }
+    m_pList->m_args[iCount] = double(numVertices);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::record_font(DisplayList::EOpcode op, const std::string& language,
+                                    const std::string& fontFile,
+                                    const std::string& fontName, double height,
+                                    bool fBold, bool fItalic)
+{
+    if (m_pList)
+    {
+        record(op, double(m_pList->add_string(language)),
+               double(m_pList->add_string(fontFile)),
+               double(m_pList->add_string(fontName)),
+               height, fBold ? 1.0 : 0.0, fItalic ? 1.0 : 0.0);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+bool DisplayListDrawer::select_font(const std::string& language,
+                                    const std::string& fontFile,
+                                    const std::string& fontName, double height,
+                                    bool fBold, bool fItalic)
+{
+    record_font(DisplayList::k_op_select_font, language, fontFile, fontName, height,
+                fBold, fItalic);
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+bool DisplayListDrawer::select_raster_font(const std::string& language,
+                                           const std::string& fontFile,
+                                           const std::string& fontName, double height,
+                                           bool fBold, bool fItalic)
+{
+    record_font(DisplayList::k_op_select_raster_font, language, fontFile, fontName,
+                height, fBold, fItalic);
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+bool DisplayListDrawer::select_vector_font(const std::string& language,
+                                           const std::string& fontFile,
+                                           const std::string& fontName, double height,
+                                           bool fBold, bool fItalic)
+{
+    record_font(DisplayList::k_op_select_vector_font, language, fontFile, fontName,
+                height, fBold, fItalic);
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::set_text_color(Color color)
+{
+    Drawer::set_text_color(color);
+    if (m_pList)
+    {
+        m_pList->add_op(DisplayList::k_op_set_text_color);
+        m_pList->add_color(color);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+int DisplayListDrawer::draw_text(double x, double y, const std::string& str)
+{
+    if (m_pList)
+    {
+        m_pList->add_op(DisplayList::k_op_draw_text);
+        m_pList->add_arg(x);
+        m_pList->add_arg(y);
+        m_pList->add_arg(double(m_pList->add_string(str)));
+    }
+    return int(str.length());
+}
+
+//---------------------------------------------------------------------------------------
+int DisplayListDrawer::draw_text(double x, double y, const wstring& str)
+{
+    if (m_pList)
+    {
+        m_pList->add_op(DisplayList::k_op_draw_wtext);
+        m_pList->add_arg(x);
+        m_pList->add_arg(y);
+        m_pList->add_arg(double(m_pList->add_wstring(str)));
+    }
+    return int(str.length());
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::draw_glyph(double x, double y, unsigned int ch)
+{
+    if (m_pList)
+    {
+        record(DisplayList::k_op_draw_glyph, x, y);
+        m_pList->add_arg(double(ch));
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::copy_bitmap(RenderingBuffer& img, UPoint pos)
+{
+    if (m_pList)
+    {
+        m_pList->add_op(DisplayList::k_op_copy_bitmap);
+        m_pList->add_arg(double(m_pList->add_bitmap(img)));
+        m_pList->add_arg(pos.x);
+        m_pList->add_arg(pos.y);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::copy_bitmap(RenderingBuffer& bmap,
+                                    Pixels srcX1, Pixels srcY1, Pixels srcX2, Pixels srcY2,
+                                    UPoint dest)
+{
+    if (m_pList)
+    {
+        m_pList->add_op(DisplayList::k_op_copy_bitmap_area);
+        m_pList->add_arg(double(m_pList->add_bitmap(bmap)));
+        m_pList->add_arg(srcX1);
+        m_pList->add_arg(srcY1);
+        m_pList->add_arg(srcX2);
+        m_pList->add_arg(srcY2);
+        m_pList->add_arg(dest.x);
+        m_pList->add_arg(dest.y);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::draw_bitmap(RenderingBuffer& bmap, bool hasAlpha,
+                                    Pixels srcX1, Pixels srcY1, Pixels srcX2, Pixels srcY2,
+                                    LUnits dstX1, LUnits dstY1, LUnits dstX2, LUnits dstY2,
+                                    EResamplingQuality resamplingMode,
+                                    double alpha)
+{
+    if (m_pList)
+    {
+        m_pList->add_op(DisplayList::k_op_draw_bitmap);
+        m_pList->add_arg(double(m_pList->add_bitmap(bmap)));
+        m_pList->add_arg(hasAlpha ? 1.0 : 0.0);
+        m_pList->add_arg(srcX1);
+        m_pList->add_arg(srcY1);
+        m_pList->add_arg(srcX2);
+        m_pList->add_arg(srcY2);
+        m_pList->add_arg(dstX1);
+        m_pList->add_arg(dstY1);
+        m_pList->add_arg(dstX2);
+        m_pList->add_arg(dstY2);
+        m_pList->add_arg(double(resamplingMode));
+        m_pList->add_arg(alpha);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::line_with_markers(UPoint start, UPoint end, LUnits width,
+                                          ELineCap startCap, ELineCap endCap)
+{
+    if (m_pList)
+    {
+        record(DisplayList::k_op_line_with_markers, start.x, start.y, end.x, end.y,
+               width, double(startCap));
+        m_pList->add_arg(double(endCap));
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::fill(Color color)
+{
+    if (m_pList)
+    {
+        m_pList->add_op(DisplayList::k_op_fill);
+        m_pList->add_color(color);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::stroke(Color color)
+{
+    if (m_pList)
+    {
+        m_pList->add_op(DisplayList::k_op_stroke);
+        m_pList->add_color(color);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::even_odd(bool flag)
+{
+    record(DisplayList::k_op_even_odd, flag ? 1.0 : 0.0);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::stroke_width(double w)
+{
+    record(DisplayList::k_op_stroke_width, w);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::fill_none()
+{
+    record(DisplayList::k_op_fill_none);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::stroke_none()
+{
+    record(DisplayList::k_op_stroke_none);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::fill_opacity(unsigned op)
+{
+    record(DisplayList::k_op_fill_opacity, double(op));
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::stroke_opacity(unsigned op)
+{
+    record(DisplayList::k_op_stroke_opacity, double(op));
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::line_join(line_join_e join)
+{
+    record(DisplayList::k_op_line_join, double(join));
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::line_cap(line_cap_e cap)
+{
+    record(DisplayList::k_op_line_cap, double(cap));
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::miter_limit(double ml)
+{
+    record(DisplayList::k_op_miter_limit, ml);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::fill_linear_gradient(LUnits x1, LUnits y1, LUnits x2, LUnits y2)
+{
+    record(DisplayList::k_op_fill_linear_gradient, x1, y1, x2, y2);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::gradient_color(Color c1, Color c2, double start, double stop)
+{
+    if (m_pList)
+    {
+        m_pList->add_op(DisplayList::k_op_gradient_color2);
+        m_pList->add_color(c1);
+        m_pList->add_color(c2);
+        m_pList->add_arg(start);
+        m_pList->add_arg(stop);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::gradient_color(Color c1, double start, double stop)
+{
+    if (m_pList)
+    {
+        m_pList->add_op(DisplayList::k_op_gradient_color);
+        m_pList->add_color(c1);
+        m_pList->add_arg(start);
+        m_pList->add_arg(stop);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::set_shift(LUnits x, LUnits y)
+{
+    record(DisplayList::k_op_set_shift, x, y);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::remove_shift()
+{
+    record(DisplayList::k_op_remove_shift);
+}
+
+//---------------------------------------------------------------------------------------
+void DisplayListDrawer::render()
+{
+    record(DisplayList::k_op_render);
+}
+
+
+}   //namespace lomse
@@ -0,0 +1,254 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include "lomse_midi_file.h"
+
+#include "lomse_injectors.h"
+#include "lomse_internal_model.h"
+#include "lomse_logger.h"
+
+#include <fstream>
+#include <sstream>
+using namespace std;
+
+
+namespace lomse
+{
+
+//=======================================================================================
+// MidiRecorder implementation
+//=======================================================================================
+MidiRecorder::MidiRecorder()
+    : MidiServerBase()
+    , m_pPlayer(nullptr)
+    , m_usedChannels(0)
+{
+}
+
+//---------------------------------------------------------------------------------------
+void MidiRecorder::clear()
+{
+    m_messages.clear();
+    m_usedChannels = 0;
+}
+
+//---------------------------------------------------------------------------------------
+void MidiRecorder::add_message(int type, int channel, int data1, int data2)
+{
+    long time = (m_pPlayer ? m_pPlayer->get_playback_time() : 0L);
+    channel &= 0x0F;
+    m_messages.push_back( MidiMessage(time, type | channel, data1 & 0x7F, data2 & 0x7F) );
+    m_usedChannels |= (1u << channel);
+}
+
+//---------------------------------------------------------------------------------------
+void MidiRecorder::program_change(int channel, int instr)
+{
+    add_message(MidiMessage::k_program_change, channel, instr, 0);
+}
+
+//---------------------------------------------------------------------------------------
+void MidiRecorder::voice_change(int channel, int instr)
+{
+    add_message(MidiMessage::k_program_change, channel, instr, 0);
+}
+
+//---------------------------------------------------------------------------------------
+void MidiRecorder::note_on(int channel, int pitch, int volume)
+{
+    add_message(MidiMessage::k_note_on, channel, pitch, volume);
+}
+
+//---------------------------------------------------------------------------------------
+void MidiRecorder::note_off(int channel, int pitch, int volume)
+{
+    add_message(MidiMessage::k_note_off, channel, pitch, volume);
+}
+
+//---------------------------------------------------------------------------------------
+void MidiRecorder::all_sounds_off()
+{
+    //Control Change 120 (All Sound Off) for each used channel
+    unsigned used = m_usedChannels;
+    for (int channel=0; channel < 16; ++channel)
+    {
+        if (used & (1u << channel))
+            add_message(MidiMessage::k_control_change, channel, 120, 0);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+static void write_number(string& data, unsigned value, int numBytes)
+{
+    //big endian
+    for (int i=numBytes-1; i >= 0; --i)
+        data.push_back( char((value >> (8*i)) & 0xFF) );
+}
+
+//---------------------------------------------------------------------------------------
+static void write_variable_length(string& data, unsigned long value)
+{
+    //7 bits per byte, most significant first. All bytes but the last one have
+    //bit 7 set
+    unsigned char bytes[5];
+    int n = 0;
+    do
+    {
+        bytes[n++] = (unsigned char)(value & 0x7F);
+        value >>= 7;
+    }
+    while (value > 0 && n < 5);
+
+    while (n > 1)
+        data.push_back( char(bytes[--n] | 0x80) );
+    data.push_back( char(bytes[0]) );
+}
+
+//---------------------------------------------------------------------------------------
+void MidiRecorder::write_track(ostream& file, const string& track)
+{
+    string header("MTrk");
+    write_number(header, unsigned(track.size()), 4);
+    file.write(header.data(), header.size());
+    file.write(track.data(), track.size());
+}
+
+//---------------------------------------------------------------------------------------
+bool MidiRecorder::save_as_midi_file(ostream& file)
+{
+    //With 500 ticks per quarter note and a tempo of 500000 microseconds per quarter
+    //note, one tick is one millisecond and message times can be used as they are
+
+    const unsigned k_division = 500;
+    const unsigned k_tempo = 500000;
+
+    int numChannels = 0;
+    for (int channel=0; channel < 16; ++channel)
+    {
+        if (m_usedChannels & (1u << channel))
+            ++numChannels;
+    }
+
+    //header chunk: format 1, tempo track + one track per channel
+    string header("MThd");
+    write_number(header, 6, 4);
+    write_number(header, 1, 2);
+    write_number(header, unsigned(numChannels + 1), 2);
+    write_number(header, k_division, 2);
+    file.write(header.data(), header.size());
+
+    //tempo track
+    string track;
+    write_variable_length(track, 0);
+    track.append("\xFF\x51\x03", 3);
+    write_number(track, k_tempo, 3);
+    write_variable_length(track, 0);
+    track.append("\xFF\x2F\x00", 3);
+    write_track(file, track);
+
+    //a track for each channel
+    for (int channel=0; channel < 16; ++channel)
+    {
+        if ((m_usedChannels & (1u << channel)) == 0)
+            continue;
+
+        track.clear();
+        long prevTime = 0L;
+        vector<MidiMessage>::const_iterator it;
+        for (it = m_messages.begin(); it != m_messages.end(); ++it)
+        {
+            if ((*it).channel() != channel)
+                continue;
+
+            long time = max(prevTime, (*it).time);
+            write_variable_length(track, (unsigned long)(time - prevTime));
+            prevTime = time;
+            track.push_back( char((*it).status) );
+            track.push_back( char((*it).data1) );
+            if ((*it).type() != MidiMessage::k_program_change)
+                track.push_back( char((*it).data2) );
+        }
+        write_variable_length(track, 0);
+        track.append("\xFF\x2F\x00", 3);
+        write_track(file, track);
+    }
+
+    return file.good();
+}
+
+
+//=======================================================================================
+// MidiFileRenderer implementation
+//=======================================================================================
+MidiFileRenderer::MidiFileRenderer(LibraryScope& libraryScope)
+    : m_libScope(libraryScope)
+    , m_pPlayer(nullptr)
+{
+    m_pPlayer = Injector::inject_ScorePlayer(m_libScope, &m_recorder);
+    m_recorder.set_player(m_pPlayer);
+}
+
+//---------------------------------------------------------------------------------------
+MidiFileRenderer::~MidiFileRenderer()
+{
+    delete m_pPlayer;
+}
+
+//---------------------------------------------------------------------------------------
+void MidiFileRenderer::play(ImoScore* pScore)
+{
+    m_recorder.clear();
+    m_pPlayer->load_score(pScore, &m_options);
+    m_pPlayer->play_offline();
+}
+
+//---------------------------------------------------------------------------------------
+bool MidiFileRenderer::render(ImoScore* pScore, ostream& file)
+{
+    play(pScore);
+    return m_recorder.save_as_midi_file(file);
+}
+
+//---------------------------------------------------------------------------------------
+bool MidiFileRenderer::render(ImoScore* pScore, const string& filename)
+{
+    ofstream file(filename.c_str(), ios::out | ios::binary);
+    if (!file.is_open())
+    {
+        LOMSE_LOG_ERROR("Error opening file '%s' for writing.", filename.c_str());
+        return false;
+    }
+
+    bool fOk = render(pScore, file);
+    file.close();
+    return fOk && !file.fail();
+}
+
+
+}   //namespace lomse
@@ -30,7 +30,10 @@
 #include "lomse_midi_table.h"
 
 #include <algorithm>
+#include <climits>
+#include <map>
 #include "lomse_internal_model.h"
+#include "lomse_document.h"
 #include "lomse_im_note.h"
 #include "lomse_time.h"
 #include "lomse_staffobjs_table.h"
@@ -48,8 +51,9 @@ namespace lomse
 // SoundEventsTable: Manager for the events table
 //
 //    There are two tables to maintain:
-//    - m_events (std::vector<SoundEvent*>):
-//        Contains the MIDI events.
+//    - m_events (std::vector<SoundEvent>):
+//        Contains the MIDI events. They are stored by value, in a contiguous block,
+//        as the playback loop traverses this table sequentially.
 //    - m_measures (std::vector<int>):
 //        Contains the index over m_events for the first event of each measure.
 //
@@ -65,10 +69,24 @@ namespace lomse
 //    marked as belonging to measure 0.
 //
 //    The two tables must be synchronized.
+//
+//    For each measure, the playback state when the measure is reached for the
+//    first time (time signature, jump counters and notes tied from previous measure)
+//    is saved in m_snapshots, so that playback can start in any measure without
+//    processing previous events. The metronome state depends on the player settings
+//    and it is added to the snapshots by compute_metronome_states().
+//
+//    After editing some measures, the table can be updated by regenerating only the
+//    events for the edited measures (method update_table()). For this, the start time
+//    of each measure is saved in m_measureStart, so that changes in the duration of
+//    the edited measures can be detected.
 //=======================================================================================
 SoundEventsTable::SoundEventsTable(ImoScore* pScore)
     : m_pScore(pScore)
     , m_numMeasures(0)
+    , m_timesFactor(0.0f)
+    , m_mtrBeatType(0)
+    , m_fMtrComputed(false)
     , m_rAnacrusisMissingTime(0.0)
 {
 }
@@ -79,28 +97,54 @@ SoundEventsTable::~SoundEventsTable()
     delete_events_table();
     m_measures.clear();
     m_channels.clear();
+    delete_jumps();
+}
+
+//---------------------------------------------------------------------------------------
+void SoundEventsTable::delete_jumps()
+{
+    vector<JumpEntry*>::iterator it;
+    for (it=m_jumps.begin(); it != m_jumps.end(); ++it)
+        delete *it;
     m_jumps.clear();
 }
 
+//---------------------------------------------------------------------------------------
+void SoundEventsTable::clear_table()
+{
+    delete_events_table();
+    delete_jumps();
+    m_measures.clear();
+    m_measureStart.clear();
+    m_snapshots.clear();
+    m_rhythmChanges.clear();
+    m_fMtrComputed = false;
+    m_channels.clear();
+    m_targets.clear();
+    m_pendingLabel.clear();
+    m_numMeasures = 0;
+}
+
 //---------------------------------------------------------------------------------------
 void SoundEventsTable::delete_events_table()
 {
-    std::vector<SoundEvent*>::iterator it;
-    for (it = m_events.begin(); it != m_events.end(); ++it)
-        delete *it;
     m_events.clear();
+    m_times.clear();
+    m_timesFactor = 0.0f;
 }
 
 //---------------------------------------------------------------------------------------
 void SoundEventsTable::create_table()
 {
+    clear_table();
     program_sounds_for_instruments();
-    create_events();
+    create_events(1, INT_MAX);
     sort_by_time();
     close_table();
     create_measures_table();
     replace_label_in_jumps();
     add_events_to_jumps();
+    create_snapshots();
 }
 
 //---------------------------------------------------------------------------------------
@@ -127,8 +171,86 @@ void SoundEventsTable::program_sounds_for_instruments()
 }
 
 //---------------------------------------------------------------------------------------
-void SoundEventsTable::create_events()
+void SoundEventsTable::update_table(int firstMeasure, int lastMeasure)
 {
+    vector<SoundEvent> oldEvents;
+    oldEvents.swap(m_events);
+    vector<TimeUnits> oldStart;
+    oldStart.swap(m_measureStart);
+    vector<int> oldChannels;
+    oldChannels.swap(m_channels);
+
+    update_events(oldEvents, oldStart, oldChannels, firstMeasure, lastMeasure);
+}
+
+//---------------------------------------------------------------------------------------
+void SoundEventsTable::update_table(const SoundEventsTable& table, int firstMeasure,
+                                    int lastMeasure)
+{
+    update_events(table.m_events, table.m_measureStart, table.m_channels,
+                  firstMeasure, lastMeasure);
+}
+
+//---------------------------------------------------------------------------------------
+void SoundEventsTable::update_events(const vector<SoundEvent>& oldEvents,
+                                     const vector<TimeUnits>& oldStart,
+                                     const vector<int>& oldChannels,
+                                     int firstMeasure, int lastMeasure)
+{
+    //AWARE: ties join notes in consecutive measures and the events for a note depend
+    //on its ties. Therefore, the measures around the edited ones are also regenerated.
+    firstMeasure = max(1, firstMeasure - 1);
+    if (lastMeasure < INT_MAX)
+        ++lastMeasure;
+
+    //instrument programs are always regenerated, but if the channel of an instrument
+    //has changed the events for all measures have to be created again
+    clear_table();
+    program_sounds_for_instruments();
+    if (oldEvents.empty() || firstMeasure > lastMeasure || m_channels != oldChannels)
+    {
+        create_table();
+        return;
+    }
+
+    create_events(firstMeasure, lastMeasure);
+
+    //measures can not be added or removed
+    if (oldStart.size() != m_measureStart.size())
+    {
+        create_table();
+        return;
+    }
+
+    //AWARE: volume depends on the beat position and this is computed from the time
+    //position and the time signature. Therefore, when the duration of the edited
+    //measures or the time signature in effect after them changes, all following
+    //measures must be regenerated.
+    int nextMeasure = lastMeasure + 1;
+    if (nextMeasure < int(oldStart.size())
+        && (!is_equal_time(oldStart[nextMeasure], m_measureStart[nextMeasure])
+            || is_rhythm_changed(oldEvents, firstMeasure, lastMeasure)) )
+    {
+        lastMeasure = INT_MAX;
+        clear_table();
+        program_sounds_for_instruments();
+        create_events(firstMeasure, lastMeasure);
+    }
+
+    merge_updated_events(oldEvents, firstMeasure, lastMeasure);
+    close_table();
+    create_measures_table();
+    replace_label_in_jumps();
+    add_events_to_jumps();
+    create_snapshots();
+}
+
+//---------------------------------------------------------------------------------------
+void SoundEventsTable::create_events(int firstMeasure, int lastMeasure)
+{
+    //Events for notes, rests and rhythm changes are only created for measures in
+    //range firstMeasure to lastMeasure. Jumps are created for the whole score.
+
     StaffObjsCursor cursor(m_pScore);
     ImoStaffObj* pSO = nullptr;
                             //TODO change so that anacruxis measure is counted as 0
@@ -142,13 +264,20 @@ void SoundEventsTable::create_events()
     while(!cursor.is_end())
     {
         int measure = cursor.measure() + 1;     //start count in 1
+        while (int(m_measureStart.size()) <= measure)
+            m_measureStart.push_back(cursor.time());
+        bool fInRange = (measure >= firstMeasure && measure <= lastMeasure);
 
-        pSO = cursor.get_staffobj();
+        //AWARE: all entries in ColStaffObjs are staffobjs. dynamic_cast not needed
+        pSO = static_cast<ImoStaffObj*>( cursor.imo_object() );
         if (pSO->is_note_rest())
         {
-            int iInstr = cursor.num_instrument();
-            int channel = m_channels[iInstr];
-            add_noterest_events(cursor, channel, measure);
+            if (fInRange)
+            {
+                int iInstr = cursor.num_instrument();
+                int channel = m_channels[iInstr];
+                add_noterest_events(cursor, channel, measure);
+            }
         }
         else if (pSO->is_barline())
         {
@@ -183,7 +312,8 @@ void SoundEventsTable::create_events()
         }
         else if (pSO->is_time_signature())
         {
-            add_rythm_change(cursor, measure, static_cast<ImoTimeSignature*>(pSO));
+            if (fInRange)
+                add_rythm_change(cursor, measure, static_cast<ImoTimeSignature*>(pSO));
         }
         else if (pSO->is_key_signature())
         {
@@ -340,17 +470,15 @@ void SoundEventsTable::store_event(TimeUnits rTime, int eventType, int channel,
                                    MidiPitch pitch, int volume, int step,
                                    ImoStaffObj* pSO, int measure)
 {
-    SoundEvent* pEvent = LOMSE_NEW SoundEvent(rTime, eventType, channel, pitch,
-                                              volume, step, pSO, measure);
-    m_events.push_back(pEvent);
+    m_events.push_back( SoundEvent(rTime, eventType, channel, pitch,
+                                   volume, step, pSO, measure) );
     m_numMeasures = max(m_numMeasures, measure);
 }
 
 //---------------------------------------------------------------------------------------
 void SoundEventsTable::store_jump_event(TimeUnits rTime, JumpEntry* pJump, int measure)
 {
-    SoundEvent* pEvent = LOMSE_NEW SoundEvent(rTime, SoundEvent::k_jump, pJump, measure);
-    m_events.push_back(pEvent);
+    m_events.push_back( SoundEvent(rTime, SoundEvent::k_jump, pJump, measure) );
     m_numMeasures = max(m_numMeasures, measure);
 }
 
@@ -358,7 +486,7 @@ void SoundEventsTable::store_jump_event(TimeUnits rTime, JumpEntry* pJump, int m
 void SoundEventsTable::add_noterest_events(StaffObjsCursor& cursor, int channel,
                                            int measure)
 {
-    ImoStaffObj* pSO = cursor.get_staffobj();
+    ImoStaffObj* pSO = static_cast<ImoStaffObj*>( cursor.imo_object() );
     ImoTimeSignature* pTS = cursor.get_applicable_time_signature();
     ImoNote* pNote = nullptr;
     int step = 0;
@@ -448,7 +576,7 @@ void SoundEventsTable::close_table()
 {
     TimeUnits maxTime = 0.0;
     if (m_events.size() > 0)
-        maxTime = TimeUnits(m_events.back()->DeltaTime);
+        maxTime = TimeUnits(m_events.back().DeltaTime);
     store_event(maxTime, SoundEvent::k_end_of_score, 0, 0, 0, 0, nullptr, 0);
 }
 
@@ -462,10 +590,10 @@ void SoundEventsTable::create_measures_table()
 
     for (int i=0; i < int(m_events.size()); i++)
     {
-        if (m_measures[m_events[i]->Measure] == -1)
+        if (m_measures[m_events[i].Measure] == -1)
         {
             //Add index to the table
-            m_measures[m_events[i]->Measure] = i;
+            m_measures[m_events[i].Measure] = i;
         }
     }
 
@@ -474,42 +602,203 @@ void SoundEventsTable::create_measures_table()
     m_measures[m_numMeasures+1] = int(m_events.size()) - 1;
 }
 
+//---------------------------------------------------------------------------------------
+static bool is_event_before(const SoundEvent& ev1, const SoundEvent& ev2)
+{
+    //ordering criteria for the events table: time, event type and measure.
+    //For events at the same time, the event type priority takes precedence over the
+    //measure so that, for instance, the note-off events at the end of a measure go
+    //before the events for the start of next measure and an end of score event,
+    //in measure 0, goes after all other events.
+
+    if (ev1.DeltaTime != ev2.DeltaTime)
+        return ev1.DeltaTime < ev2.DeltaTime;
+    if (ev1.EventType != ev2.EventType)
+        return ev1.EventType < ev2.EventType;
+    return ev1.Measure < ev2.Measure;
+}
+
 //---------------------------------------------------------------------------------------
 void SoundEventsTable::sort_by_time()
 {
-    // Sort events by time, measure and event type. Uses the bubble sort algorithm
+    // Sort events by time, event type and measure. The sort is stable: events with
+    // the same keys keep the order in which they were created.
 
-    int j, k;
-    bool fChanges;
-    int nNumElements = int(m_events.size());
-    SoundEvent* pEvAux;
+    std::stable_sort(m_events.begin(), m_events.end(), is_event_before);
+}
+
+//---------------------------------------------------------------------------------------
+bool SoundEventsTable::is_rhythm_changed(const vector<SoundEvent>& oldEvents,
+                                         int firstMeasure, int lastMeasure)
+{
+    //Compares the time signature in effect at the end of lastMeasure in the old
+    //events and in the regenerated events for measures firstMeasure to lastMeasure.
+    //Volume of notes also depends only on it, as it determines the beat positions.
 
-    for (int i = 0; i < nNumElements; i++)
+    const SoundEvent* pOld = find_last_rhythm_change(oldEvents, lastMeasure);
+    const SoundEvent* pNew = find_last_rhythm_change(m_events, lastMeasure);
+    if (!pNew)
+        pNew = find_last_rhythm_change(oldEvents, firstMeasure - 1);
+
+    if (!pOld || !pNew)
+        return pOld != pNew;
+
+    return pOld->TopNumber != pNew->TopNumber
+           || pOld->NumPulses != pNew->NumPulses
+           || pOld->BeatDuration != pNew->BeatDuration;
+}
+
+//---------------------------------------------------------------------------------------
+const SoundEvent* SoundEventsTable::find_last_rhythm_change(
+                                        const vector<SoundEvent>& events, int maxMeasure)
+{
+    const SoundEvent* pFound = nullptr;
+    vector<SoundEvent>::const_iterator it;
+    for (it = events.begin(); it != events.end(); ++it)
     {
-        fChanges = false;
-        j = nNumElements - 1;
+        if (it->EventType == SoundEvent::k_rhythm_change && it->Measure <= maxMeasure
+            && (!pFound || it->DeltaTime >= pFound->DeltaTime))
+        {
+            pFound = &(*it);
+        }
+    }
+    return pFound;
+}
+
+//---------------------------------------------------------------------------------------
+void SoundEventsTable::merge_updated_events(const vector<SoundEvent>& oldEvents,
+                                            int firstMeasure, int lastMeasure)
+{
+    //m_events contains the regenerated events for the updated measures and the jumps
+    //and instrument programs for the whole score. Old events for other measures are
+    //merged with them. As both sequences are ordered, a merge is enough and the
+    //result is the same than sorting the whole table again. For equivalent events,
+    //old events go first as in std::merge.
 
-        while ( j != i )
+    sort_by_time();
+
+    vector<SoundEvent> events;
+    events.reserve(oldEvents.size() + m_events.size() + 1);
+    vector<SoundEvent>::iterator itNew = m_events.begin();
+    vector<SoundEvent>::const_iterator it;
+    for (it = oldEvents.begin(); it != oldEvents.end(); ++it)
+    {
+        if (it->EventType == SoundEvent::k_jump
+            || it->EventType == SoundEvent::k_prog_instr
+            || it->EventType == SoundEvent::k_end_of_score
+            || (it->Measure >= firstMeasure && it->Measure <= lastMeasure))
         {
-            k = j - 1;
-            if ((m_events[j]->DeltaTime < m_events[k]->DeltaTime) ||
-                ((m_events[j]->DeltaTime == m_events[k]->DeltaTime) &&
-                 ((m_events[j]->Measure < m_events[k]->Measure) ||
-                  (m_events[j]->EventType < m_events[k]->EventType))))
-            {
-                //interchange elements
-                pEvAux = m_events[j];
-                m_events[j] = m_events[k];
-                m_events[k] = pEvAux;
-                fChanges = true;
-            }
-            j = k;
+            continue;
+        }
+
+        while (itNew != m_events.end() && is_event_before(*itNew, *it))
+            events.push_back(*itNew++);
+        events.push_back(*it);
+        m_numMeasures = max(m_numMeasures, it->Measure);
+    }
+    events.insert(events.end(), itNew, m_events.end());
+    m_events.swap(events);
+}
+
+//---------------------------------------------------------------------------------------
+bool SoundEventsTable::mix_table(SoundEventsTable* pTable, int scoreIndex)
+{
+    const int k_percussion_channel = 9;
+    const int k_num_channels = 16;
+
+    //assign free channels to the channels used in the other table
+    vector<bool> used(k_num_channels, false);
+    used[k_percussion_channel] = true;
+    vector<SoundEvent>::iterator it;
+    for (it = m_events.begin(); it != m_events.end(); ++it)
+    {
+        //jumps, rhythm changes and end of score do not use a channel
+        if (it->EventType != SoundEvent::k_jump
+            && it->EventType != SoundEvent::k_rhythm_change
+            && it->EventType != SoundEvent::k_end_of_score)
+        {
+            used[it->Channel & 0x0F] = true;
+        }
+    }
+
+    //AWARE: the table is not modified until all channels have been assigned
+    vector<int> channelMap(k_num_channels, -1);
+    vector<int> newChannels;
+    channelMap[k_percussion_channel] = k_percussion_channel;
+    vector<SoundEvent>& events = pTable->get_events();
+    for (it = events.begin(); it != events.end(); ++it)
+    {
+        if (it->EventType == SoundEvent::k_jump
+            || it->EventType == SoundEvent::k_rhythm_change
+            || it->EventType == SoundEvent::k_end_of_score
+            || channelMap[it->Channel & 0x0F] != -1)
+        {
+            continue;
         }
 
-        //If there were no changes in this loop step it implies that the table is ordered;
-        //in this case exit loop to save time
-        if (!fChanges) break;
+        int channel = 0;
+        while (channel < k_num_channels && used[channel])
+            ++channel;
+        if (channel == k_num_channels)
+            return false;
+
+        used[channel] = true;
+        channelMap[it->Channel & 0x0F] = channel;
+        newChannels.push_back(channel);
+    }
+    m_channels.insert(m_channels.end(), newChannels.begin(), newChannels.end());
+
+    //merge both tables. End of score event is generated again
+    m_events.pop_back();
+    vector<SoundEvent> mixed;
+    mixed.reserve(m_events.size() + events.size());
+    vector<SoundEvent>::iterator itMain = m_events.begin();
+    for (it = events.begin(); it != events.end(); ++it)
+    {
+        if (it->EventType == SoundEvent::k_jump
+            || it->EventType == SoundEvent::k_rhythm_change
+            || it->EventType == SoundEvent::k_end_of_score)
+        {
+            continue;
+        }
+
+        SoundEvent ev = *it;
+        ev.Channel = channelMap[ev.Channel & 0x0F];
+        ev.Score = scoreIndex;
+        while (itMain != m_events.end() && !is_event_before(ev, *itMain))
+            mixed.push_back(*itMain++);
+        mixed.push_back(ev);
+    }
+    mixed.insert(mixed.end(), itMain, m_events.end());
+    m_events.swap(mixed);
+
+    //rebuild control tables
+    close_table();
+    m_numMeasures = max(m_numMeasures, pTable->get_num_measures());
+    m_measures.clear();
+    create_measures_table();
+    add_events_to_jumps();
+    create_snapshots();
+    m_times.clear();
+
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+vector<long>& SoundEventsTable::get_timeline(float conversionFactor)
+{
+    //The playback loop needs the absolute time (milliseconds) of each event. Instead
+    //of converting the time of each event while playing, times are computed here
+    //for all events and are only recomputed when the tempo changes.
+
+    if (conversionFactor != m_timesFactor || m_times.size() != m_events.size())
+    {
+        m_timesFactor = conversionFactor;
+        m_times.resize(m_events.size());
+        for (size_t i=0; i < m_events.size(); ++i)
+            m_times[i] = long( float(m_events[i].DeltaTime) * conversionFactor );
     }
+    return m_times;
 }
 
 //---------------------------------------------------------------------------------------
@@ -538,7 +827,7 @@ string SoundEventsTable::dump_events_table()
             }
 
             //list current entry
-            SoundEvent* pSE = m_events[i];
+            SoundEvent* pSE = &m_events[i];
             msg << i << ":\t" << pSE->DeltaTime << "\t\t" << pSE->Channel << "\t"
                 << pSE->Measure << "\t";
 
@@ -603,7 +892,7 @@ string SoundEventsTable::dump_measures_table()
         int nEntry = m_measures[i];
         if (nEntry >= 0)
         {
-            SoundEvent* pSE = m_events[nEntry];
+            SoundEvent* pSE = &m_events[nEntry];
             msg << i << ":\t" << pSE->DeltaTime << "\t" << nEntry << "\n";
         }
         else
@@ -763,6 +1052,144 @@ int SoundEventsTable::find_measure_for_label(const string& label)
     return 0;
 }
 
+//---------------------------------------------------------------------------------------
+void SoundEventsTable::create_snapshots()
+{
+    m_snapshots.assign(m_measures.size(), PlaybackSnapshot());
+    m_rhythmChanges.clear();
+    m_fMtrComputed = false;
+
+    //measures ordered by their first event
+    vector< pair<int, int> > starts;
+    for (int m=1; m < int(m_measures.size()) - 1; ++m)
+    {
+        if (m_measures[m] >= 0)
+            starts.push_back( make_pair(m_measures[m], m) );
+    }
+    std::sort(starts.begin(), starts.end());
+
+    //time signatures and sounding notes, in table order
+    int lastRhythm = -1;
+    vector<int> sounding;
+    vector< pair<int, int> >::iterator itStart = starts.begin();
+    for (int i=0; i < int(m_events.size()); ++i)
+    {
+        while (itStart != starts.end() && itStart->first == i)
+        {
+            PlaybackSnapshot& state = m_snapshots[itStart->second];
+            state.rhythmChange = lastRhythm;
+            state.tiedNotes = sounding;
+            ++itStart;
+        }
+
+        SoundEvent& ev = m_events[i];
+        if (ev.EventType == SoundEvent::k_rhythm_change)
+        {
+            lastRhythm = i;
+            m_rhythmChanges.push_back(i);
+        }
+        else if (ev.EventType == SoundEvent::k_note_on)
+        {
+            sounding.push_back(i);
+        }
+        else if (ev.EventType == SoundEvent::k_note_off)
+        {
+            vector<int>::iterator it;
+            for (it = sounding.begin(); it != sounding.end(); ++it)
+            {
+                if (m_events[*it].Channel == ev.Channel
+                    && m_events[*it].NotePitch == ev.NotePitch)
+                {
+                    sounding.erase(it);
+                    break;
+                }
+            }
+        }
+    }
+
+    add_jumps_to_snapshots();
+}
+
+//---------------------------------------------------------------------------------------
+void SoundEventsTable::add_jumps_to_snapshots()
+{
+    //Jump counters depend on the path followed. Therefore, playback is simulated,
+    //following the jumps as ScorePlayer does, to save the counters when each measure
+    //is reached for the first time.
+
+    int numJumps = int(m_jumps.size());
+    if (numJumps == 0 || m_measures.size() < 3)
+        return;
+
+    map<JumpEntry*, int> index;
+    for (int j=0; j < numJumps; ++j)
+        index[m_jumps[j]] = j;
+
+    vector< pair<int, int> > counters(numJumps, make_pair(0, 0));   //visited, executed
+    vector<bool> reached(m_measures.size(), false);
+
+    //AWARE: limit the number of simulated events, in case of malformed jumps
+    long maxSteps = long(m_events.size()) * long(numJumps + 2);
+    int numEvents = int(m_events.size());
+    int i = max(0, m_measures[1]);
+    for (long steps=0; steps < maxSteps && i < numEvents; ++steps)
+    {
+        SoundEvent& ev = m_events[i];
+        if (ev.EventType == SoundEvent::k_end_of_score)
+            break;
+
+        int m = ev.Measure;
+        if (m > 0 && !reached[m] && m_measures[m] == i)
+        {
+            reached[m] = true;
+            m_snapshots[m].jumps = counters;
+        }
+
+        if (ev.EventType == SoundEvent::k_jump)
+        {
+            JumpEntry* pJump = ev.pJump;
+            pair<int, int>& cnt = counters[ index[pJump] ];
+            bool fExecuted = false;
+            if (cnt.first >= pJump->get_times_before())
+            {
+                if (pJump->get_times_valid() == 0
+                    || pJump->get_times_valid() > cnt.second)
+                {
+                    if (pJump->get_times_valid() > cnt.second)
+                        ++cnt.second;
+                    fExecuted = true;
+                }
+            }
+            ++cnt.first;
+            i = (fExecuted ? pJump->get_event() : i + 1);
+        }
+        else
+            ++i;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+PlaybackSnapshot* SoundEventsTable::get_snapshot(int nMeasure)
+{
+    if (nMeasure > 0 && nMeasure < int(m_snapshots.size()))
+        return &m_snapshots[nMeasure];
+    return nullptr;
+}
+
+//---------------------------------------------------------------------------------------
+void SoundEventsTable::restore_jumps(int nMeasure)
+{
+    PlaybackSnapshot* pState = get_snapshot(nMeasure);
+    if (!pState || pState->jumps.size() != m_jumps.size())
+    {
+        reset_jumps();
+        return;
+    }
+
+    for (size_t j=0; j < m_jumps.size(); ++j)
+        m_jumps[j]->set_counters(pState->jumps[j].first, pState->jumps[j].second);
+}
+
 //---------------------------------------------------------------------------------------
 void SoundEventsTable::reset_jumps()
 {
@@ -771,6 +1198,118 @@ void SoundEventsTable::reset_jumps()
         (*it)->reset_entry();
 }
 
+//---------------------------------------------------------------------------------------
+void SoundEventsTable::compute_metronome_states(const MetronomeState& initial,
+                                                int beatType)
+{
+    if (m_fMtrComputed && m_mtrBeatType == beatType && m_mtrInitial == initial)
+        return;
+
+    //state after each time signature, in table order
+    vector<MetronomeState> states;
+    states.reserve(m_rhythmChanges.size());
+    MetronomeState state = initial;
+    vector<int>::iterator it;
+    for (it = m_rhythmChanges.begin(); it != m_rhythmChanges.end(); ++it)
+    {
+        state.apply_rhythm_change(m_events[*it], beatType);
+        states.push_back(state);
+    }
+
+    vector<PlaybackSnapshot>::iterator itS;
+    for (itS = m_snapshots.begin(); itS != m_snapshots.end(); ++itS)
+    {
+        if (itS->rhythmChange < 0)
+            itS->metronome = initial;
+        else
+        {
+            it = std::lower_bound(m_rhythmChanges.begin(), m_rhythmChanges.end(),
+                                  itS->rhythmChange);
+            itS->metronome = states[it - m_rhythmChanges.begin()];
+        }
+    }
+
+    m_mtrInitial = initial;
+    m_mtrBeatType = beatType;
+    m_fMtrComputed = true;
+}
+
+
+//=======================================================================================
+// MetronomeState implementation
+//=======================================================================================
+MetronomeState::MetronomeState()
+    : curMtrIntval(0L)
+    , prevMtrIntval(0L)
+    , curMeasureDuration(0L)
+    , prevMeasureDuration(0L)
+    , curNumPulses(0L)
+    , prevNumPulses(0L)
+    , mtrPulseDuration(0L)
+{
+}
+
+//---------------------------------------------------------------------------------------
+void MetronomeState::initialize(long mtrIntval, long pulseDuration)
+{
+    curMtrIntval = mtrIntval;
+    prevMtrIntval = mtrIntval;
+    mtrPulseDuration = pulseDuration;
+    curMeasureDuration = pulseDuration * 4;
+    prevMeasureDuration = curMeasureDuration;
+    curNumPulses = 4;
+    prevNumPulses = curNumPulses;
+}
+
+//---------------------------------------------------------------------------------------
+void MetronomeState::apply_rhythm_change(const SoundEvent& event, int beatType)
+{
+    if (beatType == k_beat_specified)
+    {
+        //No need for changes as specified duration is already in use
+        return;
+    }
+
+    long saveCurMtrIntval = curMtrIntval;
+    long saveCurMeasureDuration = curMeasureDuration;
+    long saveCurNumPulses = curNumPulses;
+
+    if (beatType == k_beat_implied)
+    {
+        curMeasureDuration = event.TopNumber * event.BeatDuration;
+        curNumPulses = event.NumPulses;
+    }
+    else if (beatType == k_beat_bottom_ts)
+    {
+        curMeasureDuration = event.TopNumber * event.BeatDuration;
+        curNumPulses = event.TopNumber;
+    }
+
+    //adjust metronome clicks interval for maintaining notes duration equivalence
+    curMtrIntval = long( float(prevMtrIntval) *
+        (float(curMeasureDuration * prevNumPulses) /
+         float(prevMeasureDuration * curNumPulses) ));
+
+    //save old values
+    prevMtrIntval = saveCurMtrIntval;
+    prevMeasureDuration = saveCurMeasureDuration;
+    prevNumPulses = saveCurNumPulses;
+
+    mtrPulseDuration = curMeasureDuration / curNumPulses;        //a pulse duration
+}
+
+//---------------------------------------------------------------------------------------
+bool MetronomeState::operator ==(const MetronomeState& state) const
+{
+    return curMtrIntval == state.curMtrIntval
+        && prevMtrIntval == state.prevMtrIntval
+        && curMeasureDuration == state.curMeasureDuration
+        && prevMeasureDuration == state.prevMeasureDuration
+        && curNumPulses == state.curNumPulses
+        && prevNumPulses == state.prevNumPulses
+        && mtrPulseDuration == state.mtrPulseDuration;
+}
+
 
 //=======================================================================================
 // JumpEntry implementation
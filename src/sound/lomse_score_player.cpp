@@ -38,9 +38,15 @@
 #include "lomse_player_gui.h"
 #include "lomse_metronome.h"
 #include "lomse_logger.h"
+#include "lomse_build_options.h"
 
 #include <algorithm>    //max(), min()
-#include <ctime>        //clock()
+#include <cmath>        //sqrt()
+
+#if (LOMSE_PLATFORM_UNIX == 1)
+    #include <pthread.h>    //pthread_setschedparam()
+    #include <sched.h>      //SCHED_FIFO
+#endif
 
 
 namespace lomse
@@ -60,6 +66,10 @@ ScorePlayer::ScorePlayer(LibraryScope& libScope, MidiServerBase* pMidi)
     , m_fFinalEventSent(false)
     , m_pScore(nullptr)
     , m_pTable(nullptr)
+    , m_pMixedTable(nullptr)
+    , m_nRequestedMM(0L)
+    , m_fRestart(false)
+    , m_fRealTime(false)
     , m_MtrChannel(9)
     , m_MtrInstr(0)
     , m_MtrTone1(60)
@@ -69,6 +79,8 @@ ScorePlayer::ScorePlayer(LibraryScope& libScope, MidiServerBase* pMidi)
     , m_pInteractor(nullptr)
     , m_pPlayerGui(nullptr)
     , m_pMtr(nullptr)
+    , m_fUseTrackingRing(false)
+    , m_fOffline(false)
     //
     , m_nMtrPulseDuration(0L)
     , m_beatType(0)
@@ -88,6 +100,8 @@ ScorePlayer::ScorePlayer(LibraryScope& libScope, MidiServerBase* pMidi)
 ScorePlayer::~ScorePlayer()
 {
     stop();
+    terminate_thread();
+    delete m_pMixedTable;
 }
 
 //---------------------------------------------------------------------------------------
@@ -105,7 +119,75 @@ void ScorePlayer::load_score(ImoScore* pScore, PlayerGui* pPlayerGui,
     m_MtrTone2 = tone2;
     m_pMtr = m_pPlayerGui->get_metronome();
 
-    m_pTable = m_pScore->get_midi_table();
+    delete m_pMixedTable;
+    m_pMixedTable = nullptr;
+    m_tracks.clear();
+    m_tracks.push_back( PlaybackTrack(pScore) );
+
+    m_spScoreTable = m_pScore->get_shared_midi_table();
+    m_pTable = m_spScoreTable.get();
+}
+
+//---------------------------------------------------------------------------------------
+bool ScorePlayer::mix_score(ImoScore* pScore, Interactor* pInteractor)
+{
+    if (!m_pScore || !pScore)
+        return false;
+
+    stop();
+
+    //the table for the main score is not modified. A copy is used for merging
+    if (!m_pMixedTable)
+    {
+        m_pMixedTable = LOMSE_NEW SoundEventsTable(m_pScore);
+        m_pMixedTable->create_table();
+    }
+
+    int scoreIndex = int(m_tracks.size());
+    if (!m_pMixedTable->mix_table(pScore->get_midi_table(), scoreIndex))
+    {
+        LOMSE_LOG_INFO("Score not mixed. Not enough free MIDI channels");
+        return false;
+    }
+
+    m_pTable = m_pMixedTable;
+    m_tracks.push_back( PlaybackTrack(pScore, pInteractor) );
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+void ScorePlayer::remove_mixed_scores()
+{
+    stop();
+
+    delete m_pMixedTable;
+    m_pMixedTable = nullptr;
+    if (m_tracks.size() > 1)
+        m_tracks.resize(1);
+
+    if (m_pScore)
+    {
+        m_spScoreTable = m_pScore->get_shared_midi_table();
+        m_pTable = m_spScoreTable.get();
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ScorePlayer::refresh_score_table()
+{
+    //After edition, the score creates a new sound events table instead of modifying
+    //the one in use by this player. The new table is only taken when the playback
+    //thread is idle.
+
+    if (!m_pScore || m_pMixedTable)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_commandsMutex);
+    if (m_fRunning || !m_commands.empty())
+        return;
+
+    m_spScoreTable = m_pScore->get_shared_midi_table();
+    m_pTable = m_spScoreTable.get();
 }
 
 //---------------------------------------------------------------------------------------
@@ -116,6 +198,7 @@ void ScorePlayer::play(bool fVisualTracking, long nMM, Interactor* pInteractor)
     m_fVisualTracking = fVisualTracking;
     m_nMM = nMM;
     m_pInteractor = pInteractor;
+    refresh_score_table();
 
     int evStart = m_pTable->get_first_event_for_measure(1);
     int evEnd = m_pTable->get_last_event();
@@ -139,6 +222,7 @@ void ScorePlayer::play_from_measure(int nMeasure, bool fVisualTracking,
     m_fVisualTracking = fVisualTracking;
     m_nMM = nMM;
     m_pInteractor = pInteractor;
+    refresh_score_table();
 
     //remember:
     //   real measures 1..n correspond to table items 1..n
@@ -168,6 +252,7 @@ void ScorePlayer::play_measures(int startMeasure, int numMeasures, bool fVisualT
     m_fVisualTracking = fVisualTracking;
     m_nMM = nMM;
     m_pInteractor = pInteractor;
+    refresh_score_table();
 
     //remember:
     //   real measures 1..n correspond to table items 1..n
@@ -193,114 +278,366 @@ void ScorePlayer::play_measures(int startMeasure, int numMeasures, bool fVisualT
     play_segment(evStart, evEnd);
 }
 
+//---------------------------------------------------------------------------------------
+void ScorePlayer::play_offline(int startMeasure, int numMeasures, long nMM)
+{
+    stop();
+    m_fOffline = true;
+    if (numMeasures > 0)
+        play_measures(startMeasure, numMeasures, k_no_visual_tracking, nMM, nullptr);
+    else
+        play_from_measure(startMeasure, k_no_visual_tracking, nMM, nullptr);
+    m_fOffline = false;
+}
+
 //---------------------------------------------------------------------------------------
 void ScorePlayer::play_segment(int nEvStart, int nEvEnd)
 {
     LOMSE_LOG_DEBUG(Logger::k_score_player, ">>[ScorePlayer::play_segment]");
     m_fQuit = false;
-    m_fFinalEventSent = false;
 
-    //Create a new thread. It starts immediately to execute do_play()
-    delete m_pThread;
-    m_fPlaying = true;
-    m_startMutex.lock();
-    m_pThread = LOMSE_NEW SoundThread(&ScorePlayer::thread_main, this,
-                                nEvStart, nEvEnd, m_fVisualTracking,
-                                m_nMM, m_pInteractor);
-    m_startMutex.unlock();
+    if (m_fOffline)
+    {
+        m_fFinalEventSent = false;
+        //play in this thread. No events are generated
+        do_play(nEvStart, nEvEnd, k_no_visual_tracking, m_nMM, nullptr);
+        m_pMidi->all_sounds_off();
+        m_pTable->reset_jumps();
+        if (m_pMtr)
+            m_pMtr->mute(false);
+        LOMSE_LOG_DEBUG(Logger::k_score_player, "<<[ScorePlayer::play_segment] offline");
+        return;
+    }
+
+    //The playback thread is created only once and it is reused for all playbacks
+    start_thread();
+    post_command( PlaybackCommand(PlaybackCommand::k_play, nEvStart, nEvEnd,
+                                  m_fVisualTracking, m_nMM, m_pInteractor) );
     LOMSE_LOG_DEBUG(Logger::k_score_player, "<<[ScorePlayer::play_segment]");
 }
 
 //---------------------------------------------------------------------------------------
-void ScorePlayer::thread_main(int nEvStart, int nEvEnd, bool fVisualTracking,
-                              long nMM, Interactor* pInteractor)
+void ScorePlayer::quit()
 {
-    LOMSE_LOG_DEBUG(Logger::k_score_player, ">>[ScorePlayer::thread_main]");
+    //when the user application quits, it is necessary to stop the player without
+    //generating repaint or other events. That's the purpose of this method.
 
-    // waiting for "play_segment" to initialize "m_pThread"
-    m_startMutex.lock();
-    m_startMutex.unlock();
+    m_fQuit = true;
+    stop();
+}
 
-    if (pInteractor && !m_fPostEvents)
-        pInteractor->enable_forced_view_updates(false);
-    fVisualTracking &= (pInteractor != nullptr);
-    m_fRunning = true;
+//---------------------------------------------------------------------------------------
+void ScorePlayer::pause()
+{
+    if (!m_pThread || !m_fPlaying) return;
 
-    try
+    post_command( PlaybackCommand(PlaybackCommand::k_pause) );
+}
+
+//---------------------------------------------------------------------------------------
+void ScorePlayer::stop()
+{
+    LOMSE_LOG_DEBUG(Logger::k_score_player, ">> Enter");
+
+    if (m_pThread)
     {
-        do_play(nEvStart, nEvEnd, fVisualTracking, nMM, pInteractor);
-        end_of_playback_housekeeping(fVisualTracking, pInteractor);
+        std::unique_lock<std::mutex> lock(m_commandsMutex);
+
+        //pending requests are discarded
+        m_commands.clear();
+        m_commands.push_back( PlaybackCommand(PlaybackCommand::k_stop) );
+        m_newCommand.notify_one();
+
+        //AWARE: an event handler, invoked from the playback thread, could
+        //request to stop. It can not wait for itself.
+        if (!is_playback_thread())
+        {
+            LOMSE_LOG_DEBUG(Logger::k_score_player, "Waiting for playback end ...");
+            m_idle.wait(lock, [this]{ return !m_fRunning && m_commands.empty(); });
+            m_fPlaying = false;
+        }
     }
-    catch(const std::exception& e)     //to catch possible std::bad_weak_ptr
+
+    LOMSE_LOG_DEBUG(Logger::k_score_player, "<< Exit");
+}
+
+//---------------------------------------------------------------------------------------
+void ScorePlayer::seek(int nMeasure)
+{
+    if (!m_pThread || !m_fPlaying) return;
+
+    int nEvStart = m_pTable->get_first_event_for_measure(nMeasure);
+    int maxMeasure = m_pTable->get_num_measures();
+    while (nEvStart == -1 && nMeasure < maxMeasure)
     {
-        stringstream msg;
-        msg << "std exception caught: " << e.what();
-        LOMSE_LOG_ERROR(msg.str());
+        //Current measure is empty. Start in next one
+        nEvStart = m_pTable->get_first_event_for_measure(++nMeasure);
     }
-    catch (...)
+
+    if (nEvStart != -1)
+        post_command( PlaybackCommand(PlaybackCommand::k_seek, nEvStart) );
+}
+
+//---------------------------------------------------------------------------------------
+void ScorePlayer::set_tempo(long nMM)
+{
+    if (!m_pThread || !m_fPlaying || nMM <= 0L) return;
+
+    post_command( PlaybackCommand(PlaybackCommand::k_tempo, 0, 0, false, nMM) );
+}
+
+//---------------------------------------------------------------------------------------
+bool ScorePlayer::set_realtime_priority(bool value)
+{
+    start_thread();
+    if (!apply_thread_priority(value))
+        return false;
+
+    m_fRealTime = value;
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+void ScorePlayer::start_thread()
+{
+    //Create the thread, if not yet created. It starts inmediately to wait for
+    //commands (method thread_main()) and only finishes when the player is deleted
+
+    if (m_pThread)
+        return;
+
+    m_pThread = LOMSE_NEW SoundThread(&ScorePlayer::thread_main, this);
+}
+
+//---------------------------------------------------------------------------------------
+void ScorePlayer::terminate_thread()
+{
+    if (!m_pThread)
+        return;
+
+    post_command( PlaybackCommand(PlaybackCommand::k_terminate) );
+
+    if (is_playback_thread())
+        m_pThread->detach();
+    else if (m_pThread->joinable())
+        m_pThread->join();
+    delete m_pThread;
+    m_pThread = nullptr;
+}
+
+//---------------------------------------------------------------------------------------
+void ScorePlayer::post_command(const PlaybackCommand& cmd)
+{
     {
-        LOMSE_LOG_ERROR("Default exception caught");
+        std::lock_guard<std::mutex> lock(m_commandsMutex);
+        m_commands.push_back(cmd);
+        if (cmd.type == PlaybackCommand::k_play)
+            m_fPlaying = true;
     }
-    m_fPlaying = false;
-    m_fRunning = false;
+    m_newCommand.notify_one();
+}
 
-    LOMSE_LOG_DEBUG(Logger::k_score_player, "<<[ScorePlayer::thread_main]");
+//---------------------------------------------------------------------------------------
+bool ScorePlayer::is_playback_thread()
+{
+    return m_pThread && m_pThread->get_id() == std::this_thread::get_id();
 }
 
 //---------------------------------------------------------------------------------------
-void ScorePlayer::quit()
+bool ScorePlayer::apply_thread_priority(bool fRealTime)
 {
-    //when the user application quits, it is necessary to stop the player without
-    //generating repaint or other events. That's the purpose of this method.
+#if (LOMSE_PLATFORM_UNIX == 1)
+    sched_param param;
+    int policy = SCHED_OTHER;
+    param.sched_priority = 0;
+    if (fRealTime)
+    {
+        //a priority in the lower part of the range: above normal threads but below
+        //system threads, such as those of audio drivers
+        policy = SCHED_FIFO;
+        int minPriority = sched_get_priority_min(SCHED_FIFO);
+        int maxPriority = sched_get_priority_max(SCHED_FIFO);
+        param.sched_priority = minPriority + (maxPriority - minPriority) / 4;
+    }
 
-    m_fQuit = true;
-    stop();
+    int result = pthread_setschedparam(m_pThread->native_handle(), policy, &param);
+    if (result != 0)
+    {
+        LOMSE_LOG_INFO("Scheduling policy not changed. Error %d", result);
+        return false;
+    }
+    return true;
+#else
+    return !fRealTime;
+#endif
 }
 
 //---------------------------------------------------------------------------------------
-void ScorePlayer::pause()
+// Methods to be executed in the thread
+//---------------------------------------------------------------------------------------
+
+void ScorePlayer::thread_main()
 {
-    if (!m_pThread) return;
+    //The playback loop. The thread sleeps until new commands are posted. When idle,
+    //only play requests are meaningful. Other commands are processed by do_play(),
+    //between events, while playing.
 
-    m_fPaused = !m_fPaused;
+    LOMSE_LOG_DEBUG(Logger::k_score_player, ">>[ScorePlayer::thread_main]");
 
-    if (m_fPaused)
-        m_pMidi->all_sounds_off();
-    else
-        m_canPlay.notify_one();
+    std::unique_lock<std::mutex> lock(m_commandsMutex);
+    while (true)
+    {
+        m_newCommand.wait(lock, [this]{ return !m_commands.empty(); });
+        PlaybackCommand cmd = m_commands.front();
+        m_commands.pop_front();
+
+        if (cmd.type == PlaybackCommand::k_terminate)
+            break;
+
+        while (cmd.type == PlaybackCommand::k_play)
+        {
+            m_current = cmd;
+            m_fShouldStop = false;
+            m_fPaused = false;
+            m_fFinalEventSent = false;
+            m_nRequestedMM = 0L;
+            m_fRestart = false;
+            m_fRunning = true;
+
+            lock.unlock();
+            PlaybackCommand next;
+            play_command(cmd, next);
+            lock.lock();
+
+            //a new playback could have been requested while playing
+            cmd = (m_fRestart ? next : PlaybackCommand(PlaybackCommand::k_stop));
+        }
+
+        m_fRunning = false;
+        if (m_commands.empty())
+        {
+            m_fPlaying = false;
+            m_idle.notify_all();
+        }
+    }
+
+    LOMSE_LOG_DEBUG(Logger::k_score_player, "<<[ScorePlayer::thread_main]");
 }
 
 //---------------------------------------------------------------------------------------
-void ScorePlayer::stop()
+void ScorePlayer::play_command(const PlaybackCommand& cmd, PlaybackCommand& next)
 {
-    LOMSE_LOG_DEBUG(Logger::k_score_player, ">> Enter");
+    Interactor* pInteractor = cmd.pInteractor;
+    if (!m_fPostEvents)
+    {
+        if (pInteractor)
+            pInteractor->enable_forced_view_updates(false);
+        enable_forced_view_updates(false);
+    }
 
-    if (m_pThread && m_fRunning)
+    bool fVisualTracking = false;
+    if (cmd.fVisualTracking)
     {
-        LOMSE_LOG_DEBUG(Logger::k_score_player, "Ending thread ...");
-        m_fShouldStop = true;
-        m_pThread->join();
+        fVisualTracking = (pInteractor != nullptr);
+        for (size_t i=1; i < m_tracks.size(); ++i)
+            fVisualTracking |= (m_tracks[i].pInteractor != nullptr);
+    }
 
-        m_pTable->reset_jumps();
+    try
+    {
+        do_play(cmd.nEvStart, cmd.nEvEnd, fVisualTracking, cmd.nMM, pInteractor);
 
-        LOMSE_LOG_DEBUG(Logger::k_score_player, "Deleting thread ...");
-        delete m_pThread;
-        m_pThread = nullptr;
+        //AWARE: a pending play request is taken now, so that a stop request, arriving
+        //during housekeeping, will not discard it. End of playback is not notified.
+        {
+            std::lock_guard<std::mutex> lock(m_commandsMutex);
+            m_fRestart = !m_commands.empty()
+                         && m_commands.front().type == PlaybackCommand::k_play;
+            if (m_fRestart)
+            {
+                next = m_commands.front();
+                m_commands.pop_front();
+            }
+        }
+
+        end_of_playback_housekeeping(fVisualTracking, pInteractor);
     }
+    catch(const std::exception& e)     //to catch possible std::bad_weak_ptr
+    {
+        stringstream msg;
+        msg << "std exception caught: " << e.what();
+        LOMSE_LOG_ERROR(msg.str());
+    }
+    catch (...)
+    {
+        LOMSE_LOG_ERROR("Default exception caught");
+    }
+}
 
-    if (m_pThread)
-        m_pThread = nullptr;
+//---------------------------------------------------------------------------------------
+void ScorePlayer::process_commands()
+{
+    //Process the commands received while playing. Play and terminate requests
+    //finish current playback and are left in the queue, to be processed by
+    //thread_main()
 
-    m_fRunning = false;
-    m_fShouldStop = false;
+    std::lock_guard<std::mutex> lock(m_commandsMutex);
+    while (!m_commands.empty())
+    {
+        PlaybackCommand& cmd = m_commands.front();
+        switch (cmd.type)
+        {
+            case PlaybackCommand::k_pause:
+                m_fPaused = !m_fPaused.load();
+                if (m_fPaused)
+                    m_pMidi->all_sounds_off();
+                break;
 
-    LOMSE_LOG_DEBUG(Logger::k_score_player, "<< Exit");
+            case PlaybackCommand::k_stop:
+                m_fShouldStop = true;
+                m_fPaused = false;
+                break;
+
+            case PlaybackCommand::k_tempo:
+                m_nRequestedMM = cmd.nMM;
+                break;
+
+            case PlaybackCommand::k_seek:
+                if (cmd.nEvStart > m_current.nEvEnd)
+                    break;      //out of current segment. Ignore
+                //continue in the new position with current options
+                cmd.type = PlaybackCommand::k_play;
+                cmd.nEvEnd = m_current.nEvEnd;
+                cmd.fVisualTracking = m_current.fVisualTracking;
+                cmd.nMM = m_current.nMM;
+                cmd.pInteractor = m_current.pInteractor;
+                m_fShouldStop = true;
+                m_fPaused = false;
+                return;
+
+            default:    //k_play, k_terminate
+                m_fShouldStop = true;
+                m_fPaused = false;
+                return;
+        }
+        m_commands.pop_front();
+    }
 }
 
 //---------------------------------------------------------------------------------------
-// Methods to be executed in the thread
-//---------------------------------------------------------------------------------------
+void ScorePlayer::wait_while_paused()
+{
+    std::unique_lock<std::mutex> lock(m_commandsMutex);
+    while (m_fPaused && !m_fShouldStop)
+    {
+        m_newCommand.wait(lock, [this]{ return !m_commands.empty(); });
+        lock.unlock();
+        process_commands();
+        lock.lock();
+    }
+}
 
+//---------------------------------------------------------------------------------------
 void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
                           long nMM, Interactor* pInteractor)
 {
@@ -308,8 +645,11 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
     // different thread.
 
     LOMSE_LOG_DEBUG(Logger::k_score_player, ">> Enter");
-    // if no MIDI server or not inside a thread, return
-    if (!m_pMidi || !m_pThread)
+    if (!m_tracks.empty())
+        m_tracks[0].pInteractor = pInteractor;
+
+    // if no MIDI server or not inside a thread (and not offline), return
+    if (!m_pMidi || (!m_pThread && !m_fOffline))
     {
         LOMSE_LOG_DEBUG(Logger::k_score_player, "<< Enter. No Midi or no thread. << Exit");
         return;
@@ -319,13 +659,18 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
 
     //TODO All issues related to sol-fa voice playback
 
-    std::vector<SoundEvent*>& events = m_pTable->get_events();
+    std::vector<SoundEvent>& events = m_pTable->get_events();
     if (events.size() == 0)
     {
         LOMSE_LOG_DEBUG(Logger::k_score_player, "<< Enter. No events to play. << Exit");
         return;
     }
 
+    //start the clock for pacing events
+    m_scheduler.set_offline(m_fOffline);
+    m_scheduler.reset_stats();
+    m_scheduler.start(0L);
+
     const int k_SOLFA_NOTE = 60;            //pitch for sight reading with percussion sound
     int nPercussionChannel = m_MtrChannel;        //channel to use for percussion
 
@@ -375,13 +720,11 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
     //default beat and metronome information. It is going to be properly set
     //when a SoundEvent::k_RhythmChange event is found (a time signature object). So these
     //default settings will be used when no time signature in the score.
-    m_nMtrPulseDuration = long(m_beatDuration);                        //a beat duration, in TU
+    MetronomeState initialState;
+    initialState.initialize(m_nCurMtrIntval, long(m_beatDuration));  //assume 4/4 time signature
+    set_metronome_state(initialState);
     long nMtrIntvalOff = min(7L, m_nMtrPulseDuration / 4L);            //click sound duration, in TU
     long nMtrIntvalNextClick = m_nMtrPulseDuration - nMtrIntvalOff;    //interval from click off to next click
-    m_nCurMeasureDuration = m_nMtrPulseDuration * 4;                   //in TU. Assume 4/4 time signature
-    m_nPrevMeasureDuration = m_nCurMeasureDuration;
-    m_nCurNumPulses = 4;                    //assume 4/4 time signature
-    m_nPrevNumPulses = m_nCurNumPulses;
 
     m_conversionFactor = float(m_nCurMtrIntval) / float(m_nMtrPulseDuration);
     LOMSE_LOG_DEBUG(Logger::k_score_player,
@@ -389,33 +732,44 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
                     "conversionFactor=%f, m_nMtrPulseDuration=%ld",
                     m_nCurMeasureDuration, m_nCurMtrIntval, m_conversionFactor, m_nMtrPulseDuration);
 
+    //absolute time (millisecs) for each event, for current tempo. The table keeps
+    //it updated, so that no conversions are needed in the playback loop
+    std::vector<long>& times = m_pTable->get_timeline(m_conversionFactor);
+
+    //Program instruments. k_prog_instr events are at the start of the table
+    int i = 0;
+    int numEvents = int(events.size());
+    while (i < numEvents && events[i].EventType == SoundEvent::k_prog_instr)
+        program_instrument(events[i++], playMode);
+
+    //Restore the playback state at the start of the measure containing the first
+    //event to play, so that previous measures need not be processed. The metronome
+    //state depends on all previous time signatures and it is saved in the snapshot.
+    int startMeasure = events[nEvStart].Measure;
+    PlaybackSnapshot* pState = m_pTable->get_snapshot(startMeasure);
+    if (pState)
+    {
+        m_pTable->compute_metronome_states(initialState, m_beatType);
+        set_metronome_state(pState->metronome);
+
+        nMtrIntvalOff = min(7L, m_nMtrPulseDuration / 4L);
+        nMtrIntvalNextClick = m_nMtrPulseDuration - nMtrIntvalOff;
+
+        m_pTable->restore_jumps(startMeasure);
+        i = max(i, m_pTable->get_first_event_for_measure(startMeasure));
+    }
+
     //Execute control events that take place before the segment to play, so that
     //instruments and tempo are properly programmed. Continue in the loop while
     //we find control events in segment to play.
-    int i = 0;
     bool fContinue = true;
     while (fContinue)
     {
-        if (events[i]->EventType == SoundEvent::k_prog_instr)
+        if (events[i].EventType == SoundEvent::k_prog_instr)
         {
-            //change program
-            switch (playMode)
-            {
-                case k_play_rhythm_instrument:
-                    m_pMidi->voice_change(events[i]->Channel, 57);        //57 = Trumpet
-                    break;
-                case k_play_rhythm_percussion:
-                    m_pMidi->voice_change(events[i]->Channel, 66);        //66 = High Timbale
-                    break;
-                case k_play_rhythm_human_voice:
-                    //do nothing. Wave sound will be used
-                    break;
-                case k_play_normal_instrument:
-                default:
-                    m_pMidi->voice_change(events[i]->Channel, events[i]->Instrument);
-            }
+            program_instrument(events[i], playMode);
         }
-        else if (events[i]->EventType == SoundEvent::k_rhythm_change)
+        else if (events[i].EventType == SoundEvent::k_rhythm_change)
         {
             set_new_beat_information(events[i]);
 
@@ -443,7 +797,7 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
     //measure
     long curTime = 0L;
 	if (nEvStart > 1)
-		curTime = time_units_to_milliseconds( events[nEvStart]->DeltaTime );
+		curTime = times[nEvStart];
 
 
     //determine last metronome pulse before first note to play.
@@ -454,28 +808,17 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
         nMissingTime -= m_nMtrPulseDuration;
     if (nMissingTime > 0)
         nMissingTime -= m_nMtrPulseDuration;
-    nMtrEvDeltaTime = ((events[i]->DeltaTime / m_nMtrPulseDuration) - 1) * m_nMtrPulseDuration;
+    nMtrEvDeltaTime = ((events[i].DeltaTime / m_nMtrPulseDuration) - 1) * m_nMtrPulseDuration;
     nMtrEvDeltaTime -= nMissingTime;
     curTime = time_units_to_milliseconds( nMtrEvDeltaTime );
     LOMSE_LOG_DEBUG(Logger::k_score_player,
                     "At start: nMtrEvDeltaTime=%ld, event=%d, event time=%ld, anacrusis missing time=%f, "
                     "curTime=%ld, nMissingTime=%ld",
-                    nMtrEvDeltaTime, i, events[i]->DeltaTime, m_pTable->get_anacrusis_missing_time(),
+                    nMtrEvDeltaTime, i, events[i].DeltaTime, m_pTable->get_anacrusis_missing_time(),
                     curTime, nMissingTime);
 
-    //prepare weak_ptr to interactor
-    WpInteractor wpInteractor;
-    if (pInteractor)
-    {
-        SpInteractor sp = pInteractor->get_shared_ptr_from_this();
-        wpInteractor = WpInteractor(sp);
-    }
-    else
-        wpInteractor = WpInteractor();
-
-    //define and prepare highlight event
-    SpEventVisualTracking pEvent(
-            LOMSE_NEW EventVisualTracking(wpInteractor, m_pScore->get_id()) );
+    //define and prepare highlight events, one for each score
+    start_tracking();
 
     bool fFirstBeatInMeasure = true;    //first beat of a measure
     bool fCountOffPulseActive = false;
@@ -498,17 +841,17 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
             bool fAddExtraPulse = false;
 
             //check for implicit rest
-            if (numPulses * m_nMtrPulseDuration < events[i]->DeltaTime)
+            if (numPulses * m_nMtrPulseDuration < events[i].DeltaTime)
                 fAddExtraPulse = true;  //implicit rest
 
             //check for real rest
             else
             {
                 fAddExtraPulse = true;      //assume real rest
-                long time = events[i]->DeltaTime;
-                while (events[i]->DeltaTime == time)
+                long time = events[i].DeltaTime;
+                while (events[i].DeltaTime == time)
                 {
-                    if (events[i]->pSO && events[i]->pSO->is_note())
+                    if (events[i].pSO && events[i].pSO->is_note())
                     {
                         fAddExtraPulse = false;
                         break;
@@ -530,14 +873,16 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
             numPulses += m_nCurNumPulses;
 
         //generate the pulses
+        long countOffTime = 0L;
         for (int j=numPulses; j > 1; --j)
         {
             //generate click
             m_pMidi->note_on(m_MtrChannel, m_MtrTone2, 127);
-            std::chrono::milliseconds waitTime(m_nCurMtrIntval/2L);
-            std::this_thread::sleep_for(waitTime);
+            countOffTime += m_nCurMtrIntval/2L;
+            m_scheduler.wait_until(countOffTime);
             m_pMidi->note_off(m_MtrChannel, m_MtrTone2, 127);
-            std::this_thread::sleep_for(waitTime);
+            countOffTime += m_nCurMtrIntval/2L;
+            m_scheduler.wait_until(countOffTime);
         }
 
         //generate final metronome click before real events
@@ -551,16 +896,44 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
                         "end of count-off: nMtrEvDeltaTime=%ld", nMtrEvDeltaTime);
     }
 
+    //from now on, deadlines are expressed in score time
+    m_scheduler.set_current_time(curTime);
+
+    //start the notes tied from previous measure, as their note on events will not be
+    //played
+    if (pState && nEvStart == m_pTable->get_first_event_for_measure(startMeasure))
+    {
+        std::vector<int>::iterator it;
+        for (it = pState->tiedNotes.begin(); it != pState->tiedNotes.end(); ++it)
+        {
+            const SoundEvent& ev = events[*it];
+            switch(playMode)
+            {
+                case k_play_rhythm_instrument:
+                    m_pMidi->note_on(ev.Channel, k_SOLFA_NOTE, ev.Volume);
+                    break;
+                case k_play_rhythm_percussion:
+                    m_pMidi->note_on(nPercussionChannel, k_SOLFA_NOTE, ev.Volume);
+                    break;
+                case k_play_rhythm_human_voice:
+                    break;
+                case k_play_normal_instrument:
+                default:
+                    m_pMidi->note_on(ev.Channel, ev.NotePitch, ev.Volume);
+            }
+        }
+    }
+
     //loop to process events
     do
     {
         LOMSE_LOG_DEBUG(Logger::k_score_player,
                         "new iteration: i=%d, curTime=%ld, nMtrEvDeltaTime=%ld, "
-                        "events[i]->DeltaTime=%ld",
-                        i, curTime, nMtrEvDeltaTime, events[i]->DeltaTime);
+                        "events[i].DeltaTime=%ld",
+                        i, curTime, nMtrEvDeltaTime, events[i].DeltaTime);
 
         //Verify if next event is a metronome click on/off
-        if (nMtrEvDeltaTime <= events[i]->DeltaTime)
+        if (nMtrEvDeltaTime <= events[i].DeltaTime)
         {
             //Next event should be a metronome click or the click off event for the previous metronome click
             nEvTime = time_units_to_milliseconds(nMtrEvDeltaTime);
@@ -568,31 +941,15 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
             if (curTime < nEvTime)
             {
                 //flush pending events
-                long elapsed = 0L;
-                if (fVisualTracking && pEvent->get_num_items() > 0)
-                {
-                    clock_t t1=clock();
-                    if (m_fPostEvents)
-                        m_libScope.post_event(pEvent);
-                    else if (pInteractor)
-                        pInteractor->handle_event(pEvent);
-                    pEvent = SpEventVisualTracking(
-                                LOMSE_NEW EventVisualTracking(wpInteractor,
-                                                              m_pScore->get_id()) );
-                    clock_t t2=clock();
-                    elapsed = long( ((t2-t1)*1000.0)/double(CLOCKS_PER_SEC));
-                }
+                if (fVisualTracking)
+                    flush_tracking_events();
 
-                //wait for current time
-                long waitT = nEvTime - curTime - elapsed;
-                if (waitT > 0L)
-                {
-                    std::chrono::milliseconds waitTime(waitT);
-                    std::this_thread::sleep_for(waitTime);
-                }
+                //wait for current time. The deadline is absolute, so the time
+                //spent flushing events is automatically discounted
+                m_scheduler.wait_until(nEvTime);
                 curTime = nEvTime;
-                LOMSE_LOG_DEBUG(Logger::k_score_player, "flush pending events: waitT=%ld, new curTime=%ld",
-                                waitT, curTime);
+                LOMSE_LOG_DEBUG(Logger::k_score_player, "flush pending events: new curTime=%ld",
+                                curTime);
             }
 
             if (fSendMtrOff)
@@ -626,7 +983,7 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
 
                 if (fVisualTracking && nMtrEvDeltaTime >= 0L)
                 {
-                    pEvent->add_move_tempo_line_event(nMtrEvDeltaTime);
+                    add_tempo_line_item(nMtrEvDeltaTime);
                     LOMSE_LOG_DEBUG(Logger::k_events | Logger::k_score_player,
                                     "k_move_tempo_line to timepos %ld generated",
                                     nMtrEvDeltaTime);
@@ -644,51 +1001,33 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
         else
         {
             //next even comes from the table. Usually it will be a note on/off
-            nEvTime = time_units_to_milliseconds( events[i]->DeltaTime );
+            nEvTime = times[i];
             LOMSE_LOG_DEBUG(Logger::k_score_player, "nEvTime updated (event i) = %ld", nEvTime);
             if (nEvTime > curTime)
             {
                 //flush accumulated events for curTime
-                long elapsed = 0L;
-                if (fVisualTracking && pEvent->get_num_items() > 0)
-                {
-                    LOMSE_LOG_DEBUG(Logger::k_events | Logger::k_score_player,
-                                    "Flush pending events");
-                    clock_t t1=clock();
-                    if (m_fPostEvents)
-                        m_libScope.post_event(pEvent);
-                    else if (pInteractor)
-                        pInteractor->handle_event(pEvent);
-                    pEvent = SpEventVisualTracking(
-                                LOMSE_NEW EventVisualTracking(wpInteractor,
-                                                              m_pScore->get_id()) );
-                    clock_t t2=clock();
-                    elapsed = long( ((t2-t1)*1000.0)/double(CLOCKS_PER_SEC));
-                }
+                if (fVisualTracking)
+                    flush_tracking_events();
 
                 //wait until new time arrives
-                long waitT = nEvTime - curTime - elapsed;
-                if (waitT > 0L)
-                {
-                    std::chrono::milliseconds waitTime(waitT);
-                    std::this_thread::sleep_for(waitTime);
-                }
+                m_scheduler.wait_until(nEvTime);
             }
 
             //if it is a jump event, execute the jump if applicable
-            if (events[i]->EventType == SoundEvent::k_jump)
+            if (events[i].EventType == SoundEvent::k_jump)
             {
                 bool fExecuted = false;
-                JumpEntry* pJump = events[i]->pJump;
+                JumpEntry* pJump = events[i].pJump;
                 if (pJump->get_visited() >= pJump->get_times_before())
                 {
                     if (pJump->get_times_valid() == 0
                         || pJump->get_times_valid() > pJump->get_executed())
                     {
                         i = pJump->get_event();
-                        nEvTime = time_units_to_milliseconds( events[i]->DeltaTime );
+                        nEvTime = times[i];
                         curTime = nEvTime;
-                        nMtrEvDeltaTime = events[i]->DeltaTime;
+                        m_scheduler.set_current_time(curTime);
+                        nMtrEvDeltaTime = events[i].DeltaTime;
                         if (pJump->get_times_valid() > pJump->get_executed())
                             pJump->increment_applied();
                         fExecuted = true;
@@ -704,45 +1043,45 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
             }
 
 
-            if (events[i]->EventType == SoundEvent::k_note_on)
+            if (events[i].EventType == SoundEvent::k_note_on)
             {
                 //start of note
                 switch(playMode)
                 {
                     case k_play_rhythm_instrument:
-                        m_pMidi->note_on(events[i]->Channel, k_SOLFA_NOTE,
-                                        events[i]->Volume);
+                        m_pMidi->note_on(events[i].Channel, k_SOLFA_NOTE,
+                                        events[i].Volume);
                         break;
                     case k_play_rhythm_percussion:
                         m_pMidi->note_on(nPercussionChannel, k_SOLFA_NOTE,
-                                        events[i]->Volume);
+                                        events[i].Volume);
                         break;
                     case k_play_rhythm_human_voice:
-                        //WaveOn .NoteStep, events[i]->Volume);
+                        //WaveOn .NoteStep, events[i].Volume);
                         break;
                     case k_play_normal_instrument:
                     default:
-                        m_pMidi->note_on(events[i]->Channel, events[i]->NotePitch,
-                                        events[i]->Volume);
+                        m_pMidi->note_on(events[i].Channel, events[i].NotePitch,
+                                        events[i].Volume);
                 }
 
                 //generate implicit visual on event
-                if (fVisualTracking && events[i]->pSO->is_visible())
+                if (fVisualTracking && events[i].pSO->is_visible())
                 {
-                    ImoId id = events[i]->pSO->get_id();
-                    pEvent->add_item(EventVisualTracking::k_highlight_on, id);
+                    ImoId id = events[i].pSO->get_id();
+                    add_tracking_item(events[i].Score, EventVisualTracking::k_highlight_on, id);
                     LOMSE_LOG_DEBUG(Logger::k_events | Logger::k_score_player,
                                     "implicit k_highlight_on generated for %d", id);
                 }
                 LOMSE_LOG_DEBUG(Logger::k_score_player, "Note On");
             }
-            else if (events[i]->EventType == SoundEvent::k_note_off)
+            else if (events[i].EventType == SoundEvent::k_note_off)
             {
                 //end of note
                 switch(playMode)
                 {
                     case k_play_rhythm_instrument:
-                        m_pMidi->note_off(events[i]->Channel, k_SOLFA_NOTE, 127);
+                        m_pMidi->note_off(events[i].Channel, k_SOLFA_NOTE, 127);
                         break;
                     case k_play_rhythm_percussion:
                         m_pMidi->note_off(nPercussionChannel, k_SOLFA_NOTE, 127);
@@ -752,48 +1091,50 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
                         break;
                     case k_play_normal_instrument:
                     default:
-                        m_pMidi->note_off(events[i]->Channel, events[i]->NotePitch, 127);
+                        m_pMidi->note_off(events[i].Channel, events[i].NotePitch, 127);
                 }
 
                 //generate implicit visual off event
-                if (fVisualTracking && events[i]->pSO->is_visible())
+                if (fVisualTracking && events[i].pSO->is_visible())
                 {
-                    pEvent->add_item(EventVisualTracking::k_highlight_off, events[i]->pSO->get_id());
+                    add_tracking_item(events[i].Score, EventVisualTracking::k_highlight_off,
+                                      events[i].pSO->get_id());
                     LOMSE_LOG_DEBUG(Logger::k_events | Logger::k_score_player,
                                     "implicit k_highlight_off generated for %d",
-                                    events[i]->pSO->get_id());
+                                    events[i].pSO->get_id());
                 }
                 LOMSE_LOG_DEBUG(Logger::k_score_player, "Note Off");
             }
-            else if (events[i]->EventType == SoundEvent::k_visual_on)
+            else if (events[i].EventType == SoundEvent::k_visual_on)
             {
                 //set visual highlight
                 if (fVisualTracking)
                 {
-                    ImoId id = events[i]->pSO->get_id();
-                    pEvent->add_item(EventVisualTracking::k_highlight_on, id);
+                    ImoId id = events[i].pSO->get_id();
+                    add_tracking_item(events[i].Score, EventVisualTracking::k_highlight_on, id);
                     LOMSE_LOG_DEBUG(Logger::k_events | Logger::k_score_player,
                                     "explicit k_highlight_on generated for %d", id);
                 }
             }
-            else if (events[i]->EventType == SoundEvent::k_visual_off)
+            else if (events[i].EventType == SoundEvent::k_visual_off)
             {
                 //remove visual highlight
                 if (fVisualTracking)
                 {
-                    pEvent->add_item(EventVisualTracking::k_highlight_off, events[i]->pSO->get_id());
+                    add_tracking_item(events[i].Score, EventVisualTracking::k_highlight_off,
+                                      events[i].pSO->get_id());
                     LOMSE_LOG_DEBUG(Logger::k_events | Logger::k_score_player,
                                     "explicit k_highlight_off generated for %d",
-                                    events[i]->pSO->get_id());
+                                    events[i].pSO->get_id());
                 }
 
             }
-            else if (events[i]->EventType == SoundEvent::k_end_of_score)
+            else if (events[i].EventType == SoundEvent::k_end_of_score)
             {
                 //end of table
                 break;
             }
-            else if (events[i]->EventType == SoundEvent::k_rhythm_change)
+            else if (events[i].EventType == SoundEvent::k_rhythm_change)
             {
                 set_new_beat_information(events[i]);
 
@@ -804,24 +1145,9 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
                                 "new TS: nCurMeasureDuration=%ld, nCurMtrIntval=%ld",
                                 m_nCurMeasureDuration, m_nCurMtrIntval);
             }
-            else if (events[i]->EventType == SoundEvent::k_prog_instr)
+            else if (events[i].EventType == SoundEvent::k_prog_instr)
             {
-                //change program
-                switch (playMode)
-                {
-                    case k_play_rhythm_instrument:
-                        m_pMidi->voice_change(events[i]->Channel, 57);        //57 = Trumpet
-                        break;
-                    case k_play_rhythm_percussion:
-                        m_pMidi->voice_change(events[i]->Channel, 66);        //66 = High Timbale
-                        break;
-                    case k_play_rhythm_human_voice:
-                        //do nothing. Wave sound will be used
-                        break;
-                    case k_play_normal_instrument:
-                    default:
-                        m_pMidi->voice_change(events[i]->Channel, events[i]->NotePitch);
-                }
+                program_instrument(events[i], playMode);
             }
             else
             {
@@ -835,15 +1161,21 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
             LOMSE_LOG_DEBUG(Logger::k_score_player, "Increment i: curTime=%ld", curTime);
         }
 
-        //check if the thread should be paused or stopped
+        //process requests received while playing, and check if the thread should
+        //be paused or stopped
+        if (!m_fOffline)
+            process_commands();
         if (m_fShouldStop)
         {
             LOMSE_LOG_DEBUG(Logger::k_score_player, "Going to finish 1");
             break;
         }
-        while(m_fPaused)
+        if (m_fPaused)
         {
-            std::this_thread::sleep_for( std::chrono::milliseconds(200) );
+            //time while paused is not part of the playback timeline
+            m_scheduler.pause();
+            wait_while_paused();
+            m_scheduler.resume();
             if (m_fShouldStop)
             {
                 LOMSE_LOG_DEBUG(Logger::k_score_player, "Going to finish 2");
@@ -851,21 +1183,35 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
             }
         }
 
-        //update metronome information, just in case metronome was updated
-        if (nMM == 0)   //AWARE: nMM==0 means: "read tempo from GUI controls"
+        //update metronome information, just in case tempo or metronome was updated
+        long newBpm = 0L;
+        if (m_nRequestedMM > 0L)
+        {
+            //from now on, tempo in GUI controls is ignored
+            nMM = m_nRequestedMM;
+            m_nRequestedMM = 0L;
+            newBpm = nMM;
+        }
+        else if (nMM == 0)   //AWARE: nMM==0 means: "read tempo from GUI controls"
         {
             long curGuiBpm = m_pPlayerGui->get_metronome_mm();
             if (m_prevGuiBpm != curGuiBpm)
             {
-                long newMtrClickIntval = 60000L / curGuiBpm;
-                float factor = float(newMtrClickIntval) / float(m_nCurMtrIntval);
-                m_conversionFactor *= factor;
-                m_nPrevMtrIntval = long( float(m_nPrevMtrIntval) * factor);
-                m_nCurMtrIntval = newMtrClickIntval;
-                curTime = time_units_to_milliseconds( events[i-1]->DeltaTime );
+                newBpm = curGuiBpm;
                 m_prevGuiBpm = curGuiBpm;
             }
         }
+        if (newBpm > 0L)
+        {
+            long newMtrClickIntval = 60000L / newBpm;
+            float factor = float(newMtrClickIntval) / float(m_nCurMtrIntval);
+            m_conversionFactor *= factor;
+            m_nPrevMtrIntval = long( float(m_nPrevMtrIntval) * factor);
+            m_nCurMtrIntval = newMtrClickIntval;
+            m_pTable->get_timeline(m_conversionFactor);     //recompute times
+            curTime = times[i-1];
+            m_scheduler.set_current_time(curTime);
+        }
         fPlayWithMetronome = m_pPlayerGui->metronome_status();
 
     } while (i <= nEvEnd);
@@ -876,18 +1222,7 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
 
     //ensure that all visual highlight is removed
     if (fVisualTracking && !m_fQuit)
-    {
-        m_fFinalEventSent = true;
-        SpEventVisualTracking pEvent(
-            LOMSE_NEW EventVisualTracking(wpInteractor, m_pScore->get_id()) );
-        pEvent->add_item(EventVisualTracking::k_end_of_visual_tracking, k_no_imoid);
-        LOMSE_LOG_DEBUG(Logger::k_events | Logger::k_score_player,
-                        "Flush pending events");
-        if (m_fPostEvents)
-            m_libScope.post_event(pEvent);
-        else if (pInteractor)
-            pInteractor->handle_event(pEvent);
-    }
+        end_tracking();
     LOMSE_LOG_DEBUG(Logger::k_score_player, "<< Exit");
 }
 
@@ -899,24 +1234,7 @@ void ScorePlayer::end_of_playback_housekeeping(bool fVisualTracking,
 
     //ensure that all visual highlight is removed
     if (fVisualTracking && !m_fQuit && !m_fFinalEventSent)
-    {
-        m_fFinalEventSent = true;
-        WpInteractor wpInteractor;
-        if (pInteractor)
-        {
-            SpInteractor sp = pInteractor->get_shared_ptr_from_this();
-            wpInteractor = WpInteractor(sp);
-        }
-        else
-            wpInteractor = WpInteractor();
-        SpEventVisualTracking pEvent(
-            LOMSE_NEW EventVisualTracking(wpInteractor, m_pScore->get_id()) );
-        pEvent->add_item(EventVisualTracking::k_end_of_visual_tracking, k_no_imoid);
-        if (m_fPostEvents)
-            m_libScope.post_event(pEvent);
-        else if (pInteractor)
-            pInteractor->handle_event(pEvent);
-    }
+        end_tracking();
 
     //ensure that all sounds are off
     m_pMidi->all_sounds_off();
@@ -924,8 +1242,8 @@ void ScorePlayer::end_of_playback_housekeeping(bool fVisualTracking,
     //reset all jumps
     m_pTable->reset_jumps();
 
-    //do not generate events if quit
-    if (m_fQuit)
+    //do not generate events if quit or if a new playback follows
+    if (m_fQuit || m_fRestart)
     {
         LOMSE_LOG_DEBUG(Logger::k_score_player, "<< Exit");
         return;
@@ -938,6 +1256,7 @@ void ScorePlayer::end_of_playback_housekeeping(bool fVisualTracking,
     // allow view updates
     if (pInteractor)
         pInteractor->enable_forced_view_updates(true);
+    enable_forced_view_updates(true);
 
     //create event for updating player gui
     if (m_pPlayerGui)
@@ -964,41 +1283,151 @@ void ScorePlayer::end_of_playback_housekeeping(bool fVisualTracking,
 }
 
 //---------------------------------------------------------------------------------------
-void ScorePlayer::set_new_beat_information(SoundEvent* pEvent)
+void ScorePlayer::start_tracking()
 {
-    if (m_beatType == k_beat_specified)
+    //Prepare the visual tracking event for each score with Interactor
+
+    vector<PlaybackTrack>::iterator it;
+    for (it = m_tracks.begin(); it != m_tracks.end(); ++it)
     {
-        //No need for changes as specified duration is already in use
+        it->pEvent.reset();
+        it->wpInteractor.reset();
+        if (it->pInteractor)
+        {
+            it->wpInteractor = WpInteractor(it->pInteractor->get_shared_ptr_from_this());
+            it->pEvent = SpEventVisualTracking(
+                    LOMSE_NEW EventVisualTracking(it->wpInteractor,
+                                                  it->pScore->get_id()) );
+        }
     }
-    else
-    {
-        long saveCurMtrIntval = m_nCurMtrIntval;
-        long saveCurMeasureDuration = m_nCurMeasureDuration;
-        long saveCurNumPulses = m_nCurNumPulses;
+}
 
-        if (m_beatType == k_beat_implied)
+//---------------------------------------------------------------------------------------
+void ScorePlayer::flush_tracking_events()
+{
+    vector<PlaybackTrack>::iterator it;
+    for (it = m_tracks.begin(); it != m_tracks.end(); ++it)
+    {
+        if (it->pEvent && it->pEvent->get_num_items() > 0)
         {
-            m_nCurMeasureDuration = pEvent->TopNumber * pEvent->BeatDuration;
-            m_nCurNumPulses = pEvent->NumPulses;
+            LOMSE_LOG_DEBUG(Logger::k_events | Logger::k_score_player,
+                            "Flush pending events");
+            if (m_fPostEvents)
+                m_libScope.post_event(it->pEvent);
+            else
+                it->pInteractor->handle_event(it->pEvent);
+            it->pEvent = SpEventVisualTracking(
+                    LOMSE_NEW EventVisualTracking(it->wpInteractor,
+                                                  it->pScore->get_id()) );
         }
-        else if (m_beatType == k_beat_bottom_ts)
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ScorePlayer::end_tracking()
+{
+    //send the end of visual tracking to all scores with Interactor
+
+    m_fFinalEventSent = true;
+    vector<PlaybackTrack>::iterator it;
+    for (it = m_tracks.begin(); it != m_tracks.end(); ++it)
+    {
+        if (!it->pInteractor)
+            continue;
+
+        if (it == m_tracks.begin() && m_fUseTrackingRing)
         {
-            m_nCurMeasureDuration = pEvent->TopNumber * pEvent->BeatDuration;
-            m_nCurNumPulses = pEvent->TopNumber;
+            m_trackingRing.push(EventVisualTracking::k_end_of_visual_tracking,
+                                it->pScore->get_id(), k_no_imoid, 0.0);
+            continue;
         }
 
-        //adjust metronome clicks interval for maintaining notes duration equivalence
-        m_nCurMtrIntval = long( float(m_nPrevMtrIntval) *
-            (float(m_nCurMeasureDuration * m_nPrevNumPulses) /
-             float(m_nPrevMeasureDuration * m_nCurNumPulses) ));           //current TS: metronome click interval, in milliseconds
+        WpInteractor wpInteractor(it->pInteractor->get_shared_ptr_from_this());
+        SpEventVisualTracking pEvent(
+            LOMSE_NEW EventVisualTracking(wpInteractor, it->pScore->get_id()) );
+        pEvent->add_item(EventVisualTracking::k_end_of_visual_tracking, k_no_imoid);
+        if (m_fPostEvents)
+            m_libScope.post_event(pEvent);
+        else
+            it->pInteractor->handle_event(pEvent);
+    }
+}
 
-        //save old values
-        m_nPrevMtrIntval = saveCurMtrIntval;
-        m_nPrevMeasureDuration = saveCurMeasureDuration;
-        m_nPrevNumPulses = saveCurNumPulses;
+//---------------------------------------------------------------------------------------
+void ScorePlayer::enable_forced_view_updates(bool value)
+{
+    //for the Interactors of mixed scores. The Interactor for the main score is
+    //managed by the caller
 
-        m_nMtrPulseDuration = m_nCurMeasureDuration / m_nCurNumPulses;        //a pulse duration
+    for (size_t i=1; i < m_tracks.size(); ++i)
+    {
+        if (m_tracks[i].pInteractor)
+            m_tracks[i].pInteractor->enable_forced_view_updates(value);
     }
+}
+
+//---------------------------------------------------------------------------------------
+void ScorePlayer::add_tracking_item(int score, int type, ImoId id)
+{
+    //when using the tracking ring, records for the main score are stored in the ring
+    //instead of in the event and no event will be sent
+
+    PlaybackTrack& track = m_tracks[score];
+    if (score == 0 && m_fUseTrackingRing)
+    {
+        if (!m_trackingRing.push(type, track.pScore->get_id(), id, 0.0))
+            LOMSE_LOG_DEBUG(Logger::k_score_player, "Tracking ring full. Record dropped");
+    }
+    else if (track.pEvent)
+        track.pEvent->add_item(type, id);
+}
+
+//---------------------------------------------------------------------------------------
+void ScorePlayer::add_tempo_line_item(TimeUnits timepos)
+{
+    //all scores share the timeline. The tempo line is moved in all of them
+
+    vector<PlaybackTrack>::iterator it;
+    for (it = m_tracks.begin(); it != m_tracks.end(); ++it)
+    {
+        if (it == m_tracks.begin() && m_fUseTrackingRing)
+        {
+            if (!m_trackingRing.push(EventVisualTracking::k_move_tempo_line,
+                                     it->pScore->get_id(), k_no_imoid, timepos))
+                LOMSE_LOG_DEBUG(Logger::k_score_player, "Tracking ring full. Record dropped");
+        }
+        else if (it->pEvent)
+            it->pEvent->add_move_tempo_line_event(timepos);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ScorePlayer::program_instrument(const SoundEvent& event, int playMode)
+{
+    switch (playMode)
+    {
+        case k_play_rhythm_instrument:
+            m_pMidi->voice_change(event.Channel, 57);        //57 = Trumpet
+            break;
+        case k_play_rhythm_percussion:
+            m_pMidi->voice_change(event.Channel, 66);        //66 = High Timbale
+            break;
+        case k_play_rhythm_human_voice:
+            //do nothing. Wave sound will be used
+            break;
+        case k_play_normal_instrument:
+        default:
+            m_pMidi->voice_change(event.Channel, event.Instrument);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void ScorePlayer::set_new_beat_information(const SoundEvent& event)
+{
+    MetronomeState state = get_metronome_state();
+    state.apply_rhythm_change(event, m_beatType);
+    set_metronome_state(state);
+
 //    LOMSE_LOG_DEBUG(Logger::k_score_player,
 //        "PrevMeasureDuration=%ld, CurMeasureDuration=%ld, PrevNumPulses=%ld, CurNumPulses=%ld, "
 //        "PrevMtrIntval=%ld, CurMtrIntval=%ld, MtrPulseDuration=%ld",
@@ -1006,6 +1435,216 @@ void ScorePlayer::set_new_beat_information(SoundEvent* pEvent)
 //        m_nPrevMtrIntval, m_nCurMtrIntval, m_nMtrPulseDuration);
 }
 
+//---------------------------------------------------------------------------------------
+MetronomeState ScorePlayer::get_metronome_state()
+{
+    MetronomeState state;
+    state.curMtrIntval = m_nCurMtrIntval;
+    state.prevMtrIntval = m_nPrevMtrIntval;
+    state.curMeasureDuration = m_nCurMeasureDuration;
+    state.prevMeasureDuration = m_nPrevMeasureDuration;
+    state.curNumPulses = m_nCurNumPulses;
+    state.prevNumPulses = m_nPrevNumPulses;
+    state.mtrPulseDuration = m_nMtrPulseDuration;
+    return state;
+}
+
+//---------------------------------------------------------------------------------------
+void ScorePlayer::set_metronome_state(const MetronomeState& state)
+{
+    m_nCurMtrIntval = state.curMtrIntval;
+    m_nPrevMtrIntval = state.prevMtrIntval;
+    m_nCurMeasureDuration = state.curMeasureDuration;
+    m_nPrevMeasureDuration = state.prevMeasureDuration;
+    m_nCurNumPulses = state.curNumPulses;
+    m_nPrevNumPulses = state.prevNumPulses;
+    m_nMtrPulseDuration = state.mtrPulseDuration;
+}
+
+
+//=======================================================================================
+// VisualTrackingRing implementation
+//=======================================================================================
+VisualTrackingRing::VisualTrackingRing(size_t capacity)
+    : m_mask(0)
+    , m_head(0)
+    , m_tail(0)
+    , m_dropped(0L)
+{
+    //round up capacity to a power of two, so that the index in the buffer can be
+    //computed with a mask
+    size_t size = 1;
+    while (size < capacity)
+        size <<= 1;
+    m_records.resize(size);
+    m_mask = size - 1;
+}
+
+//---------------------------------------------------------------------------------------
+bool VisualTrackingRing::push(int type, ImoId scoreId, ImoId id, TimeUnits timepos)
+{
+    //Head and tail are free running counters. Only the producer modifies the tail
+    //and only the consumer modifies the head, so no locks are needed. The release
+    //store on the tail makes the record visible to the consumer before the new tail.
+
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) >= m_records.size())
+    {
+        ++m_dropped;
+        return false;
+    }
+
+    VisualTrackingRecord& record = m_records[tail & m_mask];
+    record.type = type;
+    record.scoreId = scoreId;
+    record.id = id;
+    record.timepos = timepos;
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+bool VisualTrackingRing::pop(VisualTrackingRecord& record)
+{
+    size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire))
+        return false;
+
+    record = m_records[head & m_mask];
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+
+//=======================================================================================
+// PlaybackScheduler implementation
+//=======================================================================================
+PlaybackScheduler::PlaybackScheduler()
+    : m_origin( Clock::now() )
+    , m_start(m_origin)
+    , m_lastDeadline(m_origin)
+    , m_pauseStart(m_origin)
+    , m_spinTime(0)
+    , m_fOffline(false)
+    , m_numEvents(0L)
+    , m_sumLatency(0.0)
+    , m_sumSqLatency(0.0)
+    , m_maxLatency(0.0)
+{
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackScheduler::start(long time)
+{
+    //current time point corresponds to timeline position 'time'. When offline,
+    //time is simulated and starts at the clock epoch
+
+    m_start = (m_fOffline ? Clock::time_point() : Clock::now());
+    m_lastDeadline = m_start;
+    m_origin = m_lastDeadline - std::chrono::milliseconds(time);
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackScheduler::set_current_time(long time)
+{
+    //last deadline now corresponds to timeline position 'time'. This is used for
+    //jumps and tempo changes, so that the timeline continues from the last deadline
+    //instead of from current time, and errors are not accumulated
+
+    m_origin = m_lastDeadline - std::chrono::milliseconds(time);
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackScheduler::wait_until(long time)
+{
+    Clock::time_point deadline = m_origin + std::chrono::milliseconds(time);
+
+    if (m_fOffline)
+    {
+        m_lastDeadline = deadline;
+        return;
+    }
+
+    if (m_spinTime.count() > 0)
+    {
+        //sleep until shortly before the deadline and then busy-wait
+        std::this_thread::sleep_until(deadline - m_spinTime);
+        while (Clock::now() < deadline)
+            ;
+    }
+    else
+        std::this_thread::sleep_until(deadline);
+
+    std::chrono::duration<double, std::micro> latency = Clock::now() - deadline;
+    add_latency(latency.count());
+    m_lastDeadline = deadline;
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackScheduler::pause()
+{
+    m_pauseStart = Clock::now();
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackScheduler::resume()
+{
+    //shift the timeline by the time elapsed while paused
+    Clock::duration paused = Clock::now() - m_pauseStart;
+    m_origin += paused;
+    m_lastDeadline += paused;
+}
+
+//---------------------------------------------------------------------------------------
+long PlaybackScheduler::get_elapsed_time()
+{
+    return long( std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                m_lastDeadline - m_start).count() );
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackScheduler::set_spin_time(long microseconds)
+{
+    m_spinTime = std::chrono::microseconds( max(0L, min(1000L, microseconds)) );
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackScheduler::add_latency(double latency)
+{
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    ++m_numEvents;
+    m_sumLatency += latency;
+    m_sumSqLatency += latency * latency;
+    m_maxLatency = max(m_maxLatency, latency);
+}
+
+//---------------------------------------------------------------------------------------
+PlaybackTimingStats PlaybackScheduler::get_stats()
+{
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    PlaybackTimingStats stats;
+    stats.numEvents = m_numEvents;
+    if (m_numEvents > 0)
+    {
+        double n = double(m_numEvents);
+        stats.meanLatency = m_sumLatency / n;
+        stats.maxLatency = m_maxLatency;
+        double variance = m_sumSqLatency / n - stats.meanLatency * stats.meanLatency;
+        stats.jitter = sqrt( max(0.0, variance) );
+    }
+    return stats;
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackScheduler::reset_stats()
+{
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_numEvents = 0L;
+    m_sumLatency = 0.0;
+    m_sumSqLatency = 0.0;
+    m_maxLatency = 0.0;
+}
+
 
 }   //namespace lomse
 
@@ -0,0 +1,185 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include <UnitTest++.h>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include "lomse_build_options.h"
+
+//classes related to these tests
+#include "lomse_injectors.h"
+#include "lomse_batch_renderer.h"
+#include "lomse_image_writer.h"
+#include "lomse_document.h"
+
+using namespace UnitTest;
+using namespace std;
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+class BatchRendererTestFixture
+{
+public:
+    LibraryScope m_libraryScope;
+    std::string m_scores_path;
+
+    BatchRendererTestFixture()     //SetUp fixture
+        : m_libraryScope(cout)
+    {
+        m_scores_path = TESTLIB_SCORES_PATH;
+        m_libraryScope.set_default_fonts_path(TESTLIB_FONTS_PATH);
+    }
+
+    ~BatchRendererTestFixture()    //TearDown fixture
+    {
+    }
+
+    bool is_white_bitmap(RenderingBuffer* pBitmap)
+    {
+        //rgba32 format
+        for (unsigned y=0; y < pBitmap->height(); ++y)
+        {
+            const unsigned char* p = pBitmap->row_ptr(int(y));
+            for (unsigned x=0; x < pBitmap->width() * 4; ++x)
+            {
+                if (p[x] != 255)
+                    return false;
+            }
+        }
+        return true;
+    }
+};
+
+SUITE(BatchRendererTest)
+{
+
+    TEST_FIXTURE(BatchRendererTestFixture, no_document)
+    {
+        BatchRenderer renderer(m_libraryScope);
+
+        CHECK( renderer.get_presenter() == nullptr );
+        CHECK( renderer.get_num_pages() == 0 );
+        CHECK( renderer.render_page(0, 96.0) == nullptr );
+    }
+
+    TEST_FIXTURE(BatchRendererTestFixture, open_document)
+    {
+        BatchRenderer renderer(m_libraryScope);
+
+        CHECK( renderer.open_document(m_scores_path + "00011-empty-fill-page.lms") == true );
+        CHECK( renderer.get_presenter() != nullptr );
+        CHECK( renderer.get_num_pages() == 1 );
+    }
+
+    TEST_FIXTURE(BatchRendererTestFixture, page_size_in_pixels)
+    {
+        BatchRenderer renderer(m_libraryScope);
+        renderer.new_document("(score (vers 2.0)(instrument (musicData (clef G)(n c4 q))))",
+                              Document::k_format_ldp);
+
+        USize size = renderer.get_page_size(0);
+        VSize pixels = renderer.get_page_size_in_pixels(0, 254.0);
+        CHECK( pixels.width == Pixels(size.width / 10.0f + 0.5f) );
+        CHECK( pixels.height == Pixels(size.height / 10.0f + 0.5f) );
+    }
+
+    TEST_FIXTURE(BatchRendererTestFixture, render_on_internal_bitmap)
+    {
+        BatchRenderer renderer(m_libraryScope);
+        renderer.new_document("(score (vers 2.0)(instrument (musicData (clef G)(n c4 q))))",
+                              Document::k_format_ldp);
+
+        RenderingBuffer* pBitmap = renderer.render_page(0, 72.0);
+        CHECK( pBitmap != nullptr );
+        VSize pixels = renderer.get_page_size_in_pixels(0, 72.0);
+        CHECK( int(pBitmap->width()) == pixels.width );
+        CHECK( int(pBitmap->height()) == pixels.height );
+        CHECK( is_white_bitmap(pBitmap) == false );
+
+        //the internal bitmap is reused
+        CHECK( renderer.render_page(0, 36.0) == pBitmap );
+        CHECK( renderer.render_page(1, 72.0) == nullptr );
+    }
+
+    TEST_FIXTURE(BatchRendererTestFixture, render_on_user_bitmap)
+    {
+        BatchRenderer renderer(m_libraryScope);
+        renderer.new_document("(score (vers 2.0)(instrument (musicData (clef G)(n c4 q))))",
+                              Document::k_format_ldp);
+
+        VSize pixels = renderer.get_page_size_in_pixels(0, 50.0);
+        std::vector<unsigned char> buffer(pixels.width * pixels.height * 4, 0);
+        RenderingBuffer rbuf;
+        rbuf.attach(&buffer[0], pixels.width, pixels.height, pixels.width * 4);
+
+        CHECK( renderer.render_page(0, 50.0, &rbuf) == true );
+        CHECK( buffer[0] == 255 );     //white background
+        CHECK( is_white_bitmap(&rbuf) == false );
+    }
+
+    TEST_FIXTURE(BatchRendererTestFixture, render_zero_size_page)
+    {
+        BatchRenderer renderer(m_libraryScope);
+        renderer.new_document("(score (vers 2.0)(instrument (musicData (clef G)(n c4 q))))",
+                              Document::k_format_ldp);
+
+        CHECK( renderer.render_page(0, 0.0) == nullptr );
+    }
+
+    TEST_FIXTURE(BatchRendererTestFixture, render_as_png_invalid_page)
+    {
+        BatchRenderer renderer(m_libraryScope);
+        renderer.new_document("(score (vers 2.0)(instrument (musicData (clef G)(n c4 q))))",
+                              Document::k_format_ldp);
+        string filename = "batch_renderer_test.png";
+        std::remove(filename.c_str());
+
+        CHECK( renderer.render_page_to_png(1, 30.0, filename) == false );
+        ifstream file(filename.c_str());
+        CHECK( file.good() == false );
+    }
+
+#if (LOMSE_ENABLE_PNG == 1)
+    TEST_FIXTURE(BatchRendererTestFixture, render_as_png)
+    {
+        BatchRenderer renderer(m_libraryScope);
+        renderer.new_document("(score (vers 2.0)(instrument (musicData (clef G)(n c4 q))))",
+                              Document::k_format_ldp);
+
+        stringstream out;
+        CHECK( renderer.render_page_to_png(0, 30.0, out) == true );
+        string png = out.str();
+        CHECK( png.size() > 8 );
+        CHECK( png.substr(1, 3) == "PNG" );
+    }
+#endif
+
+}
@@ -0,0 +1,142 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2016. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include <UnitTest++.h>
+#include <sstream>
+#include "lomse_build_options.h"
+
+//classes related to these tests
+#include "lomse_binary_delta.h"
+
+#include <stdexcept>
+
+using namespace UnitTest;
+using namespace std;
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+class BinaryDeltaTestFixture
+{
+public:
+    string m_source;
+
+    BinaryDeltaTestFixture()     //SetUp fixture
+    {
+        //some kilobytes of not repetitive data
+        unsigned value = 12345;
+        for (int i=0; i < 4000; ++i)
+        {
+            value = value * 1103515245 + 12345;
+            m_source.push_back( char((value >> 16) & 0xFF) );
+        }
+    }
+
+    ~BinaryDeltaTestFixture()    //TearDown fixture
+    {
+    }
+
+    bool round_trip(const string& source, const string& target)
+    {
+        string delta = BinaryDelta::create(source, target);
+        return BinaryDelta::apply(source, delta) == target;
+    }
+};
+
+
+SUITE(BinaryDeltaTest)
+{
+
+    TEST_FIXTURE(BinaryDeltaTestFixture, binary_delta_001)
+    {
+        //@001. identical strings. Small delta
+        string delta = BinaryDelta::create(m_source, m_source);
+
+        CHECK( delta.size() < 10 );
+        CHECK( BinaryDelta::apply(m_source, delta) == m_source );
+    }
+
+    TEST_FIXTURE(BinaryDeltaTestFixture, binary_delta_002)
+    {
+        //@002. bytes inserted and replaced in several places
+        string target = m_source;
+        target.insert(3000, "inserted text");
+        target[2000] = 'a';
+        target.insert(1000, "more text");
+        target[20] = 'b';
+
+        string delta = BinaryDelta::create(m_source, target);
+
+        CHECK( delta.size() < 100 );
+        CHECK( BinaryDelta::apply(m_source, delta) == target );
+    }
+
+    TEST_FIXTURE(BinaryDeltaTestFixture, binary_delta_003)
+    {
+        //@003. bytes removed and blocks moved
+        string target = m_source.substr(2000, 1500) + m_source.substr(0, 1900)
+                        + m_source.substr(3600);
+
+        string delta = BinaryDelta::create(m_source, target);
+
+        CHECK( delta.size() < 50 );
+        CHECK( BinaryDelta::apply(m_source, delta) == target );
+    }
+
+    TEST_FIXTURE(BinaryDeltaTestFixture, binary_delta_004)
+    {
+        //@004. empty and unrelated strings
+        CHECK( round_trip("", "") );
+        CHECK( round_trip("", m_source) );
+        CHECK( round_trip(m_source, "") );
+        CHECK( round_trip(m_source, "abc") );
+        CHECK( round_trip("abc", "abd") );
+        CHECK( round_trip(m_source.substr(0, 2000), m_source.substr(2000)) );
+    }
+
+    TEST_FIXTURE(BinaryDeltaTestFixture, binary_delta_005)
+    {
+        //@005. invalid delta throws exception
+        string target = m_source;
+        target.insert(1000, "inserted text");
+        string delta = BinaryDelta::create(m_source, target);
+
+        bool fException = false;
+        try
+        {
+            BinaryDelta::apply(m_source.substr(0, 500), delta);
+        }
+        catch (runtime_error&)
+        {
+            fException = true;
+        }
+        CHECK( fException );
+    }
+
+}
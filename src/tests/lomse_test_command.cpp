@@ -1359,7 +1359,7 @@ SUITE(DocCommandTest)
         MySelectionSet sel(&doc);
         int result = executer.execute(&cursor, pCmd, &sel);
 
-        CHECK( pCmd->get_undo_policy() == DocCommand::k_undo_policy_partial_checkpoint );
+        CHECK( pCmd->get_undo_policy() == DocCommand::k_undo_policy_selection_checkpoint );
         CHECK ( result == k_success );
         CHECK( doc.is_dirty() == true );
         CHECK( pCmd->get_name() == "Break beam" );
@@ -1989,7 +1989,7 @@ SUITE(DocCommandTest)
         sel.debug_add(pTuplet);
         executer.execute(&cursor, pCmd, &sel);
 
-        CHECK( pCmd->get_undo_policy() == DocCommand::k_undo_policy_partial_checkpoint );
+        CHECK( pCmd->get_undo_policy() == DocCommand::k_undo_policy_selection_checkpoint );
         CHECK( doc.is_dirty() == true );
         CHECK( pCmd->get_name() == "Delete tuplet" );
         CHECK( *cursor != nullptr );
@@ -3629,7 +3629,7 @@ SUITE(DocCommandTest)
 
         executer.execute(&cursor, pCmd, &sel);
 
-        CHECK( pCmd->get_undo_policy() == DocCommand::k_undo_policy_full_checkpoint );
+        CHECK( pCmd->get_undo_policy() == DocCommand::k_undo_policy_selection_checkpoint );
         CHECK( doc.is_dirty() == true );
         CHECK( pCmd->get_name() == "Join beam" );
         CHECK( *cursor != nullptr );
@@ -3653,6 +3653,56 @@ SUITE(DocCommandTest)
 //        cout << pTable->dump();
     }
 
+    TEST_FIXTURE(DocCommandTestFixture, join_beam_2402)
+    {
+        //2402. join two beams. Undo restores both beams from a selection checkpoint
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument#121 (musicData "
+            "(clef G)(n e4 e g+)(n f4 e g-)(n g4 e g+)(n a4 e g-)(barline)"
+            "(n c5 q)(n c5 q)(n c5 q)(n c5 q)(barline)"
+            ")))");
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        string source = doc.to_string(true);
+        doc.clear_dirty();
+        DocCursor cursor(&doc);
+        DocCommandExecuter executer(&doc);
+        cursor.enter_element();     //points to clef
+        cursor.move_next();         //points to e4
+        MySelectionSet sel(&doc);
+        ImoNote* pNote1 = static_cast<ImoNote*>( *cursor );
+        sel.debug_add(pNote1);
+        cursor.move_next();
+        cursor.move_next();         //points to g4
+        ImoNote* pNote3 = static_cast<ImoNote*>( *cursor );
+        sel.debug_add(pNote3);
+        ImoId idNote1 = pNote1->get_id();
+        ImoId idBeam1 = pNote1->get_beam()->get_id();
+        ImoId idBeam2 = pNote3->get_beam()->get_id();
+        DocCommand* pCmd = LOMSE_NEW CmdJoinBeam();
+
+        executer.execute(&cursor, pCmd, &sel);
+
+        CHECK( pCmd->has_selection_checkpoint() == true );
+        CHECK( pCmd->get_undo_data_size()
+               < doc.get_checkpoint_data_for(pScore->get_id()).size() / 2 );
+        CHECK( doc.get_pointer_to_imo(idBeam1) == nullptr );
+        CHECK( doc.get_pointer_to_imo(idBeam2) == nullptr );
+
+        executer.undo(&cursor, &sel);
+
+        CHECK( doc.to_string(true) == source );
+        ImoNote* pNote = static_cast<ImoNote*>( doc.get_pointer_to_imo(idNote1) );
+        CHECK( pNote->get_beam() == doc.get_pointer_to_imo(idBeam1) );
+        CHECK( pNote->get_beam()->get_num_objects() == 2 );
+
+        executer.redo(&cursor, &sel);
+
+        pNote = static_cast<ImoNote*>( *cursor );
+        CHECK( pNote->get_step() == k_step_G );
+        CHECK( pNote->is_beamed() == true );
+        CHECK( pNote->get_beam()->get_num_objects() == 2 );
+    }
+
     // DocCmdComposite ------------------------------------------------------------------
 
     TEST_FIXTURE(DocCommandTestFixture, composite_cmd_2501)
@@ -5180,4 +5230,237 @@ SUITE(DocCommandTest)
         CHECK( pNote && pNote->get_notated_accidentals() == k_no_accidentals );
     }
 
+
+    //@ DocCommandExecuter. Undo data --------------------------------------------------
+
+    TEST_FIXTURE(DocCommandTestFixture, executer_undo_data_01)
+    {
+        //@01. only the checkpoint of last command is stored in full. Undo/redo ok
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument#121 (musicData "
+            "(clef G)(n c4 q)(n d4 q)(n e4 q)(barline)"
+            ")))");
+        doc.clear_dirty();
+        DocCursor cursor(&doc);
+        DocCommandExecuter executer(&doc);
+        MySelectionSet sel(&doc);
+        cursor.enter_element();     //points to clef
+        while (*cursor != nullptr)
+            cursor.move_next();     //points to end of score
+
+        string s0 = doc.to_string();
+        DocCommand* pCmd1 = LOMSE_NEW CmdAddNoteRest("(n a4 e v1)", k_edit_mode_replace);
+        executer.execute(&cursor, pCmd1, &sel);
+        string s1 = doc.to_string();
+        DocCommand* pCmd2 = LOMSE_NEW CmdAddNoteRest("(n b4 e v1)", k_edit_mode_replace);
+        executer.execute(&cursor, pCmd2, &sel);
+        string s2 = doc.to_string();
+        DocCommand* pCmd3 = LOMSE_NEW CmdAddNoteRest("(n c5 e v1)", k_edit_mode_replace);
+        executer.execute(&cursor, pCmd3, &sel);
+        string s3 = doc.to_string();
+
+        CHECK( pCmd1->is_checkpoint_delta() == true );
+        CHECK( pCmd2->is_checkpoint_delta() == true );
+        CHECK( pCmd3->is_checkpoint_delta() == false );
+        CHECK( executer.get_undo_memory_used() < 2 * pCmd3->get_undo_data_size() );
+
+        executer.undo(&cursor, &sel);
+        CHECK( doc.to_string() == s2 );
+        CHECK( pCmd2->is_checkpoint_delta() == false );
+        executer.undo(&cursor, &sel);
+        CHECK( doc.to_string() == s1 );
+        executer.redo(&cursor, &sel);
+        CHECK( doc.to_string() == s2 );
+        CHECK( pCmd1->is_checkpoint_delta() == true );
+        executer.redo(&cursor, &sel);
+        CHECK( doc.to_string() == s3 );
+        executer.undo(&cursor, &sel);
+        executer.undo(&cursor, &sel);
+        executer.undo(&cursor, &sel);
+        CHECK( doc.to_string() == s0 );
+        CHECK( executer.is_undo_possible() == false );
+    }
+
+    TEST_FIXTURE(DocCommandTestFixture, executer_undo_data_02)
+    {
+        //@02. memory limit. Oldest commands are removed but not the last one
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument#121 (musicData "
+            "(clef G)(n c4 q)(n d4 q)(n e4 q)(barline)"
+            ")))");
+        doc.clear_dirty();
+        DocCursor cursor(&doc);
+        DocCommandExecuter executer(&doc);
+        MySelectionSet sel(&doc);
+        cursor.enter_element();     //points to clef
+        while (*cursor != nullptr)
+            cursor.move_next();     //points to end of score
+        CHECK( executer.get_undo_memory_limit() == 0 );
+
+        executer.execute(&cursor, LOMSE_NEW CmdAddNoteRest("(n a4 e v1)",
+                                                           k_edit_mode_replace), &sel);
+        executer.execute(&cursor, LOMSE_NEW CmdAddNoteRest("(n b4 e v1)",
+                                                           k_edit_mode_replace), &sel);
+        string s2 = doc.to_string();
+        CHECK( executer.undo_stack_size() == 2 );
+
+        executer.set_undo_memory_limit(1);
+        CHECK( executer.undo_stack_size() == 1 );
+
+        executer.execute(&cursor, LOMSE_NEW CmdAddNoteRest("(n c5 e v1)",
+                                                           k_edit_mode_replace), &sel);
+        CHECK( executer.undo_stack_size() == 1 );
+
+        executer.undo(&cursor, &sel);
+        CHECK( doc.to_string() == s2 );
+        CHECK( executer.is_undo_possible() == false );
+    }
+
+    TEST_FIXTURE(DocCommandTestFixture, executer_transaction_01)
+    {
+        //@01. commands in a transaction are undone/redone as a single command
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument#121 (musicData "
+            "(clef G)(n c4 q)(n d4 q)(n e4 q)(barline)"
+            ")))");
+        doc.clear_dirty();
+        DocCursor cursor(&doc);
+        DocCommandExecuter executer(&doc);
+        MySelectionSet sel(&doc);
+        cursor.enter_element();     //points to clef
+        while (*cursor != nullptr)
+            cursor.move_next();     //points to end of score
+
+        string s0 = doc.to_string();
+        executer.begin_transaction(&cursor, &sel, "Add notes");
+        executer.execute(&cursor, LOMSE_NEW CmdAddNoteRest("(n a4 e v1)",
+                                                           k_edit_mode_replace), &sel);
+        executer.execute(&cursor, LOMSE_NEW CmdAddNoteRest("(n b4 e v1)",
+                                                           k_edit_mode_replace), &sel);
+        executer.execute(&cursor, LOMSE_NEW CmdAddNoteRest("(n c5 e v1)",
+                                                           k_edit_mode_replace), &sel);
+        CHECK( executer.is_transaction_open() == true );
+        CHECK( executer.undo_stack_size() == 0 );
+        executer.commit_transaction(&cursor, &sel);
+        string s1 = doc.to_string();
+        ImoId idCursor = cursor.get_pointee_id();
+
+        CHECK( executer.is_transaction_open() == false );
+        CHECK( executer.undo_stack_size() == 1 );
+        CHECK( s1 != s0 );
+
+        executer.undo(&cursor, &sel);
+        CHECK( doc.to_string() == s0 );
+        CHECK( executer.is_undo_possible() == false );
+
+        executer.redo(&cursor, &sel);
+        CHECK( doc.to_string() == s1 );
+        CHECK( cursor.get_pointee_id() == idCursor );
+    }
+
+    TEST_FIXTURE(DocCommandTestFixture, executer_transaction_02)
+    {
+        //@02. rollback. Document and cursor restored. Nothing pushed
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument#121 (musicData "
+            "(clef G)(n c4 q)(n d4 q)(n e4 q)(barline)"
+            ")))");
+        doc.clear_dirty();
+        DocCursor cursor(&doc);
+        DocCommandExecuter executer(&doc);
+        MySelectionSet sel(&doc);
+        cursor.enter_element();     //points to clef
+        cursor.move_next();         //points to first note
+        ImoId idCursor = cursor.get_pointee_id();
+
+        string s0 = doc.to_string();
+        executer.begin_transaction(&cursor, &sel, "Add notes");
+        executer.execute(&cursor, LOMSE_NEW CmdAddNoteRest("(n a4 e v1)",
+                                                           k_edit_mode_replace), &sel);
+        executer.execute(&cursor, LOMSE_NEW CmdAddNoteRest("(n b4 e v1)",
+                                                           k_edit_mode_replace), &sel);
+        executer.rollback_transaction(&cursor, &sel);
+
+        CHECK( doc.to_string() == s0 );
+        CHECK( cursor.get_pointee_id() == idCursor );
+        CHECK( executer.is_transaction_open() == false );
+        CHECK( executer.is_undo_possible() == false );
+    }
+
+    TEST_FIXTURE(DocCommandTestFixture, executer_transaction_03)
+    {
+        //@03. nested transactions. Only the outermost commit closes it. Empty
+        //transactions are not pushed
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument#121 (musicData "
+            "(clef G)(n c4 q)(n d4 q)(n e4 q)(barline)"
+            ")))");
+        doc.clear_dirty();
+        DocCursor cursor(&doc);
+        DocCommandExecuter executer(&doc);
+        MySelectionSet sel(&doc);
+        cursor.enter_element();     //points to clef
+        while (*cursor != nullptr)
+            cursor.move_next();     //points to end of score
+
+        executer.begin_transaction(&cursor, &sel);
+        executer.commit_transaction(&cursor, &sel);
+        CHECK( executer.undo_stack_size() == 0 );
+
+        string s0 = doc.to_string();
+        executer.begin_transaction(&cursor, &sel);
+        executer.execute(&cursor, LOMSE_NEW CmdAddNoteRest("(n a4 e v1)",
+                                                           k_edit_mode_replace), &sel);
+        executer.begin_transaction(&cursor, &sel);
+        executer.execute(&cursor, LOMSE_NEW CmdAddNoteRest("(n b4 e v1)",
+                                                           k_edit_mode_replace), &sel);
+        executer.commit_transaction(&cursor, &sel);
+        CHECK( executer.is_transaction_open() == true );
+        executer.commit_transaction(&cursor, &sel);
+        CHECK( executer.is_transaction_open() == false );
+        CHECK( executer.undo_stack_size() == 1 );
+
+        executer.undo(&cursor, &sel);
+        CHECK( doc.to_string() == s0 );
+    }
+
+    TEST_FIXTURE(DocCommandTestFixture, executer_transaction_04)
+    {
+        //@04. undo while transaction open commits the transaction. Deltas ok
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument#121 (musicData "
+            "(clef G)(n c4 q)(n d4 q)(n e4 q)(barline)"
+            ")))");
+        doc.clear_dirty();
+        DocCursor cursor(&doc);
+        DocCommandExecuter executer(&doc);
+        MySelectionSet sel(&doc);
+        cursor.enter_element();     //points to clef
+        while (*cursor != nullptr)
+            cursor.move_next();     //points to end of score
+
+        string s0 = doc.to_string();
+        DocCommand* pCmd1 = LOMSE_NEW CmdAddNoteRest("(n a4 e v1)", k_edit_mode_replace);
+        executer.execute(&cursor, pCmd1, &sel);
+        string s1 = doc.to_string();
+        executer.begin_transaction(&cursor, &sel);
+        executer.execute(&cursor, LOMSE_NEW CmdAddNoteRest("(n b4 e v1)",
+                                                           k_edit_mode_replace), &sel);
+        executer.execute(&cursor, LOMSE_NEW CmdAddNoteRest("(n c5 e v1)",
+                                                           k_edit_mode_replace), &sel);
+        CHECK( pCmd1->is_checkpoint_delta() == false );
+
+        executer.undo(&cursor, &sel);
+        CHECK( executer.is_transaction_open() == false );
+        CHECK( doc.to_string() == s1 );
+        executer.undo(&cursor, &sel);
+        CHECK( doc.to_string() == s0 );
+    }
+
 }
@@ -0,0 +1,184 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include <UnitTest++.h>
+#include <sstream>
+#include "lomse_build_options.h"
+
+//classes related to these tests
+#include "lomse_injectors.h"
+#include "lomse_display_list_drawer.h"
+#include "lomse_screen_drawer.h"
+#include "lomse_batch_renderer.h"
+#include "lomse_presenter.h"
+#include "lomse_interactor.h"
+#include "lomse_graphical_model.h"
+#include "lomse_document.h"
+
+using namespace UnitTest;
+using namespace std;
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+class DisplayListTestFixture
+{
+public:
+    LibraryScope m_libraryScope;
+    std::string m_scores_path;
+
+    DisplayListTestFixture()     //SetUp fixture
+        : m_libraryScope(cout)
+    {
+        m_scores_path = TESTLIB_SCORES_PATH;
+        m_libraryScope.set_default_fonts_path(TESTLIB_FONTS_PATH);
+    }
+
+    ~DisplayListTestFixture()    //TearDown fixture
+    {
+    }
+
+    GraphicModel* get_graphic_model(BatchRenderer& renderer)
+    {
+        Interactor* pIntor = renderer.get_presenter()->get_interactor_raw_ptr(0);
+        return pIntor->get_graphic_model();
+    }
+
+    void prepare_drawer(ScreenDrawer& drawer, RenderingBuffer& rbuf, double scale)
+    {
+        TransAffine transform(scale, 0.0, 0.0, scale, 0.0, 0.0);
+        drawer.reset(rbuf, Color(255, 255, 255));
+        drawer.set_viewport(0, 0);
+        drawer.set_transform(transform);
+    }
+
+    bool is_white_bitmap(std::vector<unsigned char>& buffer)
+    {
+        for (unsigned char byte : buffer)
+        {
+            if (byte != 255)
+                return false;
+        }
+        return true;
+    }
+};
+
+SUITE(DisplayListTest)
+{
+
+    TEST_FIXTURE(DisplayListTestFixture, record_page)
+    {
+        BatchRenderer renderer(m_libraryScope);
+        renderer.new_document("(score (vers 2.0)(instrument (musicData (clef G)(n c4 q))))",
+                              Document::k_format_ldp);
+        GraphicModel* pGModel = get_graphic_model(renderer);
+
+        DisplayListDrawer recorder(m_libraryScope);
+        RenderOptions opt;
+        DisplayList* pList = recorder.record_page(pGModel, 0, opt);
+
+        CHECK( pList->is_empty() == false );
+        CHECK( pList->get_num_commands() > 0 );
+        CHECK( pList->get_memory_size() > 0 );
+        CHECK( recorder.is_recording() == false );
+
+        pList->clear();
+        CHECK( pList->is_empty() == true );
+        delete pList;
+    }
+
+    TEST_FIXTURE(DisplayListTestFixture, replay_equals_direct_drawing)
+    {
+        BatchRenderer renderer(m_libraryScope);
+        renderer.new_document("(score (vers 2.0)(instrument (musicData (clef G)"
+                              "(key D)(time 2 4)(n c4 q)(n e4 e g+)(n g4 e g-)"
+                              "(barline)(n c5 h))))",
+                              Document::k_format_ldp);
+        GraphicModel* pGModel = get_graphic_model(renderer);
+        RenderOptions opt;
+
+        VSize pixels = renderer.get_page_size_in_pixels(0, 72.0);
+        double scale = 72.0 / 2540.0;
+        size_t bytes = size_t(pixels.width) * size_t(pixels.height) * 4;
+
+        //direct drawing
+        std::vector<unsigned char> direct(bytes, 0);
+        RenderingBuffer rbuf1;
+        rbuf1.attach(&direct[0], pixels.width, pixels.height, pixels.width * 4);
+        ScreenDrawer drawer1(m_libraryScope);
+        prepare_drawer(drawer1, rbuf1, scale);
+        UPoint origin(0.0f, 0.0f);
+        pGModel->draw_page(0, origin, &drawer1, opt);
+        drawer1.render();
+
+        //replay of recorded drawing
+        DisplayListDrawer recorder(m_libraryScope);
+        DisplayList* pList = recorder.record_page(pGModel, 0, opt);
+        std::vector<unsigned char> replayed(bytes, 0);
+        RenderingBuffer rbuf2;
+        rbuf2.attach(&replayed[0], pixels.width, pixels.height, pixels.width * 4);
+        ScreenDrawer drawer2(m_libraryScope);
+        prepare_drawer(drawer2, rbuf2, scale);
+        pList->replay(&drawer2);
+        drawer2.render();
+
+        CHECK( is_white_bitmap(direct) == false );
+        CHECK( direct == replayed );
+
+        delete pList;
+    }
+
+    TEST_FIXTURE(DisplayListTestFixture, replay_with_other_scale)
+    {
+        BatchRenderer renderer(m_libraryScope);
+        renderer.new_document("(score (vers 2.0)(instrument (musicData (clef G)(n c4 q))))",
+                              Document::k_format_ldp);
+        GraphicModel* pGModel = get_graphic_model(renderer);
+        RenderOptions opt;
+        DisplayListDrawer recorder(m_libraryScope);
+        DisplayList* pList = recorder.record_page(pGModel, 0, opt);
+
+        //the same list can be replayed several times, at any scale
+        ScreenDrawer drawer(m_libraryScope);
+        std::vector<unsigned char> buffer(400 * 300 * 4, 0);
+        RenderingBuffer rbuf;
+        rbuf.attach(&buffer[0], 400, 300, 400 * 4);
+        for (int i=1; i <= 3; ++i)
+        {
+            prepare_drawer(drawer, rbuf, 0.02 * i);
+            pList->replay(&drawer);
+            drawer.render();
+            CHECK( is_white_bitmap(buffer) == false );
+        }
+
+        delete pList;
+    }
+
+}
+
@@ -42,8 +42,11 @@
 #include "lomse_events.h"
 #include "lomse_document_iterator.h"
 #include "lomse_im_factory.h"
+#include "lomse_im_snapshot.h"
+#include "lomse_staffobjs_table.h"
 
 #include <exception>
+#include <thread>
 using namespace UnitTest;
 using namespace std;
 using namespace lomse;
@@ -121,6 +124,128 @@ SUITE(IdAssignerTest)
 // Document tests
 //=======================================================================================
 
+//---------------------------------------------------------------------------------------
+//scores in test-scores folder used for checking the binary snapshot round trip
+static const char* k_snapshot_corpus[] = {
+    "00010-empty-renders-one-staff.lms", "00011-empty-fill-page.lms",
+    "00012-page-filled-with-empty-systems.lms",
+    "00013-empty-piano-filled-with-empty-systems.lms", "00020-space-before-clef.lms",
+    "00021-spacing-in-prolog.lms", "00022-spacing-in-prolog-one-note.lms",
+    "00023-spacing-in-prolog-two-instr.lms",
+    "00030-same-duration-notes-equally-spaced.lms",
+    "00031-notes-spacing-proportional-to-notes-duration.lms",
+    "00032-notes-with-fixed-spacing.lms", "00033-accidentals-do-no-alter-spacing.lms",
+    "00034-accidentals-do-no-alter-fixed-spacing.lms",
+    "00035-spacing-notes-with-figured-bass.lms", "00040-all-notes-fixed-spacing.lms",
+    "00041-all-notes-proportional-spacing.lms", "00042-all-notes-dotted.lms",
+    "00043-all-notes-double-dotted.lms", "00044-all-notes-triple-dotted.lms",
+    "00045-shorter-flags.lms", "00051-accidentals.lms",
+    "00060-all-rests-fixed-spacing.lms", "00061-all-rests-proportional-spacing.lms",
+    "00062-all-rests-dotted.lms", "00063-all-rests-double-dotted.lms",
+    "00064-all-rests-triple-dotted.lms", "00070-chord-no-stem-no-flag.lms",
+    "00071-chord-stem-up-no-flag.lms", "00072-chord-stem-up-note-reversed-no-flag.lms",
+    "00073-chord-stem-down-no-flag.lms",
+    "00074-chord-stem-down-note-reversed-no-flag.lms",
+    "00075-chord-stem-up-no-flag-accidental.lms",
+    "00076-chord-many-accidentals-note-reversed.lms", "00080-chord-spacing.lms",
+    "00081-chord-spacing-not-enough-space.lms",
+    "00082-chords-with-reversed-notes-do-not-overlap.lms",
+    "00083-chord-across-two-staves.lms", "00085-chord-flags.lms",
+    "00086-chord-notes-ordering.lms", "00087-many-chords.lms",
+    "00090-clef-between-notes-properly-spaced-when-enough-space.lms",
+    "00091-clef-between-notes-properly-spaced-when-removing-variable-space.lms",
+    "00110-all-key-signatures.lms", "00120-time-signatures.lms",
+    "00131-vertical-right-alignment-prolog-one-note.lms",
+    "00132-vertical-right-alignment-same-time-positions.lms",
+    "00133-vertical-right-alignment-different-time-positions.lms",
+    "00134-vertical-right-alignment-when-accidental-requires-more-space.lms",
+    "00135-vertical-right-alignment-when-clefs-between-notes.lms",
+    "00136-clef-follows-note-when-note-displaced.lms",
+    "00137-prolog-properly-aligned-in-second-system.lms",
+    "00138-vertical-right-alignment-when-many-clefs-between-notes.lms",
+    "00139-triplet-against-5-tuplet-4.14.lms", "00140-loose-spacing-4.16.lms",
+    "00141-triplet-against-s-e-dot_4.15a.lms", "00180-new-system.lms",
+    "00180-spacer.lms", "00181-go-back.lms", "00190-all-barlines.lmd",
+    "00200-bars-go-one-after-the-other.lms", "00201-systems-are-justified.lms",
+    "00202-long-single-bar-is-splitted.lms", "00205-multimetric.lmd",
+    "00206-long-bar-not-splitted.lms", "00207-difficult-to-break.lms",
+    "00210-one-instr-2-staves.lms", "00211-two-instr-3-staves.lms",
+    "00212-empty-STB.lmd", "00220-empty-piano-with-name.lms",
+    "00221-empty-two-instr-3-staves.lms", "00222-empty-choir-STB-piano.lmd",
+    "00223-empty-SATB-choir-name.lmd", "00224-all-group-styles.lmd",
+    "00225-group-joined-barlines.lms", "00226-group-mensurstrich-layout.lms",
+    "00227-group-mensurstrich-layout.lms", "00228-group-joined-barlines.lms",
+    "00230-space-for-lyrics.lms", "00240-defaults-note-NJNT.lms",
+    "00241-defaults-final-barline-NJT.lms", "00242-defaults-simple-barline-NJNT.lms",
+    "00243-j1-note-NJNT.lms", "00244-j1-final-barline-J.lms",
+    "00245-j1-simple-barline-NJNT.lms", "00246-j2-note-NJNT.lms",
+    "00247-j2-barline-J.lms", "00248-j3-note-J.lms", "00249-j0t2-note-NJNT.lms",
+    "00250-j0t2-barline-NJT.lms", "00251-j0t3-note-NJT.lms",
+    "00253-justification-error.xml", "00600-non-timed-not-enough-space.lms",
+    "00601-minimum-exceptional-space.lms",
+    "00602-invisible-non-timed-after-prolog.lms", "00603-clef-change-after-prolog.lms",
+    "00604-barline-previous-space-before-note.lms",
+    "00605-noterest-do-not-transfer-space-to-non-timed.lms",
+    "00606-noterest-do-not-transfer-space-to-prolog.lms",
+    "00607-several-visible-non-timed.lms",
+    "00608-invisible-non-zero-width-after_barline.lms", "00609-notes-no-prolog.lms",
+    "00610-accidental-after-barline.lms",
+    "00611-accidental-after-barline-and-spacer.lms",
+    "00612-clef-between-notes-adds-little-space-when-not-enough-space.lms",
+    "00613-all-clefs-all-sizes.lms",
+    "00614-vertical-right-alignment-when-accidental-requires-more-space.lms",
+    "00615-clef-follows-note-when-note-displaced.lms",
+    "00616-vertical-right-alignment-when-many-clefs-between-notes.lms",
+    "00617-clef-change-at-start.lms", "00618-metronome-does-not-takes-space.lms",
+    "00619-empty-bar-with-barline.lms", "00620-spacing-consecutive-spacers.lms",
+    "00621-directions-take-no-space.xml", "00622-non-timed-in-other-line.lms",
+    "00623-clef-change-lyrics.xml", "00624-clef-change-accidental-lyrics.lms",
+    "00625-spacer-lyrics.lms", "00626-lyrics-min-separation.lms",
+    "01010-tuplet-triplets.lms", "01011-tuplet-duplets.lms", "01012-tuplet-tuplet.lms",
+    "01013-tuplet-only-bracket.lms", "01014-nested-tuplets.lms",
+    "01015-tuplet-braket-position.lms", "01020-beams.lms", "01021-chords-beamed.lms",
+    "01022-beams.lms", "01023-beam-4s-q.lms", "01024-rests-in-beam.lms",
+    "01025-short-rests-in-beam.lms", "01026-beamed-chords.lms", "01027-beam-slant.lms",
+    "01030-ties.lms", "01031-tie-bezier.lms", "01032-tie-bezier-break.lms",
+    "01033-tie-bezier-barline.lms", "01034-tie-after-barline.lms", "01040-slur.lms",
+    "01041-slur.lms", "01042-slur.lms", "01043-slur-BrahWiMeSample.lms",
+    "01044-slur.lms", "02010-graphic-line-text.lms", "02011-line-after-barline.lms",
+    "02020-fermatas.lms", "02021-all-fermatas.lms", "02030-metronome.lms",
+    "02031-metronome.lms", "02032-metronome.lms", "02033-direction-in-prolog.lms",
+    "02034-direction-at-start.lms", "02040-text.lms", "02041-text-titles.lms",
+    "02042-text-attached.lms", "02050-textbox.lms", "02070-dynamics-marks.lms",
+    "02080-all-accents.lms", "02081-all-caesura-and-breath-marks.lms",
+    "02090-lyrics-two-lines-only-text.lms", "02091-lyrics-melisma-hyphenation.lms",
+    "02092-chant.lms", "02093-lyrics-above-below.lms",
+    "07001-two-notes-different-duration.lms",
+    "07002-several-lines-with-different-durations.lms",
+    "07003-empty-bar-with-barline.lms", "07004-two-voices-missing-timepos.lms",
+    "07011-chord-whole-notes-no-accidentals-note-reversed.lms",
+    "07012-two-instruments-four-staves.lmd", "07013-two-instruments-four-staves.lms",
+    "08011-paragraph.lmd", "08012-long-text-paragraph.lms",
+    "08013-paragraph-one-line.lms", "08014-paragraph-unicode.lms",
+    "08021-small-table.lmd", "08022-table-merged-cells.lms", "08031-score-player.lms",
+    "08042-read-png-image.lms", "09001-paragraph-two-scores-in-vertical.lms",
+    "09002-ebook-example.lms", "09003-ebook-three-pages.lms",
+    "09004-paragraph-score-table.lms", "09005-lenmusdoc-example.lmd",
+    "09007-score-in-exercise.lmd", "09008-score-in-exercise.lmd",
+    "09009-dynamic-object.lms", "09010-exercise.lms",
+    "09011-two-scores-in-vertical.lms", "09901-empty-file.lms",
+    "10021-unicode-text.lms", "50000-hello-world.xml", "50001-accent-on-note.xml",
+    "50011-ornaments.xml", "50011b-ornaments.xml", "50021-articulations.xml",
+    "50021b-articulations.xml", "50031-slide.xml", "50033-glissando-chords.xml",
+    "50034-fix-beams.xml", "50035-directions-take-no-space.xml",
+    "50036-directions-take-no-space-2.xml", "50040-wedge.xml",
+    "50041-octave_shift.xml", "50042-stacked-articulations.xml",
+    "50043-beamed-group-two-staves.xml",
+    "50044-beamed-group-cross-staff-mixed-flags.xml",
+    "50045-cross-staff-beamed-group-slur.xml",
+    "50046-cross-staff-beamed-group-more-space.xml",
+    "50047-cross-staff-beamed-group-more-space.xml",
+    "50106-repeat-barlines-simple-volta.xml", "50201-repeat-barlines-split-volta.xml",
+    "50301-pitch.xml", "50302-pitch.xml", "50303-pitch.xml", "50999-empty-file.xml"
+};
+
 class DocumentTestFixture
 {
 public:
@@ -161,11 +286,93 @@ public:
             "))" );
     }
 
+    void create_document_2()
+    {
+        //two instruments, three measures
+        m_pDoc = LOMSE_NEW Document(m_libraryScope);
+        m_pDoc->from_string("(lenmusdoc (vers 0.0) (content "
+            "(score#94 (vers 2.0) "
+                "(instrument#119 (musicData (clef G)(n#130 c4 q)(barline#131)"
+                    "(n#132 d4 q)(barline#133)(n#134 e4 q)(barline#135) ))"
+                "(instrument#140 (musicData (clef F4)(n#141 c3 q)(barline#142)"
+                    "(n#143 d3 q)(barline#144)(n#145 e3 q)(barline#146) )))"
+            "(para#150 (txt \"Hello world!\"))"
+            "))" );
+        m_pDoc->clear_dirty();
+    }
+
+    //returns an empty string if the round trip is ok or a message describing the
+    //failure. Documents with objects not supported by ImSnapshot are checked by
+    //replacing each score from its snapshot, when possible
+    string snapshot_round_trip(const string& filename)
+    {
+        int format = Document::k_format_ldp;
+        string ext = filename.substr(filename.rfind('.'));
+        if (ext == ".lmd")
+            format = Document::k_format_lmd;
+        else if (ext == ".xml")
+            format = Document::k_format_mxl;
+
+        stringstream errormsg;
+        Document doc(m_libraryScope, errormsg);
+        doc.from_file(m_scores_path + filename, format);
+        string source = doc.to_string(true);
+        string data = doc.get_checkpoint_data();
+        if (!ImSnapshot::is_snapshot(data))
+        {
+            ImoContent* pContent = doc.get_im_root()->get_content();
+            ImoObj::children_iterator it;
+            for (it = pContent->begin(); it != pContent->end(); ++it)
+            {
+                if (!(*it)->is_score())
+                    continue;
+                ImoId id = (*it)->get_id();
+                data = doc.get_checkpoint_data_for(id);
+                if (!ImSnapshot::is_snapshot(data))
+                    continue;
+                doc.replace_object_from_checkpoint_data(id, data);
+                if (doc.to_string(true) != source)
+                    return filename + ": LDP export differs after restoring a score";
+                it = ImoObj::children_iterator( doc.get_pointer_to_imo(id) );
+            }
+            return "";
+        }
+
+        Document copy(m_libraryScope, errormsg);
+        copy.from_checkpoint(data);
+        if (copy.to_string(true) != source)
+            return filename + ": LDP export differs after restore";
+        ImoId id = doc.get_im_root()->get_id();
+        if (copy.get_checkpoint_source_for(id) != doc.get_checkpoint_source_for(id))
+            return filename + ": LMD export differs after restore";
+        if (copy.get_checkpoint_data() != data)
+            return filename + ": snapshot differs after restore";
+        return "";
+    }
+
     LibraryScope m_libraryScope;
     string m_scores_path;
     Document* m_pDoc;
 };
 
+//---------------------------------------------------------------------------------------
+class MyDocModifiedHandler : public EventHandler
+{
+public:
+    SpDocChangeSet m_spChanges;
+    int m_numEvents;
+
+    MyDocModifiedHandler() : m_numEvents(0) {}
+    virtual ~MyDocModifiedHandler() {}
+
+    void handle_event(SpEventInfo pEvent)
+    {
+        SpEventDoc pEv( static_pointer_cast<EventDoc>(pEvent) );
+        m_spChanges = pEv->get_change_set();
+        ++m_numEvents;
+    }
+};
+
 //---------------------------------------------------------------------------------------
 SUITE(DocumentTest)
 {
@@ -533,5 +740,407 @@ SUITE(DocumentTest)
         CHECK( pImo->is_note() );
     }
 
-};
+    TEST_FIXTURE(DocumentTestFixture, checkpoints_212)
+    {
+        //212. checkpoint data for a score is a binary snapshot
+        create_document_1();
+
+        string data = m_pDoc->get_checkpoint_data_for(94L);
+
+        CHECK( ImSnapshot::is_snapshot(data) == true );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, checkpoints_213)
+    {
+        //213. replace object from snapshot preserves ids and content
+        create_document_1();
+        string source = m_pDoc->to_string(true);
+        string data = m_pDoc->get_checkpoint_data_for(94L);
+        ImoObj* pOld = m_pDoc->get_pointer_to_imo(121L);
+
+        m_pDoc->replace_object_from_checkpoint_data(94L, data);
+
+        CHECK( m_pDoc->to_string(true) == source );
+        ImoObj* pImo = m_pDoc->get_pointer_to_imo(94L);
+        CHECK( pImo && pImo->is_score() );
+        pImo = m_pDoc->get_pointer_to_imo(121L);
+        CHECK( pImo && pImo->is_clef() );
+        CHECK( pImo != pOld );
+        CHECK( m_pDoc->get_checkpoint_data_for(94L) == data );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, checkpoints_214)
+    {
+        //214. full document restored from snapshot
+        Document doc(m_libraryScope);
+        doc.from_file(m_scores_path + "01043-slur-BrahWiMeSample.lms",
+                      Document::k_format_ldp);
+        string data = doc.get_checkpoint_data();
+        CHECK( ImSnapshot::is_snapshot(data) == true );
+
+        Document copy(m_libraryScope);
+        copy.from_checkpoint(data);
+
+        CHECK( copy.to_string(true) == doc.to_string(true) );
+        CHECK( copy.get_checkpoint_data() == data );
+        CHECK( copy.is_dirty() == true );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, checkpoints_215)
+    {
+        //215. relations are re-linked when restoring from snapshot
+        Document doc(m_libraryScope);
+        doc.from_file(m_scores_path + "01030-ties.lms", Document::k_format_ldp);
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        ImoId id = pScore->get_id();
+        string data = doc.get_checkpoint_data_for(id);
+
+        doc.replace_object_from_checkpoint_data(id, data);
+
+        pScore = static_cast<ImoScore*>( doc.get_pointer_to_imo(id) );
+        ColStaffObjs* pTable = pScore->get_staffobjs_table();
+        CHECK( pTable && pTable->num_entries() > 0 );
+        int numTies = 0;
+        ColStaffObjsIterator it;
+        for (it = pTable->begin(); it != pTable->end(); ++it)
+        {
+            ImoStaffObj* pSO = (*it)->imo_object();
+            if (pSO->is_note() && static_cast<ImoNote*>(pSO)->is_tied_next())
+            {
+                ImoNote* pNote = static_cast<ImoNote*>(pSO);
+                ImoTie* pTie = pNote->get_tie_next();
+                CHECK( pTie->get_start_note() == pNote );
+                CHECK( pTie->get_end_note()->get_tie_prev() == pTie );
+                CHECK( doc.get_pointer_to_imo(pTie->get_id()) == pTie );
+                ++numTies;
+            }
+        }
+        CHECK( numTies > 0 );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, checkpoints_216)
+    {
+        //216. unsupported objects fall back to LMD checkpoint data
+        Document doc(m_libraryScope);
+        doc.from_file(m_scores_path + "08042-read-png-image.lms",
+                      Document::k_format_ldp);
+
+        string data = doc.get_checkpoint_data();
+
+        CHECK( ImSnapshot::is_snapshot(data) == false );
+        CHECK( data.find("<lenmusdoc") != string::npos );
+    }
 
+    TEST_FIXTURE(DocumentTestFixture, checkpoints_217)
+    {
+        //217. checkpoint for objects includes related objects and restores them
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G)(n e4 e g+)(n f4 e)(n g4 e g-)(n a4 q)(barline)"
+            "(n c5 q)(n c5 q l)(n c5 q)(n c5 q)(barline))))");
+        string source = doc.to_string(true);
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        ImoNote* pNote = static_cast<ImoNote*>(
+                pScore->get_instrument(0)->get_musicdata()->get_child(1) );
+        CHECK( pNote->is_beamed() );
+        ImoId idBeam = pNote->get_beam()->get_id();
+        list<ImoId> ids;
+        ids.push_back( pNote->get_id() );
+
+        string data = doc.get_checkpoint_data_for_objects(ids);
+
+        CHECK( ImSnapshot::is_snapshot(data) == true );
+        CHECK( data.size() < doc.get_checkpoint_data_for(pScore->get_id()).size() / 2 );
+
+        doc.delete_relation( pNote->get_beam() );
+        CHECK( doc.get_pointer_to_imo(idBeam) == nullptr );
+
+        doc.replace_objects_from_checkpoint_data(data);
+
+        CHECK( doc.to_string(true) == source );
+        pNote = static_cast<ImoNote*>( doc.get_pointer_to_imo(ids.front()) );
+        CHECK( pNote && pNote->is_beamed() );
+        CHECK( doc.get_pointer_to_imo(idBeam) == pNote->get_beam() );
+        CHECK( pNote->get_beam()->get_num_objects() == 3 );
+        ColStaffObjs* pTable = pScore->get_staffobjs_table();
+        CHECK( pTable->get_index()->find_entry(pNote->get_id())->imo_object() == pNote );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, checkpoints_218)
+    {
+        //218. no checkpoint for objects that are not in a score
+        create_document_1();
+        list<ImoId> ids;
+        ids.push_back( m_pDoc->get_im_root()->get_content_item(1)->get_id() );  //para
+
+        CHECK( m_pDoc->get_checkpoint_data_for_objects(ids) == "" );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, checkpoints_219)
+    {
+        //219. replacing an object from checkpoint data marks the document dirty
+        create_document_1();
+        string data = m_pDoc->get_checkpoint_data_for(94L);
+        m_pDoc->clear_dirty();
+
+        m_pDoc->replace_object_from_checkpoint_data(94L, data);
+
+        CHECK( m_pDoc->is_dirty() == true );
+        CHECK( m_pDoc->get_change_set().is_score_changed(94L) == true );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, checkpoints_220)
+    {
+        //220. snapshot round trip preserves all scores in test-scores folder
+        int numScores = sizeof(k_snapshot_corpus) / sizeof(k_snapshot_corpus[0]);
+        int numFailures = 0;
+        for (int i=0; i < numScores; ++i)
+        {
+            string msg = snapshot_round_trip(k_snapshot_corpus[i]);
+            if (!msg.empty())
+            {
+                cout << test_name() << ": " << msg << endl;
+                ++numFailures;
+            }
+        }
+
+        CHECK( numFailures == 0 );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, snapshot_300)
+    {
+        //300. snapshot is a read-only copy of the document
+        create_document_1();
+        SpDocument spSnapshot = m_pDoc->get_snapshot();
+
+        CHECK( spSnapshot.get() != m_pDoc );
+        CHECK( spSnapshot->is_snapshot() == true );
+        CHECK( spSnapshot->is_editable() == false );
+        CHECK( m_pDoc->is_snapshot() == false );
+        CHECK( m_pDoc->is_editable() == true );
+        CHECK( spSnapshot->to_string() == m_pDoc->to_string() );
+        CHECK( spSnapshot->get_im_root() != m_pDoc->get_im_root() );
+        ImoScore* pScore = static_cast<ImoScore*>( spSnapshot->get_pointer_to_imo(94L) );
+        CHECK( pScore && pScore->get_staffobjs_table() != nullptr );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, snapshot_301)
+    {
+        //301. snapshot is shared while the document is not modified
+        create_document_1();
+        SpDocument spSnapshot1 = m_pDoc->get_snapshot();
+        SpDocument spSnapshot2 = m_pDoc->get_snapshot();
+
+        CHECK( spSnapshot1 == spSnapshot2 );
+        CHECK( m_pDoc->get_snapshot(false) != spSnapshot1 );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, snapshot_302)
+    {
+        //302. modifying the document creates a new snapshot. Old one not affected
+        create_document_1();
+        SpDocument spSnapshot1 = m_pDoc->get_snapshot();
+        string source = spSnapshot1->to_string();
+        unsigned int changes = m_pDoc->get_changes_counter();
+
+        m_pDoc->add_paragraph();
+
+        CHECK( m_pDoc->get_changes_counter() != changes );
+        SpDocument spSnapshot2 = m_pDoc->get_snapshot();
+        CHECK( spSnapshot1 != spSnapshot2 );
+        CHECK( spSnapshot1->to_string() == source );
+        CHECK( spSnapshot2->to_string() == m_pDoc->to_string() );
+        CHECK( spSnapshot2->to_string() != source );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, snapshot_303)
+    {
+        //303. snapshot is not kept by the document when no longer used
+        create_document_1();
+        WpDocument wpSnapshot = m_pDoc->get_snapshot();
+
+        CHECK( wpSnapshot.expired() == true );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, snapshot_304)
+    {
+        //304. snapshot can be read in other thread while the document is modified
+        create_document_1();
+        SpDocument spSnapshot = m_pDoc->get_snapshot();
+        string source = spSnapshot->to_string();
+        string exported;
+
+        std::thread reader([spSnapshot, &exported]() {
+            exported = spSnapshot->to_string();
+        });
+        for (int i=0; i < 10; ++i)
+            m_pDoc->add_paragraph();
+        reader.join();
+
+        CHECK( exported == source );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, change_set_400)
+    {
+        //400. a new document is fully changed
+        create_document_1();
+
+        CHECK( m_pDoc->get_change_set().is_all_changed() == true );
+        CHECK( m_pDoc->get_change_set().is_empty() == false );
+        CHECK( m_pDoc->get_change_set().is_score_changed(94L) == true );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, change_set_401)
+    {
+        //401. notification carries the change set and clears it
+        create_document_1();
+        MyDocModifiedHandler handler;
+        m_pDoc->add_event_handler(k_doc_modified_event, &handler);
+
+        m_pDoc->notify_if_document_modified();
+
+        CHECK( handler.m_numEvents == 1 );
+        CHECK( handler.m_spChanges && handler.m_spChanges->is_all_changed() );
+        CHECK( m_pDoc->is_dirty() == false );
+        CHECK( m_pDoc->get_change_set().is_empty() == true );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, change_set_402)
+    {
+        //402. modified note: only its item, score, instrument and measure
+        create_document_2();
+        MyDocModifiedHandler handler;
+        m_pDoc->add_event_handler(k_doc_modified_event, &handler);
+
+        ImoNote* pNote = static_cast<ImoNote*>( m_pDoc->get_pointer_to_imo(132L) );
+        pNote->set_dirty(true);
+        m_pDoc->notify_if_document_modified();
+
+        SpDocChangeSet spChanges = handler.m_spChanges;
+        CHECK( spChanges->is_all_changed() == false );
+        CHECK( spChanges->get_changed_items().size() == 1 );
+        CHECK( spChanges->is_item_changed(94L) == true );
+        CHECK( spChanges->is_item_changed(150L) == false );
+        CHECK( spChanges->is_score_changed(94L) == true );
+        CHECK( spChanges->is_instrument_changed(94L, 0) == true );
+        CHECK( spChanges->is_instrument_changed(94L, 1) == false );
+        int first, last;
+        CHECK( spChanges->get_changed_measures(94L, &first, &last) == true );
+        CHECK( first == 1 );
+        CHECK( last == 1 );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, change_set_403)
+    {
+        //403. deleted note: measure located from previous object
+        create_document_2();
+        MyDocModifiedHandler handler;
+        m_pDoc->add_event_handler(k_doc_modified_event, &handler);
+
+        ImoInstrument* pInstr = static_cast<ImoInstrument*>( m_pDoc->get_pointer_to_imo(140L) );
+        ImoStaffObj* pSO = static_cast<ImoStaffObj*>( m_pDoc->get_pointer_to_imo(145L) );
+        pInstr->delete_staffobj(pSO);
+        m_pDoc->notify_if_document_modified();
+
+        SpDocChangeSet spChanges = handler.m_spChanges;
+        CHECK( spChanges->is_instrument_changed(94L, 0) == false );
+        CHECK( spChanges->is_instrument_changed(94L, 1) == true );
+        int first, last;
+        CHECK( spChanges->get_changed_measures(94L, &first, &last) == true );
+        CHECK( first == 2 );
+        CHECK( last == 2 );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, change_set_404)
+    {
+        //404. deleted barline: all following measures changed
+        create_document_2();
+        MyDocModifiedHandler handler;
+        m_pDoc->add_event_handler(k_doc_modified_event, &handler);
+
+        ImoInstrument* pInstr = static_cast<ImoInstrument*>( m_pDoc->get_pointer_to_imo(119L) );
+        ImoStaffObj* pSO = static_cast<ImoStaffObj*>( m_pDoc->get_pointer_to_imo(131L) );
+        pInstr->delete_staffobj(pSO);
+        m_pDoc->notify_if_document_modified();
+
+        int first, last;
+        CHECK( handler.m_spChanges->get_changed_measures(94L, &first, &last) == true );
+        CHECK( first == 0 );
+        CHECK( last == DocChangeSet::k_end_of_score );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, change_set_405)
+    {
+        //405. modified paragraph: scores not changed
+        create_document_2();
+        MyDocModifiedHandler handler;
+        m_pDoc->add_event_handler(k_doc_modified_event, &handler);
+
+        ImoParagraph* pPara = static_cast<ImoParagraph*>( m_pDoc->get_pointer_to_imo(150L) );
+        pPara->add_text_item(" Bye!");
+        m_pDoc->notify_if_document_modified();
+
+        SpDocChangeSet spChanges = handler.m_spChanges;
+        CHECK( spChanges->is_all_changed() == false );
+        CHECK( spChanges->is_item_changed(150L) == true );
+        CHECK( spChanges->is_score_changed(94L) == false );
+        CHECK( spChanges->get_changed_scores().empty() == true );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, change_set_406)
+    {
+        //406. added content item: whole document changed
+        create_document_2();
+
+        m_pDoc->add_paragraph();
+
+        CHECK( m_pDoc->is_dirty() == true );
+        CHECK( m_pDoc->get_change_set().is_all_changed() == true );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, change_set_407)
+    {
+        //407. added instrument: all measures changed
+        create_document_2();
+        ImoScore* pScore = static_cast<ImoScore*>( m_pDoc->get_pointer_to_imo(94L) );
+
+        pScore->add_instrument();
+
+        const DocChangeSet& changes = m_pDoc->get_change_set();
+        CHECK( changes.is_all_changed() == false );
+        CHECK( changes.is_instrument_changed(94L, 2) == true );
+        int first, last;
+        CHECK( changes.get_changed_measures(94L, &first, &last) == true );
+        CHECK( first == 0 );
+        CHECK( last == DocChangeSet::k_end_of_score );
+    }
+
+    TEST_FIXTURE(DocumentTestFixture, change_set_408)
+    {
+        //408. deleted/inserted note: instrument dirty but only the note is recorded
+        create_document_2();
+        MyDocModifiedHandler handler;
+        m_pDoc->add_event_handler(k_doc_modified_event, &handler);
+        ImoInstrument* pInstr = static_cast<ImoInstrument*>( m_pDoc->get_pointer_to_imo(140L) );
+        ImoStaffObj* pSO = static_cast<ImoStaffObj*>( m_pDoc->get_pointer_to_imo(145L) );
+        ImoStaffObj* pNext = static_cast<ImoStaffObj*>( pSO->get_next_sibling() );
+        pInstr->set_dirty(false);
+
+        pInstr->delete_staffobj(pSO);
+        m_pDoc->notify_if_document_modified();
+
+        CHECK( pInstr->is_dirty() == true );
+        int first, last;
+        CHECK( handler.m_spChanges->get_changed_measures(94L, &first, &last) == true );
+        CHECK( first == 2 );
+        CHECK( last == 2 );
+
+        pInstr->set_dirty(false);
+        pInstr->insert_staffobj_at(pNext, "(n c4 q)", cout);
+
+        CHECK( pInstr->is_dirty() == true );
+        CHECK( m_pDoc->get_change_set().is_instrument_changed(94L, 0) == false );
+        CHECK( m_pDoc->get_change_set().is_instrument_changed(94L, 1) == true );
+    }
+
+};
@@ -0,0 +1,215 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2018. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include <UnitTest++.h>
+#include <sstream>
+#include "lomse_build_options.h"
+
+//classes related to these tests
+#include "lomse_document_loader.h"
+#include "lomse_injectors.h"
+#include "lomse_presenter.h"
+#include "lomse_graphic_view.h"
+#include "lomse_document.h"
+#include "lomse_internal_model.h"
+
+#include <vector>
+
+using namespace UnitTest;
+using namespace std;
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+class DocumentLoaderTestFixture
+{
+public:
+    LibraryScope m_libraryScope;
+    std::string m_scores_path;
+    vector<int> m_stages;
+    int m_cancelAtStage;
+
+    DocumentLoaderTestFixture()     //SetUp fixture
+        : m_libraryScope(cout)
+        , m_cancelAtStage(-1)
+    {
+        m_scores_path = TESTLIB_SCORES_PATH;
+        m_libraryScope.set_default_fonts_path(TESTLIB_FONTS_PATH);
+    }
+
+    ~DocumentLoaderTestFixture()    //TearDown fixture
+    {
+    }
+
+    static void wrapper_on_load_event(void* pThis, SpEventInfo pEvent)
+    {
+        static_cast<DocumentLoaderTestFixture*>(pThis)->on_load_event(pEvent);
+    }
+
+    void on_load_event(SpEventInfo pEvent)
+    {
+        SpEventLoad pEv( static_pointer_cast<EventLoad>(pEvent) );
+        m_stages.push_back(pEv->get_stage());
+        if (pEv->get_stage() == m_cancelAtStage)
+            pEv->get_loader()->cancel();
+    }
+
+    DocumentLoader* create_loader(const string& filename, ostream& reporter=cout)
+    {
+        DocumentLoader* pLoader = LOMSE_NEW DocumentLoader(m_libraryScope, k_view_simple,
+                                                           filename, reporter);
+        pLoader->add_event_handler(k_load_progress_event, this, wrapper_on_load_event);
+        pLoader->add_event_handler(k_load_end_event, this, wrapper_on_load_event);
+        return pLoader;
+    }
+};
+
+SUITE(DocumentLoaderTest)
+{
+
+    TEST_FIXTURE(DocumentLoaderTestFixture, load_ldp_file)
+    {
+        DocumentLoader* pLoader = create_loader(m_scores_path + "00011-empty-fill-page.lms");
+        pLoader->start();
+        pLoader->wait();
+
+        CHECK( pLoader->is_finished() == true );
+        CHECK( pLoader->get_stage() == EventLoad::k_stage_ready );
+        CHECK( m_stages.size() == 4 );
+        CHECK( m_stages[0] == EventLoad::k_stage_parsing );
+        CHECK( m_stages[1] == EventLoad::k_stage_analysing );
+        CHECK( m_stages[2] == EventLoad::k_stage_building_model );
+        CHECK( m_stages[3] == EventLoad::k_stage_ready );
+
+        Presenter* pPresenter = pLoader->get_presenter();
+        CHECK( pPresenter != nullptr );
+        CHECK( pPresenter->get_num_interactors() == 1 );
+        Document* pDoc = pPresenter->get_document_raw_ptr();
+        ImoScore* pScore = dynamic_cast<ImoScore*>( pDoc->get_im_root()->get_content_item(0) );
+        CHECK( pScore != nullptr );
+        CHECK( pLoader->get_presenter() == nullptr );
+
+        delete pLoader;
+        delete pPresenter;
+    }
+
+    TEST_FIXTURE(DocumentLoaderTestFixture, load_musicxml_file)
+    {
+        DocumentLoader* pLoader = create_loader(m_scores_path + "50000-hello-world.xml");
+        pLoader->start();
+        pLoader->wait();
+
+        CHECK( pLoader->get_stage() == EventLoad::k_stage_ready );
+        CHECK( pLoader->get_num_errors() == 0 );
+        CHECK( m_stages.size() == 4 );
+
+        Presenter* pPresenter = pLoader->get_presenter();
+        CHECK( pPresenter != nullptr );
+        Document* pDoc = pPresenter->get_document_raw_ptr();
+        ImoScore* pScore = dynamic_cast<ImoScore*>( pDoc->get_im_root()->get_content_item(0) );
+        CHECK( pScore != nullptr );
+        CHECK( pScore && pScore->get_num_instruments() == 1 );
+
+        delete pLoader;
+        delete pPresenter;
+    }
+
+    TEST_FIXTURE(DocumentLoaderTestFixture, cancel_before_start)
+    {
+        DocumentLoader* pLoader = create_loader(m_scores_path + "50000-hello-world.xml");
+        pLoader->cancel();
+        pLoader->start();
+        pLoader->wait();
+
+        CHECK( pLoader->get_stage() == EventLoad::k_stage_cancelled );
+        CHECK( m_stages.size() == 1 );
+        CHECK( m_stages[0] == EventLoad::k_stage_cancelled );
+        CHECK( pLoader->get_presenter() == nullptr );
+
+        delete pLoader;
+    }
+
+    TEST_FIXTURE(DocumentLoaderTestFixture, cancel_while_loading)
+    {
+        m_cancelAtStage = EventLoad::k_stage_analysing;
+        DocumentLoader* pLoader = create_loader(m_scores_path + "50000-hello-world.xml");
+        pLoader->start();
+        pLoader->wait();
+
+        CHECK( pLoader->get_stage() == EventLoad::k_stage_cancelled );
+        CHECK( m_stages.size() == 3 );
+        CHECK( m_stages[1] == EventLoad::k_stage_analysing );
+        CHECK( m_stages[2] == EventLoad::k_stage_cancelled );
+        CHECK( pLoader->get_presenter() == nullptr );
+
+        delete pLoader;
+    }
+
+    TEST_FIXTURE(DocumentLoaderTestFixture, cancel_before_building_model)
+    {
+        m_cancelAtStage = EventLoad::k_stage_building_model;
+        DocumentLoader* pLoader = create_loader(m_scores_path + "00011-empty-fill-page.lms");
+        pLoader->start();
+        pLoader->wait();
+
+        CHECK( pLoader->get_stage() == EventLoad::k_stage_cancelled );
+        CHECK( m_stages.size() == 4 );
+        CHECK( m_stages[3] == EventLoad::k_stage_cancelled );
+        CHECK( pLoader->get_presenter() == nullptr );
+
+        delete pLoader;
+    }
+
+    TEST_FIXTURE(DocumentLoaderTestFixture, unsupported_format)
+    {
+        stringstream errormsg;
+        DocumentLoader* pLoader = create_loader(m_scores_path + "no-file.xyz", errormsg);
+        pLoader->start();
+        pLoader->wait();
+
+        CHECK( pLoader->get_stage() == EventLoad::k_stage_ready );
+        CHECK( pLoader->get_num_errors() == 1 );
+        CHECK( errormsg.str() == "File format not supported.\n" );
+        Presenter* pPresenter = pLoader->get_presenter();
+        CHECK( pPresenter != nullptr );
+
+        delete pLoader;
+        delete pPresenter;
+    }
+
+    TEST_FIXTURE(DocumentLoaderTestFixture, delete_loader_cancels_loading)
+    {
+        DocumentLoader* pLoader = create_loader(m_scores_path + "50000-hello-world.xml");
+        pLoader->start();
+        delete pLoader;
+
+        CHECK( m_stages.empty() || m_stages.back() >= EventLoad::k_stage_ready );
+    }
+
+};
@@ -29,6 +29,8 @@
 
 #include <UnitTest++.h>
 #include <sstream>
+#include <thread>
+#include <mutex>
 #include "lomse_config.h"
 
 //classes related to these tests
@@ -36,6 +38,7 @@
 #include "lomse_document.h"
 #include "lomse_internal_model.h"
 #include "lomse_events.h"
+#include "lomse_events_dispatcher.h"
 #include "lomse_hyperlink_ctrl.h"
 #include "lomse_button_ctrl.h"
 
@@ -248,3 +251,250 @@ SUITE(DocumentEventsTest)
 
 };
 
+
+
+//---------------------------------------------------------------------------------------
+class MyDispatcherObserver : public Observer
+{
+public:
+    MyDispatcherObserver() : Observer(nullptr) {}
+    ~MyDispatcherObserver() {}
+};
+
+//---------------------------------------------------------------------------------------
+class MyCountingHandler : public EventHandler
+{
+protected:
+    std::mutex m_mutex;
+    int m_numEvents;
+    VRect m_lastRect;
+    bool m_fLastWholeWindow;
+
+public:
+    MyCountingHandler() : m_numEvents(0), m_fLastWholeWindow(false) {}
+    ~MyCountingHandler() {}
+
+    //mandatory override
+    void handle_event(SpEventInfo pEvent)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_numEvents;
+        if (pEvent->is_update_window_event())
+        {
+            SpEventPaint pPaint( static_pointer_cast<EventPaint>(pEvent) );
+            m_lastRect = pPaint->get_damaged_rectangle();
+            m_fLastWholeWindow = pPaint->is_whole_window();
+        }
+    }
+
+    int num_events()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_numEvents;
+    }
+
+    VRect last_rect()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_lastRect;
+    }
+
+    bool last_whole_window()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_fLastWholeWindow;
+    }
+
+    bool wait_for_events(int numEvents)
+    {
+        for (int i=0; i < 2000 && num_events() < numEvents; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return num_events() == numEvents;
+    }
+};
+
+//---------------------------------------------------------------------------------------
+class MyStoppingHandler : public MyCountingHandler
+{
+protected:
+    EventsDispatcher* m_pDispatcher;
+
+public:
+    MyStoppingHandler(EventsDispatcher* pDispatcher) : m_pDispatcher(pDispatcher) {}
+
+    void handle_event(SpEventInfo pEvent)
+    {
+        m_pDispatcher->stop_events_loop();
+        MyCountingHandler::handle_event(pEvent);
+    }
+};
+
+//---------------------------------------------------------------------------------------
+SUITE(EventsDispatcherTest)
+{
+
+    TEST(EventsDispatcher_DirectInvocation)
+    {
+        EventsDispatcher dispatcher;
+        dispatcher.start_events_loop();
+        MyDispatcherObserver observer;
+        MyCountingHandler handler;
+        observer.add_handler(k_update_window_event, &handler);
+
+        SpEventInfo ev( new EventPaint(WpInteractor(), VRect(0, 0, 10, 10)) );
+        dispatcher.post_event(&observer, ev);
+
+        CHECK( handler.num_events() == 1 );
+        CHECK( dispatcher.num_pending_events() == 0 );
+    }
+
+    TEST_FIXTURE(DocumentEventsTestFixture, EventsDispatcher_QueuedEventsDispatched)
+    {
+        EventsDispatcher dispatcher(false);
+        dispatcher.start_events_loop();
+        MyDispatcherObserver observer;
+        MyCountingHandler handler;
+        observer.add_handler(k_on_click_event, &handler);
+        SpDocument spDoc( new MyDocument(m_libraryScope) );
+        spDoc->create_empty();
+        ImoParagraph* pPara = spDoc->add_paragraph();
+
+        for (int i=0; i < 100; ++i)
+        {
+            SpEventInfo ev( new MyEventOnClick(pPara, WpDocument(spDoc)) );
+            dispatcher.post_event(&observer, ev);
+        }
+
+        CHECK( handler.wait_for_events(100) );
+        dispatcher.stop_events_loop();
+    }
+
+    TEST(EventsDispatcher_UpdateWindowCoalesced)
+    {
+        EventsDispatcher dispatcher(false);
+        MyDispatcherObserver observer;
+        MyCountingHandler handler;
+        observer.add_handler(k_update_window_event, &handler);
+
+        //loop not started: events remain in the queue
+        dispatcher.post_event(&observer,
+            SpEventInfo(new EventPaint(WpInteractor(), VRect(10, 10, 10, 10))) );
+        dispatcher.post_event(&observer,
+            SpEventInfo(new EventPaint(WpInteractor(), VRect(50, 40, 10, 20))) );
+        dispatcher.post_event(&observer,
+            SpEventInfo(new EventPaint(WpInteractor(), VRect(30, 30, 5, 5))) );
+        CHECK( dispatcher.num_pending_events() == 1 );
+
+        dispatcher.start_events_loop();
+        CHECK( handler.wait_for_events(1) );
+        CHECK( handler.last_rect() == VRect(10, 10, 50, 50) );
+        dispatcher.stop_events_loop();
+    }
+
+    TEST(EventsDispatcher_UpdateWindowCoalescedWholeWindow)
+    {
+        //a whole window repaint must not be lost when merging
+        for (int order=0; order < 2; ++order)
+        {
+            EventsDispatcher dispatcher(false);
+            MyDispatcherObserver observer;
+            MyCountingHandler handler;
+            observer.add_handler(k_update_window_event, &handler);
+
+            SpEventInfo whole( new EventPaint(WpInteractor(), VRect(0, 0, 0, 0), true) );
+            SpEventInfo partial( new EventPaint(WpInteractor(), VRect(10, 10, 10, 10)) );
+            dispatcher.post_event(&observer, (order == 0 ? whole : partial));
+            dispatcher.post_event(&observer, (order == 0 ? partial : whole));
+            CHECK( dispatcher.num_pending_events() == 1 );
+
+            dispatcher.start_events_loop();
+            CHECK( handler.wait_for_events(1) );
+            CHECK( handler.last_whole_window() == true );
+            CHECK( handler.last_rect().is_empty() );
+            dispatcher.stop_events_loop();
+        }
+    }
+
+    TEST(EventsDispatcher_UpdateWindowCoalescedEmptyRectangle)
+    {
+        //an empty rectangle without the whole window flag does not add damage
+        EventsDispatcher dispatcher(false);
+        MyDispatcherObserver observer;
+        MyCountingHandler handler;
+        observer.add_handler(k_update_window_event, &handler);
+
+        dispatcher.post_event(&observer,
+            SpEventInfo(new EventPaint(WpInteractor(), VRect(10, 10, 10, 10))) );
+        dispatcher.post_event(&observer,
+            SpEventInfo(new EventPaint(WpInteractor(), VRect(0, 0, 0, 0))) );
+        CHECK( dispatcher.num_pending_events() == 1 );
+
+        dispatcher.start_events_loop();
+        CHECK( handler.wait_for_events(1) );
+        CHECK( handler.last_whole_window() == false );
+        CHECK( handler.last_rect() == VRect(10, 10, 10, 10) );
+        dispatcher.stop_events_loop();
+    }
+
+    TEST(EventsDispatcher_StopFromEventsThread)
+    {
+        //stopping from an event handler only requests the loop to finish
+        EventsDispatcher dispatcher(false);
+        dispatcher.set_coalescing_policy(EventsDispatcher::k_coalesce_none);
+        dispatcher.start_events_loop();
+        MyDispatcherObserver observer;
+        MyStoppingHandler handler(&dispatcher);
+        observer.add_handler(k_update_window_event, &handler);
+
+        dispatcher.post_event(&observer,
+            SpEventInfo(new EventPaint(WpInteractor(), VRect(0, 0, 10, 10))) );
+        CHECK( handler.wait_for_events(1) );
+
+        dispatcher.stop_events_loop();
+        dispatcher.post_event(&observer,
+            SpEventInfo(new EventPaint(WpInteractor(), VRect(0, 0, 10, 10))) );
+        CHECK( dispatcher.num_pending_events() == 1 );
+        CHECK( handler.num_events() == 1 );
+    }
+
+    TEST(EventsDispatcher_EventsThreadEnabledInLibraryScope)
+    {
+        LibraryScope libraryScope(cout);
+        CHECK( libraryScope.get_events_dispatcher()->is_direct_invocation() == true );
+
+        libraryScope.enable_events_thread(true);
+        EventsDispatcher* pDispatcher = libraryScope.get_events_dispatcher();
+        CHECK( pDispatcher->is_direct_invocation() == false );
+
+        MyDispatcherObserver observer;
+        MyCountingHandler handler;
+        observer.add_handler(k_update_window_event, &handler);
+        pDispatcher->post_event(&observer,
+            SpEventInfo(new EventPaint(WpInteractor(), VRect(0, 0, 10, 10))) );
+        CHECK( handler.wait_for_events(1) );
+
+        libraryScope.enable_events_thread(false);
+        CHECK( pDispatcher->is_direct_invocation() == true );
+    }
+
+    TEST(EventsDispatcher_NoCoalescing)
+    {
+        EventsDispatcher dispatcher(false);
+        dispatcher.set_coalescing_policy(EventsDispatcher::k_coalesce_none);
+        MyDispatcherObserver observer;
+        MyCountingHandler handler;
+        observer.add_handler(k_update_window_event, &handler);
+
+        for (int i=0; i < 3; ++i)
+        {
+            dispatcher.post_event(&observer,
+                SpEventInfo(new EventPaint(WpInteractor(), VRect(i, i, 10, 10))) );
+        }
+        CHECK( dispatcher.num_pending_events() == 3 );
+
+        dispatcher.start_events_loop();
+        CHECK( handler.wait_for_events(3) );
+        dispatcher.stop_events_loop();
+    }
+
+};
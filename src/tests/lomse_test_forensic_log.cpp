@@ -0,0 +1,245 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2016. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include <UnitTest++.h>
+#include <sstream>
+#include "lomse_build_options.h"
+
+//classes related to these tests
+#include "lomse_forensic_log.h"
+#include "lomse_injectors.h"
+#include "lomse_document.h"
+#include "lomse_document_cursor.h"
+#include "lomse_command.h"
+#include "lomse_selections.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace UnitTest;
+using namespace std;
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+// helper, for accessing protected members
+class MyForensicLog : public ForensicLog
+{
+public:
+    MyForensicLog(const string& path) : ForensicLog(path, k_disabled) {}
+
+    void lock_file() { m_fileMutex.lock(); }
+    void unlock_file() { m_fileMutex.unlock(); }
+};
+
+
+//---------------------------------------------------------------------------------------
+class ForensicLogTestFixture
+{
+public:
+    LibraryScope m_libraryScope;
+    string m_path;
+
+    ForensicLogTestFixture()     //SetUp fixture
+        : m_libraryScope(cout)
+        , m_path("forensic_log_test.txt")
+    {
+        std::remove(m_path.c_str());
+    }
+
+    ~ForensicLogTestFixture()    //TearDown fixture
+    {
+        std::remove(m_path.c_str());
+    }
+
+    string read_log(const string& path)
+    {
+        ifstream file(path);
+        stringstream ss;
+        ss << file.rdbuf();
+        return ss.str();
+    }
+};
+
+
+SUITE(ForensicLogTest)
+{
+
+    TEST_FIXTURE(ForensicLogTestFixture, forensic_log_001)
+    {
+        //@001. synchronous mode. Records written immediately
+        ForensicLog log(m_path);
+        log.write("record 1\n");
+        log.write("record 2\n");
+
+        CHECK( log.get_mode() == ForensicLog::k_synchronous );
+        CHECK( read_log(m_path) == "record 1\nrecord 2\n" );
+        CHECK( log.num_pending_records() == 0 );
+    }
+
+    TEST_FIXTURE(ForensicLogTestFixture, forensic_log_002)
+    {
+        //@002. disabled mode. Nothing written
+        ForensicLog log(m_path, ForensicLog::k_disabled);
+        log.write("record 1\n");
+        log.flush();
+
+        CHECK( log.is_enabled() == false );
+        CHECK( read_log(m_path) == "" );
+    }
+
+    TEST_FIXTURE(ForensicLogTestFixture, forensic_log_003)
+    {
+        //@003. asynchronous mode. Records written in order after flush
+        ForensicLog log(m_path, ForensicLog::k_asynchronous);
+        stringstream expected;
+        for (int i=0; i < 100; ++i)
+        {
+            stringstream ss;
+            ss << "record " << i << endl;
+            log.write(ss.str());
+            expected << ss.str();
+        }
+        log.flush();
+
+        CHECK( log.num_pending_records() == 0 );
+        CHECK( read_log(m_path) == expected.str() );
+    }
+
+    TEST_FIXTURE(ForensicLogTestFixture, forensic_log_004)
+    {
+        //@004. asynchronous mode. Pending records written when log is destroyed
+        {
+            ForensicLog log(m_path, ForensicLog::k_asynchronous);
+            log.write("record 1\n");
+            log.write("record 2\n");
+        }
+
+        CHECK( read_log(m_path) == "record 1\nrecord 2\n" );
+    }
+
+    TEST_FIXTURE(ForensicLogTestFixture, forensic_log_005)
+    {
+        //@005. ring full. Oldest records discarded and noted in the file
+        MyForensicLog log(m_path);
+        log.set_capacity(20);
+        log.set_mode(ForensicLog::k_asynchronous);
+
+        log.lock_file();        //writer thread can not take the records
+        log.write("record 1\n");
+        log.write("record 2\n");
+        log.write("record 3\n");
+        log.write("record 4\n");
+        log.unlock_file();
+        log.flush();
+
+        CHECK( log.num_lost_records() == 2 );
+        CHECK( read_log(m_path) ==
+            "[ForensicLog] 2 records discarded. Ring full.\nrecord 3\nrecord 4\n" );
+    }
+
+    TEST_FIXTURE(ForensicLogTestFixture, forensic_log_006)
+    {
+        //@006. clear() truncates the file
+        ForensicLog log(m_path);
+        log.write("record 1\n");
+        log.clear();
+        log.write("record 2\n");
+
+        CHECK( read_log(m_path) == "record 2\n" );
+    }
+
+    TEST_FIXTURE(ForensicLogTestFixture, forensic_log_007)
+    {
+        //@007. LibraryScope. Synchronous mode by default. Mode can be changed
+        ForensicLog* pLog = m_libraryScope.get_forensic_log();
+
+        CHECK( pLog != nullptr );
+        CHECK( pLog->get_mode() == ForensicLog::k_synchronous );
+        CHECK( pLog->get_path() == "forensic_log.txt" );
+
+        m_libraryScope.set_forensic_log_mode(ForensicLog::k_asynchronous);
+        CHECK( pLog->get_mode() == ForensicLog::k_asynchronous );
+        CHECK( m_libraryScope.get_forensic_log() == pLog );
+    }
+
+    TEST_FIXTURE(ForensicLogTestFixture, forensic_log_008)
+    {
+        //@008. commands write their data in the LibraryScope log. Checkpoint as source
+        ForensicLog* pLog = m_libraryScope.get_forensic_log();
+        pLog->set_mode(ForensicLog::k_asynchronous);
+        size_t start = read_log(pLog->get_path()).size();
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G)(n c4 q)(barline)"
+            ")))");
+        DocCursor cursor(&doc);
+        DocCommandExecuter executer(&doc);
+        SelectionSet sel(&doc);
+        cursor.enter_element();     //points to clef
+        cursor.move_next();         //points to note
+
+        executer.execute(&cursor, LOMSE_NEW CmdAddNoteRest("(n e4 q)", k_edit_mode_replace), &sel);
+        executer.undo(&cursor, &sel);
+        pLog->flush();
+
+        string data = read_log(pLog->get_path()).substr(start);
+        size_t execute = data.find("Before executing command");
+        size_t undo = data.find("Before Undo");
+        CHECK( execute != string::npos );
+        CHECK( undo != string::npos );
+        CHECK( execute < undo );
+        CHECK( pLog->num_pending_records() == 0 );
+        //checkpoint is logged as source, for rebuilding the document
+        size_t source = data.find("(n#36 c4 q");
+        CHECK( source != string::npos && source < undo );
+        CHECK( data.find("Binary snapshot") == string::npos );
+    }
+
+    TEST_FIXTURE(ForensicLogTestFixture, forensic_log_009)
+    {
+        //@009. flush_all_on_crash() skips busy logs and writes pending records
+        MyForensicLog log(m_path);
+        log.set_mode(ForensicLog::k_asynchronous);
+
+        log.lock_file();
+        log.write("record 1\n");
+        log.write("record 2\n");
+        ForensicLog::flush_all_on_crash();
+        CHECK( log.num_pending_records() == 2 );
+        log.unlock_file();
+
+        ForensicLog::flush_all_on_crash();
+        log.flush();
+        CHECK( log.num_pending_records() == 0 );
+        CHECK( read_log(m_path) == "record 1\nrecord 2\n" );
+    }
+
+}
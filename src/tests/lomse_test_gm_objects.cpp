@@ -55,7 +55,13 @@ public:
     MyGmoBoxDocPage(ImoObj* pCreatorImo) : GmoBoxDocPage(pCreatorImo) {}
     ~MyGmoBoxDocPage() {}
 
-    inline std::list<GmoShape*>& get_all_shapes() { return m_allShapes; }
+    std::list<GmoShape*> get_all_shapes()
+    {
+        std::list<GmoShape*> shapes;
+        for (size_t i=0; i < m_layers.size(); ++i)
+            shapes.insert(shapes.end(), m_layers[i].begin(), m_layers[i].end());
+        return shapes;
+    }
 };
 
 
@@ -242,7 +248,7 @@ SUITE(GmoTest)
         pScorePage->add_system(pBox, 0);
         pBox->add_shapes_to_tables();
 
-        std::list<GmoShape*>& shapes = page.get_all_shapes();
+        std::list<GmoShape*> shapes = page.get_all_shapes();
         std::list<GmoShape*>::iterator it = shapes.begin();
 
         //cout << (*it)->get_layer() << endl;
@@ -274,6 +280,36 @@ SUITE(GmoTest)
         delete pInfo;
     }
 
+    TEST_FIXTURE(GmoTestFixture, BoxDocPage_FirstShapeForLayerIsTopmost)
+    {
+        Document doc(m_libraryScope);
+        GmoBoxDocPage page(nullptr);
+        GmoBoxDocPageContent* pDPC = LOMSE_NEW GmoBoxDocPageContent(nullptr);
+        page.add_child_box(pDPC);
+        GmoBoxScorePage* pScorePage = LOMSE_NEW GmoBoxScorePage(nullptr);
+        pDPC->add_child_box(pScorePage);
+        GmoBoxSystem* pBox = LOMSE_NEW GmoBoxSystem(nullptr);
+        ImoStaffInfo* pInfo = static_cast<ImoStaffInfo*>(
+                                    ImFactory::inject(k_imo_staff_info, &doc));
+        GmoShapeStaff* pShape0 = LOMSE_NEW GmoShapeStaff(pInfo, 0, pInfo, 0, 20.0f, Color(0,0,0));
+        pBox->add_shape(pShape0, 1);
+        GmoShapeStaff* pShape1 = LOMSE_NEW GmoShapeStaff(pInfo, 1, pInfo, 0, 20.0f, Color(0,0,0));
+        pBox->add_shape(pShape1, 3);
+        GmoShapeStaff* pShape2 = LOMSE_NEW GmoShapeStaff(pInfo, 2, pInfo, 0, 20.0f, Color(0,0,0));
+        pBox->add_shape(pShape2, 1);
+
+        pScorePage->add_system(pBox, 0);
+        pBox->add_shapes_to_tables();
+
+        CHECK( page.get_num_shapes() == 3 );
+        CHECK( page.get_first_shape_for_layer(0) == nullptr );
+        CHECK( page.get_first_shape_for_layer(1) == pShape2 );
+        CHECK( page.get_first_shape_for_layer(2) == nullptr );
+        CHECK( page.get_first_shape_for_layer(3) == pShape1 );
+        CHECK( page.get_first_shape_for_layer(4) == nullptr );
+        delete pInfo;
+    }
+
     TEST_FIXTURE(GmoTestFixture, Shape_SetOrigin)
     {
         Document doc(m_libraryScope);
@@ -515,6 +515,15 @@ SUITE(InteractorTest)
         CHECK( pIntor->sel_point_is(10, 33) == true );
     }
 
+    TEST_FIXTURE(InteractorTestFixture, Timing_SubMillisecondResolution)
+    {
+        ptime start(true);
+        ptime end = start;
+        end.timepoint += chrono::microseconds(1500);
+
+        CHECK( end - start == 1.5 );
+    }
+
     //TEST_FIXTURE(InteractorTestFixture, NotificationReceived)
     //{
     //    fNotified = false;
@@ -0,0 +1,348 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include <UnitTest++.h>
+#include <sstream>
+#include "lomse_build_options.h"
+
+//classes related to these tests
+#include "lomse_injectors.h"
+#include "lomse_midi_file.h"
+#include "lomse_document.h"
+#include "lomse_internal_model.h"
+#include "lomse_score_player.h"
+#include "lomse_player_gui.h"
+
+
+
+using namespace UnitTest;
+using namespace std;
+using namespace lomse;
+
+//---------------------------------------------------------------------------------------
+class MidiFileTestFixture
+{
+public:
+    LibraryScope m_libraryScope;
+    std::string m_scores_path;
+
+    MidiFileTestFixture()     //SetUp fixture
+        : m_libraryScope(cout)
+    {
+        m_scores_path = TESTLIB_SCORES_PATH;
+        m_libraryScope.set_default_fonts_path(TESTLIB_FONTS_PATH);
+    }
+
+    ~MidiFileTestFixture()    //TearDown fixture
+    {
+    }
+
+    bool check_message(const MidiMessage& msg, long time, int type, int channel,
+                       int data1)
+    {
+        if (msg.time != time || msg.type() != type || msg.channel() != channel
+            || msg.data1 != data1)
+        {
+            cout << UnitTest::CurrentTest::Details()->testName
+                 << ". Message: time=" << msg.time << ", status=" << hex
+                 << msg.status << dec << ", data1=" << msg.data1 << endl;
+            return false;
+        }
+        return true;
+    }
+
+    void dump_messages(vector<MidiMessage>& messages)
+    {
+        cout << UnitTest::CurrentTest::Details()->testName << endl;
+        vector<MidiMessage>::iterator it;
+        for (it = messages.begin(); it != messages.end(); ++it)
+        {
+            cout << (*it).time << "\t" << hex << (*it).status << dec << "\t"
+                 << (*it).data1 << "\t" << (*it).data2 << endl;
+        }
+    }
+};
+
+SUITE(MidiFileTest)
+{
+
+    TEST_FIXTURE(MidiFileTestFixture, recorder_001)
+    {
+        //@001. Offline playback. Messages recorded with their times
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G)(n c4 q)(n e4 q) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        MidiRecorder midi;
+        ScorePlayer* pPlayer = Injector::inject_ScorePlayer(m_libraryScope, &midi);
+        midi.set_player(pPlayer);
+        PlayerNoGui playGui(60);
+        pPlayer->load_score(pScore, &playGui);
+        pPlayer->play_offline();
+
+        vector<MidiMessage>& messages = midi.get_messages();
+//        dump_messages(messages);
+        CHECK( messages.size() == 8 );
+        CHECK( check_message(messages[0], 0L, MidiMessage::k_program_change, 9, 0) );
+        CHECK( check_message(messages[1], 0L, MidiMessage::k_program_change, 0, 0) );
+        CHECK( check_message(messages[2], 0L, MidiMessage::k_note_on, 0, 60) );
+        CHECK( check_message(messages[3], 1000L, MidiMessage::k_note_off, 0, 60) );
+        CHECK( check_message(messages[4], 1000L, MidiMessage::k_note_on, 0, 64) );
+        CHECK( check_message(messages[5], 2000L, MidiMessage::k_note_off, 0, 64) );
+        CHECK( check_message(messages[6], 2000L, MidiMessage::k_control_change, 0, 120) );
+        CHECK( check_message(messages[7], 2000L, MidiMessage::k_control_change, 9, 120) );
+
+        delete pPlayer;
+    }
+
+    TEST_FIXTURE(MidiFileTestFixture, recorder_002)
+    {
+        //@002. Offline playback. Tempo is honoured. When tempo is forced, there
+        //is a metronome pulse before the first note
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G)(n c4 q)(n e4 q) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        MidiRecorder midi;
+        ScorePlayer* pPlayer = Injector::inject_ScorePlayer(m_libraryScope, &midi);
+        midi.set_player(pPlayer);
+        PlayerNoGui playGui(60);
+        pPlayer->load_score(pScore, &playGui);
+        pPlayer->play_offline(1, 0, 120L);
+
+        vector<MidiMessage>& messages = midi.get_messages();
+        CHECK( messages.size() == 8 );
+        CHECK( check_message(messages[2], 500L, MidiMessage::k_note_on, 0, 60) );
+        CHECK( check_message(messages[3], 1000L, MidiMessage::k_note_off, 0, 60) );
+        CHECK( check_message(messages[4], 1000L, MidiMessage::k_note_on, 0, 64) );
+        CHECK( check_message(messages[5], 1500L, MidiMessage::k_note_off, 0, 64) );
+
+        delete pPlayer;
+    }
+
+    TEST_FIXTURE(MidiFileTestFixture, recorder_003)
+    {
+        //@003. Offline playback. Repetitions are honoured
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G)(time 1 4)(n c4 q)(barline endRepetition)(n e4 q) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        MidiRecorder midi;
+        ScorePlayer* pPlayer = Injector::inject_ScorePlayer(m_libraryScope, &midi);
+        midi.set_player(pPlayer);
+        PlayerNoGui playGui(60);
+        pPlayer->load_score(pScore, &playGui);
+        pPlayer->play_offline();
+
+        vector<MidiMessage>& messages = midi.get_messages();
+//        dump_messages(messages);
+        vector<MidiMessage> notes;
+        vector<MidiMessage>::iterator it;
+        for (it = messages.begin(); it != messages.end(); ++it)
+        {
+            if ((*it).type() == MidiMessage::k_note_on)
+                notes.push_back(*it);
+        }
+        CHECK( notes.size() == 3 );
+        CHECK( check_message(notes[0], 0L, MidiMessage::k_note_on, 0, 60) );
+        CHECK( check_message(notes[1], 1000L, MidiMessage::k_note_on, 0, 60) );
+        CHECK( check_message(notes[2], 2000L, MidiMessage::k_note_on, 0, 64) );
+
+        delete pPlayer;
+    }
+
+    TEST_FIXTURE(MidiFileTestFixture, recorder_004)
+    {
+        //@004. Offline playback. Count-off clicks delay the music
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G)(time 2 4)(n c4 q)(n e4 q) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        MidiRecorder midi;
+        ScorePlayer* pPlayer = Injector::inject_ScorePlayer(m_libraryScope, &midi);
+        midi.set_player(pPlayer);
+        PlayerNoGui playGui(60, k_do_countoff);
+        pPlayer->load_score(pScore, &playGui);
+        pPlayer->play_offline();
+
+        vector<MidiMessage>& messages = midi.get_messages();
+//        dump_messages(messages);
+        int numClicks = 0;
+        long firstNote = -1L;
+        vector<MidiMessage>::iterator it;
+        for (it = messages.begin(); it != messages.end(); ++it)
+        {
+            if ((*it).type() == MidiMessage::k_note_on)
+            {
+                if ((*it).channel() == 9)
+                    ++numClicks;
+                else if (firstNote == -1L)
+                    firstNote = (*it).time;
+            }
+        }
+        CHECK( numClicks == 2 );
+        CHECK( firstNote > 1000L );
+
+        delete pPlayer;
+    }
+
+    TEST_FIXTURE(MidiFileTestFixture, recorder_005)
+    {
+        //@005. Offline playback is not done in real time
+
+        stringstream ldp;
+        ldp << "(score (vers 2.0)(instrument (musicData (clef G)(time 4 4)";
+        for (int i=0; i < 200; ++i)
+            ldp << "(n c4 q)(n e4 q)(n g4 q)(n c5 q)(barline)";
+        ldp << ")))";
+        Document doc(m_libraryScope);
+        doc.from_string(ldp.str());
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        MidiRecorder midi;
+        ScorePlayer* pPlayer = Injector::inject_ScorePlayer(m_libraryScope, &midi);
+        midi.set_player(pPlayer);
+        PlayerNoGui playGui(60);
+        pPlayer->load_score(pScore, &playGui);
+
+        pPlayer->play_offline();
+
+        vector<MidiMessage>& messages = midi.get_messages();
+        CHECK( messages.size() == 1604 );
+        CHECK( messages.back().time == 800000L );
+        //the scheduler never waited for a deadline
+        CHECK( pPlayer->get_timing_stats().numEvents == 0 );
+
+        delete pPlayer;
+    }
+
+    TEST_FIXTURE(MidiFileTestFixture, recorder_006)
+    {
+        //@006. Playback from a measure sounds the notes tied from previous measure
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G)(time 2 4)(n c4 q)(n e4 q l)(barline simple)"
+            "(n e4 q)(n g4 q)(barline simple) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        MidiRecorder midi;
+        ScorePlayer* pPlayer = Injector::inject_ScorePlayer(m_libraryScope, &midi);
+        midi.set_player(pPlayer);
+        PlayerNoGui playGui(60);
+        pPlayer->load_score(pScore, &playGui);
+        pPlayer->play_offline(2, 0);
+
+        vector<MidiMessage>& messages = midi.get_messages();
+//        dump_messages(messages);
+        CHECK( messages.size() == 8 );
+        CHECK( check_message(messages[2], 0L, MidiMessage::k_note_on, 0, 64) );
+        CHECK( check_message(messages[3], 1000L, MidiMessage::k_note_off, 0, 64) );
+        CHECK( check_message(messages[4], 1000L, MidiMessage::k_note_on, 0, 67) );
+
+        delete pPlayer;
+    }
+
+    TEST_FIXTURE(MidiFileTestFixture, recorder_007)
+    {
+        //@007. Mixed playback. Both scores are played with shared timing
+
+        Document doc(m_libraryScope);
+        doc.from_string("(lenmusdoc (vers 0.0) (content "
+            "(score (vers 2.0)(instrument (musicData "
+            "(clef G)(n c4 q)(n e4 q) )))"
+            "(score (vers 2.0)(instrument (musicData "
+            "(clef F4)(n c3 h) )))"
+            "))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        ImoScore* pScore2 = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(1) );
+        MidiRecorder midi;
+        ScorePlayer* pPlayer = Injector::inject_ScorePlayer(m_libraryScope, &midi);
+        midi.set_player(pPlayer);
+        PlayerNoGui playGui(60);
+        pPlayer->load_score(pScore, &playGui);
+        CHECK( pPlayer->mix_score(pScore2) == true );
+        CHECK( pPlayer->num_mixed_scores() == 1 );
+        pPlayer->play_offline();
+
+        vector<MidiMessage>& messages = midi.get_messages();
+//        dump_messages(messages);
+        CHECK( messages.size() == 12 );
+        CHECK( check_message(messages[0], 0L, MidiMessage::k_program_change, 9, 0) );
+        CHECK( check_message(messages[1], 0L, MidiMessage::k_program_change, 0, 0) );
+        CHECK( check_message(messages[2], 0L, MidiMessage::k_program_change, 1, 0) );
+        CHECK( check_message(messages[3], 0L, MidiMessage::k_note_on, 0, 60) );
+        CHECK( check_message(messages[4], 0L, MidiMessage::k_note_on, 1, 48) );
+        CHECK( check_message(messages[5], 1000L, MidiMessage::k_note_off, 0, 60) );
+        CHECK( check_message(messages[6], 1000L, MidiMessage::k_note_on, 0, 64) );
+        CHECK( check_message(messages[7], 2000L, MidiMessage::k_note_off, 0, 64) );
+        CHECK( check_message(messages[8], 2000L, MidiMessage::k_note_off, 1, 48) );
+
+        //main score table is not modified
+        pPlayer->remove_mixed_scores();
+        CHECK( pPlayer->num_mixed_scores() == 0 );
+        midi.clear();
+        pPlayer->play_offline();
+        CHECK( midi.get_messages().size() == 8 );
+
+        delete pPlayer;
+    }
+
+    TEST_FIXTURE(MidiFileTestFixture, midi_file_001)
+    {
+        //@001. Type 1 file: tempo track and one track per channel
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G)(n c4 q) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        MidiFileRenderer renderer(m_libraryScope);
+        stringstream file;
+
+        CHECK( renderer.render(pScore, file) == true );
+
+        string data = file.str();
+        //header: format 1, 3 tracks (tempo, channel 0, channel 9), 500 ticks/quarter
+        CHECK( data.substr(0, 4) == "MThd" );
+        CHECK( data.substr(4, 10) == string("\x00\x00\x00\x06\x00\x01\x00\x03\x01\xF4", 10) );
+        //tempo track: set tempo 500000 and end of track
+        CHECK( data.substr(14, 8) == string("MTrk\x00\x00\x00\x0B", 8) );
+        CHECK( data.substr(22, 11) == string("\x00\xFF\x51\x03\x07\xA1\x20\x00\xFF\x2F\x00", 11) );
+        //channel 0 track: program, note on, note off (1000 ticks later), all sound off
+        CHECK( data.substr(33, 8) == string("MTrk\x00\x00\x00\x14", 8) );
+        CHECK( data.substr(41, 20) == string("\x00\xC0\x00\x00\x90\x3C\x40\x87\x68\x80\x3C\x7F"
+                                             "\x00\xB0\x78\x00\x00\xFF\x2F\x00", 20) );
+        //channel 9 track: metronome program and all sound off
+        CHECK( data.substr(61, 4) == "MTrk" );
+        CHECK( data.size() == 61 + 8 + 12 );
+    }
+
+}
@@ -29,6 +29,7 @@
 
 #include <UnitTest++.h>
 #include <sstream>
+#include <climits>
 #include "lomse_build_options.h"
 
 //classes related to these tests
@@ -36,6 +37,7 @@
 #include "lomse_midi_table.h"
 #include "lomse_document.h"
 #include "lomse_internal_model.h"
+#include "lomse_im_note.h"
 //#include "lomse_staffobjs_table.h"
 
 
@@ -52,7 +54,7 @@ public:
     virtual ~MySoundEventsTable() {}
 
     void my_program_sounds_for_instruments() { program_sounds_for_instruments(); }
-    void my_create_events() { create_events(); }
+    void my_create_events() { create_events(1, INT_MAX); }
     void my_close_table() { close_table(); }
     void my_sort_by_time() { sort_by_time(); }
 
@@ -168,8 +170,8 @@ SUITE(MidiTableTest)
 
         //cout << "num.events = " << table.num_events() << endl;
         CHECK( table.num_events() == 1 );
-        std::vector<SoundEvent*>& events = table.get_events();
-        SoundEvent* ev = events.front();
+        std::vector<SoundEvent>& events = table.get_events();
+        SoundEvent* ev = &events.front();
         CHECK( ev->Channel == 0 );
         CHECK( ev->Instrument == 0 );
         CHECK( ev->EventType == SoundEvent::k_prog_instr );
@@ -188,8 +190,8 @@ SUITE(MidiTableTest)
 
         //cout << "num.events = " << table.num_events() << endl;
         CHECK( table.num_events() == 1 );
-        std::vector<SoundEvent*>& events = table.get_events();
-        SoundEvent* ev = events.front();
+        std::vector<SoundEvent>& events = table.get_events();
+        SoundEvent* ev = &events.front();
         CHECK( ev->Channel == 0 );
         CHECK( ev->Instrument == 2 );
         CHECK( ev->EventType == SoundEvent::k_prog_instr );
@@ -208,13 +210,13 @@ SUITE(MidiTableTest)
         table.my_create_events();
 
         CHECK( table.num_events() == 3 );
-        std::vector<SoundEvent*>& events = table.get_events();
-        std::vector<SoundEvent*>::iterator it = events.begin();
-        CHECK( (*it)->EventType == SoundEvent::k_prog_instr );
+        std::vector<SoundEvent>& events = table.get_events();
+        std::vector<SoundEvent>::iterator it = events.begin();
+        CHECK( (*it).EventType == SoundEvent::k_prog_instr );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_note_on );
+        CHECK( (*it).EventType == SoundEvent::k_note_on );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_note_off );
+        CHECK( (*it).EventType == SoundEvent::k_note_off );
     }
 
     TEST_FIXTURE(MidiTableTestFixture, CreateEvents_OneRest)
@@ -231,13 +233,13 @@ SUITE(MidiTableTest)
 
         //cout << "num.events = " << table.num_events() << endl;
         CHECK( table.num_events() == 3 );
-        std::vector<SoundEvent*>& events = table.get_events();
-        std::vector<SoundEvent*>::iterator it = events.begin();
-        CHECK( (*it)->EventType == SoundEvent::k_prog_instr );
+        std::vector<SoundEvent>& events = table.get_events();
+        std::vector<SoundEvent>::iterator it = events.begin();
+        CHECK( (*it).EventType == SoundEvent::k_prog_instr );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_visual_on );
+        CHECK( (*it).EventType == SoundEvent::k_visual_on );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_visual_off );
+        CHECK( (*it).EventType == SoundEvent::k_visual_off );
     }
 
     TEST_FIXTURE(MidiTableTestFixture, CreateEvents_RestNoVisible)
@@ -254,13 +256,13 @@ SUITE(MidiTableTest)
 
         //cout << "num.events = " << table.num_events() << endl;
         CHECK( table.num_events() == 3 );
-        std::vector<SoundEvent*>& events = table.get_events();
-        std::vector<SoundEvent*>::iterator it = events.begin();
-        CHECK( (*it)->EventType == SoundEvent::k_prog_instr );
+        std::vector<SoundEvent>& events = table.get_events();
+        std::vector<SoundEvent>::iterator it = events.begin();
+        CHECK( (*it).EventType == SoundEvent::k_prog_instr );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_note_on );
+        CHECK( (*it).EventType == SoundEvent::k_note_on );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_note_off );
+        CHECK( (*it).EventType == SoundEvent::k_note_off );
     }
 
     TEST_FIXTURE(MidiTableTestFixture, CreateEvents_TwoNotesTied)
@@ -276,17 +278,17 @@ SUITE(MidiTableTest)
         table.my_create_events();
 
         CHECK( table.num_events() == 5 );
-        std::vector<SoundEvent*>& events = table.get_events();
-        std::vector<SoundEvent*>::iterator it = events.begin();
-        CHECK( (*it)->EventType == SoundEvent::k_prog_instr );
+        std::vector<SoundEvent>& events = table.get_events();
+        std::vector<SoundEvent>::iterator it = events.begin();
+        CHECK( (*it).EventType == SoundEvent::k_prog_instr );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_note_on );
+        CHECK( (*it).EventType == SoundEvent::k_note_on );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_visual_off );
+        CHECK( (*it).EventType == SoundEvent::k_visual_off );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_visual_on );
+        CHECK( (*it).EventType == SoundEvent::k_visual_on );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_note_off );
+        CHECK( (*it).EventType == SoundEvent::k_note_off );
     }
 
     TEST_FIXTURE(MidiTableTestFixture, BarlineIncrementsMeasureCount)
@@ -301,19 +303,19 @@ SUITE(MidiTableTest)
         table.my_program_sounds_for_instruments();
         table.my_create_events();
 
-        std::vector<SoundEvent*>& events = table.get_events();
-        std::vector<SoundEvent*>::iterator it = events.begin();
-        CHECK( (*it)->EventType == SoundEvent::k_prog_instr );
+        std::vector<SoundEvent>& events = table.get_events();
+        std::vector<SoundEvent>::iterator it = events.begin();
+        CHECK( (*it).EventType == SoundEvent::k_prog_instr );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_note_on );
-        CHECK( (*it)->Measure == 1 );
+        CHECK( (*it).EventType == SoundEvent::k_note_on );
+        CHECK( (*it).Measure == 1 );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_note_off );
+        CHECK( (*it).EventType == SoundEvent::k_note_off );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_note_on );
-        CHECK( (*it)->Measure == 2 );
+        CHECK( (*it).EventType == SoundEvent::k_note_on );
+        CHECK( (*it).Measure == 2 );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_note_off );
+        CHECK( (*it).EventType == SoundEvent::k_note_off );
     }
 
     TEST_FIXTURE(MidiTableTestFixture, TimeSignatureAddsRythmChange)
@@ -329,16 +331,16 @@ SUITE(MidiTableTest)
         table.my_create_events();
 
         CHECK( table.num_events() == 2 );
-        std::vector<SoundEvent*>& events = table.get_events();
-        std::vector<SoundEvent*>::iterator it = events.begin();
-        CHECK( (*it)->EventType == SoundEvent::k_prog_instr );
+        std::vector<SoundEvent>& events = table.get_events();
+        std::vector<SoundEvent>::iterator it = events.begin();
+        CHECK( (*it).EventType == SoundEvent::k_prog_instr );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_rhythm_change );
-        CHECK( (*it)->TopNumber == 2 );
-        CHECK( (*it)->BeatDuration == 64 );
-        CHECK( (*it)->NumPulses == 2 );
-        //cout << ", NumPulses = " << (*it)->NumPulses
-        //     << ", TopNumber = " << (*it)->TopNumber << endl;
+        CHECK( (*it).EventType == SoundEvent::k_rhythm_change );
+        CHECK( (*it).TopNumber == 2 );
+        CHECK( (*it).BeatDuration == 64 );
+        CHECK( (*it).NumPulses == 2 );
+        //cout << ", NumPulses = " << (*it).NumPulses
+        //     << ", TopNumber = " << (*it).TopNumber << endl;
     }
 
     TEST_FIXTURE(MidiTableTestFixture, TimeSignatureInfoOk)
@@ -354,16 +356,16 @@ SUITE(MidiTableTest)
         table.my_create_events();
 
         CHECK( table.num_events() == 2 );
-        std::vector<SoundEvent*>& events = table.get_events();
-        std::vector<SoundEvent*>::iterator it = events.begin();
-        CHECK( (*it)->EventType == SoundEvent::k_prog_instr );
+        std::vector<SoundEvent>& events = table.get_events();
+        std::vector<SoundEvent>::iterator it = events.begin();
+        CHECK( (*it).EventType == SoundEvent::k_prog_instr );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_rhythm_change );
-        CHECK( (*it)->TopNumber == 6 );
-        CHECK( (*it)->BeatDuration == 32 );
-        CHECK( (*it)->NumPulses == 2 );
-        //cout << ", NumPulses = " << (*it)->NumPulses
-        //     << ", TopNumber = " << (*it)->TopNumber << endl;
+        CHECK( (*it).EventType == SoundEvent::k_rhythm_change );
+        CHECK( (*it).TopNumber == 6 );
+        CHECK( (*it).BeatDuration == 32 );
+        CHECK( (*it).NumPulses == 2 );
+        //cout << ", NumPulses = " << (*it).NumPulses
+        //     << ", TopNumber = " << (*it).TopNumber << endl;
     }
 
     TEST_FIXTURE(MidiTableTestFixture, CloseTableAddsEvent)
@@ -378,10 +380,10 @@ SUITE(MidiTableTest)
         table.my_close_table();
 
         CHECK( table.num_events() == 1 );
-        std::vector<SoundEvent*>& events = table.get_events();
-        std::vector<SoundEvent*>::iterator it = events.begin();
-        CHECK( (*it)->EventType == SoundEvent::k_end_of_score );
-        CHECK( (*it)->DeltaTime == 0.0f );
+        std::vector<SoundEvent>& events = table.get_events();
+        std::vector<SoundEvent>::iterator it = events.begin();
+        CHECK( (*it).EventType == SoundEvent::k_end_of_score );
+        CHECK( (*it).DeltaTime == 0.0f );
     }
 
     TEST_FIXTURE(MidiTableTestFixture, CloseTableFinalTime)
@@ -398,16 +400,16 @@ SUITE(MidiTableTest)
         table.my_close_table();
 
         CHECK( table.num_events() == 4 );
-        std::vector<SoundEvent*>& events = table.get_events();
-        std::vector<SoundEvent*>::iterator it = events.begin();
-        CHECK( (*it)->EventType == SoundEvent::k_prog_instr );
+        std::vector<SoundEvent>& events = table.get_events();
+        std::vector<SoundEvent>::iterator it = events.begin();
+        CHECK( (*it).EventType == SoundEvent::k_prog_instr );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_visual_on );
+        CHECK( (*it).EventType == SoundEvent::k_visual_on );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_visual_off );
+        CHECK( (*it).EventType == SoundEvent::k_visual_off );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_end_of_score );
-        CHECK( (*it)->DeltaTime == 64.0f );
+        CHECK( (*it).EventType == SoundEvent::k_end_of_score );
+        CHECK( (*it).DeltaTime == 64.0f );
     }
 
     TEST_FIXTURE(MidiTableTestFixture, EventsSorted)
@@ -424,24 +426,24 @@ SUITE(MidiTableTest)
         table.my_close_table();
         table.my_sort_by_time();
 
-        std::vector<SoundEvent*>& events = table.get_events();
-        std::vector<SoundEvent*>::iterator it = events.begin();
-        CHECK( (*it)->EventType == SoundEvent::k_prog_instr );
+        std::vector<SoundEvent>& events = table.get_events();
+        std::vector<SoundEvent>::iterator it = events.begin();
+        CHECK( (*it).EventType == SoundEvent::k_prog_instr );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_note_on );
-        CHECK( (*it)->DeltaTime == 0.0f );
+        CHECK( (*it).EventType == SoundEvent::k_note_on );
+        CHECK( (*it).DeltaTime == 0.0f );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_note_on );
-        CHECK( (*it)->DeltaTime == 0.0f );
+        CHECK( (*it).EventType == SoundEvent::k_note_on );
+        CHECK( (*it).DeltaTime == 0.0f );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_note_off );
-        CHECK( (*it)->DeltaTime == 64.0f );
+        CHECK( (*it).EventType == SoundEvent::k_note_off );
+        CHECK( (*it).DeltaTime == 64.0f );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_note_off );
-        CHECK( (*it)->DeltaTime == 64.0f );
+        CHECK( (*it).EventType == SoundEvent::k_note_off );
+        CHECK( (*it).DeltaTime == 64.0f );
         ++it;
-        CHECK( (*it)->EventType == SoundEvent::k_end_of_score );
-        CHECK( (*it)->DeltaTime == 64.0f );
+        CHECK( (*it).EventType == SoundEvent::k_end_of_score );
+        CHECK( (*it).DeltaTime == 64.0f );
     }
 
 
@@ -456,15 +458,15 @@ SUITE(MidiTableTest)
         MySoundEventsTable table(pScore);
         table.create_table();
 
-        std::vector<SoundEvent*>& events = table.get_events();
+        std::vector<SoundEvent>& events = table.get_events();
 
         int iEv = table.get_first_event_for_measure(1);
         CHECK( iEv == 1 );
-        CHECK( events[iEv]->EventType == SoundEvent::k_note_on );
+        CHECK( events[iEv].EventType == SoundEvent::k_note_on );
 
         iEv = table.get_last_event();
         CHECK( iEv == 5 );
-        CHECK( events[iEv]->EventType == SoundEvent::k_end_of_score );
+        CHECK( events[iEv].EventType == SoundEvent::k_end_of_score );
 
         CHECK( table.get_num_measures() == 1 );
     }
@@ -478,11 +480,11 @@ SUITE(MidiTableTest)
         MySoundEventsTable table(pScore);
         table.create_table();
 
-        std::vector<SoundEvent*>& events = table.get_events();
+        std::vector<SoundEvent>& events = table.get_events();
 
         int iEv = table.get_first_event_for_measure(2);
         CHECK( iEv == 5 );
-        CHECK( events[iEv]->EventType == SoundEvent::k_end_of_score );
+        CHECK( events[iEv].EventType == SoundEvent::k_end_of_score );
     }
 
     TEST_FIXTURE(MidiTableTestFixture, MeasuresTable_InitialControlMeasure)
@@ -494,11 +496,11 @@ SUITE(MidiTableTest)
         MySoundEventsTable table(pScore);
         table.create_table();
 
-        std::vector<SoundEvent*>& events = table.get_events();
+        std::vector<SoundEvent>& events = table.get_events();
 
         int iEv = table.get_first_event_for_measure(0);
         CHECK( iEv == 0 );
-        CHECK( events[iEv]->EventType == SoundEvent::k_prog_instr );
+        CHECK( events[iEv].EventType == SoundEvent::k_prog_instr );
     }
 
     TEST_FIXTURE(MidiTableTestFixture, MeasuresTable_TwoMeasures)
@@ -510,27 +512,27 @@ SUITE(MidiTableTest)
         MySoundEventsTable table(pScore);
         table.create_table();
 
-        std::vector<SoundEvent*>& events = table.get_events();
+        std::vector<SoundEvent>& events = table.get_events();
 
         int iEv = table.get_first_event_for_measure(0);
         CHECK( iEv == 0 );
-        CHECK( events[iEv]->EventType == SoundEvent::k_prog_instr );
+        CHECK( events[iEv].EventType == SoundEvent::k_prog_instr );
 
         iEv = table.get_first_event_for_measure(1);
         CHECK( iEv == 1 );
-        CHECK( events[iEv]->EventType == SoundEvent::k_note_on );
+        CHECK( events[iEv].EventType == SoundEvent::k_note_on );
 
         iEv = table.get_first_event_for_measure(2);
         CHECK( iEv == 3 );
-        CHECK( events[iEv]->EventType == SoundEvent::k_note_on );
+        CHECK( events[iEv].EventType == SoundEvent::k_note_on );
 
         iEv = table.get_first_event_for_measure(3);
         CHECK( iEv == 5 );
-        CHECK( events[iEv]->EventType == SoundEvent::k_end_of_score );
+        CHECK( events[iEv].EventType == SoundEvent::k_end_of_score );
 
         iEv = table.get_last_event();
         CHECK( iEv == 5 );
-        CHECK( events[iEv]->EventType == SoundEvent::k_end_of_score );
+        CHECK( events[iEv].EventType == SoundEvent::k_end_of_score );
 
         CHECK( table.get_num_measures() == 2 );
     }
@@ -845,22 +847,22 @@ SUITE(MidiTableTest)
 //        cout << pTable->dump_midi_events() << endl;
         CHECK( pTable && pTable->num_events() == 12 );
         CHECK( pTable && pTable->get_anacrusis_missing_time() == 0.0 );
-        std::vector<SoundEvent*>& events = pTable->get_events();
-        CHECK( events[1]->EventType == SoundEvent::k_note_on );
-        CHECK( events[1]->DeltaTime == 0L );
-        CHECK( events[1]->Volume == 64);
-        CHECK( events[3]->EventType == SoundEvent::k_note_on );
-        CHECK( events[3]->DeltaTime == 64L );
-        CHECK( events[3]->Volume == 64);
-        CHECK( events[5]->EventType == SoundEvent::k_note_on );
-        CHECK( events[5]->DeltaTime == 128L );
-        CHECK( events[5]->Volume == 64);
-        CHECK( events[7]->EventType == SoundEvent::k_note_on );
-        CHECK( events[7]->DeltaTime == 192L );
-        CHECK( events[7]->Volume == 64);
-        CHECK( events[9]->EventType == SoundEvent::k_note_on );
-        CHECK( events[9]->DeltaTime == 256L );
-        CHECK( events[9]->Volume == 64);
+        std::vector<SoundEvent>& events = pTable->get_events();
+        CHECK( events[1].EventType == SoundEvent::k_note_on );
+        CHECK( events[1].DeltaTime == 0L );
+        CHECK( events[1].Volume == 64);
+        CHECK( events[3].EventType == SoundEvent::k_note_on );
+        CHECK( events[3].DeltaTime == 64L );
+        CHECK( events[3].Volume == 64);
+        CHECK( events[5].EventType == SoundEvent::k_note_on );
+        CHECK( events[5].DeltaTime == 128L );
+        CHECK( events[5].Volume == 64);
+        CHECK( events[7].EventType == SoundEvent::k_note_on );
+        CHECK( events[7].DeltaTime == 192L );
+        CHECK( events[7].Volume == 64);
+        CHECK( events[9].EventType == SoundEvent::k_note_on );
+        CHECK( events[9].DeltaTime == 256L );
+        CHECK( events[9].Volume == 64);
     }
 
     TEST_FIXTURE(MidiTableTestFixture, volume_002)
@@ -880,19 +882,19 @@ SUITE(MidiTableTest)
 //        cout << pTable->dump_midi_events() << endl;
         CHECK( pTable && pTable->num_events() == 11 );
         CHECK( pTable && pTable->get_anacrusis_missing_time() == 0.0 );
-        std::vector<SoundEvent*>& events = pTable->get_events();
-        CHECK( events[2]->EventType == SoundEvent::k_note_on );
-        CHECK( events[2]->DeltaTime == 0L );
-        CHECK( events[2]->Volume == 85 );
-        CHECK( events[4]->EventType == SoundEvent::k_note_on );
-        CHECK( events[4]->DeltaTime == 64L );
-        CHECK( events[4]->Volume == 75 );
-        CHECK( events[6]->EventType == SoundEvent::k_note_on );
-        CHECK( events[6]->DeltaTime == 128L );
-        CHECK( events[6]->Volume == 75 );
-        CHECK( events[8]->EventType == SoundEvent::k_note_on );
-        CHECK( events[8]->DeltaTime == 192L );
-        CHECK( events[8]->Volume == 85 );
+        std::vector<SoundEvent>& events = pTable->get_events();
+        CHECK( events[2].EventType == SoundEvent::k_note_on );
+        CHECK( events[2].DeltaTime == 0L );
+        CHECK( events[2].Volume == 85 );
+        CHECK( events[4].EventType == SoundEvent::k_note_on );
+        CHECK( events[4].DeltaTime == 64L );
+        CHECK( events[4].Volume == 75 );
+        CHECK( events[6].EventType == SoundEvent::k_note_on );
+        CHECK( events[6].DeltaTime == 128L );
+        CHECK( events[6].Volume == 75 );
+        CHECK( events[8].EventType == SoundEvent::k_note_on );
+        CHECK( events[8].DeltaTime == 192L );
+        CHECK( events[8].Volume == 85 );
     }
 
     TEST_FIXTURE(MidiTableTestFixture, volume_003)
@@ -912,22 +914,616 @@ SUITE(MidiTableTest)
 //        cout << pTable->dump_midi_events() << endl;
         CHECK( pTable && pTable->num_events() == 13 );
         CHECK( is_equal_time(pTable->get_anacrusis_missing_time(), 128.0 ) );
-        std::vector<SoundEvent*>& events = pTable->get_events();
-        CHECK( events[2]->EventType == SoundEvent::k_note_on );
-        CHECK( events[2]->DeltaTime == 0L );
-        CHECK( events[2]->Volume == 75 );
-        CHECK( events[4]->EventType == SoundEvent::k_note_on );
-        CHECK( events[4]->DeltaTime == 64L );
-        CHECK( events[4]->Volume == 85 );
-        CHECK( events[6]->EventType == SoundEvent::k_note_on );
-        CHECK( events[6]->DeltaTime == 128L );
-        CHECK( events[6]->Volume == 75 );
-        CHECK( events[8]->EventType == SoundEvent::k_note_on );
-        CHECK( events[8]->DeltaTime == 192L );
-        CHECK( events[8]->Volume == 75 );
-        CHECK( events[10]->EventType == SoundEvent::k_note_on );
-        CHECK( events[10]->DeltaTime == 256L );
-        CHECK( events[10]->Volume == 85 );
+        std::vector<SoundEvent>& events = pTable->get_events();
+        CHECK( events[2].EventType == SoundEvent::k_note_on );
+        CHECK( events[2].DeltaTime == 0L );
+        CHECK( events[2].Volume == 75 );
+        CHECK( events[4].EventType == SoundEvent::k_note_on );
+        CHECK( events[4].DeltaTime == 64L );
+        CHECK( events[4].Volume == 85 );
+        CHECK( events[6].EventType == SoundEvent::k_note_on );
+        CHECK( events[6].DeltaTime == 128L );
+        CHECK( events[6].Volume == 75 );
+        CHECK( events[8].EventType == SoundEvent::k_note_on );
+        CHECK( events[8].DeltaTime == 192L );
+        CHECK( events[8].Volume == 75 );
+        CHECK( events[10].EventType == SoundEvent::k_note_on );
+        CHECK( events[10].DeltaTime == 256L );
+        CHECK( events[10].Volume == 85 );
+    }
+
+    //@ timeline -------------------------------------------------------------------
+
+    TEST_FIXTURE(MidiTableTestFixture, timeline_001)
+    {
+        //001. Timeline contains the time in milliseconds for each event
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G p1)(n c4 q)(n e4 q)(barline simple)(n c4 h)"
+            ")))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        SoundEventsTable* pTable = pScore->get_midi_table();
+
+        std::vector<SoundEvent>& events = pTable->get_events();
+        std::vector<long>& times = pTable->get_timeline(2.0f);
+        CHECK( times.size() == events.size() );
+        for (size_t i=0; i < events.size(); ++i)
+            CHECK( times[i] == 2L * events[i].DeltaTime );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, timeline_002)
+    {
+        //002. Timeline is recomputed when tempo changes
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G p1)(n c4 q)(n e4 q)(barline simple)(n c4 h)"
+            ")))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        SoundEventsTable* pTable = pScore->get_midi_table();
+
+        std::vector<SoundEvent>& events = pTable->get_events();
+        pTable->get_timeline(2.0f);
+        std::vector<long>& times = pTable->get_timeline(0.5f);
+        CHECK( times.size() == events.size() );
+        CHECK( times[3] == 32L );
+        for (size_t i=0; i < events.size(); ++i)
+            CHECK( times[i] == events[i].DeltaTime / 2L );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, update_table_001)
+    {
+        //001. Update after changing a pitch gives the same table than a full rebuild
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G p1)(n c4 q)(n e4 q)(barline simple)(n g4 q)(n a4 q)(barline simple)"
+            "(n c5 h)(barline simple)(n e5 q)(n c5 q)(barline end)"
+            ")))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        SoundEventsTable* pTable = pScore->get_midi_table();
+        ImoNote* pNote = static_cast<ImoNote*>(
+                                pTable->get_events()[pTable->get_first_event_for_measure(3)].pSO );
+
+        pNote->set_notated_pitch(k_step_D, 5, k_no_accidentals);
+        pScore->end_of_changes();
+        pScore->update_midi_table(3, 3);
+        CHECK( pScore->get_midi_table() == pTable );
+
+        MySoundEventsTable table(pScore);
+        table.create_table();
+        CHECK( pTable->dump_midi_events() == table.dump_midi_events() );
+        CHECK( pTable->get_events()[pTable->get_first_event_for_measure(3)].NotePitch
+               == int(pNote->get_midi_pitch()) );
+//        cout << test_name() << endl << pTable->dump_midi_events() << endl;
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, update_table_002)
+    {
+        //002. Following measures are shifted when the measure duration changes
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G p1)(n c4 q)(n e4 q)(barline simple)(n g4 q)(n a4 q)(barline simple)"
+            "(n c5 h)(barline simple)(n e5 q)(n c5 q)(barline end)"
+            ")))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        SoundEventsTable* pTable = pScore->get_midi_table();
+        long endTime = pTable->get_events().back().DeltaTime;
+        ImoNote* pNote = static_cast<ImoNote*>(
+                                pTable->get_events()[pTable->get_first_event_for_measure(2)].pSO );
+
+        pNote->set_note_type_and_dots(k_half, 0);
+        pScore->end_of_changes();
+        pScore->update_midi_table(2, 2);
+        CHECK( pScore->get_midi_table() == pTable );
+
+        MySoundEventsTable table(pScore);
+        table.create_table();
+        CHECK( pTable->dump_midi_events() == table.dump_midi_events() );
+        CHECK( pTable->get_events().back().DeltaTime == endTime + long(k_duration_quarter) );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, update_table_003)
+    {
+        //003. Jumps are rebuilt
+
+        load_mxl_score_for_test("55-repeat-dal-segno-al-coda.xml");
+        int numMeasures = m_pTable->get_num_measures();
+        ImoNote* pNote = nullptr;
+        std::vector<SoundEvent>& events = m_pTable->get_events();
+        for (int i=m_pTable->get_first_event_for_measure(2); !pNote; ++i)
+        {
+            if (events[i].EventType == SoundEvent::k_note_on)
+                pNote = static_cast<ImoNote*>(events[i].pSO);
+        }
+
+        pNote->set_note_type_and_dots(k_eighth, 0);
+        m_pScore->end_of_changes();
+        m_pScore->update_midi_table(2, 2);
+        CHECK( m_pScore->get_midi_table() == m_pTable );
+
+        MySoundEventsTable table(m_pScore);
+        table.create_table();
+        CHECK( m_pTable->dump_midi_events() == table.dump_midi_events() );
+        CHECK( m_pTable->get_num_measures() == numMeasures );
+        CHECK( m_pTable->num_jumps() == table.num_jumps() );
+        for (int i=0; i < m_pTable->num_jumps(); ++i)
+        {
+            CHECK( m_pTable->get_jump(i)->dump_entry() == table.get_jump(i)->dump_entry() );
+        }
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, update_table_004)
+    {
+        //004. Table is rebuilt when the score is modified and not updated
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G p1)(n c4 q)(n e4 q)(barline simple)(n g4 q)(n a4 q)(barline simple)"
+            ")))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        SoundEventsTable* pTable = pScore->get_midi_table();
+        ImoNote* pNote = static_cast<ImoNote*>(
+                                pTable->get_events()[pTable->get_first_event_for_measure(2)].pSO );
+
+        pNote->set_notated_pitch(k_step_D, 5, k_no_accidentals);
+        pScore->end_of_changes();
+
+        CHECK( pScore->get_midi_table() == pTable );
+        CHECK( pTable->get_events()[pTable->get_first_event_for_measure(2)].NotePitch
+               == int(pNote->get_midi_pitch()) );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, update_table_005)
+    {
+        //005. A shared table is not rebuilt: a new table is created
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G p1)(n c4 q)(n e4 q)(barline simple)(n g4 q)(n a4 q)(barline simple)"
+            ")))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        std::shared_ptr<SoundEventsTable> spTable = pScore->get_shared_midi_table();
+        int iEv = spTable->get_first_event_for_measure(2);
+        int oldPitch = spTable->get_events()[iEv].NotePitch;
+        ImoNote* pNote = static_cast<ImoNote*>( spTable->get_events()[iEv].pSO );
+
+        pNote->set_notated_pitch(k_step_D, 5, k_no_accidentals);
+        pScore->end_of_changes();
+
+        SoundEventsTable* pTable = pScore->get_midi_table();
+        CHECK( pTable != spTable.get() );
+        CHECK( spTable->get_events()[iEv].NotePitch == oldPitch );
+        CHECK( pTable->get_events()[iEv].NotePitch == int(pNote->get_midi_pitch()) );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, update_table_006)
+    {
+        //006. A shared table is not updated: the updated table is a copy
+
+        load_mxl_score_for_test("55-repeat-dal-segno-al-coda.xml");
+        std::shared_ptr<SoundEventsTable> spTable = m_pScore->get_shared_midi_table();
+        string oldEvents = spTable->dump_midi_events();
+        ImoNote* pNote = nullptr;
+        std::vector<SoundEvent>& events = spTable->get_events();
+        for (int i=spTable->get_first_event_for_measure(2); !pNote; ++i)
+        {
+            if (events[i].EventType == SoundEvent::k_note_on)
+                pNote = static_cast<ImoNote*>(events[i].pSO);
+        }
+
+        pNote->set_note_type_and_dots(k_eighth, 0);
+        m_pScore->end_of_changes();
+        m_pScore->update_midi_table(2, 2);
+
+        SoundEventsTable* pTable = m_pScore->get_midi_table();
+        CHECK( pTable != spTable.get() );
+        CHECK( spTable->dump_midi_events() == oldEvents );
+
+        MySoundEventsTable table(m_pScore);
+        table.create_table();
+        CHECK( pTable->dump_midi_events() == table.dump_midi_events() );
+        CHECK( pTable->num_jumps() == table.num_jumps() );
+        for (int i=0; i < pTable->num_jumps(); ++i)
+        {
+            CHECK( pTable->get_jump(i) != spTable->get_jump(i) );
+            CHECK( pTable->get_jump(i)->dump_entry() == table.get_jump(i)->dump_entry() );
+        }
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, update_table_007)
+    {
+        //007. Following measures are regenerated when the time signature changes
+        //but the measure duration does not change (4/4 -> 2/2)
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G p1)(time 4 4)(n c4 q)(n e4 q)(n g4 q)(n c5 q)(barline simple)"
+            "(n c4 q)(n e4 q)(n g4 q)(n c5 q)(barline simple)"
+            "(n c4 q)(n e4 q)(n g4 q)(n c5 q)(barline simple)"
+            "(n c4 q)(n e4 q)(n g4 q)(n c5 q)(barline end)"
+            ")))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        SoundEventsTable* pTable = pScore->get_midi_table();
+        ImoTimeSignature* pTS = nullptr;
+        std::vector<SoundEvent>& events = pTable->get_events();
+        for (size_t i=0; i < events.size() && !pTS; ++i)
+        {
+            if (events[i].EventType == SoundEvent::k_rhythm_change)
+                pTS = static_cast<ImoTimeSignature*>(events[i].pSO);
+        }
+        CHECK( pTS != nullptr );
+
+        pTS->set_top_number(2);
+        pTS->set_bottom_number(2);
+        pScore->end_of_changes();
+        pScore->update_midi_table(1, 1);
+        CHECK( pScore->get_midi_table() == pTable );
+
+        MySoundEventsTable table(pScore);
+        table.create_table();
+        CHECK( pTable->dump_midi_events() == table.dump_midi_events() );
+
+        //second quarter note in last measure is now an off-beat note
+        int iEv = pTable->get_first_event_for_measure(4);
+        int numNotes = 0;
+        for (; iEv < pTable->num_events() && numNotes < 2; ++iEv)
+        {
+            if (events[iEv].EventType == SoundEvent::k_note_on)
+                ++numNotes;
+        }
+        CHECK( events[iEv-1].Volume == 60 );
+//        cout << test_name() << endl << pTable->dump_midi_events() << endl;
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, update_table_008)
+    {
+        //008. Instrument programs are regenerated when updating the table
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (infoMIDI 0 1)(musicData "
+            "(clef G p1)(n c4 q)(n e4 q)(barline simple)(n g4 q)(n a4 q)(barline simple)"
+            "(n c5 h)(barline simple)(n e5 q)(n c5 q)(barline end)"
+            ")))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        SoundEventsTable* pTable = pScore->get_midi_table();
+        ImoMidiInfo* pMidi = pScore->get_instrument(0)->get_sound_info(0)->get_midi_info();
+
+        pMidi->set_midi_program(40);
+        pScore->end_of_changes();
+        pScore->update_midi_table(3, 3);
+
+        CHECK( pScore->get_midi_table() == pTable );
+        MySoundEventsTable table(pScore);
+        table.create_table();
+        CHECK( pTable->dump_midi_events() == table.dump_midi_events() );
+        CHECK( pTable->get_events()[0].EventType == SoundEvent::k_prog_instr );
+        CHECK( pTable->get_events()[0].Instrument == 40 );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, update_table_009)
+    {
+        //009. The table is created again when the channel of an instrument changes
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (infoMIDI 0 1)(musicData "
+            "(clef G p1)(n c4 q)(n e4 q)(barline simple)(n g4 q)(n a4 q)(barline simple)"
+            "(n c5 h)(barline simple)(n e5 q)(n c5 q)(barline end)"
+            ")))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        SoundEventsTable* pTable = pScore->get_midi_table();
+        ImoMidiInfo* pMidi = pScore->get_instrument(0)->get_sound_info(0)->get_midi_info();
+
+        pMidi->set_midi_channel(5);
+        pScore->end_of_changes();
+        pScore->update_midi_table(3, 3);
+
+        CHECK( pScore->get_midi_table() == pTable );
+        MySoundEventsTable table(pScore);
+        table.create_table();
+        CHECK( pTable->dump_midi_events() == table.dump_midi_events() );
+        CHECK( pTable->get_channels()[0] == 5 );
+        int iEv = pTable->get_first_event_for_measure(4);
+        CHECK( pTable->get_events()[iEv].Channel == 5 );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, update_table_010)
+    {
+        //010. The Document informs the modified measures: only them are regenerated
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G p1)(n c4 q)(n e4 q)(barline simple)(n g4 q)(n a4 q)(barline simple)"
+            "(n c5 h)(barline simple)(n e5 q)(n c5 q)(barline end)"
+            ")))" );
+        doc.clear_dirty();
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        SoundEventsTable* pTable = pScore->get_midi_table();
+        std::vector<SoundEvent>& events = pTable->get_events();
+        ImoNote* pNote1 = static_cast<ImoNote*>(
+                                events[pTable->get_first_event_for_measure(1)].pSO );
+        ImoNote* pNote4 = static_cast<ImoNote*>(
+                                events[pTable->get_first_event_for_measure(4)].pSO );
+        int oldPitch = events[pTable->get_first_event_for_measure(4)].NotePitch;
+
+        //modification in first measure is informed to the Document. Modification in
+        //last measure is not informed, so its events are not regenerated
+        pNote1->set_notated_pitch(k_step_D, 4, k_no_accidentals);
+        pNote1->set_dirty(true);
+        pNote4->set_notated_pitch(k_step_F, 5, k_no_accidentals);
+        pScore->end_of_changes();
+        doc.notify_if_document_modified();
+
+        CHECK( pScore->get_midi_table() == pTable );
+        CHECK( events[pTable->get_first_event_for_measure(1)].NotePitch
+               == int(pNote1->get_midi_pitch()) );
+        CHECK( events[pTable->get_first_event_for_measure(4)].NotePitch == oldPitch );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, update_table_011)
+    {
+        //011. The table is created again after modifications not informed to the
+        //Document
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G p1)(n c4 q)(n e4 q)(barline simple)(n g4 q)(n a4 q)(barline simple)"
+            "(n c5 h)(barline simple)(n e5 q)(n c5 q)(barline end)"
+            ")))" );
+        doc.clear_dirty();
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        SoundEventsTable* pTable = pScore->get_midi_table();
+        std::vector<SoundEvent>& events = pTable->get_events();
+        ImoNote* pNote = static_cast<ImoNote*>(
+                                events[pTable->get_first_event_for_measure(4)].pSO );
+
+        pNote->set_notated_pitch(k_step_F, 5, k_no_accidentals);
+        pScore->end_of_changes();
+        doc.notify_if_document_modified();
+
+        CHECK( pScore->get_midi_table() == pTable );
+        CHECK( events[pTable->get_first_event_for_measure(4)].NotePitch
+               == int(pNote->get_midi_pitch()) );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, snapshot_001)
+    {
+        //001. Snapshot contains the last time signature before the measure
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G)(time 2 4)(n c4 q)(n e4 q)(barline simple)"
+            "(time 3 4)(n c4 q)(n e4 q)(n g4 q)(barline simple)"
+            "(n c4 q)(n e4 q)(n g4 q)(barline simple)"
+            ")))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        SoundEventsTable* pTable = pScore->get_midi_table();
+        std::vector<SoundEvent>& events = pTable->get_events();
+
+        PlaybackSnapshot* pState = pTable->get_snapshot(1);
+        CHECK( pState && pState->rhythmChange == -1 );
+
+        pState = pTable->get_snapshot(3);
+        CHECK( pState && pState->rhythmChange > 0 );
+        CHECK( events[pState->rhythmChange].TopNumber == 3 );
+        CHECK( pState->tiedNotes.size() == 0 );
+        CHECK( pState->jumps.size() == 0 );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, snapshot_002)
+    {
+        //002. Snapshot contains the notes tied from previous measure
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G)(time 2 4)(n c4 q)(n e4 q l)(barline simple)"
+            "(n e4 q)(n g4 q)(barline simple)"
+            ")))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        SoundEventsTable* pTable = pScore->get_midi_table();
+        std::vector<SoundEvent>& events = pTable->get_events();
+
+        PlaybackSnapshot* pState = pTable->get_snapshot(2);
+        CHECK( pState && pState->tiedNotes.size() == 1 );
+        CHECK( pState && events[pState->tiedNotes[0]].EventType == SoundEvent::k_note_on );
+        CHECK( pState && events[pState->tiedNotes[0]].NotePitch == 64 );
+        CHECK( pState && events[pState->tiedNotes[0]].Measure == 1 );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, snapshot_003)
+    {
+        //003. Jump counters when each measure is reached for the first time.
+        //Da capo al fine: Fine in measure 2, D.C. in measure 4
+
+        load_mxl_score_for_test("52-repeat-da-capo-al-fine.xml");
+//        cout << test_name() << endl << m_pTable->dump_midi_events() << endl;
+
+        CHECK( m_pTable->num_jumps() == 2 );
+        PlaybackSnapshot* pState = m_pTable->get_snapshot(1);
+        CHECK( pState && pState->jumps.size() == 2 );
+        CHECK( pState && pState->jumps[0].first == 0 && pState->jumps[1].first == 0 );
+
+        pState = m_pTable->get_snapshot(3);
+        CHECK( pState && pState->jumps.size() == 2 );
+        CHECK( pState && pState->jumps[0].first == 1 && pState->jumps[0].second == 0 );
+        CHECK( pState && pState->jumps[1].first == 0 && pState->jumps[1].second == 0 );
+
+        m_pTable->restore_jumps(3);
+        CHECK( m_pTable->get_jump(0)->get_visited() == 1 );
+        CHECK( m_pTable->get_jump(1)->get_visited() == 0 );
+        m_pTable->reset_jumps();
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, snapshot_004)
+    {
+        //004. Metronome state depends on all previous time signatures, not only on
+        //the last two ones, as the click interval is rounded after each change
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G)(time 3 8)(n c4 q)(n e4 e)(barline simple)"
+            "(time 2 4)(n c4 q)(n e4 q)(barline simple)"
+            "(time 2 2)(n c4 h)(n e4 h)(barline simple)"
+            "(n c4 h)(n e4 h)(barline simple)"
+            ")))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        SoundEventsTable* pTable = pScore->get_midi_table();
+        std::vector<SoundEvent>& events = pTable->get_events();
+
+        MetronomeState initial;
+        initial.initialize(60000L / 70L, long(k_duration_quarter));
+        pTable->compute_metronome_states(initial, k_beat_implied);
+
+        MetronomeState state = initial;
+        MetronomeState lastTwo = initial;
+        int numChanges = 0;
+        for (int i=0; i < pTable->get_first_event_for_measure(4); ++i)
+        {
+            if (events[i].EventType == SoundEvent::k_rhythm_change)
+            {
+                state.apply_rhythm_change(events[i], k_beat_implied);
+                if (++numChanges > 1)
+                    lastTwo.apply_rhythm_change(events[i], k_beat_implied);
+            }
+        }
+        CHECK( numChanges == 3 );
+
+        PlaybackSnapshot* pState = pTable->get_snapshot(1);
+        CHECK( pState && pState->metronome == initial );
+        pState = pTable->get_snapshot(4);
+        CHECK( pState && pState->metronome == state );
+        CHECK( pState && !(pState->metronome == lastTwo) );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, mix_table_001)
+    {
+        //001. Events are merged in time order. Channels are remapped
+
+        Document doc(m_libraryScope);
+        doc.from_string("(lenmusdoc (vers 0.0) (content "
+            "(score (vers 2.0)(instrument (musicData "
+            "(clef G)(time 2 4)(n c4 q)(n e4 q)(barline simple) )))"
+            "(score (vers 2.0)(instrument (musicData "
+            "(clef F4)(time 2 4)(n c3 h)(barline simple) )))"
+            "))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        ImoScore* pScore2 = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(1) );
+        SoundEventsTable table(pScore);
+        table.create_table();
+        int numEvents = table.num_events();
+        SoundEventsTable* pTable2 = pScore2->get_midi_table();
+
+        CHECK( table.mix_table(pTable2, 1) == true );
+//        cout << test_name() << endl << table.dump_midi_events() << endl;
+
+        std::vector<SoundEvent>& events = table.get_events();
+        CHECK( table.num_events() == numEvents + pTable2->num_events() - 2 );
+        CHECK( events.back().EventType == SoundEvent::k_end_of_score );
+        CHECK( table.get_num_measures() == 1 );
+        CHECK( table.get_channels().size() == 2 );
+        CHECK( table.get_channels()[1] == 1 );
+        bool fOrdered = true;
+        int numMixed = 0;
+        for (int i=1; i < table.num_events(); ++i)
+        {
+            fOrdered &= (events[i-1].DeltaTime <= events[i].DeltaTime);
+            if (events[i].Score == 1)
+            {
+                ++numMixed;
+                fOrdered &= (events[i].Channel == 1);
+                fOrdered &= (events[i].EventType != SoundEvent::k_rhythm_change);
+            }
+        }
+        CHECK( fOrdered == true );
+        CHECK( numMixed == pTable2->num_events() - 2 );
+        CHECK( events[table.get_first_event_for_measure(1)].DeltaTime == 0L );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, mix_table_002)
+    {
+        //002. Not mixed when there are no free channels. Table is not modified
+
+        Document doc(m_libraryScope);
+        doc.from_string("(lenmusdoc (vers 0.0) (content "
+            "(score (vers 2.0)(instrument (musicData (clef G)(n c4 q) )))"
+            "(score (vers 2.0)(instrument (musicData (clef G)(n e4 q) )))"
+            "))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        ImoScore* pScore2 = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(1) );
+        SoundEventsTable table(pScore);
+        table.create_table();
+        SoundEventsTable* pTable2 = pScore2->get_midi_table();
+
+        //16 channels: channel 0 for main score, channel 9 reserved
+        for (int i=1; i < 15; ++i)
+            CHECK( table.mix_table(pTable2, i) == true );
+        int numEvents = table.num_events();
+
+        CHECK( table.mix_table(pTable2, 15) == false );
+        CHECK( table.num_events() == numEvents );
+        CHECK( table.get_channels().size() == 15 );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, mix_table_003)
+    {
+        //003. Table is not modified when only some channels can be assigned
+
+        Document doc(m_libraryScope);
+        doc.from_string("(lenmusdoc (vers 0.0) (content "
+            "(score (vers 2.0)(instrument (musicData (clef G)(n c4 q) )))"
+            "(score (vers 2.0)(instrument (musicData (clef G)(n e4 q) )))"
+            "(score (vers 2.0)"
+                "(instrument (musicData (clef G)(n e4 q) ))"
+                "(instrument (musicData (clef F4)(n c3 q) )))"
+            "))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        ImoScore* pScore2 = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(1) );
+        ImoScore* pScore3 = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(2) );
+        SoundEventsTable table(pScore);
+        table.create_table();
+        SoundEventsTable* pTable2 = pScore2->get_midi_table();
+        SoundEventsTable* pTable3 = pScore3->get_midi_table();
+
+        //only channel 15 remains free
+        for (int i=1; i < 14; ++i)
+            CHECK( table.mix_table(pTable2, i) == true );
+        int numEvents = table.num_events();
+
+        CHECK( table.mix_table(pTable3, 14) == false );
+        CHECK( table.num_events() == numEvents );
+        CHECK( table.get_channels().size() == 14 );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, mix_table_004)
+    {
+        //004. Control events in main table do not reserve channel 0
+
+        Document doc(m_libraryScope);
+        doc.from_string("(lenmusdoc (vers 0.0) (content "
+            "(score (vers 2.0)(instrument (musicData (clef G)(time 2 4) )))"
+            "(score (vers 2.0)(instrument (musicData (clef G)(n e4 q) )))"
+            "))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        ImoScore* pScore2 = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(1) );
+        SoundEventsTable table(pScore);
+        table.create_table();
+        SoundEventsTable* pTable2 = pScore2->get_midi_table();
+        //leave only the rhythm change and end of score events in main table
+        std::vector<SoundEvent>& events = table.get_events();
+        events.erase(events.begin());
+        CHECK( events.front().EventType == SoundEvent::k_rhythm_change );
+
+        CHECK( table.mix_table(pTable2, 1) == true );
+
+        bool fChannel0 = true;
+        for (int i=0; i < table.num_events(); ++i)
+        {
+            if (events[i].Score == 1)
+                fChannel0 &= (events[i].Channel == 0);
+        }
+        CHECK( fChannel0 == true );
     }
 
 }
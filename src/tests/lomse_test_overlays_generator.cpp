@@ -0,0 +1,248 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include <UnitTest++.h>
+#include <sstream>
+#include "lomse_build_options.h"
+
+//classes related to these tests
+#include "lomse_injectors.h"
+#include "lomse_overlays_generator.h"
+#include "lomse_visual_effect.h"
+#include "lomse_screen_drawer.h"
+
+using namespace UnitTest;
+using namespace std;
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+//a solid rectangle, in view coordinates
+class MyRectEffect : public VisualEffect
+{
+protected:
+    URect m_rect;
+
+public:
+    MyRectEffect(LibraryScope& libraryScope, const URect& rect)
+        : VisualEffect(nullptr, libraryScope)
+        , m_rect(rect)
+    {
+        m_fVisible = true;
+    }
+    virtual ~MyRectEffect() {}
+
+    void move_to(LUnits x, LUnits y) { m_rect.x = x; m_rect.y = y; }
+
+    void on_draw(ScreenDrawer* pDrawer)
+    {
+        pDrawer->begin_path();
+        pDrawer->fill(Color(255, 0, 0));
+        pDrawer->stroke(Color(255, 0, 0));
+        pDrawer->rect(m_rect.get_top_left(), m_rect.size(), 0.0f);
+        pDrawer->end_path();
+        pDrawer->render();
+    }
+
+    URect get_bounds() { return m_rect; }
+};
+
+//---------------------------------------------------------------------------------------
+class OverlaysGeneratorTestFixture
+{
+public:
+    LibraryScope m_libraryScope;
+    std::string m_scores_path;
+    std::vector<unsigned char> m_buffer;
+    std::vector<unsigned char> m_background;
+    RenderingBuffer m_rbuf;
+
+    OverlaysGeneratorTestFixture()     //SetUp fixture
+        : m_libraryScope(cout)
+        , m_buffer(400 * 300 * 4)
+    {
+        m_scores_path = TESTLIB_SCORES_PATH;
+        m_libraryScope.set_default_fonts_path(TESTLIB_FONTS_PATH);
+        m_rbuf.attach(&m_buffer[0], 400, 300, 400 * 4);
+    }
+
+    ~OverlaysGeneratorTestFixture()    //TearDown fixture
+    {
+    }
+
+    void prepare(ScreenDrawer& drawer, OverlaysGenerator& overlays)
+    {
+        //1 pixel = 10 LUnits
+        double scale = 0.1 * 2540.0 / m_libraryScope.get_screen_ppi();
+        TransAffine transform(scale, 0.0, 0.0, scale, 0.0, 0.0);
+        drawer.reset(m_rbuf, Color(255, 255, 255));
+        drawer.set_viewport(0, 0);
+        drawer.set_transform(transform);
+
+        //a non-uniform background
+        for (size_t i=0; i < m_buffer.size(); ++i)
+            m_buffer[i] = static_cast<unsigned char>(i % 251);
+        m_background = m_buffer;
+
+        overlays.set_rendering_buffer(&m_rbuf);
+        overlays.on_new_background();
+    }
+
+    bool is_background(int x1, int y1, int x2, int y2)
+    {
+        for (int y = y1; y < y2; ++y)
+        {
+            size_t start = size_t(y * 400 + x1) * 4;
+            size_t end = size_t(y * 400 + x2) * 4;
+            for (size_t i = start; i < end; ++i)
+            {
+                if (m_buffer[i] != m_background[i])
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    bool is_painted(int x, int y)
+    {
+        size_t i = size_t(y * 400 + x) * 4;
+        return m_buffer[i] != m_background[i];
+    }
+};
+
+SUITE(OverlaysGeneratorTest)
+{
+
+    TEST_FIXTURE(OverlaysGeneratorTestFixture, restores_previous_area)
+    {
+        ScreenDrawer drawer(m_libraryScope);
+        OverlaysGenerator overlays(nullptr, m_libraryScope);
+        prepare(drawer, overlays);
+        MyRectEffect* pEffect = LOMSE_NEW MyRectEffect(m_libraryScope,
+                                                       URect(500.0, 500.0, 200.0, 200.0));
+        overlays.add_visual_effect(pEffect);
+
+        overlays.update_all_visual_effects(&drawer);
+        CHECK( is_painted(60, 60) == true );
+
+        pEffect->move_to(2500.0f, 1500.0f);
+        overlays.update_visual_effect(pEffect, &drawer);
+
+        CHECK( is_background(0, 0, 200, 100) == true );
+        CHECK( is_painted(60, 60) == false );
+        CHECK( is_painted(260, 160) == true );
+    }
+
+    TEST_FIXTURE(OverlaysGeneratorTestFixture, hidden_effect_is_removed)
+    {
+        ScreenDrawer drawer(m_libraryScope);
+        OverlaysGenerator overlays(nullptr, m_libraryScope);
+        prepare(drawer, overlays);
+        MyRectEffect* pEffect = LOMSE_NEW MyRectEffect(m_libraryScope,
+                                                       URect(500.0, 500.0, 200.0, 200.0));
+        overlays.add_visual_effect(pEffect);
+        overlays.update_all_visual_effects(&drawer);
+        overlays.get_damaged_rectangle();
+
+        pEffect->hide();
+        overlays.update_visual_effect(pEffect, &drawer);
+
+        CHECK( is_background(0, 0, 400, 300) == true );
+        URect damaged = overlays.get_damaged_rectangle();
+        CHECK( damaged.contains(URect(500.0, 500.0, 200.0, 200.0)) );
+    }
+
+    TEST_FIXTURE(OverlaysGeneratorTestFixture, removed_effect_is_restored)
+    {
+        ScreenDrawer drawer(m_libraryScope);
+        OverlaysGenerator overlays(nullptr, m_libraryScope);
+        prepare(drawer, overlays);
+        MyRectEffect* pEffect = LOMSE_NEW MyRectEffect(m_libraryScope,
+                                                       URect(500.0, 500.0, 200.0, 200.0));
+        overlays.add_visual_effect(pEffect);
+        overlays.update_all_visual_effects(&drawer);
+
+        overlays.remove_visual_effect(pEffect);
+        delete pEffect;
+        overlays.update_all_visual_effects(&drawer);
+
+        CHECK( is_background(0, 0, 400, 300) == true );
+    }
+
+    TEST_FIXTURE(OverlaysGeneratorTestFixture, damaged_rectangle_only_changed_effects)
+    {
+        ScreenDrawer drawer(m_libraryScope);
+        OverlaysGenerator overlays(nullptr, m_libraryScope);
+        prepare(drawer, overlays);
+        MyRectEffect* pEffect1 = LOMSE_NEW MyRectEffect(m_libraryScope,
+                                                        URect(500.0, 500.0, 200.0, 200.0));
+        MyRectEffect* pEffect2 = LOMSE_NEW MyRectEffect(m_libraryScope,
+                                                        URect(3000.0, 2000.0, 200.0, 200.0));
+        overlays.add_visual_effect(pEffect1);
+        overlays.add_visual_effect(pEffect2);
+        overlays.update_all_visual_effects(&drawer);
+
+        //first time, after a new background, full rectangle
+        CHECK( overlays.get_damaged_rectangle() == URect(0.0, 0.0, 0.0, 0.0) );
+
+        pEffect2->move_to(3000.0f, 2500.0f);
+        overlays.update_visual_effect(pEffect2, &drawer);
+        URect damaged = overlays.get_damaged_rectangle();
+
+        CHECK( damaged.contains(URect(3000.0, 2000.0, 200.0, 700.0)) );
+        CHECK( damaged.left() > 700.0f );
+        CHECK( is_painted(60, 60) == true );
+        CHECK( is_painted(310, 260) == true );
+        CHECK( is_background(300, 190, 330, 240) == true );
+    }
+
+    TEST_FIXTURE(OverlaysGeneratorTestFixture, damaged_rectangle_accumulates_updates)
+    {
+        ScreenDrawer drawer(m_libraryScope);
+        OverlaysGenerator overlays(nullptr, m_libraryScope);
+        prepare(drawer, overlays);
+        MyRectEffect* pEffect1 = LOMSE_NEW MyRectEffect(m_libraryScope,
+                                                        URect(500.0, 500.0, 200.0, 200.0));
+        MyRectEffect* pEffect2 = LOMSE_NEW MyRectEffect(m_libraryScope,
+                                                        URect(3000.0, 2000.0, 200.0, 200.0));
+        overlays.add_visual_effect(pEffect1);
+        overlays.add_visual_effect(pEffect2);
+        overlays.update_all_visual_effects(&drawer);
+        overlays.get_damaged_rectangle();
+
+        pEffect1->move_to(600.0f, 500.0f);
+        overlays.update_visual_effect(pEffect1, &drawer);
+        pEffect2->move_to(3100.0f, 2000.0f);
+        overlays.update_visual_effect(pEffect2, &drawer);
+        URect damaged = overlays.get_damaged_rectangle();
+
+        CHECK( damaged.contains(URect(500.0, 500.0, 2800.0, 1700.0)) );
+    }
+
+}
@@ -1639,6 +1639,21 @@ SUITE(ScoreCursorTest)
         //cout << cursor.dump_cursor();
     }
 
+    TEST_FIXTURE(ScoreCursorTestFixture, to_measure_327)
+    {
+        //327. to measure, measure not found. Last barline is start of measure
+        create_document_7();
+        MyScoreCursor cursor(m_pDoc, m_pScore);
+
+        cursor.to_measure(5, -1, -1);
+
+        CHECK_CURRENT_STATE_AT_END_OF_STAFF(cursor, 0, 0, 2, 256.0);
+        TimeInfo ti = cursor.get_time_info();
+        CHECK( ti.get_current_measure_start_timepos() == 256.0 );
+        CHECK( ti.get_current_beat_duration() == k_duration_quarter );
+        //cout << cursor.dump_cursor();
+    }
+
 //    TEST_FIXTURE(ScoreCursorTestFixture, next_note_in_chord_340)
 //    {
 //        //340. to_next_note_in_chord()
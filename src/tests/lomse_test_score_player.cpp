@@ -41,6 +41,7 @@
 #include "lomse_events.h"
 #include "lomse_doorway.h"
 #include "lomse_interactor.h"
+#include "lomse_graphic_view.h"
 #include "lomse_player_gui.h"
 
 #include <list>
@@ -102,8 +103,6 @@ public:
         {
             std::this_thread::sleep_for( std::chrono::milliseconds(100) );
         }
-        //delete m_pThread;
-        m_pThread = nullptr;
     }
 
     inline const char* test_name()
@@ -143,8 +142,23 @@ public:
         {
             std::this_thread::sleep_for( std::chrono::milliseconds(100) );
         }
-        //delete m_pThread;
-        m_pThread = nullptr;
+    }
+
+    SoundThread* my_get_thread() { return m_pThread; }
+    MetronomeState my_get_metronome_state() { return get_metronome_state(); }
+};
+
+//---------------------------------------------------------------------------------------
+//Helper, to access the deadlines computed by the scheduler
+class MyPlaybackScheduler : public PlaybackScheduler
+{
+public:
+    MyPlaybackScheduler() : PlaybackScheduler() {}
+
+    long my_last_deadline()     //microseconds since playback start
+    {
+        return long( std::chrono::duration_cast<std::chrono::microseconds>(
+                                                m_lastDeadline - m_start).count() );
     }
 };
 
@@ -154,9 +168,10 @@ class MyMidiServer : public MidiServerBase
 {
 protected:
     std::list<int> m_events;
+    int m_lastPitch;
 
 public:
-    MyMidiServer() : MidiServerBase() {}
+    MyMidiServer() : MidiServerBase(), m_lastPitch(0) {}
     virtual ~MyMidiServer() {
         m_events.clear();
     }
@@ -173,9 +188,10 @@ public:
     {
         m_events.push_back(k_voice_change);
     }
-    void note_on(int UNUSED(channel), int UNUSED(pitch), int UNUSED(volume))
+    void note_on(int UNUSED(channel), int pitch, int UNUSED(volume))
     {
         m_events.push_back(k_note_on);
+        m_lastPitch = pitch;
     }
     void note_off(int UNUSED(channel), int UNUSED(pitch), int UNUSED(volume))
     {
@@ -186,6 +202,7 @@ public:
     }
 
     std::list<int>& my_get_events() { return m_events; }
+    int my_last_pitch() { return m_lastPitch; }
 };
 
 //---------------------------------------------------------------------------------------
@@ -485,4 +502,425 @@ SUITE(ScorePlayerTest)
         CHECK( handler.my_last_event_type() == k_end_of_playback_event );
     }
 
+    TEST_FIXTURE(ScorePlayerTestFixture, TimingStatsCollected)
+    {
+        LomseDoorway* pLomse = m_libraryScope.platform_interface();
+        pLomse->set_notify_callback(nullptr, MyScorePlayer::my_callback);
+        SpDocument spDoc( new Document(m_libraryScope) );
+        spDoc->from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(n c4 e)(n d4 e) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( spDoc->get_im_root()->get_content_item(0) );
+        MyMidiServer midi;
+        MyScorePlayer player(m_libraryScope, &midi);
+        PlayerNoGui playGui;
+        player.load_score(pScore, &playGui);
+        int nEvMax = player.my_get_table()->num_events() - 1;
+        player.my_do_play(0, nEvMax, k_play_normal_instrument, k_no_visual_tracking,
+                          k_no_countoff, 240L, nullptr);
+        player.my_wait_for_termination();
+
+        PlaybackTimingStats stats = player.get_timing_stats();
+        CHECK( stats.numEvents > 0 );
+        CHECK( stats.meanLatency >= 0.0 );
+        CHECK( stats.maxLatency >= stats.meanLatency );
+        CHECK( stats.jitter >= 0.0 );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, Scheduler_DeadlinesAreAbsolute)
+    {
+        //time spent between waits is not accumulated as timing error
+
+        MyPlaybackScheduler scheduler;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        scheduler.start(0L);
+        bool fDrift = false;
+        for (int i=1; i <= 10; ++i)
+        {
+            std::this_thread::sleep_for( std::chrono::milliseconds(3) );
+            scheduler.wait_until(10L * i);
+            fDrift |= (scheduler.my_last_deadline() != 10000L * i);
+        }
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        CHECK( fDrift == false );
+        CHECK( elapsed.count() >= 100.0 );
+        PlaybackTimingStats stats = scheduler.get_stats();
+        CHECK( stats.numEvents == 10 );
+        CHECK( stats.meanLatency >= 0.0 );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, Scheduler_PauseShiftsTimeline)
+    {
+        PlaybackScheduler scheduler;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        scheduler.start(0L);
+        scheduler.wait_until(10L);
+        scheduler.pause();
+        std::this_thread::sleep_for( std::chrono::milliseconds(30) );
+        scheduler.resume();
+        scheduler.wait_until(20L);
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        CHECK( elapsed.count() >= 50.0 );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, Scheduler_SpinTimeLimited)
+    {
+        PlaybackScheduler scheduler;
+        CHECK( scheduler.get_spin_time() == 0L );
+        scheduler.set_spin_time(200L);
+        CHECK( scheduler.get_spin_time() == 200L );
+        scheduler.set_spin_time(5000L);
+        CHECK( scheduler.get_spin_time() == 1000L );
+        scheduler.set_spin_time(-3L);
+        CHECK( scheduler.get_spin_time() == 0L );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, TrackingRing_PushPop)
+    {
+        VisualTrackingRing ring(5);
+        CHECK( ring.capacity() == 8 );
+        CHECK( ring.is_empty() == true );
+
+        for (int i=0; i < 8; ++i)
+            CHECK( ring.push(EventVisualTracking::k_highlight_on, 7, i, 0.0) == true );
+        CHECK( ring.push(EventVisualTracking::k_highlight_on, 7, 8, 0.0) == false );
+        CHECK( ring.num_dropped() == 1L );
+
+        VisualTrackingRecord record;
+        CHECK( ring.pop(record) == true );
+        CHECK( record.type == EventVisualTracking::k_highlight_on );
+        CHECK( record.scoreId == 7 );
+        CHECK( record.id == 0 );
+        CHECK( ring.push(EventVisualTracking::k_move_tempo_line, 7, k_no_imoid, 64.0) == true );
+
+        for (int i=1; i < 8; ++i)
+        {
+            CHECK( ring.pop(record) == true );
+            CHECK( record.id == i );
+        }
+        CHECK( ring.pop(record) == true );
+        CHECK( record.type == EventVisualTracking::k_move_tempo_line );
+        CHECK( record.timepos == 64.0 );
+        CHECK( ring.pop(record) == false );
+        CHECK( ring.is_empty() == true );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, TrackingRing_TwoThreads)
+    {
+        //records pushed by one thread arrive, in order, to the other thread
+
+        VisualTrackingRing ring(64);
+        const int numRecords = 20000;
+        std::thread producer([&ring, numRecords]()
+        {
+            for (int i=0; i < numRecords; ++i)
+            {
+                while (!ring.push(EventVisualTracking::k_highlight_on, 1, i, 0.0))
+                    std::this_thread::yield();
+            }
+        });
+
+        int expected = 0;
+        bool fOrdered = true;
+        VisualTrackingRecord record;
+        while (expected < numRecords)
+        {
+            if (ring.pop(record))
+            {
+                fOrdered &= (record.id == expected);
+                ++expected;
+            }
+            else
+                std::this_thread::yield();
+        }
+        producer.join();
+
+        CHECK( fOrdered == true );
+        CHECK( ring.is_empty() == true );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, DoPlay_TrackingRing)
+    {
+        LomseDoorway* pLomse = m_libraryScope.platform_interface();
+        pLomse->set_notify_callback(nullptr, MyScorePlayer::my_callback);
+        SpDocument spDoc( new Document(m_libraryScope) );
+        spDoc->from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(n c4 e) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( spDoc->get_im_root()->get_content_item(0) );
+        MyMidiServer midi;
+        MyScorePlayer player(m_libraryScope, &midi);
+        player.use_tracking_ring(true);
+        PlayerNoGui playGui;
+        player.load_score(pScore, &playGui);
+        int nEvMax = player.my_get_table()->num_events() - 1;
+        SpInteractor inter( LOMSE_NEW Interactor(m_libraryScope, WpDocument(spDoc), nullptr, nullptr) );
+        player.my_do_play(0, nEvMax, k_play_normal_instrument, k_do_visual_tracking,
+                          k_no_countoff, 120L, inter.get());
+        player.my_wait_for_termination();
+
+        //only end of playback is notified
+        CHECK( m_notifications.size() == 1 );
+        CHECK( m_notifications.front()->get_event_type() == k_end_of_playback_event );
+
+        //tracking information is in the ring
+        VisualTrackingRing* pRing = player.get_tracking_ring();
+        VisualTrackingRecord record;
+        CHECK( pRing->pop(record) == true );
+        CHECK( record.type == EventVisualTracking::k_move_tempo_line );
+        CHECK( record.scoreId == pScore->get_id() );
+        CHECK( pRing->pop(record) == true );
+        CHECK( record.type == EventVisualTracking::k_highlight_on );
+        int lastType = record.type;
+        while (pRing->pop(record))
+            lastType = record.type;
+        CHECK( lastType == EventVisualTracking::k_end_of_visual_tracking );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, UpdateVisualTracking_DrainsRing)
+    {
+        SpDocument spDoc( new Document(m_libraryScope) );
+        spDoc->from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(n c4 e) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( spDoc->get_im_root()->get_content_item(0) );
+        MidiServerBase midi;
+        MyScorePlayer player(m_libraryScope, &midi);
+        SpInteractor inter( LOMSE_NEW Interactor(m_libraryScope, WpDocument(spDoc), nullptr, nullptr) );
+
+        CHECK( inter->update_visual_tracking(&player) == false );
+
+        VisualTrackingRing* pRing = player.get_tracking_ring();
+        pRing->push(EventVisualTracking::k_move_tempo_line, pScore->get_id(), k_no_imoid, 0.0);
+        pRing->push(EventVisualTracking::k_end_of_visual_tracking, pScore->get_id(),
+                    k_no_imoid, 0.0);
+
+        CHECK( inter->update_visual_tracking(&player) == true );
+        CHECK( pRing->is_empty() == true );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, UpdateVisualTracking_DeletedNote)
+    {
+        //records for notes no longer in the document are ignored
+
+        SpDocument spDoc( new Document(m_libraryScope) );
+        spDoc->from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(n c4 e) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( spDoc->get_im_root()->get_content_item(0) );
+        MidiServerBase midi;
+        MyScorePlayer player(m_libraryScope, &midi);
+        GraphicView* pView = Injector::inject_SimpleView(m_libraryScope, spDoc.get());
+        SpInteractor inter(Injector::inject_Interactor(m_libraryScope, WpDocument(spDoc),
+                                                       pView, nullptr));
+        pView->set_interactor(inter.get());
+
+        VisualTrackingRing* pRing = player.get_tracking_ring();
+        pRing->push(EventVisualTracking::k_highlight_on, pScore->get_id(), 9999, 0.0);
+        pRing->push(EventVisualTracking::k_highlight_off, pScore->get_id(), 9998, 0.0);
+
+        CHECK( inter->update_visual_tracking(&player) == true );
+        CHECK( pRing->is_empty() == true );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, DoPlay_MetronomeRestoredFromSnapshot)
+    {
+        //metronome state when starting after three time signatures is the same than
+        //when the previous measures are played
+
+        SpDocument spDoc( new Document(m_libraryScope) );
+        spDoc->from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(time 3 8)(n c4 q)(n e4 e)(barline)"
+            "(time 2 4)(n c4 q)(n e4 q)(barline)(time 2 2)(n c4 h)(n e4 h)(barline)"
+            "(n c4 h)(n e4 h)(barline) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( spDoc->get_im_root()->get_content_item(0) );
+        MyMidiServer midi;
+        MyScorePlayer2 player(m_libraryScope, &midi);
+        PlayerNoGui playGui;
+        player.load_score(pScore, &playGui);
+
+        player.play_offline(1, 0, 70L);
+        MetronomeState fromStart = player.my_get_metronome_state();
+        player.play_offline(4, 0, 70L);
+        MetronomeState fromMeasure = player.my_get_metronome_state();
+
+        CHECK( fromMeasure == fromStart );
+        CHECK( fromStart.curMtrIntval != 60000L / 70L );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, PlaybackThread_Reused)
+    {
+        //the playback thread is not created again for each playback
+
+        SpDocument spDoc( new Document(m_libraryScope) );
+        spDoc->from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(n c4 s) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( spDoc->get_im_root()->get_content_item(0) );
+        MyMidiServer midi;
+        MyScorePlayer2 player(m_libraryScope, &midi);
+        PlayerNoGui playGui;
+        player.load_score(pScore, &playGui);
+
+        player.play(k_no_visual_tracking, 240L);
+        player.my_wait_for_termination();
+        SoundThread* pThread = player.my_get_thread();
+        player.play(k_no_visual_tracking, 240L);
+        player.my_wait_for_termination();
+
+        CHECK( pThread != nullptr );
+        CHECK( player.my_get_thread() == pThread );
+        CHECK( player.is_playing() == false );
+        CHECK( midi.my_get_events().size() == 10 );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, PlaybackThread_StopWaitsForEnd)
+    {
+        //stop() returns when playback is finished. Rapid start/stop is possible
+
+        SpDocument spDoc( new Document(m_libraryScope) );
+        spDoc->from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(n c4 w)(n e4 w)(n g4 w) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( spDoc->get_im_root()->get_content_item(0) );
+        MyMidiServer midi;
+        MyScorePlayer2 player(m_libraryScope, &midi);
+        PlayerNoGui playGui;
+        player.load_score(pScore, &playGui);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i=0; i < 20; ++i)
+        {
+            player.play(k_no_visual_tracking, 60L);
+            CHECK( player.is_playing() == true );
+            player.stop();
+            CHECK( player.is_playing() == false );
+            //AWARE: when stop() arrives before playback starts, nothing is played
+            std::list<int>& events = midi.my_get_events();
+            CHECK( events.empty() || events.back() == MyMidiServer::k_all_sounds_off );
+        }
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        CHECK( elapsed.count() < 4000.0 );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, PlaybackThread_Seek)
+    {
+        //seek() continues playback at the requested measure
+
+        SpDocument spDoc( new Document(m_libraryScope) );
+        spDoc->from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(time 2 4)"
+            "(n c4 h)(barline)(n d4 h)(barline)(n e4 h)(barline)(n f4 h)(barline)"
+            "(n g4 q)(barline) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( spDoc->get_im_root()->get_content_item(0) );
+        MyMidiServer midi;
+        MyScorePlayer2 player(m_libraryScope, &midi);
+        PlayerNoGui playGui;
+        player.load_score(pScore, &playGui);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        player.play(k_no_visual_tracking, 60L);
+        player.seek(5);
+        player.my_wait_for_termination();
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        CHECK( midi.my_last_pitch() == 67 );
+        CHECK( elapsed.count() < 4000.0 );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, PlaybackThread_SetTempo)
+    {
+        //set_tempo() changes the tempo of current playback
+
+        SpDocument spDoc( new Document(m_libraryScope) );
+        spDoc->from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(time 4 4)"
+            "(n c4 q)(n d4 q)(n e4 q)(n f4 q)(barline) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( spDoc->get_im_root()->get_content_item(0) );
+        MyMidiServer midi;
+        MyScorePlayer2 player(m_libraryScope, &midi);
+        PlayerNoGui playGui;
+        player.load_score(pScore, &playGui);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        player.play(k_no_visual_tracking, 30L);
+        player.set_tempo(600L);
+        player.my_wait_for_termination();
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        CHECK( midi.my_last_pitch() == 65 );
+        CHECK( elapsed.count() < 4000.0 );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, PlaybackThread_RealTimePriority)
+    {
+        //real-time scheduling can be not permitted, but normal scheduling is
+        //always available
+
+        MidiServerBase midi;
+        ScorePlayer* pPlayer = Injector::inject_ScorePlayer(m_libraryScope, &midi);
+
+        bool fRealTime = pPlayer->set_realtime_priority(true);
+        CHECK( pPlayer->is_realtime_priority() == fRealTime );
+        CHECK( pPlayer->set_realtime_priority(false) == true );
+        CHECK( pPlayer->is_realtime_priority() == false );
+
+        delete pPlayer;
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, MixedPlayback_VisualTracking)
+    {
+        //visual tracking for a mixed score is routed to its Interactor and score
+
+        LomseDoorway* pLomse = m_libraryScope.platform_interface();
+        pLomse->set_notify_callback(nullptr, MyScorePlayer::my_callback);
+        SpDocument spDoc( new Document(m_libraryScope) );
+        spDoc->from_string("(lenmusdoc (vers 0.0) (content "
+            "(score (vers 2.0)(instrument (musicData (clef G)(n c4 e) )))"
+            "(score (vers 2.0)(instrument (musicData (clef G)(n e4 e) )))"
+            "))" );
+        ImoScore* pScore = static_cast<ImoScore*>( spDoc->get_im_root()->get_content_item(0) );
+        ImoScore* pScore2 = static_cast<ImoScore*>( spDoc->get_im_root()->get_content_item(1) );
+        MyMidiServer midi;
+        MyScorePlayer2 player(m_libraryScope, &midi);
+        PlayerNoGui playGui;
+        player.load_score(pScore, &playGui);
+        SpInteractor inter( LOMSE_NEW Interactor(m_libraryScope, WpDocument(spDoc), nullptr, nullptr) );
+        SpInteractor inter2( LOMSE_NEW Interactor(m_libraryScope, WpDocument(spDoc), nullptr, nullptr) );
+        CHECK( player.mix_score(pScore2, inter2.get()) == true );
+        m_notifications.clear();
+        player.play(k_do_visual_tracking, 120L, inter.get());
+        player.my_wait_for_termination();
+
+        int numMain = 0;
+        int numMixed = 0;
+        bool fRouted = true;
+        std::list<SpEventInfo>::iterator it;
+        for (it = m_notifications.begin(); it != m_notifications.end(); ++it)
+        {
+            if ((*it)->get_event_type() != k_tracking_event)
+                continue;
+            SpEventVisualTracking pEv( static_pointer_cast<EventVisualTracking>(*it) );
+            SpInteractor sp = pEv->get_interactor().lock();
+            if (pEv->get_score_id() == pScore->get_id())
+            {
+                ++numMain;
+                fRouted &= (sp.get() == inter.get());
+            }
+            else if (pEv->get_score_id() == pScore2->get_id())
+            {
+                ++numMixed;
+                fRouted &= (sp.get() == inter2.get());
+            }
+        }
+        CHECK( numMain > 0 );
+        CHECK( numMixed > 0 );
+        CHECK( fRouted == true );
+        CHECK( std::count(midi.my_get_events().begin(), midi.my_get_events().end(),
+                          int(MyMidiServer::k_note_on)) == 2 );
+        m_notifications.clear();
+    }
+
 }
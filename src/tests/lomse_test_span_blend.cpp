@@ -0,0 +1,265 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+#include <UnitTest++.h>
+#include <sstream>
+#include <vector>
+#include <cstdlib>
+#include "lomse_build_options.h"
+
+//classes related to these tests
+#include "agg_pixfmt_rgba.h"
+#include "agg_span_blend_simd.h"
+
+using namespace UnitTest;
+using namespace std;
+using namespace agg;
+
+
+//---------------------------------------------------------------------------------------
+// Checks that the SIMD implementations of the span blending loops produce exactly the
+// same result than the original scalar AGG code.
+template<class PixFmt>
+class SpanBlendTester
+{
+public:
+    typedef typename PixFmt::blender_type blender_type;
+    typedef typename PixFmt::order_type order_type;
+
+    enum { k_width = 67, k_height = 4 };      //not multiple of SIMD width
+
+    std::vector<int8u> m_buffer;
+    std::vector<int8u> m_expected;
+    std::vector<int8u> m_covers;
+    std::vector<rgba8> m_colors;
+    rendering_buffer m_rbuf;
+
+    SpanBlendTester()
+        : m_buffer(k_width * k_height * 4)
+        , m_expected(k_width * k_height * 4)
+        , m_covers(k_width)
+        , m_colors(k_width)
+    {
+        m_rbuf.attach(&m_buffer[0], k_width, k_height, k_width * 4);
+    }
+
+    void randomize(unsigned seed)
+    {
+        std::srand(seed);
+        for (size_t i=0; i < m_buffer.size(); i += 4)
+        {
+            //premultiplied pixels
+            int8u a = int8u(std::rand() & 0xFF);
+            m_buffer[i + order_type::A] = a;
+            m_buffer[i + order_type::R] = rgba8::multiply(int8u(std::rand() & 0xFF), a);
+            m_buffer[i + order_type::G] = rgba8::multiply(int8u(std::rand() & 0xFF), a);
+            m_buffer[i + order_type::B] = rgba8::multiply(int8u(std::rand() & 0xFF), a);
+        }
+        for (size_t i=0; i < m_covers.size(); ++i)
+        {
+            //include many 0 and 255 values, for testing all code paths
+            int r = std::rand() % 4;
+            m_covers[i] = int8u(r == 0 ? 0 : r == 1 ? 255 : std::rand() & 0xFF);
+            r = std::rand() % 4;
+            m_colors[i] = rgba8(int8u(std::rand()), int8u(std::rand()), int8u(std::rand()),
+                                int8u(r == 0 ? 0 : r == 1 ? 255 : std::rand() & 0xFF));
+        }
+        m_expected = m_buffer;
+    }
+
+    void expected_blend(int8u* p, const rgba8& c, unsigned cover)
+    {
+        if (c.a == 0)
+            return;
+        if (c.a == 255 && cover == 255)
+        {
+            p[order_type::R] = c.r;
+            p[order_type::G] = c.g;
+            p[order_type::B] = c.b;
+            p[order_type::A] = c.a;
+        }
+        else
+            blender_type::blend_pix(p, c.r, c.g, c.b, c.a, cover_type(cover));
+    }
+
+    bool test_blend_solid_hspan(unsigned seed)
+    {
+        randomize(seed);
+        rgba8 c = m_colors[0];
+        if (c.a == 0)
+            c.a = 100;
+        PixFmt pixf(m_rbuf);
+        for (int y=0; y < k_height; ++y)
+        {
+            unsigned len = unsigned(k_width - y);
+            pixf.blend_solid_hspan(y, y, len, c, &m_covers[0]);
+            for (unsigned i=0; i < len; ++i)
+                expected_blend(&m_expected[(y * k_width + y + i) * 4], c, m_covers[i]);
+        }
+        return m_buffer == m_expected;
+    }
+
+    bool test_blend_hline(unsigned seed)
+    {
+        randomize(seed);
+        PixFmt pixf(m_rbuf);
+        for (int y=0; y < k_height; ++y)
+        {
+            rgba8 c = m_colors[y];
+            unsigned cover = (y == 0 ? 255 : m_covers[y]);
+            if (y == 0)
+                c.a = 255;
+            pixf.blend_hline(0, y, k_width, c, int8u(cover));
+            for (unsigned i=0; i < k_width; ++i)
+                expected_blend(&m_expected[(y * k_width + i) * 4], c, cover);
+        }
+        return m_buffer == m_expected;
+    }
+
+    bool test_blend_color_hspan(unsigned seed)
+    {
+        randomize(seed);
+        PixFmt pixf(m_rbuf);
+
+        //with covers
+        pixf.blend_color_hspan(1, 0, k_width - 1, &m_colors[0], &m_covers[0], 255);
+        for (unsigned i=0; i < k_width - 1; ++i)
+            expected_blend(&m_expected[(1 + i) * 4], m_colors[i], m_covers[i]);
+
+        //with a single cover value
+        pixf.blend_color_hspan(0, 1, k_width, &m_colors[0], nullptr, 255);
+        for (unsigned i=0; i < k_width; ++i)
+            expected_blend(&m_expected[(k_width + i) * 4], m_colors[i], 255);
+
+        pixf.blend_color_hspan(0, 2, k_width, &m_colors[0], nullptr, 77);
+        for (unsigned i=0; i < k_width; ++i)
+            expected_blend(&m_expected[(2 * k_width + i) * 4], m_colors[i], 77);
+
+        return m_buffer == m_expected;
+    }
+
+    bool test_copy_hline(unsigned seed)
+    {
+        randomize(seed);
+        PixFmt pixf(m_rbuf);
+        rgba8 c = m_colors[1];
+        pixf.copy_hline(3, 2, k_width - 3, c);
+        for (unsigned i=3; i < k_width; ++i)
+        {
+            int8u* p = &m_expected[(2 * k_width + i) * 4];
+            p[order_type::R] = c.r;
+            p[order_type::G] = c.g;
+            p[order_type::B] = c.b;
+            p[order_type::A] = c.a;
+        }
+        return m_buffer == m_expected;
+    }
+
+    bool test_all()
+    {
+        bool fOk = true;
+        for (unsigned seed=1; seed < 20; ++seed)
+        {
+            fOk &= test_blend_solid_hspan(seed);
+            fOk &= test_blend_hline(seed);
+            fOk &= test_blend_color_hspan(seed);
+            fOk &= test_copy_hline(seed);
+        }
+        return fOk;
+    }
+};
+
+//---------------------------------------------------------------------------------------
+class SpanBlendTestFixture
+{
+public:
+    simd::isa_e m_savedIsa;
+
+    SpanBlendTestFixture()     //SetUp fixture
+    {
+        m_savedIsa = simd::get_isa();
+    }
+
+    ~SpanBlendTestFixture()    //TearDown fixture
+    {
+        simd::set_isa(m_savedIsa);
+    }
+
+    bool test_isa(simd::isa_e isa)
+    {
+        if (!simd::set_isa(isa))
+            return true;    //not supported in this CPU
+
+        bool fOk = true;
+        SpanBlendTester<pixfmt_rgba32> rgba;
+        fOk &= rgba.test_all();
+        SpanBlendTester<pixfmt_bgra32> bgra;
+        fOk &= bgra.test_all();
+        SpanBlendTester<pixfmt_argb32> argb;
+        fOk &= argb.test_all();
+        SpanBlendTester<pixfmt_abgr32> abgr;
+        fOk &= abgr.test_all();
+        return fOk;
+    }
+};
+
+SUITE(SpanBlendTest)
+{
+
+    TEST_FIXTURE(SpanBlendTestFixture, isa_detection)
+    {
+        simd::isa_e isa = simd::detect_isa();
+        CHECK( simd::set_isa(isa) == true );
+        CHECK( simd::get_isa() == isa );
+        CHECK( simd::set_isa(simd::isa_scalar) == true );
+        CHECK( simd::get_isa() == simd::isa_scalar );
+    }
+
+    TEST_FIXTURE(SpanBlendTestFixture, scalar_equals_agg)
+    {
+        CHECK( test_isa(simd::isa_scalar) == true );
+    }
+
+    TEST_FIXTURE(SpanBlendTestFixture, sse2_equals_agg)
+    {
+        CHECK( test_isa(simd::isa_sse2) == true );
+    }
+
+    TEST_FIXTURE(SpanBlendTestFixture, avx2_equals_agg)
+    {
+        CHECK( test_isa(simd::isa_avx2) == true );
+    }
+
+    TEST_FIXTURE(SpanBlendTestFixture, neon_equals_agg)
+    {
+        CHECK( test_isa(simd::isa_neon) == true );
+    }
+
+}
+
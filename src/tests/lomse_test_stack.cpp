@@ -195,4 +195,37 @@ SUITE(UndoableStackTest)
         CHECK( *(stack.get_item(3)) == 4 );
     }
 
+    TEST_FIXTURE(UndoableStackTestFixture, UndoableStackRemoveOldest)
+    {
+        UndoStackInt stack;
+        stack.push( new int(1) );
+        stack.push( new int(2) );
+        stack.push( new int(3) );
+        stack.remove_oldest();
+        CHECK( stack.size() == 2 );
+        CHECK( *(stack.get_item(0)) == 2 );
+        stack.remove_oldest();
+        stack.remove_oldest();
+        CHECK( stack.size() == 0 );
+        stack.remove_oldest();
+        CHECK( stack.size() == 0 );
+    }
+
+    TEST_FIXTURE(UndoableStackTestFixture, UndoableStackIterators)
+    {
+        UndoStackInt stack;
+        stack.push( new int(1) );
+        stack.push( new int(2) );
+        stack.push( new int(3) );
+        stack.pop();    //3
+        int sum = 0;
+        UndoStackInt::iterator it;
+        for (it = stack.begin(); it != stack.end(); ++it)
+            sum += **it;
+        CHECK( sum == 3 );
+        it = stack.history_begin();
+        CHECK( **it == 3 );
+        CHECK( ++it == stack.history_end() );
+    }
+
 }
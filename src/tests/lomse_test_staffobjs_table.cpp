@@ -1769,6 +1769,94 @@ SUITE(ColStaffObjsBuilderTest)
         if (pRoot && !pRoot->is_document()) delete pRoot;
     }
 
-}
+    TEST_FIXTURE(ColStaffObjsBuilderTestFixture, ColStaffObjsIndex_FindEntryAndBarline)
+    {
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0) "
+            "(instrument (musicData (clef G)(n c4 q)(n d4 q)(barline)(n e4 h)(barline)))"
+            "(instrument (musicData (clef F4)(n c3 h)(barline)(n d3 h)(barline))) )" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        ColStaffObjs* pColStaffObjs = pScore->get_staffobjs_table();
+        ColStaffObjsIndex* pIndex = pColStaffObjs->get_index();
+//        cout << test_name() << endl;
+        //cout << pColStaffObjs->dump();
+
+        ColStaffObjsIterator it = pColStaffObjs->begin();
+        for (; it != pColStaffObjs->end(); ++it)
+        {
+            ColStaffObjsEntry* pEntry = *it;
+            CHECK( pIndex->find_entry(pEntry->element_id()) == pEntry );
+        }
+        CHECK( pIndex->find_entry(k_no_imoid) == nullptr );
+
+        ColStaffObjsEntry* pEntry = pIndex->find_barline(1, 1);
+        CHECK( pEntry != nullptr );
+        CHECK( pEntry->imo_object()->is_barline() == true );
+        CHECK( pEntry->num_instrument() == 1 );
+        CHECK( pEntry->measure() == 1 );
+        CHECK( is_equal_time(pEntry->time(), 256.0) );
+        CHECK( pIndex->find_barline(1, 2) == nullptr );
+        CHECK( pIndex->find_barline(2, 0) == nullptr );
+
+        pEntry = pIndex->last_entry(0);
+        CHECK( pEntry->num_instrument() == 0 );
+        CHECK( pEntry->imo_object()->is_barline() == true );
+        CHECK( is_equal_time(pEntry->time(), 256.0) );
+    }
+
+    TEST_FIXTURE(ColStaffObjsBuilderTestFixture, ColStaffObjsIndex_FindByTime)
+    {
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 1.6) (instrument (staves 2)(musicData "
+            "(clef G p1)(clef F4 p2)(time 2 4)(n c4 q p1)(n e4 q)(goBack start)"
+            "(n c3 h p2)(barline)(n d4 h p1)(goBack start)(n d3 q p2)(n e3 q)"
+            "(barline))) )" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        ColStaffObjs* pColStaffObjs = pScore->get_staffobjs_table();
+        ColStaffObjsIndex* pIndex = pColStaffObjs->get_index();
+//        cout << test_name() << endl;
+        //cout << pColStaffObjs->dump();
+
+        ColStaffObjsEntry* pEntry = pIndex->find_entry_not_before(0, 1, 64.0, nullptr);
+        CHECK( pEntry != nullptr );
+        CHECK( pEntry->imo_object()->is_barline() == true );
+        CHECK( is_equal_time(pEntry->time(), 128.0) );
+
+        pEntry = pIndex->find_entry_not_before(0, 1, 192.0, nullptr);
+        CHECK( pEntry->imo_object()->is_note() == true );
+        CHECK( pEntry->staff() == 1 );
+        CHECK( is_equal_time(pEntry->time(), 192.0) );
+
+        pEntry = pIndex->find_entry_not_before(0, 0, 192.0, nullptr);
+        CHECK( pEntry->imo_object()->is_barline() == true );
+        CHECK( is_equal_time(pEntry->time(), 256.0) );
+
+        ColStaffObjsEntry* pBarline = pIndex->find_barline_before(0, pEntry);
+        CHECK( pBarline != nullptr );
+        CHECK( is_equal_time(pBarline->time(), 128.0) );
+        ColStaffObjsEntry* pTime = pIndex->find_time_signature_before(0, pEntry);
+        CHECK( pTime != nullptr );
+        CHECK( pTime->imo_object()->is_time_signature() == true );
+    }
+
+    TEST_FIXTURE(ColStaffObjsBuilderTestFixture, ColStaffObjsIndex_RebuiltAfterChanges)
+    {
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0) (instrument (musicData "
+            "(clef G)(n c4 q)(n d4 q)(barline))) )" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        ColStaffObjs* pColStaffObjs = pScore->get_staffobjs_table();
 
+        ColStaffObjsIterator it = pColStaffObjs->begin();
+        ++it;
+        ImoStaffObj* pNote = (*it)->imo_object();
+        ImoId id = pNote->get_id();
+        CHECK( pColStaffObjs->get_index()->find_entry(id) == *it );
+
+        pColStaffObjs->delete_entry_for(pNote);
 
+        CHECK( pColStaffObjs->get_index()->find_entry(id) == nullptr );
+        CHECK( pColStaffObjs->get_index()->last_entry(0)->imo_object()->is_barline() );
+    }
+
+}
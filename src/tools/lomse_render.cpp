@@ -0,0 +1,187 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Lomse is copyrighted work (c) 2010-2020. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice, this
+//      list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright notice, this
+//      list of conditions and the following disclaimer in the documentation and/or
+//      other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// For any comment, suggestion or feature request, please contact the manager of
+// the project at cecilios@users.sourceforge.net
+//---------------------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------------------
+// lomse_render: command line program for rendering document pages as PNG images.
+//
+//  usage: lomse_render [options] file [file ...]
+//
+//  options:
+//      -r, --dpi <n>           resolution, in dots per inch (default: 96)
+//      -p, --pages <m>[-<n>]   pages to render, 1..n (default: all pages)
+//      -o, --output <dir>      folder for the generated images (default: current)
+//      -f, --fonts <dir>       folder containing the Lomse fonts
+//      -z, --compression <n>   PNG compression level 0..9 (default: zlib default)
+//      -q, --quiet             do not display progress information
+//
+//  Images are named after the source file and the page number, i.e. for 'score.xml'
+//  the images will be 'score-1.png', 'score-2.png', etc. All files are rendered by the
+//  same BatchRenderer, so that fonts and caches are reused.
+//---------------------------------------------------------------------------------------
+
+#include "lomse_doorway.h"
+#include "lomse_batch_renderer.h"
+#include "lomse_pixel_formats.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace lomse;
+using namespace std;
+
+
+//---------------------------------------------------------------------------------------
+static void print_usage()
+{
+    cout << "usage: lomse_render [options] file [file ...]" << endl << endl
+         << "options:" << endl
+         << "    -r, --dpi <n>           resolution, in dots per inch (default: 96)" << endl
+         << "    -p, --pages <m>[-<n>]   pages to render, 1..n (default: all pages)" << endl
+         << "    -o, --output <dir>      folder for the generated images" << endl
+         << "    -f, --fonts <dir>       folder containing the Lomse fonts" << endl
+         << "    -z, --compression <n>   PNG compression level 0..9" << endl
+         << "    -q, --quiet             do not display progress information" << endl;
+}
+
+//---------------------------------------------------------------------------------------
+static string base_name(const string& filename)
+{
+    size_t start = filename.find_last_of("/\\");
+    start = (start == string::npos ? 0 : start + 1);
+    size_t end = filename.rfind('.');
+    if (end == string::npos || end < start)
+        end = filename.size();
+    return filename.substr(start, end - start);
+}
+
+//---------------------------------------------------------------------------------------
+static bool is_option(const char* arg, const char* shortName, const char* longName)
+{
+    return strcmp(arg, shortName) == 0 || strcmp(arg, longName) == 0;
+}
+
+//---------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    double dpi = 96.0;
+    int firstPage = 0;
+    int lastPage = -1;
+    int compression = -1;
+    bool fQuiet = false;
+    string outputPath;
+    string fontsPath;
+    vector<string> files;
+
+    for (int i=1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        bool fHasValue = (i + 1 < argc);
+        if (is_option(arg, "-r", "--dpi") && fHasValue)
+            dpi = atof(argv[++i]);
+        else if (is_option(arg, "-p", "--pages") && fHasValue)
+        {
+            string pages = argv[++i];
+            size_t dash = pages.find('-');
+            firstPage = atoi(pages.substr(0, dash).c_str()) - 1;
+            lastPage = (dash == string::npos ? firstPage
+                                             : atoi(pages.substr(dash+1).c_str()) - 1);
+        }
+        else if (is_option(arg, "-o", "--output") && fHasValue)
+            outputPath = argv[++i];
+        else if (is_option(arg, "-f", "--fonts") && fHasValue)
+            fontsPath = argv[++i];
+        else if (is_option(arg, "-z", "--compression") && fHasValue)
+            compression = atoi(argv[++i]);
+        else if (is_option(arg, "-q", "--quiet"))
+            fQuiet = true;
+        else if (arg[0] == '-')
+        {
+            print_usage();
+            return 1;
+        }
+        else
+            files.push_back(arg);
+    }
+
+    if (files.empty() || dpi <= 0.0)
+    {
+        print_usage();
+        return 1;
+    }
+    if (!outputPath.empty() && outputPath.back() != '/' && outputPath.back() != '\\')
+        outputPath += "/";
+
+    //initialize the library. Errors in documents are not relevant here
+    LomseDoorway lomse;
+    lomse.init_library(k_pix_format_rgb24, 96, false, cerr);
+    if (!fontsPath.empty())
+        lomse.set_default_fonts_path(fontsPath);
+
+    BatchRenderer* pRenderer = lomse.create_batch_renderer();
+    pRenderer->set_png_compression_level(compression);
+
+    int numFailures = 0;
+    int totalPages = 0;
+    auto start = chrono::steady_clock::now();
+    for (const string& filename : files)
+    {
+        if (!pRenderer->open_document(filename, cerr))
+        {
+            cerr << filename << ": error loading document" << endl;
+            ++numFailures;
+            continue;
+        }
+
+        int last = (lastPage < 0 ? pRenderer->get_num_pages() - 1 : lastPage);
+        int expected = max(0, min(last, pRenderer->get_num_pages() - 1) - firstPage + 1);
+        int numPages = pRenderer->render_pages_to_png(outputPath + base_name(filename),
+                                                      dpi, firstPage, last);
+        totalPages += numPages;
+        if (numPages != expected)
+            ++numFailures;
+
+        if (!fQuiet)
+            cout << filename << ": " << numPages << " page(s) rendered" << endl;
+    }
+    pRenderer->close_document();
+    delete pRenderer;
+
+    if (!fQuiet)
+    {
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+        cout << files.size() << " file(s), " << totalPages << " page(s) in "
+             << elapsed.count() << " ms" << endl;
+    }
+
+    return numFailures > 0 ? 2 : 0;
+}